@@ -12,6 +12,8 @@
 #include "common/ring_buffer.h"
 #include "core/memory.h"
 
+class PointerWrap;
+
 namespace Service::DSP {
 class DSP_DSP;
 } // namespace Service::DSP
@@ -92,6 +94,12 @@ public:
     /// Unloads the DSP program
     virtual void UnloadComponent() = 0;
 
+    /**
+     * Serializes the state of the DSP which isn't kept in DSP memory. Sets an error on the
+     * PointerWrap if the implementation can't store its state.
+     */
+    virtual void DoState(PointerWrap& p) = 0;
+
     /// Select the sink to use based on sink id.
     void SetSink(const std::string& sink_id, const std::string& audio_device);
     /// Get the current sink
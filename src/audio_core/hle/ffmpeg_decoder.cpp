@@ -237,6 +237,7 @@ std::optional<BinaryResponse> FFMPEGDecoder::Impl::Decode(const BinaryRequest& r
         }
         std::memcpy(memory.GetFCRAMPointer(request.dst_addr_ch0 - Memory::FCRAM_PADDR),
                     out_streams[0].data(), out_streams[0].size());
+        memory.MarkRegionDirty(request.dst_addr_ch0, static_cast<u32>(out_streams[0].size()));
     }
 
     if (out_streams[1].size() != 0) {
@@ -248,6 +249,7 @@ std::optional<BinaryResponse> FFMPEGDecoder::Impl::Decode(const BinaryRequest& r
         }
         std::memcpy(memory.GetFCRAMPointer(request.dst_addr_ch1 - Memory::FCRAM_PADDR),
                     out_streams[1].data(), out_streams[1].size());
+        memory.MarkRegionDirty(request.dst_addr_ch1, static_cast<u32>(out_streams[1].size()));
     }
     return response;
 }
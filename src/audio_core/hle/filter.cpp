@@ -8,6 +8,7 @@
 #include "audio_core/hle/common.h"
 #include "audio_core/hle/filter.h"
 #include "audio_core/hle/shared_memory.h"
+#include "common/chunk_file.h"
 #include "common/common_types.h"
 
 namespace AudioCore::HLE {
@@ -47,6 +48,14 @@ void SourceFilters::ProcessFrame(StereoFrame16& frame) {
     }
 }
 
+void SourceFilters::DoState(PointerWrap& p) {
+    p.Do(simple_filter_enabled);
+    p.Do(biquad_filter_enabled);
+    // The filters only hold integer coefficients and samples
+    p.DoVoid(&simple_filter, sizeof(simple_filter));
+    p.DoVoid(&biquad_filter, sizeof(biquad_filter));
+}
+
 // SimpleFilter
 
 void SourceFilters::SimpleFilter::Reset() {
@@ -9,6 +9,8 @@
 #include "audio_core/hle/shared_memory.h"
 #include "common/common_types.h"
 
+class PointerWrap;
+
 namespace AudioCore::HLE {
 
 /// Preprocessing filters. There is an independent set of filters for each Source.
@@ -48,6 +50,9 @@ public:
      */
     void ProcessFrame(StereoFrame16& frame);
 
+    /// Serializes the filter configuration and history.
+    void DoState(PointerWrap& p);
+
 private:
     bool simple_filter_enabled;
     bool biquad_filter_enabled;
@@ -16,9 +16,11 @@
 #include "audio_core/hle/source.h"
 #include "audio_core/sink.h"
 #include "common/assert.h"
+#include "common/chunk_file.h"
 #include "common/common_types.h"
 #include "common/hash.h"
 #include "common/logging/log.h"
+#include "common/subsystem_timer.h"
 #include "core/core.h"
 #include "core/core_timing.h"
 
@@ -46,6 +48,8 @@ public:
 
     void SetServiceToInterrupt(std::weak_ptr<DSP_DSP> dsp);
 
+    void DoState(PointerWrap& p);
+
 private:
     void ResetPipes();
     void WriteU16(DspPipe pipe_number, u16 value);
@@ -270,6 +274,17 @@ void DspHle::Impl::SetServiceToInterrupt(std::weak_ptr<DSP_DSP> dsp) {
     dsp_dsp = std::move(dsp);
 }
 
+void DspHle::Impl::DoState(PointerWrap& p) {
+    p.Do(dsp_state);
+    for (auto& pipe : pipe_data) {
+        p.Do(pipe);
+    }
+    for (auto& source : sources) {
+        source.DoState(p);
+    }
+    mixers.DoState(p);
+}
+
 void DspHle::Impl::ResetPipes() {
     for (auto& data : pipe_data) {
         data.clear();
@@ -390,6 +405,7 @@ bool DspHle::Impl::Tick() {
 }
 
 void DspHle::Impl::AudioTickCallback(s64 cycles_late) {
+    Common::ScopedSubsystemTimer timer(Common::Subsystem::DSP);
     if (Tick()) {
         // TODO(merry): Signal all the other interrupts as appropriate.
         if (auto service = dsp_dsp.lock()) {
@@ -454,4 +470,8 @@ void DspHle::UnloadComponent() {
     // Do nothing
 }
 
+void DspHle::DoState(PointerWrap& p) {
+    impl->DoState(p);
+}
+
 } // namespace AudioCore
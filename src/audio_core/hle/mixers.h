@@ -8,6 +8,8 @@
 #include "audio_core/audio_types.h"
 #include "audio_core/hle/shared_memory.h"
 
+class PointerWrap;
+
 namespace AudioCore::HLE {
 
 class Mixers final {
@@ -25,6 +27,9 @@ public:
         return current_frame;
     }
 
+    /// Serializes the mixer configuration and the intermediate mix buffers.
+    void DoState(PointerWrap& p);
+
 private:
     StereoFrame16 current_frame = {};
 
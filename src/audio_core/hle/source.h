@@ -14,6 +14,8 @@
 #include "audio_core/interpolate.h"
 #include "common/common_types.h"
 
+class PointerWrap;
+
 namespace Memory {
 class MemorySystem;
 }
@@ -60,6 +62,9 @@ public:
      */
     void MixInto(QuadFrame32& dest, std::size_t intermediate_mix_id) const;
 
+    /// Serializes the buffer queue and the decoding, resampling and filter state.
+    void DoState(PointerWrap& p);
+
 private:
     const std::size_t source_id;
     Memory::MemorySystem* memory_system;
@@ -9,6 +9,9 @@
 #include "audio_core/lle/lle.h"
 #include "common/assert.h"
 #include "common/bit_field.h"
+#include "common/chunk_file.h"
+#include "common/logging/log.h"
+#include "common/subsystem_timer.h"
 #include "common/swap.h"
 #include "common/thread.h"
 #include "core/core.h"
@@ -178,6 +181,7 @@ struct DspLle::Impl final {
     }
 
     void TeakraSliceEvent(u64 late) {
+        Common::ScopedSubsystemTimer timer(Common::Subsystem::DSP);
         RunTeakraSlice();
         u64 next = TeakraSlice * 2; // DSP runs at clock rate half of the CPU rate
         if (next < late)
@@ -473,6 +477,12 @@ void DspLle::UnloadComponent() {
     impl->UnloadComponent();
 }
 
+void DspLle::DoState(PointerWrap& p) {
+    // Teakra has no way to save and restore the state of the emulated DSP
+    LOG_ERROR(Audio_DSP, "The state of the LLE DSP can't be saved");
+    p.SetError(PointerWrap::ERROR_FAILURE);
+}
+
 DspLle::DspLle(Memory::MemorySystem& memory, bool multithread)
     : impl(std::make_unique<Impl>(multithread)) {
     Teakra::AHBMCallback ahbm;
@@ -481,6 +491,7 @@ DspLle::DspLle(Memory::MemorySystem& memory, bool multithread)
     };
     ahbm.write8 = [&memory](u32 address, u8 value) {
         *memory.GetFCRAMPointer(address - Memory::FCRAM_PADDR) = value;
+        memory.MarkRegionDirty(address, 1);
     };
     impl->teakra.SetAHBMCallback(ahbm);
     impl->teakra.SetAudioCallback([this](std::array<s16, 2> sample) { OutputSample(sample); });
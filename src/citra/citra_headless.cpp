@@ -0,0 +1,448 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+// This needs to be included before getopt.h because the latter #defines symbols used by it
+#include "common/microprofile.h"
+
+#include <getopt.h>
+#ifndef _MSC_VER
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+// windows.h needs to be included before shellapi.h
+#include <windows.h>
+
+#include <shellapi.h>
+#endif
+
+#include <fmt/format.h>
+#include <json.hpp>
+#include "citra/config.h"
+#include "citra/emu_window/emu_window_headless.h"
+#include "common/common_paths.h"
+#include "common/detached_tasks.h"
+#include "common/file_util.h"
+#include "common/hash.h"
+#include "common/logging/backend.h"
+#include "common/logging/filter.h"
+#include "common/logging/log.h"
+#include "common/scm_rev.h"
+#include "common/scope_exit.h"
+#include "common/string_util.h"
+#include "common/subsystem_timer.h"
+#include "core/core.h"
+#include "core/core_timing.h"
+#include "core/frontend/applets/default_applets.h"
+#include "core/movie.h"
+#include "core/settings.h"
+#include "video_core/renderer_headless/renderer_headless.h"
+#include "video_core/video_core.h"
+
+static void PrintHelp(const char* argv0) {
+    std::cout << "Usage: " << argv0
+              << " [options] <filename>\n"
+                 "-n, --frames=NUMBER   Exit after emulating NUMBER frames\n"
+                 "-m, --max-speed       Run as fast as possible instead of at the original speed\n"
+                 "-d, --dump-frames=DIR Write every frame to DIR as a PNG image\n"
+                 "-p, --movie-play=FILE Playback the movie (game inputs) from the given file\n"
+                 "-b, --benchmark=FILE  Write a JSON report of the time spent in each subsystem\n"
+                 "                      to FILE, requires --frames and --movie-play and implies\n"
+                 "                      --max-speed\n"
+                 "-h, --help            Display this help and exit\n"
+                 "-v, --version         Output version information and exit\n";
+}
+
+static void PrintVersion() {
+    std::cout << "Citra " << Common::g_scm_branch << " " << Common::g_scm_desc << std::endl;
+}
+
+static void InitializeLogging() {
+    Log::Filter log_filter(Log::Level::Debug);
+    log_filter.ParseFilterString(Settings::values.log_filter);
+    Log::SetGlobalFilter(log_filter);
+
+    Log::AddBackend(std::make_unique<Log::ColorConsoleBackend>());
+
+    const std::string& log_dir = FileUtil::GetUserPath(FileUtil::UserPath::LogDir);
+    FileUtil::CreateFullPath(log_dir);
+    Log::AddBackend(std::make_unique<Log::FileBackend>(log_dir + LOG_FILE));
+#ifdef _WIN32
+    Log::AddBackend(std::make_unique<Log::DebuggerBackend>());
+#endif
+}
+
+static u32 ComputeCrc32(u32 crc, const u8* data, std::size_t size) {
+    static const auto table = [] {
+        std::array<u32, 256> table{};
+        for (u32 i = 0; i < 256; ++i) {
+            u32 value = i;
+            for (int bit = 0; bit < 8; ++bit) {
+                value = (value & 1) ? 0xEDB88320 ^ (value >> 1) : value >> 1;
+            }
+            table[i] = value;
+        }
+        return table;
+    }();
+
+    crc = ~crc;
+    for (std::size_t i = 0; i < size; ++i) {
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+static void AppendBigEndian(std::vector<u8>& out, u32 value) {
+    out.push_back(static_cast<u8>(value >> 24));
+    out.push_back(static_cast<u8>(value >> 16));
+    out.push_back(static_cast<u8>(value >> 8));
+    out.push_back(static_cast<u8>(value));
+}
+
+static void AppendPngChunk(std::vector<u8>& out, const char type[4], const std::vector<u8>& data) {
+    AppendBigEndian(out, static_cast<u32>(data.size()));
+    const std::size_t type_offset = out.size();
+    out.insert(out.end(), type, type + 4);
+    out.insert(out.end(), data.begin(), data.end());
+    AppendBigEndian(out, ComputeCrc32(0, out.data() + type_offset, out.size() - type_offset));
+}
+
+/**
+ * Writes an RGBA8 image as PNG. There is no deflate implementation in the tree, so the image data
+ * is stored uncompressed; the files are meant for comparisons by tools, not for archiving.
+ */
+static bool WritePng(const std::string& path, u32 width, u32 height, const std::vector<u8>& rgba) {
+    // Every row is prefixed with its filter type, which is always "none"
+    const std::size_t row_size = width * 4;
+    std::vector<u8> image_data;
+    image_data.reserve((row_size + 1) * height);
+    for (u32 y = 0; y < height; ++y) {
+        image_data.push_back(0);
+        image_data.insert(image_data.end(), rgba.begin() + y * row_size,
+                          rgba.begin() + (y + 1) * row_size);
+    }
+
+    // zlib stream made of stored deflate blocks
+    constexpr std::size_t MAX_BLOCK_SIZE = 0xFFFF;
+    std::vector<u8> zlib_data{0x78, 0x01};
+    u32 adler_a = 1;
+    u32 adler_b = 0;
+    std::size_t offset = 0;
+    do {
+        const std::size_t block_size = std::min(MAX_BLOCK_SIZE, image_data.size() - offset);
+        const bool is_final = offset + block_size == image_data.size();
+        zlib_data.push_back(is_final ? 1 : 0);
+        zlib_data.push_back(static_cast<u8>(block_size));
+        zlib_data.push_back(static_cast<u8>(block_size >> 8));
+        zlib_data.push_back(static_cast<u8>(~block_size));
+        zlib_data.push_back(static_cast<u8>(~block_size >> 8));
+        for (std::size_t i = offset; i < offset + block_size; ++i) {
+            adler_a = (adler_a + image_data[i]) % 65521;
+            adler_b = (adler_b + adler_a) % 65521;
+        }
+        zlib_data.insert(zlib_data.end(), image_data.begin() + offset,
+                         image_data.begin() + offset + block_size);
+        offset += block_size;
+    } while (offset < image_data.size());
+    AppendBigEndian(zlib_data, (adler_b << 16) | adler_a);
+
+    std::vector<u8> header;
+    AppendBigEndian(header, width);
+    AppendBigEndian(header, height);
+    // 8 bits per channel, RGBA, default compression, filtering and no interlacing
+    header.insert(header.end(), {8, 6, 0, 0, 0});
+
+    std::vector<u8> png{0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    AppendPngChunk(png, "IHDR", header);
+    AppendPngChunk(png, "IDAT", zlib_data);
+    AppendPngChunk(png, "IEND", {});
+
+    FileUtil::IOFile file(path, "wb");
+    return file.WriteBytes(png.data(), png.size()) == png.size();
+}
+
+/// Writes both screens of a frame into one image, with the bottom screen centered below the top one
+static bool WriteFrame(const std::string& path,
+                       const std::array<Headless::ScreenFrame, 2>& screens) {
+    const u32 width = std::max(screens[0].width, screens[1].width);
+    const u32 height = screens[0].height + screens[1].height;
+    std::vector<u8> image(width * height * 4);
+
+    u32 top = 0;
+    for (const Headless::ScreenFrame& screen : screens) {
+        const u32 left = (width - screen.width) / 2;
+        for (u32 y = 0; y < screen.height; ++y) {
+            std::copy_n(&screen.pixels[y * screen.width * 4], screen.width * 4,
+                        &image[((top + y) * width + left) * 4]);
+        }
+        top += screen.height;
+    }
+
+    return WritePng(path, width, height, image);
+}
+
+/// Writes the results of a benchmark run in a format that can be compared across builds
+static bool WriteBenchmarkReport(const std::string& path, u64 program_id,
+                                 const std::string& movie, int frames, double wall_time,
+                                 double emulated_time, const Common::SubsystemTimes& times) {
+    using Seconds = std::chrono::duration<double>;
+
+    nlohmann::json subsystems;
+    double accounted_time = 0.0;
+    for (std::size_t i = 0; i < Common::NumSubsystems; ++i) {
+        const double time = std::chrono::duration_cast<Seconds>(times.self_time[i]).count();
+        accounted_time += time;
+        subsystems[Common::GetSubsystemName(static_cast<Common::Subsystem>(i))] = {
+            {"seconds", time},
+            {"calls", times.calls[i]},
+            {"share", time / wall_time},
+        };
+    }
+    // Everything outside of the measured subsystems, e.g. the frontend and scheduling
+    subsystems["other"] = {
+        {"seconds", wall_time - accounted_time},
+        {"share", (wall_time - accounted_time) / wall_time},
+    };
+
+    // Runs are only comparable when they replayed the same inputs
+    std::string movie_contents;
+    FileUtil::ReadFileToString(false, movie.c_str(), movie_contents);
+    const u64 movie_hash = Common::ComputeHash64(movie_contents.data(), movie_contents.size());
+
+    const nlohmann::json report = {
+        {"build", {{"branch", Common::g_scm_branch}, {"description", Common::g_scm_desc}}},
+        {"program_id", fmt::format("{:016X}", program_id)},
+        {"movie", {{"path", movie}, {"hash", fmt::format("{:016X}", movie_hash)}}},
+        {"settings",
+         {{"cpu_jit", Settings::values.use_cpu_jit},
+          {"shader_jit", Settings::values.use_shader_jit},
+          {"sw_rasterizer_threads", Settings::values.sw_rasterizer_threads},
+          {"vertex_shader_threads", Settings::values.vertex_shader_threads},
+          {"texture_decode_threads", Settings::values.texture_decode_threads},
+          {"asynchronous_gpu", Settings::values.use_asynchronous_gpu}}},
+        {"frames", frames},
+        {"wall_seconds", wall_time},
+        {"emulated_seconds", emulated_time},
+        {"fps", frames / wall_time},
+        {"speed", emulated_time / wall_time},
+        {"subsystems", subsystems},
+    };
+
+    const std::string contents = report.dump(4);
+    FileUtil::IOFile file(path, "w");
+    return file.WriteBytes(contents.data(), contents.size()) == contents.size();
+}
+
+/// Application entry point
+int main(int argc, char** argv) {
+    Common::DetachedTasks detached_tasks;
+    Config config;
+    int option_index = 0;
+    u64 num_frames = 0;
+    bool max_speed = false;
+    std::string dump_dir;
+    std::string movie_play;
+    std::string benchmark_report;
+
+    InitializeLogging();
+
+    char* endarg;
+#ifdef _WIN32
+    int argc_w;
+    auto argv_w = CommandLineToArgvW(GetCommandLineW(), &argc_w);
+
+    if (argv_w == nullptr) {
+        LOG_CRITICAL(Frontend, "Failed to get command line arguments");
+        return -1;
+    }
+#endif
+    std::string filepath;
+
+    static struct option long_options[] = {
+        {"frames", required_argument, 0, 'n'},
+        {"max-speed", no_argument, 0, 'm'},
+        {"dump-frames", required_argument, 0, 'd'},
+        {"movie-play", required_argument, 0, 'p'},
+        {"benchmark", required_argument, 0, 'b'},
+        {"help", no_argument, 0, 'h'},
+        {"version", no_argument, 0, 'v'},
+        {0, 0, 0, 0},
+    };
+
+    while (optind < argc) {
+        int arg = getopt_long(argc, argv, "n:md:p:b:hv", long_options, &option_index);
+        if (arg != -1) {
+            switch (static_cast<char>(arg)) {
+            case 'n':
+                errno = 0;
+                num_frames = strtoull(optarg, &endarg, 0);
+                if (endarg == optarg)
+                    errno = EINVAL;
+                if (errno != 0) {
+                    perror("--frames");
+                    exit(1);
+                }
+                break;
+            case 'm':
+                max_speed = true;
+                break;
+            case 'd':
+                dump_dir = optarg;
+                if (!dump_dir.empty() && dump_dir.back() != '/' && dump_dir.back() != '\\') {
+                    dump_dir += DIR_SEP;
+                }
+                break;
+            case 'p':
+                movie_play = optarg;
+                break;
+            case 'b':
+                benchmark_report = optarg;
+                break;
+            case 'h':
+                PrintHelp(argv[0]);
+                return 0;
+            case 'v':
+                PrintVersion();
+                return 0;
+            }
+        } else {
+#ifdef _WIN32
+            filepath = Common::UTF16ToUTF8(argv_w[optind]);
+#else
+            filepath = argv[optind];
+#endif
+            optind++;
+        }
+    }
+
+#ifdef _WIN32
+    LocalFree(argv_w);
+#endif
+
+    MicroProfileOnThreadCreate("EmuThread");
+    SCOPE_EXIT({ MicroProfileShutdown(); });
+
+    if (filepath.empty()) {
+        LOG_CRITICAL(Frontend, "Failed to load ROM: No ROM specified");
+        return -1;
+    }
+
+    if (!dump_dir.empty() && !FileUtil::CreateFullPath(dump_dir)) {
+        LOG_CRITICAL(Frontend, "Failed to create the frame dump directory {}", dump_dir);
+        return -1;
+    }
+
+    if (!benchmark_report.empty()) {
+        if (num_frames == 0) {
+            LOG_CRITICAL(Frontend, "Benchmarks need a fixed number of frames");
+            return -1;
+        }
+        if (movie_play.empty()) {
+            LOG_CRITICAL(Frontend, "Benchmarks need a movie to play the inputs from");
+            return -1;
+        }
+        max_speed = true;
+
+        // Make runs reproducible: the clock is taken from the movie
+        Settings::values.init_clock = Settings::InitClock::FixedTime;
+        Settings::values.snapshot_interval = 0;
+        Common::SetSubsystemTimersEnabled(true);
+    }
+
+    if (!movie_play.empty()) {
+        Core::Movie::GetInstance().PrepareForPlayback(movie_play);
+    }
+
+    // There is no display, audio device or input device
+    Settings::values.use_headless_renderer = true;
+    Settings::values.use_hw_renderer = false;
+    Settings::values.sink_id = "null";
+    Settings::values.use_frame_limit = !max_speed;
+    Settings::values.frame_limit = 100;
+    Settings::values.use_gdbstub = false;
+    for (auto& button : Settings::values.current_input_profile.buttons) {
+        button.clear();
+    }
+    for (auto& analog : Settings::values.current_input_profile.analogs) {
+        analog.clear();
+    }
+    Settings::values.current_input_profile.motion_device.clear();
+    Settings::values.current_input_profile.touch_device.clear();
+    Settings::Apply();
+
+    // Register frontend applets
+    Frontend::RegisterDefaultApplets();
+
+    EmuWindow_Headless emu_window;
+
+    Core::System& system{Core::System::GetInstance()};
+
+    SCOPE_EXIT({ system.Shutdown(); });
+
+    const Core::System::ResultStatus load_result{system.Load(emu_window, filepath)};
+    if (load_result != Core::System::ResultStatus::Success) {
+        LOG_CRITICAL(Frontend, "Failed to load {} (Error {})", filepath,
+                     static_cast<u32>(load_result));
+        return -1;
+    }
+
+    Core::Telemetry().AddField(Telemetry::FieldType::App, "Frontend", "Headless");
+
+    auto& renderer = static_cast<Headless::RendererHeadless&>(*VideoCore::g_renderer);
+    if (!dump_dir.empty()) {
+        renderer.SetFrameCallback([&dump_dir, &renderer](const auto& screens) {
+            const std::string path =
+                fmt::format("{}{:06d}.png", dump_dir, renderer.GetCurrentFrame());
+            if (!WriteFrame(path, screens)) {
+                LOG_ERROR(Frontend, "Failed to write frame {}", path);
+            }
+        });
+    }
+
+    if (!movie_play.empty()) {
+        Core::Movie::GetInstance().StartPlayback(movie_play);
+    }
+
+    Common::ResetSubsystemTimes();
+    const auto start_time = std::chrono::steady_clock::now();
+    while (num_frames == 0 || static_cast<u64>(renderer.GetCurrentFrame()) < num_frames) {
+        if (system.RunLoop() != Core::System::ResultStatus::Success) {
+            break;
+        }
+    }
+    const auto wall_time = std::chrono::duration_cast<std::chrono::duration<double>>(
+                               std::chrono::steady_clock::now() - start_time)
+                               .count();
+
+    const int frames = renderer.GetCurrentFrame();
+    const double emulated_time = system.CoreTiming().GetGlobalTimeUs().count() / 1000000.0;
+    std::cout << fmt::format("Emulated {} frames ({:.3f} s) in {:.3f} s: {:.2f} FPS, {:.1f}% speed",
+                             frames, emulated_time, wall_time, frames / wall_time,
+                             emulated_time / wall_time * 100.0)
+              << std::endl;
+
+    if (!benchmark_report.empty()) {
+        u64 program_id = 0;
+        system.GetAppLoader().ReadProgramId(program_id);
+        if (!WriteBenchmarkReport(benchmark_report, program_id, movie_play, frames, wall_time,
+                                  emulated_time, Common::GetSubsystemTimes())) {
+            LOG_ERROR(Frontend, "Failed to write the benchmark report to {}", benchmark_report);
+        }
+    }
+
+    Core::Movie::GetInstance().Shutdown();
+
+    detached_tasks.WaitForAllTasks();
+    return 0;
+}
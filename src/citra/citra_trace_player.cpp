@@ -0,0 +1,527 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+// This needs to be included before getopt.h because the latter #defines symbols used by it
+#include "common/microprofile.h"
+
+#include <getopt.h>
+#ifndef _MSC_VER
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+// windows.h needs to be included before shellapi.h
+#include <windows.h>
+
+#include <shellapi.h>
+#endif
+
+#include <fmt/format.h>
+#include <json.hpp>
+#include "citra/config.h"
+#include "citra/emu_window/emu_window_headless.h"
+#include "common/common_paths.h"
+#include "common/file_util.h"
+#include "common/hash.h"
+#include "common/logging/backend.h"
+#include "common/logging/filter.h"
+#include "common/logging/log.h"
+#include "common/scm_rev.h"
+#include "common/scope_exit.h"
+#include "common/string_util.h"
+#include "core/hw/gpu.h"
+#include "core/hw/hw.h"
+#include "core/hw/lcd.h"
+#include "core/memory.h"
+#include "core/settings.h"
+#include "core/tracer/citrace.h"
+#include "video_core/gpu_thread.h"
+#include "video_core/pica_state.h"
+#include "video_core/renderer_headless/renderer_headless.h"
+#include "video_core/video_core.h"
+
+static void PrintHelp(const char* argv0) {
+    std::cout << "Usage: " << argv0
+              << " [options] <filename>\n"
+                 "-l, --loops=NUMBER    Replay the trace NUMBER times, starting over from its\n"
+                 "                      initial state each time\n"
+                 "-q, --quiet           Only print the totals instead of every frame\n"
+                 "-b, --benchmark=FILE  Write a JSON report of the replayed frames to FILE\n"
+                 "-h, --help            Display this help and exit\n"
+                 "-v, --version         Output version information and exit\n";
+}
+
+static void PrintVersion() {
+    std::cout << "Citra " << Common::g_scm_branch << " " << Common::g_scm_desc << std::endl;
+}
+
+static void InitializeLogging() {
+    Log::Filter log_filter(Log::Level::Debug);
+    log_filter.ParseFilterString(Settings::values.log_filter);
+    Log::SetGlobalFilter(log_filter);
+
+    Log::AddBackend(std::make_unique<Log::ColorConsoleBackend>());
+
+    const std::string& log_dir = FileUtil::GetUserPath(FileUtil::UserPath::LogDir);
+    FileUtil::CreateFullPath(log_dir);
+    Log::AddBackend(std::make_unique<Log::FileBackend>(log_dir + LOG_FILE));
+#ifdef _WIN32
+    Log::AddBackend(std::make_unique<Log::DebuggerBackend>());
+#endif
+}
+
+/// A CiTrace file, as written by CiTrace::Recorder
+struct Trace {
+    std::vector<u8> data;
+    CiTrace::CTHeader header;
+    std::vector<CiTrace::CTStreamElement> stream;
+};
+
+/// Replay results of one frame of a trace
+struct FrameResult {
+    double seconds;
+    /// Hashes of the pixels displayed on the top and bottom screens at the end of the frame
+    std::array<u64, 2> screen_hashes;
+};
+
+/// Returns whether the given number of u32 words at the given file offset are part of the trace
+static bool ContainsWords(const Trace& trace, u32 offset, u32 size) {
+    return offset <= trace.data.size() && size <= (trace.data.size() - offset) / sizeof(u32);
+}
+
+static bool LoadTrace(const std::string& path, Trace& trace) {
+    FileUtil::IOFile file(path, "rb");
+    if (!file.IsOpen()) {
+        LOG_CRITICAL(Frontend, "Failed to open {}", path);
+        return false;
+    }
+    trace.data.resize(file.GetSize());
+    if (file.ReadBytes(trace.data.data(), trace.data.size()) != trace.data.size()) {
+        LOG_CRITICAL(Frontend, "Failed to read {}", path);
+        return false;
+    }
+
+    if (trace.data.size() < sizeof(trace.header)) {
+        LOG_CRITICAL(Frontend, "{} is too small to be a CiTrace", path);
+        return false;
+    }
+    std::memcpy(&trace.header, trace.data.data(), sizeof(trace.header));
+    const auto& header = trace.header;
+    if (std::memcmp(header.magic, CiTrace::CTHeader::ExpectedMagicWord(), 4) != 0 ||
+        header.version != CiTrace::CTHeader::ExpectedVersion()) {
+        LOG_CRITICAL(Frontend, "{} is not a CiTrace of version {}", path,
+                     CiTrace::CTHeader::ExpectedVersion());
+        return false;
+    }
+
+    const auto& initial = header.initial_state_offsets;
+    if (!ContainsWords(trace, initial.gpu_registers, initial.gpu_registers_size) ||
+        !ContainsWords(trace, initial.lcd_registers, initial.lcd_registers_size) ||
+        !ContainsWords(trace, initial.pica_registers, initial.pica_registers_size) ||
+        !ContainsWords(trace, initial.default_attributes, initial.default_attributes_size) ||
+        !ContainsWords(trace, initial.vs_program_binary, initial.vs_program_binary_size) ||
+        !ContainsWords(trace, initial.vs_swizzle_data, initial.vs_swizzle_data_size) ||
+        !ContainsWords(trace, initial.vs_float_uniforms, initial.vs_float_uniforms_size) ||
+        !ContainsWords(trace, initial.gs_program_binary, initial.gs_program_binary_size) ||
+        !ContainsWords(trace, initial.gs_swizzle_data, initial.gs_swizzle_data_size) ||
+        !ContainsWords(trace, initial.gs_float_uniforms, initial.gs_float_uniforms_size)) {
+        LOG_CRITICAL(Frontend, "The initial state of {} is truncated", path);
+        return false;
+    }
+
+    constexpr std::size_t element_size = sizeof(CiTrace::CTStreamElement);
+    if (header.stream_offset > trace.data.size() ||
+        header.stream_size > (trace.data.size() - header.stream_offset) / element_size) {
+        LOG_CRITICAL(Frontend, "The stream of {} is truncated", path);
+        return false;
+    }
+    trace.stream.resize(header.stream_size);
+    std::memcpy(trace.stream.data(), trace.data.data() + header.stream_offset,
+                trace.stream.size() * element_size);
+
+    for (const auto& element : trace.stream) {
+        if (element.type != CiTrace::MemoryLoad) {
+            continue;
+        }
+        const auto& load = element.memory_load;
+        if (load.file_offset > trace.data.size() ||
+            load.size > trace.data.size() - load.file_offset) {
+            LOG_CRITICAL(Frontend, "The memory load at {:#X} of {} is truncated", load.file_offset,
+                         path);
+            return false;
+        }
+    }
+    return true;
+}
+
+/// Copies at most dest_size words of the initial state at the given file offset
+static void RestoreWords(const Trace& trace, u32 offset, u32 size, void* dest,
+                         std::size_t dest_size) {
+    std::memcpy(dest, trace.data.data() + offset, std::min<std::size_t>(size, dest_size) * 4);
+}
+
+/// Reads the i-th word of the initial state at the given file offset, as a float24
+static Pica::float24 ReadFloat24(const Trace& trace, u32 offset, std::size_t i) {
+    u32 value;
+    std::memcpy(&value, trace.data.data() + offset + i * sizeof(u32), sizeof(u32));
+    return Pica::float24::FromRaw(value);
+}
+
+static void RestoreShaderSetup(const Trace& trace, u32 program_offset, u32 program_size,
+                               u32 swizzle_offset, u32 swizzle_size, u32 uniforms_offset,
+                               u32 uniforms_size, Pica::Shader::ShaderSetup& setup) {
+    RestoreWords(trace, program_offset, program_size, setup.program_code.data(),
+                 setup.program_code.size());
+    RestoreWords(trace, swizzle_offset, swizzle_size, setup.swizzle_data.data(),
+                 setup.swizzle_data.size());
+    setup.MarkProgramCodeDirty();
+    setup.MarkSwizzleDataDirty();
+
+    // The uniforms are stored as four float24 components each
+    const std::size_t num_uniforms = std::min<std::size_t>(uniforms_size / 4, 96);
+    for (std::size_t i = 0; i < num_uniforms; ++i) {
+        for (std::size_t comp = 0; comp < 4; ++comp) {
+            setup.uniforms.f[i][comp] = ReadFloat24(trace, uniforms_offset, 4 * i + comp);
+        }
+    }
+}
+
+/**
+ * Fragment lighting, fog and procedural texture lookup tables aren't part of CiTraces, every replay
+ * starts from the ones the first replay started with
+ */
+struct LookupTables {
+    Pica::State::ProcTex proctex;
+    Pica::State::Lighting lighting;
+    decltype(Pica::State::fog) fog;
+};
+
+/// Restores the GPU state at the start of the trace
+static void RestoreInitialState(const Trace& trace, const LookupTables& lookup_tables) {
+    Pica::g_state.proctex = lookup_tables.proctex;
+    Pica::g_state.lighting = lookup_tables.lighting;
+    Pica::g_state.fog = lookup_tables.fog;
+
+    const auto& initial = trace.header.initial_state_offsets;
+    RestoreWords(trace, initial.gpu_registers, initial.gpu_registers_size, &GPU::g_regs,
+                 GPU::Regs::NumIds());
+    RestoreWords(trace, initial.lcd_registers, initial.lcd_registers_size, &LCD::g_regs,
+                 LCD::Regs::NumIds());
+    RestoreWords(trace, initial.pica_registers, initial.pica_registers_size,
+                 Pica::g_state.regs.reg_array.data(), Pica::Regs::NUM_REGS);
+
+    auto& default_attributes = Pica::g_state.input_default_attributes;
+    const std::size_t num_attributes = std::min<std::size_t>(initial.default_attributes_size / 4,
+                                                             std::size(default_attributes.attr));
+    for (std::size_t i = 0; i < num_attributes; ++i) {
+        for (std::size_t comp = 0; comp < 4; ++comp) {
+            default_attributes.attr[i][comp] =
+                ReadFloat24(trace, initial.default_attributes, 4 * i + comp);
+        }
+    }
+
+    RestoreShaderSetup(trace, initial.vs_program_binary, initial.vs_program_binary_size,
+                       initial.vs_swizzle_data, initial.vs_swizzle_data_size,
+                       initial.vs_float_uniforms, initial.vs_float_uniforms_size,
+                       Pica::g_state.vs);
+    RestoreShaderSetup(trace, initial.gs_program_binary, initial.gs_program_binary_size,
+                       initial.gs_swizzle_data, initial.gs_swizzle_data_size,
+                       initial.gs_float_uniforms, initial.gs_float_uniforms_size,
+                       Pica::g_state.gs);
+}
+
+/**
+ * Replays the stream of a trace, calling on_frame at the end of each frame. Memory loads are
+ * written to emulated memory as the CPU would have, register writes go through the same handlers
+ * as the writes of the CPU, so command lists are run by Pica::CommandProcessor.
+ */
+template <typename OnFrame>
+static void ReplayStream(const Trace& trace, Memory::MemorySystem& memory, OnFrame&& on_frame) {
+    for (const auto& element : trace.stream) {
+        switch (element.type) {
+        case CiTrace::FrameMarker:
+            on_frame();
+            break;
+
+        case CiTrace::MemoryLoad: {
+            const auto& load = element.memory_load;
+            if (load.size == 0) {
+                break;
+            }
+            if (!memory.IsValidPhysicalAddress(load.physical_address) ||
+                !memory.IsValidPhysicalAddress(load.physical_address + load.size - 1)) {
+                LOG_ERROR(Frontend, "Memory load to invalid range {:08X}+{:X}",
+                          load.physical_address, load.size);
+                break;
+            }
+            std::memcpy(memory.GetPhysicalPointer(load.physical_address),
+                        trace.data.data() + load.file_offset, load.size);
+            Memory::RasterizerInvalidateRegion(load.physical_address, load.size);
+            break;
+        }
+
+        case CiTrace::RegisterWrite: {
+            const auto& write = element.register_write;
+            // The recorder logs registers by their physical address
+            const VAddr address =
+                write.physical_address - Memory::IO_AREA_PADDR + Memory::IO_AREA_VADDR;
+            switch (write.size) {
+            case CiTrace::CTRegisterWrite::SIZE_8:
+                HW::Write<u8>(address, static_cast<u8>(write.value));
+                break;
+            case CiTrace::CTRegisterWrite::SIZE_16:
+                HW::Write<u16>(address, static_cast<u16>(write.value));
+                break;
+            case CiTrace::CTRegisterWrite::SIZE_32:
+                HW::Write<u32>(address, static_cast<u32>(write.value));
+                break;
+            case CiTrace::CTRegisterWrite::SIZE_64:
+                HW::Write<u64>(address, write.value);
+                break;
+            default:
+                LOG_ERROR(Frontend, "Register write of unknown size {:#X}",
+                          static_cast<u32>(write.size));
+                break;
+            }
+            break;
+        }
+
+        default:
+            LOG_ERROR(Frontend, "Unknown stream element type {:#X}",
+                      static_cast<u32>(element.type));
+            break;
+        }
+    }
+}
+
+/// Writes the results of a replay in a format that can be compared across builds
+static bool WriteBenchmarkReport(const std::string& path, const std::string& trace_path, u32 loops,
+                                 double wall_time, const std::vector<FrameResult>& frames) {
+    nlohmann::json frame_reports = nlohmann::json::array();
+    for (const FrameResult& frame : frames) {
+        frame_reports.push_back({
+            {"seconds", frame.seconds},
+            {"top_hash", fmt::format("{:016X}", frame.screen_hashes[0])},
+            {"bottom_hash", fmt::format("{:016X}", frame.screen_hashes[1])},
+        });
+    }
+
+    const nlohmann::json report = {
+        {"build", {{"branch", Common::g_scm_branch}, {"description", Common::g_scm_desc}}},
+        {"trace", trace_path},
+        {"settings",
+         {{"shader_jit", Settings::values.use_shader_jit},
+          {"sw_rasterizer_threads", Settings::values.sw_rasterizer_threads},
+          {"vertex_shader_threads", Settings::values.vertex_shader_threads},
+          {"texture_decode_threads", Settings::values.texture_decode_threads}}},
+        {"loops", loops},
+        {"wall_seconds", wall_time},
+        {"fps", frames.size() / wall_time},
+        {"frames", frame_reports},
+    };
+
+    const std::string contents = report.dump(4);
+    FileUtil::IOFile file(path, "w");
+    return file.WriteBytes(contents.data(), contents.size()) == contents.size();
+}
+
+/// Application entry point
+int main(int argc, char** argv) {
+    Config config;
+    int option_index = 0;
+    u32 loops = 1;
+    bool quiet = false;
+    std::string benchmark_report;
+
+    InitializeLogging();
+
+    char* endarg;
+#ifdef _WIN32
+    int argc_w;
+    auto argv_w = CommandLineToArgvW(GetCommandLineW(), &argc_w);
+
+    if (argv_w == nullptr) {
+        LOG_CRITICAL(Frontend, "Failed to get command line arguments");
+        return -1;
+    }
+#endif
+    std::string filepath;
+
+    static struct option long_options[] = {
+        {"loops", required_argument, 0, 'l'},
+        {"quiet", no_argument, 0, 'q'},
+        {"benchmark", required_argument, 0, 'b'},
+        {"help", no_argument, 0, 'h'},
+        {"version", no_argument, 0, 'v'},
+        {0, 0, 0, 0},
+    };
+
+    while (optind < argc) {
+        int arg = getopt_long(argc, argv, "l:qb:hv", long_options, &option_index);
+        if (arg != -1) {
+            switch (static_cast<char>(arg)) {
+            case 'l':
+                errno = 0;
+                loops = static_cast<u32>(strtoul(optarg, &endarg, 0));
+                if (endarg == optarg || loops == 0)
+                    errno = EINVAL;
+                if (errno != 0) {
+                    perror("--loops");
+                    exit(1);
+                }
+                break;
+            case 'q':
+                quiet = true;
+                break;
+            case 'b':
+                benchmark_report = optarg;
+                break;
+            case 'h':
+                PrintHelp(argv[0]);
+                return 0;
+            case 'v':
+                PrintVersion();
+                return 0;
+            }
+        } else {
+#ifdef _WIN32
+            filepath = Common::UTF16ToUTF8(argv_w[optind]);
+#else
+            filepath = argv[optind];
+#endif
+            optind++;
+        }
+    }
+
+#ifdef _WIN32
+    LocalFree(argv_w);
+#endif
+
+    MicroProfileOnThreadCreate("EmuThread");
+    SCOPE_EXIT({ MicroProfileShutdown(); });
+
+    if (filepath.empty()) {
+        LOG_CRITICAL(Frontend, "No trace specified");
+        return -1;
+    }
+
+    Trace trace;
+    if (!LoadTrace(filepath, trace)) {
+        return -1;
+    }
+
+    // Everything is rasterized in software on this thread, so that replays are deterministic
+    Settings::values.use_headless_renderer = true;
+    Settings::values.use_hw_renderer = false;
+    Settings::values.use_asynchronous_gpu = false;
+    Settings::values.use_gdbstub = false;
+    Settings::Apply();
+
+    // Only the GPU is emulated, the trace contains all the memory it reads. There is no GSP
+    // service to deliver the interrupts the GPU raises to.
+    VideoCore::g_gpu_interrupts_enabled = false;
+    Memory::MemorySystem memory;
+    GPU::InitRegisters(memory);
+    LCD::Init();
+
+    EmuWindow_Headless emu_window;
+    if (VideoCore::Init(emu_window, memory) != Core::System::ResultStatus::Success) {
+        LOG_CRITICAL(Frontend, "Failed to initialize the video core");
+        return -1;
+    }
+    SCOPE_EXIT({ VideoCore::Shutdown(); });
+
+    auto& renderer = static_cast<Headless::RendererHeadless&>(*VideoCore::g_renderer);
+
+    using Clock = std::chrono::steady_clock;
+    using Seconds = std::chrono::duration<double>;
+    std::vector<FrameResult> frames;
+    std::size_t mismatches = 0;
+    const std::size_t frames_per_loop = std::count_if(
+        trace.stream.begin(), trace.stream.end(),
+        [](const auto& element) { return element.type == CiTrace::FrameMarker; });
+    frames.reserve(frames_per_loop * loops);
+
+    const auto lookup_tables = std::make_unique<LookupTables>(
+        LookupTables{Pica::g_state.proctex, Pica::g_state.lighting, Pica::g_state.fog});
+
+    std::array<Headless::ScreenFrame, 2> screens;
+    const auto start_time = Clock::now();
+    for (u32 loop = 0; loop < loops; ++loop) {
+        RestoreInitialState(trace, *lookup_tables);
+
+        auto frame_start = Clock::now();
+        ReplayStream(trace, memory, [&] {
+            const Seconds frame_time = Clock::now() - frame_start;
+
+            FrameResult frame{frame_time.count()};
+            for (std::size_t i = 0; i < screens.size(); ++i) {
+                renderer.LoadScreen(i, screens[i]);
+                frame.screen_hashes[i] =
+                    Common::ComputeHash64(screens[i].pixels.data(), screens[i].pixels.size());
+            }
+
+            // Replays are deterministic, every loop has to display the same frames
+            const std::size_t index = frames.size();
+            if (index >= frames_per_loop &&
+                frames[index % frames_per_loop].screen_hashes != frame.screen_hashes) {
+                LOG_ERROR(Frontend, "Frame {} of loop {} differs from the first loop",
+                          index % frames_per_loop, loop);
+                ++mismatches;
+            }
+
+            if (!quiet) {
+                std::cout << fmt::format("Frame {:5}: {:8.3f} ms, top {:016X}, bottom {:016X}",
+                                         index, frame.seconds * 1000.0, frame.screen_hashes[0],
+                                         frame.screen_hashes[1])
+                          << std::endl;
+            }
+            frames.push_back(frame);
+
+            // Reading back the screens is not part of the next frame
+            frame_start = Clock::now();
+        });
+    }
+    const double wall_time = Seconds(Clock::now() - start_time).count();
+
+    if (frames.empty()) {
+        std::cout << fmt::format("Replayed a trace without frames in {:.3f} s", wall_time)
+                  << std::endl;
+    } else {
+        double total_frame_time = 0.0;
+        for (const FrameResult& frame : frames) {
+            total_frame_time += frame.seconds;
+        }
+        const double average_frame_time = total_frame_time / frames.size();
+        const auto [fastest, slowest] =
+            std::minmax_element(frames.begin(), frames.end(), [](const auto& lhs, const auto& rhs) {
+                return lhs.seconds < rhs.seconds;
+            });
+        std::cout << fmt::format("Replayed {} frames in {:.3f} s: {:.2f} FPS, frame times "
+                                 "{:.3f} ms min, {:.3f} ms avg, {:.3f} ms max",
+                                 frames.size(), wall_time, frames.size() / wall_time,
+                                 fastest->seconds * 1000.0, average_frame_time * 1000.0,
+                                 slowest->seconds * 1000.0)
+                  << std::endl;
+    }
+
+    if (!benchmark_report.empty() &&
+        !WriteBenchmarkReport(benchmark_report, filepath, loops, wall_time, frames)) {
+        LOG_ERROR(Frontend, "Failed to write the benchmark report to {}", benchmark_report);
+    }
+
+    return mismatches == 0 ? 0 : 1;
+}
@@ -6,16 +6,15 @@
 #include <memory>
 #include <sstream>
 #include <unordered_map>
-#include <SDL.h>
 #include <inih/cpp/INIReader.h>
 #include "citra/config.h"
+#include "citra/default_input.h"
 #include "citra/default_ini.h"
 #include "common/file_util.h"
 #include "common/logging/log.h"
 #include "common/param_package.h"
 #include "core/hle/service/service.h"
 #include "core/settings.h"
-#include "input_common/main.h"
 #include "input_common/udp/client.h"
 
 Config::Config() {
@@ -46,34 +45,11 @@ bool Config::LoadINI(const std::string& default_contents, bool retry) {
     return true;
 }
 
-static const std::array<int, Settings::NativeButton::NumButtons> default_buttons = {
-    SDL_SCANCODE_A, SDL_SCANCODE_S, SDL_SCANCODE_Z, SDL_SCANCODE_X, SDL_SCANCODE_T, SDL_SCANCODE_G,
-    SDL_SCANCODE_F, SDL_SCANCODE_H, SDL_SCANCODE_Q, SDL_SCANCODE_W, SDL_SCANCODE_M, SDL_SCANCODE_N,
-    SDL_SCANCODE_O, SDL_SCANCODE_P, SDL_SCANCODE_1, SDL_SCANCODE_2, SDL_SCANCODE_B,
-};
-
-static const std::array<std::array<int, 5>, Settings::NativeAnalog::NumAnalogs> default_analogs{{
-    {
-        SDL_SCANCODE_UP,
-        SDL_SCANCODE_DOWN,
-        SDL_SCANCODE_LEFT,
-        SDL_SCANCODE_RIGHT,
-        SDL_SCANCODE_D,
-    },
-    {
-        SDL_SCANCODE_I,
-        SDL_SCANCODE_K,
-        SDL_SCANCODE_J,
-        SDL_SCANCODE_L,
-        SDL_SCANCODE_D,
-    },
-}};
-
 void Config::ReadValues() {
     // Controls
     // TODO: add multiple input profile support
     for (int i = 0; i < Settings::NativeButton::NumButtons; ++i) {
-        std::string default_param = InputCommon::GenerateKeyboardParam(default_buttons[i]);
+        std::string default_param = DefaultInput::GetButtonParam(i);
         Settings::values.current_input_profile.buttons[i] =
             sdl2_config->GetString("Controls", Settings::NativeButton::mapping[i], default_param);
         if (Settings::values.current_input_profile.buttons[i].empty())
@@ -81,9 +57,7 @@ void Config::ReadValues() {
     }
 
     for (int i = 0; i < Settings::NativeAnalog::NumAnalogs; ++i) {
-        std::string default_param = InputCommon::GenerateAnalogParamFromKeys(
-            default_analogs[i][0], default_analogs[i][1], default_analogs[i][2],
-            default_analogs[i][3], default_analogs[i][4], 0.5f);
+        std::string default_param = DefaultInput::GetAnalogParam(i);
         Settings::values.current_input_profile.analogs[i] =
             sdl2_config->GetString("Controls", Settings::NativeAnalog::mapping[i], default_param);
         if (Settings::values.current_input_profile.analogs[i].empty())
@@ -103,6 +77,12 @@ void Config::ReadValues() {
 
     // Core
     Settings::values.use_cpu_jit = sdl2_config->GetBoolean("Core", "use_cpu_jit", true);
+    Settings::values.snapshot_interval =
+        static_cast<u32>(sdl2_config->GetInteger("Core", "snapshot_interval", 0));
+    Settings::values.snapshot_keyframe_interval =
+        static_cast<u32>(sdl2_config->GetInteger("Core", "snapshot_keyframe_interval", 10));
+    Settings::values.skip_idle_loops = sdl2_config->GetBoolean("Core", "skip_idle_loops", false);
+    Settings::values.idle_loop_titles = sdl2_config->GetString("Core", "idle_loop_titles", "");
 
     // Renderer
     Settings::values.use_gles = sdl2_config->GetBoolean("Renderer", "use_gles", false);
@@ -120,6 +100,18 @@ void Config::ReadValues() {
     Settings::values.shaders_accurate_mul =
         sdl2_config->GetBoolean("Renderer", "shaders_accurate_mul", false);
     Settings::values.use_shader_jit = sdl2_config->GetBoolean("Renderer", "use_shader_jit", true);
+    Settings::values.use_disk_shader_cache =
+        sdl2_config->GetBoolean("Renderer", "use_disk_shader_cache", true);
+    Settings::values.sw_rasterizer_threads =
+        static_cast<u16>(sdl2_config->GetInteger("Renderer", "sw_rasterizer_threads", 1));
+    Settings::values.vertex_shader_threads =
+        static_cast<u16>(sdl2_config->GetInteger("Renderer", "vertex_shader_threads", 1));
+    Settings::values.texture_decode_threads =
+        static_cast<u16>(sdl2_config->GetInteger("Renderer", "texture_decode_threads", 1));
+    Settings::values.surface_cache_budget =
+        static_cast<u16>(sdl2_config->GetInteger("Renderer", "surface_cache_budget", 0));
+    Settings::values.use_asynchronous_gpu =
+        sdl2_config->GetBoolean("Renderer", "use_asynchronous_gpu", false);
     Settings::values.resolution_factor =
         static_cast<u16>(sdl2_config->GetInteger("Renderer", "resolution_factor", 1));
     Settings::values.vsync_enabled = sdl2_config->GetBoolean("Renderer", "vsync_enabled", false);
@@ -91,6 +91,23 @@ udp_pad_index=
 # 0: Interpreter (slow), 1 (default): JIT (fast)
 use_cpu_jit =
 
+# Seconds of emulated time between snapshots of the emulated system, used for rewinding. The latest
+# snapshots are kept when the emulator exits, so that a session which crashed can be resumed.
+# 0 (default): Disabled
+snapshot_interval =
+
+# Number of snapshots after which a full snapshot is taken. The ones in between only store the
+# memory pages that changed. Default: 10
+snapshot_keyframe_interval =
+
+# Whether to skip ahead in time when a title busy-waits, saving the host CPU time spent on it
+# 0 (default): Off, 1: On
+skip_idle_loops =
+
+# Comma separated program IDs of the titles to skip idle loops in, in hexadecimal
+# Empty (default): Every title
+idle_loop_titles =
+
 [Renderer]
 # Whether to render using GLES or OpenGL
 # 0 (default): OpenGL, 1: GLES
@@ -116,6 +133,32 @@ shaders_accurate_gs =
 # 0: Interpreter (slow), 1 (default): JIT (fast)
 use_shader_jit =
 
+# Whether to store the shaders compiled by the shader JIT on disk and precompile them on boot
+# 0: Off, 1 (default): On
+use_disk_shader_cache =
+
+# Number of threads the software renderer rasterizes screen tiles on
+# 0: Auto (one per host thread), 1 (default): Single-threaded, Otherwise the number of threads
+sw_rasterizer_threads =
+
+# Number of threads vertices are shaded on when they are not processed by the host GPU
+# 0: Auto (one per host thread), 1 (default): Single-threaded, Otherwise the number of threads
+vertex_shader_threads =
+
+# Number of threads textures are converted on when they are loaded to or flushed from the host GPU
+# 0: Auto (one per host thread), 1 (default): Single-threaded, Otherwise the number of threads
+texture_decode_threads =
+
+# Host GPU memory in MiB the surfaces of the hardware renderer may take before the least recently
+# used ones are evicted
+# 0 (default): Unlimited, Otherwise the budget in MiB
+surface_cache_budget =
+
+# Whether to emulate the GPU on a thread of its own, overlapping it with CPU emulation. Only used
+# with the software renderer
+# 0 (default): Off, 1: On
+use_asynchronous_gpu =
+
 # Resolution scale factor
 # 0: Auto (scales resolution to window size), 1: Native 3DS screen resolution, Otherwise a scale
 # factor for the 3DS resolution
@@ -0,0 +1,19 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <string>
+
+// The default bindings depend on the keys of the frontend's window, so each frontend links its
+// own implementation of these functions.
+namespace DefaultInput {
+
+/// Returns the param package of the default binding of a button, or an empty string if none
+std::string GetButtonParam(int button);
+
+/// Returns the param package of the default binding of an analog stick, or an empty string if none
+std::string GetAnalogParam(int analog);
+
+} // namespace DefaultInput
@@ -0,0 +1,19 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include "citra/default_input.h"
+
+// The headless window has no keyboard, so nothing is bound unless the configuration says so
+
+namespace DefaultInput {
+
+std::string GetButtonParam(int button) {
+    return {};
+}
+
+std::string GetAnalogParam(int analog) {
+    return {};
+}
+
+} // namespace DefaultInput
@@ -0,0 +1,46 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <array>
+#include <SDL.h>
+#include "citra/default_input.h"
+#include "core/settings.h"
+#include "input_common/main.h"
+
+namespace DefaultInput {
+
+static const std::array<int, Settings::NativeButton::NumButtons> default_buttons = {
+    SDL_SCANCODE_A, SDL_SCANCODE_S, SDL_SCANCODE_Z, SDL_SCANCODE_X, SDL_SCANCODE_T, SDL_SCANCODE_G,
+    SDL_SCANCODE_F, SDL_SCANCODE_H, SDL_SCANCODE_Q, SDL_SCANCODE_W, SDL_SCANCODE_M, SDL_SCANCODE_N,
+    SDL_SCANCODE_O, SDL_SCANCODE_P, SDL_SCANCODE_1, SDL_SCANCODE_2, SDL_SCANCODE_B,
+};
+
+static const std::array<std::array<int, 5>, Settings::NativeAnalog::NumAnalogs> default_analogs{{
+    {
+        SDL_SCANCODE_UP,
+        SDL_SCANCODE_DOWN,
+        SDL_SCANCODE_LEFT,
+        SDL_SCANCODE_RIGHT,
+        SDL_SCANCODE_D,
+    },
+    {
+        SDL_SCANCODE_I,
+        SDL_SCANCODE_K,
+        SDL_SCANCODE_J,
+        SDL_SCANCODE_L,
+        SDL_SCANCODE_D,
+    },
+}};
+
+std::string GetButtonParam(int button) {
+    return InputCommon::GenerateKeyboardParam(default_buttons[button]);
+}
+
+std::string GetAnalogParam(int analog) {
+    const auto& keys = default_analogs[analog];
+    return InputCommon::GenerateAnalogParamFromKeys(keys[0], keys[1], keys[2], keys[3], keys[4],
+                                                    0.5f);
+}
+
+} // namespace DefaultInput
@@ -0,0 +1,27 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include "citra/emu_window/emu_window_headless.h"
+#include "common/logging/log.h"
+#include "common/scm_rev.h"
+#include "core/3ds.h"
+#include "core/settings.h"
+
+EmuWindow_Headless::EmuWindow_Headless() {
+    UpdateCurrentFramebufferLayout(Core::kScreenTopWidth,
+                                   Core::kScreenTopHeight + Core::kScreenBottomHeight);
+    LOG_INFO(Frontend, "Citra Version: {} | {}-{}", Common::g_build_fullname, Common::g_scm_branch,
+             Common::g_scm_desc);
+    Settings::LogSettings();
+}
+
+EmuWindow_Headless::~EmuWindow_Headless() = default;
+
+void EmuWindow_Headless::SwapBuffers() {}
+
+void EmuWindow_Headless::PollEvents() {}
+
+void EmuWindow_Headless::MakeCurrent() {}
+
+void EmuWindow_Headless::DoneCurrent() {}
@@ -0,0 +1,26 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include "core/frontend/emu_window.h"
+
+/// Window without any display, graphics context or input devices, used with the headless renderer
+class EmuWindow_Headless : public EmuWindow {
+public:
+    EmuWindow_Headless();
+    ~EmuWindow_Headless();
+
+    /// There is nothing to display, so this does nothing
+    void SwapBuffers() override;
+
+    /// There are no window events, so this does nothing
+    void PollEvents() override;
+
+    /// There is no graphics context, so this does nothing
+    void MakeCurrent() override;
+
+    /// There is no graphics context, so this does nothing
+    void DoneCurrent() override;
+};
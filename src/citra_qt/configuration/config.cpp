@@ -54,7 +54,7 @@ const std::array<std::array<int, 5>, Settings::NativeAnalog::NumAnalogs> Config:
 // QKeySequnce(...).toString() is NOT ALLOWED HERE.
 // This must be in alphabetical order according to action name as it must have the same order as
 // UISetting::values.shortcuts, which is alphabetically ordered.
-const std::array<UISettings::Shortcut, 19> Config::default_hotkeys{
+const std::array<UISettings::Shortcut, 22> Config::default_hotkeys{
     {{"Advance Frame", "Main Window", {"\\", Qt::ApplicationShortcut}},
      {"Capture Screenshot", "Main Window", {"Ctrl+P", Qt::ApplicationShortcut}},
      {"Continue/Pause Emulation", "Main Window", {"F4", Qt::WindowShortcut}},
@@ -65,8 +65,11 @@ const std::array<UISettings::Shortcut, 19> Config::default_hotkeys{
      {"Increase Speed Limit", "Main Window", {"+", Qt::ApplicationShortcut}},
      {"Load Amiibo", "Main Window", {"F2", Qt::ApplicationShortcut}},
      {"Load File", "Main Window", {"Ctrl+O", Qt::WindowShortcut}},
+     {"Load State", "Main Window", {"F8", Qt::WindowShortcut}},
      {"Remove Amiibo", "Main Window", {"F3", Qt::ApplicationShortcut}},
      {"Restart Emulation", "Main Window", {"F6", Qt::WindowShortcut}},
+     {"Rewind", "Main Window", {"Ctrl+R", Qt::WindowShortcut}},
+     {"Save State", "Main Window", {"F7", Qt::WindowShortcut}},
      {"Stop Emulation", "Main Window", {"F5", Qt::WindowShortcut}},
      {"Swap Screens", "Main Window", {"F9", Qt::WindowShortcut}},
      {"Toggle Filter Bar", "Main Window", {"Ctrl+F", Qt::WindowShortcut}},
@@ -145,6 +148,12 @@ void Config::ReadValues() {
 
     qt_config->beginGroup("Core");
     Settings::values.use_cpu_jit = ReadSetting("use_cpu_jit", true).toBool();
+    Settings::values.snapshot_interval = ReadSetting("snapshot_interval", 0).toUInt();
+    Settings::values.snapshot_keyframe_interval =
+        ReadSetting("snapshot_keyframe_interval", 10).toUInt();
+    Settings::values.skip_idle_loops = ReadSetting("skip_idle_loops", false).toBool();
+    Settings::values.idle_loop_titles =
+        ReadSetting("idle_loop_titles", "").toString().toStdString();
     qt_config->endGroup();
 
     qt_config->beginGroup("Renderer");
@@ -160,6 +169,16 @@ void Config::ReadValues() {
     Settings::values.shaders_accurate_gs = ReadSetting("shaders_accurate_gs", true).toBool();
     Settings::values.shaders_accurate_mul = ReadSetting("shaders_accurate_mul", false).toBool();
     Settings::values.use_shader_jit = ReadSetting("use_shader_jit", true).toBool();
+    Settings::values.use_disk_shader_cache = ReadSetting("use_disk_shader_cache", true).toBool();
+    Settings::values.sw_rasterizer_threads =
+        static_cast<u16>(ReadSetting("sw_rasterizer_threads", 1).toInt());
+    Settings::values.vertex_shader_threads =
+        static_cast<u16>(ReadSetting("vertex_shader_threads", 1).toInt());
+    Settings::values.texture_decode_threads =
+        static_cast<u16>(ReadSetting("texture_decode_threads", 1).toInt());
+    Settings::values.surface_cache_budget =
+        static_cast<u16>(ReadSetting("surface_cache_budget", 0).toInt());
+    Settings::values.use_asynchronous_gpu = ReadSetting("use_asynchronous_gpu", false).toBool();
     Settings::values.resolution_factor =
         static_cast<u16>(ReadSetting("resolution_factor", 1).toInt());
     Settings::values.vsync_enabled = ReadSetting("vsync_enabled", false).toBool();
@@ -442,6 +461,10 @@ void Config::SaveValues() {
 
     qt_config->beginGroup("Core");
     WriteSetting("use_cpu_jit", Settings::values.use_cpu_jit, true);
+    WriteSetting("snapshot_interval", Settings::values.snapshot_interval, 0);
+    WriteSetting("snapshot_keyframe_interval", Settings::values.snapshot_keyframe_interval, 10);
+    WriteSetting("skip_idle_loops", Settings::values.skip_idle_loops, false);
+    WriteSetting("idle_loop_titles", QString::fromStdString(Settings::values.idle_loop_titles), "");
     qt_config->endGroup();
 
     qt_config->beginGroup("Renderer");
@@ -450,6 +473,12 @@ void Config::SaveValues() {
     WriteSetting("shaders_accurate_gs", Settings::values.shaders_accurate_gs, true);
     WriteSetting("shaders_accurate_mul", Settings::values.shaders_accurate_mul, false);
     WriteSetting("use_shader_jit", Settings::values.use_shader_jit, true);
+    WriteSetting("use_disk_shader_cache", Settings::values.use_disk_shader_cache, true);
+    WriteSetting("sw_rasterizer_threads", Settings::values.sw_rasterizer_threads, 1);
+    WriteSetting("vertex_shader_threads", Settings::values.vertex_shader_threads, 1);
+    WriteSetting("texture_decode_threads", Settings::values.texture_decode_threads, 1);
+    WriteSetting("surface_cache_budget", Settings::values.surface_cache_budget, 0);
+    WriteSetting("use_asynchronous_gpu", Settings::values.use_asynchronous_gpu, false);
     WriteSetting("resolution_factor", Settings::values.resolution_factor, 1);
     WriteSetting("vsync_enabled", Settings::values.vsync_enabled, false);
     WriteSetting("use_frame_limit", Settings::values.use_frame_limit, true);
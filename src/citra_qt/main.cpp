@@ -446,6 +446,24 @@ void GMainWindow::InitializeHotkeys() {
                     OnCaptureScreenshot();
                 }
             });
+    connect(hotkey_registry.GetHotkey("Main Window", "Save State", this), &QShortcut::activated,
+            this, [&] {
+                if (emulation_running) {
+                    Core::System::GetInstance().RequestSaveState(1);
+                }
+            });
+    connect(hotkey_registry.GetHotkey("Main Window", "Load State", this), &QShortcut::activated,
+            this, [&] {
+                if (emulation_running) {
+                    Core::System::GetInstance().RequestLoadState(1);
+                }
+            });
+    connect(hotkey_registry.GetHotkey("Main Window", "Rewind", this), &QShortcut::activated, this,
+            [&] {
+                if (emulation_running) {
+                    Core::System::GetInstance().RequestRewind(1);
+                }
+            });
 }
 
 void GMainWindow::ShowUpdaterWidgets() {
@@ -825,6 +843,14 @@ void GMainWindow::BootGame(const QString& filename) {
     if (!LoadROM(filename))
         return;
 
+    if (Core::System::GetInstance().CanResumeSnapshots() &&
+        QMessageBox::question(this, tr("Resume Session"),
+                              tr("Snapshots of an earlier session of this game were found. It may "
+                                 "have ended unexpectedly. Do you want to resume from the latest "
+                                 "snapshot?")) == QMessageBox::Yes) {
+        Core::System::GetInstance().RequestResume();
+    }
+
     // Create and start the emulation thread
     emu_thread = std::make_unique<EmuThread>(render_window);
     emit EmulationStarting(emu_thread.get());
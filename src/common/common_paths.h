@@ -38,6 +38,7 @@
 #define SYSDATA_DIR "sysdata"
 #define LOG_DIR "log"
 #define CHEATS_DIR "cheats"
+#define STATES_DIR "states"
 #define DLL_DIR "external_dlls"
 
 // Filenames
@@ -0,0 +1,152 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include <limits>
+#include "common/compression.h"
+
+namespace Common::Compression {
+
+namespace {
+
+constexpr std::size_t MIN_MATCH_LENGTH = 4;
+constexpr std::size_t MAX_OFFSET = std::numeric_limits<u16>::max();
+/// Lengths up to this value are stored in the token, longer ones continue in extra bytes
+constexpr std::size_t TOKEN_LENGTH_MAX = 15;
+constexpr unsigned HASH_BITS = 12;
+constexpr std::size_t NO_POSITION = std::numeric_limits<std::size_t>::max();
+
+u32 Hash(const u8* data) {
+    u32 value;
+    std::memcpy(&value, data, sizeof(value));
+    return (value * 2654435761U) >> (32 - HASH_BITS);
+}
+
+u8 TokenLength(std::size_t length) {
+    return static_cast<u8>(length < TOKEN_LENGTH_MAX ? length : TOKEN_LENGTH_MAX);
+}
+
+void WriteExtraLength(std::vector<u8>& output, std::size_t length) {
+    if (length < TOKEN_LENGTH_MAX) {
+        return;
+    }
+    for (length -= TOKEN_LENGTH_MAX; length >= 0xFF; length -= 0xFF) {
+        output.push_back(0xFF);
+    }
+    output.push_back(static_cast<u8>(length));
+}
+
+bool ReadExtraLength(const u8* data, std::size_t size, std::size_t& pos, std::size_t& length) {
+    if (length < TOKEN_LENGTH_MAX) {
+        return true;
+    }
+    u8 byte;
+    do {
+        if (pos == size) {
+            return false;
+        }
+        byte = data[pos++];
+        length += byte;
+    } while (byte == 0xFF);
+    return true;
+}
+
+} // Anonymous namespace
+
+std::vector<u8> Compress(const u8* data, std::size_t size) {
+    std::vector<u8> output;
+    output.reserve(size / 2 + 16);
+
+    std::vector<std::size_t> table(std::size_t(1) << HASH_BITS, NO_POSITION);
+    std::size_t anchor = 0;
+    std::size_t pos = 0;
+
+    // Writes the literals from anchor to pos, followed by a match unless match_length is 0
+    const auto emit = [&](std::size_t match_length, std::size_t offset) {
+        const std::size_t literal_length = pos - anchor;
+        const std::size_t match_code = match_length != 0 ? match_length - MIN_MATCH_LENGTH : 0;
+        output.push_back(static_cast<u8>(TokenLength(literal_length) << 4 |
+                                         TokenLength(match_code)));
+        WriteExtraLength(output, literal_length);
+        output.insert(output.end(), data + anchor, data + pos);
+        if (match_length != 0) {
+            output.push_back(static_cast<u8>(offset));
+            output.push_back(static_cast<u8>(offset >> 8));
+            WriteExtraLength(output, match_code);
+        }
+    };
+
+    while (size - pos >= MIN_MATCH_LENGTH) {
+        std::size_t& entry = table[Hash(data + pos)];
+        const std::size_t candidate = entry;
+        entry = pos;
+        if (candidate == NO_POSITION || pos - candidate > MAX_OFFSET ||
+            std::memcmp(data + candidate, data + pos, MIN_MATCH_LENGTH) != 0) {
+            ++pos;
+            continue;
+        }
+
+        std::size_t match_length = MIN_MATCH_LENGTH;
+        while (pos + match_length < size &&
+               data[candidate + match_length] == data[pos + match_length]) {
+            ++match_length;
+        }
+        emit(match_length, pos - candidate);
+        pos += match_length;
+        anchor = pos;
+    }
+
+    // The last sequence has no match, it is written even for empty input
+    pos = size;
+    emit(0, 0);
+    return output;
+}
+
+bool Decompress(const u8* data, std::size_t size, u8* output, std::size_t output_size) {
+    std::size_t pos = 0;
+    std::size_t output_pos = 0;
+    while (pos < size) {
+        const u8 token = data[pos++];
+
+        std::size_t literal_length = token >> 4;
+        if (!ReadExtraLength(data, size, pos, literal_length) || literal_length > size - pos ||
+            literal_length > output_size - output_pos) {
+            return false;
+        }
+        std::memcpy(output + output_pos, data + pos, literal_length);
+        pos += literal_length;
+        output_pos += literal_length;
+
+        // Only the last sequence has no match
+        if (pos == size) {
+            return output_pos == output_size;
+        }
+
+        if (size - pos < 2) {
+            return false;
+        }
+        const std::size_t offset = data[pos] | data[pos + 1] << 8;
+        pos += 2;
+        std::size_t match_length = token & 0xF;
+        if (!ReadExtraLength(data, size, pos, match_length)) {
+            return false;
+        }
+        match_length += MIN_MATCH_LENGTH;
+        if (offset == 0 || offset > output_pos || match_length > output_size - output_pos) {
+            return false;
+        }
+
+        // Matches may overlap the bytes they produce, so copy byte by byte
+        const u8* source = output + output_pos - offset;
+        for (std::size_t i = 0; i < match_length; ++i) {
+            output[output_pos + i] = source[i];
+        }
+        output_pos += match_length;
+    }
+
+    // The data ended without the last sequence
+    return false;
+}
+
+} // namespace Common::Compression
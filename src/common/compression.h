@@ -0,0 +1,31 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include "common/common_types.h"
+
+namespace Common::Compression {
+
+/**
+ * Compresses a buffer with a small LZ77 codec. The output is a list of sequences, each made of a
+ * token byte holding the literal and match lengths, the literals, a 16-bit offset and the match,
+ * much like an LZ4 block. It trades compression ratio for speed, so that compressing memory
+ * snapshots doesn't noticeably stall the emulation.
+ */
+std::vector<u8> Compress(const u8* data, std::size_t size);
+
+/**
+ * Decompresses a buffer produced by Compress.
+ * @param data Compressed data
+ * @param size Size of the compressed data
+ * @param output Buffer receiving the decompressed data
+ * @param output_size Size the decompressed data must have
+ * @returns false if the compressed data is damaged or doesn't decompress to output_size bytes
+ */
+bool Decompress(const u8* data, std::size_t size, u8* output, std::size_t output_size);
+
+} // namespace Common::Compression
@@ -29,6 +29,7 @@ enum class UserPath {
     NANDDir,
     RootDir,
     SDMCDir,
+    StatesDir,
     SysDataDir,
     UserDir,
 };
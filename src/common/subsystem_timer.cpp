@@ -0,0 +1,101 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <atomic>
+#include "common/subsystem_timer.h"
+
+namespace Common {
+
+namespace {
+
+struct Counter {
+    std::atomic<u64> nanoseconds{0};
+    std::atomic<u64> calls{0};
+};
+
+std::atomic<bool> timers_enabled{false};
+std::array<Counter, NumSubsystems> counters;
+
+/// Innermost active timer of the current thread
+thread_local ScopedSubsystemTimer* current_timer = nullptr;
+
+} // Anonymous namespace
+
+const char* GetSubsystemName(Subsystem subsystem) {
+    switch (subsystem) {
+    case Subsystem::CPU:
+        return "cpu";
+    case Subsystem::GPUCommandList:
+        return "gpu_command_list";
+    case Subsystem::ShaderEngine:
+        return "shader_engine";
+    case Subsystem::Rasterizer:
+        return "rasterizer";
+    case Subsystem::DSP:
+        return "dsp";
+    case Subsystem::HLEServices:
+        return "hle_services";
+    case Subsystem::CoreTiming:
+        return "core_timing";
+    default:
+        return "unknown";
+    }
+}
+
+void SetSubsystemTimersEnabled(bool enabled) {
+    timers_enabled = enabled;
+}
+
+SubsystemTimes GetSubsystemTimes() {
+    SubsystemTimes times;
+    for (std::size_t i = 0; i < NumSubsystems; ++i) {
+        times.self_time[i] = std::chrono::nanoseconds(counters[i].nanoseconds.load());
+        times.calls[i] = counters[i].calls.load();
+    }
+    return times;
+}
+
+void ResetSubsystemTimes() {
+    for (Counter& counter : counters) {
+        counter.nanoseconds = 0;
+        counter.calls = 0;
+    }
+}
+
+ScopedSubsystemTimer::ScopedSubsystemTimer(Subsystem subsystem) : subsystem(subsystem) {
+    if (!timers_enabled.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    const auto now = Clock::now();
+    active = true;
+    parent = current_timer;
+    if (parent != nullptr) {
+        parent->Pause(now);
+    }
+    current_timer = this;
+    resume_time = now;
+    counters[static_cast<std::size_t>(subsystem)].calls.fetch_add(1, std::memory_order_relaxed);
+}
+
+ScopedSubsystemTimer::~ScopedSubsystemTimer() {
+    if (!active) {
+        return;
+    }
+
+    const auto now = Clock::now();
+    Pause(now);
+    current_timer = parent;
+    if (parent != nullptr) {
+        parent->resume_time = now;
+    }
+}
+
+void ScopedSubsystemTimer::Pause(Clock::time_point now) {
+    const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(now - resume_time);
+    counters[static_cast<std::size_t>(subsystem)].nanoseconds.fetch_add(
+        static_cast<u64>(elapsed.count()), std::memory_order_relaxed);
+}
+
+} // namespace Common
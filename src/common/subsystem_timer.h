@@ -0,0 +1,71 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include "common/common_types.h"
+
+namespace Common {
+
+/// Parts of the emulator whose time is measured by the benchmark mode
+enum class Subsystem : std::size_t {
+    CPU,
+    GPUCommandList,
+    ShaderEngine,
+    Rasterizer,
+    DSP,
+    HLEServices,
+    CoreTiming,
+    NumSubsystems,
+};
+
+constexpr std::size_t NumSubsystems = static_cast<std::size_t>(Subsystem::NumSubsystems);
+
+/// Returns a short, machine-readable name of the subsystem
+const char* GetSubsystemName(Subsystem subsystem);
+
+struct SubsystemTimes {
+    /// Time spent in each subsystem, excluding the time spent in other subsystems called by it
+    std::array<std::chrono::nanoseconds, NumSubsystems> self_time{};
+    /// Number of times each subsystem was entered
+    std::array<u64, NumSubsystems> calls{};
+};
+
+/// Enables or disables measuring subsystem times, disabled by default
+void SetSubsystemTimersEnabled(bool enabled);
+
+/// Returns the times measured since the last reset
+SubsystemTimes GetSubsystemTimes();
+
+void ResetSubsystemTimes();
+
+/**
+ * Measures the time spent in a subsystem while in scope. Timers nest: while a timer is active on
+ * the same thread, the time of the enclosing timer is paused, so that each subsystem is only
+ * charged for its own work. Disabled timers only cost a relaxed atomic load, so that they can stay
+ * in regular builds, unlike MicroProfile scopes which can't be read back by the emulator.
+ */
+class ScopedSubsystemTimer {
+public:
+    explicit ScopedSubsystemTimer(Subsystem subsystem);
+    ~ScopedSubsystemTimer();
+
+    ScopedSubsystemTimer(const ScopedSubsystemTimer&) = delete;
+    ScopedSubsystemTimer& operator=(const ScopedSubsystemTimer&) = delete;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    void Pause(Clock::time_point now);
+
+    Subsystem subsystem;
+    bool active = false;
+    ScopedSubsystemTimer* parent = nullptr;
+    Clock::time_point resume_time;
+};
+
+} // namespace Common
@@ -0,0 +1,95 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include "common/thread.h"
+#include "common/thread_pool.h"
+
+namespace Common {
+
+ThreadPool::ThreadPool(std::size_t num_threads, std::string name_) : name(std::move(name_)) {
+    const std::size_t num_workers = num_threads > 1 ? num_threads - 1 : 0;
+    workers.reserve(num_workers);
+    for (std::size_t i = 0; i < num_workers; ++i) {
+        workers.emplace_back([this, i] { WorkerLoop(i); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop = true;
+    }
+    work_available.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::ParallelFor(std::size_t count, const std::function<void(std::size_t)>& func) {
+    if (count == 0) {
+        return;
+    }
+
+    if (workers.empty() || count == 1) {
+        for (std::size_t i = 0; i < count; ++i) {
+            func(i);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        job = &func;
+        job_count = count;
+        next_index = 0;
+        busy_workers = workers.size();
+        ++generation;
+    }
+    work_available.notify_all();
+
+    RunJob(func, count);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    work_done.wait(lock, [this] { return busy_workers == 0; });
+    job = nullptr;
+}
+
+std::size_t ThreadPool::GetHardwareThreadCount() {
+    return std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+}
+
+void ThreadPool::WorkerLoop(std::size_t index) {
+    const std::string thread_name = name + " " + std::to_string(index);
+    SetCurrentThreadName(thread_name.c_str());
+
+    u64 last_generation = 0;
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        work_available.wait(lock, [&] { return stop || generation != last_generation; });
+        if (stop) {
+            return;
+        }
+
+        last_generation = generation;
+        const auto& func = *job;
+        const std::size_t count = job_count;
+
+        lock.unlock();
+        RunJob(func, count);
+        lock.lock();
+
+        if (--busy_workers == 0) {
+            work_done.notify_one();
+        }
+    }
+}
+
+void ThreadPool::RunJob(const std::function<void(std::size_t)>& func, std::size_t count) {
+    for (std::size_t i = next_index++; i < count; i = next_index++) {
+        func(i);
+    }
+}
+
+} // namespace Common
@@ -0,0 +1,66 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "common/common_funcs.h"
+#include "common/common_types.h"
+
+namespace Common {
+
+/**
+ * A fixed-size pool of worker threads for fork/join style parallel loops.
+ *
+ * ParallelFor() hands out the indices of a loop to the workers (and to the calling thread, which
+ * takes part in the work) and only returns once every index has been processed. Only one thread
+ * may submit work to a given pool at a time.
+ */
+class ThreadPool : NonCopyable {
+public:
+    /**
+     * Creates a pool with the given total number of threads, including the submitting thread.
+     * A pool with a thread count of 0 or 1 spawns no workers and runs everything inline.
+     */
+    explicit ThreadPool(std::size_t num_threads, std::string name = "ThreadPool");
+    ~ThreadPool();
+
+    /// Returns the number of threads work is distributed over, including the submitting thread
+    std::size_t GetThreadCount() const {
+        return workers.size() + 1;
+    }
+
+    /// Calls func(i) for every i in [0, count) and waits until all calls have returned
+    void ParallelFor(std::size_t count, const std::function<void(std::size_t)>& func);
+
+    /// Returns the number of hardware threads, or 1 if this cannot be determined
+    static std::size_t GetHardwareThreadCount();
+
+private:
+    void WorkerLoop(std::size_t index);
+    void RunJob(const std::function<void(std::size_t)>& func, std::size_t count);
+
+    std::string name;
+    std::vector<std::thread> workers;
+
+    std::mutex mutex;
+    std::condition_variable work_available;
+    std::condition_variable work_done;
+
+    const std::function<void(std::size_t)>* job = nullptr;
+    std::size_t job_count = 0;
+    std::atomic<std::size_t> next_index{0};
+    std::size_t busy_workers = 0;
+    u64 generation = 0;
+    bool stop = false;
+};
+
+} // namespace Common
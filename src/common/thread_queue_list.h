@@ -113,6 +113,10 @@ struct ThreadQueueList {
         first = nullptr;
     }
 
+    const std::deque<T>& get_queue(Priority priority) const {
+        return queues[priority].data;
+    }
+
     bool empty(Priority priority) const {
         const Queue* cur = &queues[priority];
         return cur->data.empty();
@@ -0,0 +1,268 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <array>
+#include <mutex>
+#include "common/assert.h"
+#include "common/logging/log.h"
+#include "common/write_watch.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#define HAS_WRITE_WATCH
+#elif defined(__unix__) || defined(__APPLE__)
+#include <csignal>
+#include <sys/mman.h>
+#include <unistd.h>
+#define HAS_WRITE_WATCH
+#endif
+
+namespace Common {
+
+namespace {
+
+/// Instances the fault handler looks the faulting address up in
+constexpr std::size_t MAX_INSTANCES = 8;
+std::array<std::atomic<WriteWatchedMemory*>, MAX_INSTANCES> instances{};
+
+bool HandleFault(const void* address) {
+    for (const auto& instance : instances) {
+        WriteWatchedMemory* const memory = instance.load(std::memory_order_acquire);
+        if (memory != nullptr && memory->HandleWriteFault(address)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+class SpinLockGuard {
+public:
+    explicit SpinLockGuard(std::atomic_flag& flag) : flag(flag) {
+        while (flag.test_and_set(std::memory_order_acquire)) {
+        }
+    }
+
+    ~SpinLockGuard() {
+        flag.clear(std::memory_order_release);
+    }
+
+private:
+    std::atomic_flag& flag;
+};
+
+#ifdef _WIN32
+
+LONG CALLBACK FaultHandler(PEXCEPTION_POINTERS info) {
+    const EXCEPTION_RECORD& record = *info->ExceptionRecord;
+    // The first parameter of an access violation is 1 for writes, the second one the address
+    if (record.ExceptionCode == EXCEPTION_ACCESS_VIOLATION && record.NumberParameters >= 2 &&
+        record.ExceptionInformation[0] == 1 &&
+        HandleFault(reinterpret_cast<const void*>(record.ExceptionInformation[1]))) {
+        return EXCEPTION_CONTINUE_EXECUTION;
+    }
+    return EXCEPTION_CONTINUE_SEARCH;
+}
+
+void InstallFaultHandler() {
+    static std::once_flag installed;
+    std::call_once(installed, [] { AddVectoredExceptionHandler(1, FaultHandler); });
+}
+
+std::size_t GetHostPageSize() {
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwPageSize;
+}
+
+#elif defined(HAS_WRITE_WATCH)
+
+struct sigaction previous_segv_action;
+struct sigaction previous_bus_action;
+
+void FaultHandler(int signal, siginfo_t* info, void* context) {
+    if (HandleFault(info->si_addr)) {
+        return;
+    }
+
+    // Not a write to watched memory, pass it on to the handler installed before
+    const struct sigaction& previous =
+        signal == SIGSEGV ? previous_segv_action : previous_bus_action;
+    if (previous.sa_flags & SA_SIGINFO) {
+        previous.sa_sigaction(signal, info, context);
+    } else if (previous.sa_handler == SIG_DFL || previous.sa_handler == SIG_IGN) {
+        // Faults can't be ignored, the default action is taken once the access is retried
+        struct sigaction default_action {};
+        default_action.sa_handler = SIG_DFL;
+        sigaction(signal, &default_action, nullptr);
+    } else {
+        previous.sa_handler(signal);
+    }
+}
+
+void InstallFaultHandler(int signal, struct sigaction& previous) {
+    struct sigaction current;
+    sigaction(signal, nullptr, &current);
+    if ((current.sa_flags & SA_SIGINFO) && current.sa_sigaction == FaultHandler) {
+        return;
+    }
+
+    struct sigaction action {};
+    action.sa_sigaction = FaultHandler;
+    action.sa_flags = SA_SIGINFO | SA_NODEFER;
+    sigemptyset(&action.sa_mask);
+    sigaction(signal, &action, &previous);
+}
+
+/// Installs the fault handler unless it is already installed. Checked whenever memory is
+/// protected, as other code, like crash reporters, may have replaced it in the meantime.
+void InstallFaultHandler() {
+    static std::mutex mutex;
+    std::lock_guard lock(mutex);
+    InstallFaultHandler(SIGSEGV, previous_segv_action);
+    // Some hosts, like macOS, raise SIGBUS for writes to protected pages
+    InstallFaultHandler(SIGBUS, previous_bus_action);
+}
+
+std::size_t GetHostPageSize() {
+    return static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+}
+
+#else
+
+std::size_t GetHostPageSize() {
+    return 4096;
+}
+
+#endif
+
+} // Anonymous namespace
+
+WriteWatchedMemory::WriteWatchedMemory(std::size_t size)
+    : memory_size(size), block_size(GetHostPageSize()),
+      num_blocks((size + block_size - 1) / block_size),
+      written_blocks(std::make_unique<std::atomic<u64>[]>((num_blocks + 63) / 64)) {
+    const std::size_t allocation_size = num_blocks * block_size;
+#ifdef _WIN32
+    memory = static_cast<u8*>(
+        VirtualAlloc(nullptr, allocation_size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE));
+    ASSERT_MSG(memory != nullptr, "Failed to allocate {} bytes", allocation_size);
+#elif defined(HAS_WRITE_WATCH)
+    void* const pointer = mmap(nullptr, allocation_size, PROT_READ | PROT_WRITE,
+                               MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    ASSERT_MSG(pointer != MAP_FAILED, "Failed to allocate {} bytes", allocation_size);
+    memory = static_cast<u8*>(pointer);
+#else
+    memory = new u8[allocation_size]();
+#endif
+
+    for (std::size_t i = 0; i < (num_blocks + 63) / 64; ++i) {
+        written_blocks[i].store(0, std::memory_order_relaxed);
+    }
+
+#ifdef HAS_WRITE_WATCH
+    const auto slot = std::find_if(instances.begin(), instances.end(), [this](auto& instance) {
+        WriteWatchedMemory* expected = nullptr;
+        return instance.compare_exchange_strong(expected, this);
+    });
+    if (slot == instances.end()) {
+        LOG_ERROR(Common_Memory, "Too many watched regions, writes to this one aren't tracked");
+    } else {
+        can_watch = true;
+    }
+#endif
+}
+
+WriteWatchedMemory::~WriteWatchedMemory() {
+    for (auto& instance : instances) {
+        WriteWatchedMemory* expected = this;
+        instance.compare_exchange_strong(expected, nullptr);
+    }
+
+#ifdef _WIN32
+    VirtualFree(memory, 0, MEM_RELEASE);
+#elif defined(HAS_WRITE_WATCH)
+    munmap(memory, num_blocks * block_size);
+#else
+    delete[] memory;
+#endif
+}
+
+std::vector<bool> WriteWatchedMemory::TakeWrittenBlocks() {
+    std::vector<bool> blocks(num_blocks, true);
+    if (!can_watch) {
+        return blocks;
+    }
+
+#ifdef HAS_WRITE_WATCH
+    InstallFaultHandler();
+#endif
+
+    SpinLockGuard lock(protection_lock);
+    SetWritable(0, num_blocks, false);
+    for (std::size_t block = 0; block < num_blocks; block += 64) {
+        const u64 bits = written_blocks[block / 64].exchange(0, std::memory_order_relaxed);
+        if (!watching) {
+            continue;
+        }
+        for (std::size_t bit = 0; bit < 64 && block + bit < num_blocks; ++bit) {
+            blocks[block + bit] = (bits >> bit) & 1;
+        }
+    }
+    watching = true;
+    return blocks;
+}
+
+void WriteWatchedMemory::MarkWritten(std::size_t offset, std::size_t size) {
+    if (!watching || size == 0 || offset >= memory_size) {
+        return;
+    }
+    const std::size_t first_block = offset / block_size;
+    const std::size_t end_block = (std::min(offset + size, memory_size) - 1) / block_size + 1;
+
+    // Blocks are writable as long as their bit is set, so most calls don't need the lock
+    const auto is_written = [this](std::size_t block) {
+        return (written_blocks[block / 64].load(std::memory_order_relaxed) >> (block % 64)) & 1;
+    };
+    std::size_t block = first_block;
+    while (block < end_block && is_written(block)) {
+        ++block;
+    }
+    if (block == end_block) {
+        return;
+    }
+
+    SpinLockGuard lock(protection_lock);
+    SetWritable(block, end_block, true);
+    for (; block < end_block; ++block) {
+        written_blocks[block / 64].fetch_or(u64(1) << (block % 64), std::memory_order_relaxed);
+    }
+}
+
+bool WriteWatchedMemory::HandleWriteFault(const void* address) {
+    const u8* const pointer = static_cast<const u8*>(address);
+    if (pointer < memory || pointer >= memory + memory_size) {
+        return false;
+    }
+    const std::size_t block = (pointer - memory) / block_size;
+
+    SpinLockGuard lock(protection_lock);
+    SetWritable(block, block + 1, true);
+    written_blocks[block / 64].fetch_or(u64(1) << (block % 64), std::memory_order_relaxed);
+    return true;
+}
+
+void WriteWatchedMemory::SetWritable(std::size_t first_block, std::size_t end_block,
+                                     bool writable) {
+    u8* const start = memory + first_block * block_size;
+    const std::size_t length = (end_block - first_block) * block_size;
+#ifdef _WIN32
+    DWORD old_protection;
+    VirtualProtect(start, length, writable ? PAGE_READWRITE : PAGE_READONLY, &old_protection);
+#elif defined(HAS_WRITE_WATCH)
+    mprotect(start, length, writable ? PROT_READ | PROT_WRITE : PROT_READ);
+#endif
+}
+
+} // namespace Common
@@ -0,0 +1,83 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include "common/common_types.h"
+
+namespace Common {
+
+/**
+ * Zero-initialized memory whose writes can be watched with host page protection. While watching,
+ * blocks which weren't written to since the written blocks were last taken are write-protected.
+ * The first write to such a block faults, the fault handler marks the block as written to and
+ * makes it writable again, and the write is retried. Reads are never intercepted.
+ *
+ * Writes the fault handler can't see, like the host OS writing into the memory during a system
+ * call, must be announced with MarkWritten. Announcing large writes also saves taking a fault for
+ * every block they touch.
+ */
+class WriteWatchedMemory {
+public:
+    explicit WriteWatchedMemory(std::size_t size);
+    ~WriteWatchedMemory();
+
+    WriteWatchedMemory(const WriteWatchedMemory&) = delete;
+    WriteWatchedMemory& operator=(const WriteWatchedMemory&) = delete;
+
+    u8* data() {
+        return memory;
+    }
+
+    const u8* data() const {
+        return memory;
+    }
+
+    std::size_t size() const {
+        return memory_size;
+    }
+
+    /// Returns the granularity of the tracking, the host page size
+    std::size_t GetBlockSize() const {
+        return block_size;
+    }
+
+    /**
+     * Returns which blocks were written to since the previous call, and starts watching writes if
+     * it didn't already. All blocks count as written to on the first call, and on every call if
+     * the host doesn't support watching writes.
+     */
+    std::vector<bool> TakeWrittenBlocks();
+
+    /// Marks the blocks touching the given range as written to and makes them writable.
+    /// Thread-safe.
+    void MarkWritten(std::size_t offset, std::size_t size);
+
+    /// Handles a write fault at the given address, returns false if it isn't in watched memory.
+    /// Only meant to be called by the fault handler.
+    bool HandleWriteFault(const void* address);
+
+private:
+    void SetWritable(std::size_t first_block, std::size_t end_block, bool writable);
+
+    u8* memory = nullptr;
+    std::size_t memory_size;
+    std::size_t block_size;
+    std::size_t num_blocks;
+
+    /// Whether the fault handler can find this memory, false if the host doesn't support it
+    bool can_watch = false;
+    std::atomic<bool> watching{false};
+    /// One bit per block, set when the block is made writable
+    std::unique_ptr<std::atomic<u64>[]> written_blocks;
+    /// Held while changing the protection of blocks together with their bits. A spin lock, as it
+    /// is taken in the fault handler.
+    std::atomic_flag protection_lock = ATOMIC_FLAG_INIT;
+};
+
+} // namespace Common
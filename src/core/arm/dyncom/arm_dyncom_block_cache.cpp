@@ -0,0 +1,90 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include "common/assert.h"
+#include "core/arm/dyncom/arm_dyncom_block_cache.h"
+
+/// The cache whose block is being translated on this thread
+static thread_local BlockCache* translating_cache = nullptr;
+
+BlockCache::BlockCache() = default;
+BlockCache::~BlockCache() = default;
+
+BlockHeader* BlockCache::BeginBlock() {
+    ASSERT(translating_cache == nullptr);
+    if (chunk_size - chunk_offset < sizeof(BlockHeader) + MAX_INSTRUCTION_SIZE) {
+        if (current_chunk + 1 < chunks.size()) {
+            ++current_chunk;
+        } else if (chunks.size() < MAX_CHUNKS) {
+            chunks.push_back(std::make_unique<u8[]>(CHUNK_SIZE));
+            current_chunk = chunks.size() - 1;
+        } else {
+            Clear();
+        }
+        chunk_offset = 0;
+        chunk_size = CHUNK_SIZE;
+    }
+
+    BlockHeader* block = reinterpret_cast<BlockHeader*>(Allocate(sizeof(BlockHeader)));
+    block->successor = nullptr;
+    block->successor_generation = 0;
+    block->successor_pc = 0;
+    translating_cache = this;
+    return block;
+}
+
+void BlockCache::EndBlock(u32 pc, BlockHeader* block) {
+    ASSERT(translating_cache == this);
+    translating_cache = nullptr;
+
+    auto& directory = directories[pc >> DIRECTORY_SHIFT];
+    if (!directory) {
+        directory = std::make_unique<Directory>();
+    }
+    auto& page = (*directory)[(pc >> PAGE_BITS) & DIRECTORY_MASK];
+    if (!page) {
+        page = std::make_unique<PageBlocks>();
+        page->fill(nullptr);
+    }
+    (*page)[(pc & PAGE_MASK) >> 1] = block;
+}
+
+void* BlockCache::AllocateInstruction(std::size_t size) {
+    ASSERT_MSG(translating_cache != nullptr, "Instruction translated outside of a block");
+    ASSERT_MSG(size <= MAX_INSTRUCTION_SIZE, "Translated instruction is too large");
+    return translating_cache->Allocate(size);
+}
+
+u8* BlockCache::Allocate(std::size_t size) {
+    // BeginBlock and HasRoomForInstruction guarantee that the block doesn't leave its chunk
+    ASSERT(chunk_size - chunk_offset >= size);
+    u8* pointer = chunks[current_chunk].get() + chunk_offset;
+    chunk_offset += size;
+    return pointer;
+}
+
+void BlockCache::Invalidate(u32 start, std::size_t size) {
+    if (size == 0) {
+        return;
+    }
+    const u64 end = u64{start} + size;
+    for (u64 address = start & ~PAGE_MASK; address < end; address += PAGE_MASK + 1) {
+        auto& directory = directories[address >> DIRECTORY_SHIFT];
+        if (directory) {
+            (*directory)[(address >> PAGE_BITS) & DIRECTORY_MASK].reset();
+        }
+    }
+    ++generation;
+}
+
+void BlockCache::Clear() {
+    for (auto& directory : directories) {
+        directory.reset();
+    }
+    // The chunks are kept for the blocks to come, blocks that are still running may be in them
+    current_chunk = 0;
+    chunk_offset = 0;
+    chunk_size = chunks.empty() ? 0 : CHUNK_SIZE;
+    ++generation;
+}
@@ -0,0 +1,107 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include "common/common_types.h"
+
+/// Precedes the translated instructions of every block in the code arena
+struct BlockHeader {
+    /// The block last dispatched to from this one, valid while successor_generation is current
+    BlockHeader* successor;
+    u64 successor_generation;
+    u32 successor_pc;
+
+    u8* Instructions() {
+        return reinterpret_cast<u8*>(this + 1);
+    }
+};
+
+/**
+ * Translated blocks of one interpreter instance. Blocks are found through a table indexed by the
+ * page and offset of their first instruction, and their translations are bump-allocated from a
+ * code arena that grows in chunks up to a bound, past which every block is dropped.
+ *
+ * Blocks end at page boundaries, so invalidating a range only has to drop the blocks of the pages
+ * it touches. Their translations stay in the arena until everything is dropped, which is why
+ * blocks that are still running can't be freed from under the interpreter.
+ */
+class BlockCache {
+public:
+    /// Every translated instruction has to fit into this many bytes
+    static constexpr std::size_t MAX_INSTRUCTION_SIZE = 256;
+
+    BlockCache();
+    ~BlockCache();
+
+    /// Returns the block starting at pc, or null if it isn't translated
+    BlockHeader* Find(u32 pc) const {
+        const auto& directory = directories[pc >> DIRECTORY_SHIFT];
+        if (!directory) {
+            return nullptr;
+        }
+        const auto& page = (*directory)[(pc >> PAGE_BITS) & DIRECTORY_MASK];
+        return page ? (*page)[(pc & PAGE_MASK) >> 1] : nullptr;
+    }
+
+    /**
+     * Starts a new block. Until EndBlock is called, the instructions translated on this thread
+     * are allocated right after it. This may drop every block if the arena is full.
+     */
+    BlockHeader* BeginBlock();
+
+    /// Returns whether another instruction fits into the block begun last
+    bool HasRoomForInstruction() const {
+        return chunk_size - chunk_offset >= MAX_INSTRUCTION_SIZE;
+    }
+
+    /// Makes the block begun last findable at pc
+    void EndBlock(u32 pc, BlockHeader* block);
+
+    /// Allocates memory for a translated instruction of the block being translated on this thread
+    static void* AllocateInstruction(std::size_t size);
+
+    /// Drops the blocks starting in the pages touching the given range
+    void Invalidate(u32 start, std::size_t size);
+
+    /// Drops every block
+    void Clear();
+
+    /**
+     * Returns a counter that changes whenever blocks are dropped. Blocks, and links between them,
+     * that were looked up in an older generation may not be valid anymore.
+     */
+    u64 GetGeneration() const {
+        return generation;
+    }
+
+private:
+    static constexpr u32 PAGE_BITS = 12;
+    static constexpr u32 PAGE_MASK = (1 << PAGE_BITS) - 1;
+    /// The pages are grouped into directories of 4 MiB of address space
+    static constexpr u32 DIRECTORY_SHIFT = 22;
+    static constexpr u32 DIRECTORY_MASK = (1 << (DIRECTORY_SHIFT - PAGE_BITS)) - 1;
+    /// Size of the chunks the arena grows by, and the bound of its total size
+    static constexpr std::size_t CHUNK_SIZE = 4 * 1024 * 1024;
+    static constexpr std::size_t MAX_CHUNKS = 32;
+
+    /// Blocks starting in one page, by the halfword offset of their first instruction
+    using PageBlocks = std::array<BlockHeader*, (PAGE_MASK + 1) / 2>;
+    using Directory = std::array<std::unique_ptr<PageBlocks>, DIRECTORY_MASK + 1>;
+
+    u8* Allocate(std::size_t size);
+
+    std::array<std::unique_ptr<Directory>, std::size_t{1} << (32 - DIRECTORY_SHIFT)> directories;
+
+    std::vector<std::unique_ptr<u8[]>> chunks;
+    std::size_t current_chunk = 0;
+    std::size_t chunk_offset = 0;
+    std::size_t chunk_size = 0;
+
+    u64 generation = 0;
+};
@@ -840,7 +840,7 @@ static unsigned int InterpreterTranslateInstruction(const ARMul_State* cpu, cons
     return inst_size;
 }
 
-static int InterpreterTranslateBlock(ARMul_State* cpu, std::size_t& bb_start, u32 addr) {
+static int InterpreterTranslateBlock(ARMul_State* cpu, BlockHeader*& block, u32 addr) {
     MICROPROFILE_SCOPE(DynCom_Decode);
 
     // Decode instruction, get index
@@ -850,12 +850,18 @@ static int InterpreterTranslateBlock(ARMul_State* cpu, std::size_t& bb_start, u3
     ARM_INST_PTR inst_base = nullptr;
     TransExtData ret = TransExtData::NON_BRANCH;
     int size = 0; // instruction size of basic block
-    bb_start = trans_cache_buf_top;
+    block = cpu->block_cache.BeginBlock();
 
     u32 phys_addr = addr;
     u32 pc_start = cpu->Reg[15];
 
     while (ret == TransExtData::NON_BRANCH) {
+        // A block has to be contiguous in the code arena, the rest goes into the next one
+        if (inst_base != nullptr && !cpu->block_cache.HasRoomForInstruction()) {
+            inst_base->br = TransExtData::END_OF_PAGE;
+            break;
+        }
+
         unsigned int inst_size = InterpreterTranslateInstruction(cpu, phys_addr, inst_base);
 
         size++;
@@ -868,16 +874,16 @@ static int InterpreterTranslateBlock(ARMul_State* cpu, std::size_t& bb_start, u3
         ret = inst_base->br;
     };
 
-    cpu->instruction_cache[pc_start] = bb_start;
+    cpu->block_cache.EndBlock(pc_start, block);
 
     return KEEP_GOING;
 }
 
-static int InterpreterTranslateSingle(ARMul_State* cpu, std::size_t& bb_start, u32 addr) {
+static int InterpreterTranslateSingle(ARMul_State* cpu, BlockHeader*& block, u32 addr) {
     MICROPROFILE_SCOPE(DynCom_Decode);
 
     ARM_INST_PTR inst_base = nullptr;
-    bb_start = trans_cache_buf_top;
+    block = cpu->block_cache.BeginBlock();
 
     u32 phys_addr = addr;
     u32 pc_start = cpu->Reg[15];
@@ -888,7 +894,7 @@ static int InterpreterTranslateSingle(ARMul_State* cpu, std::size_t& bb_start, u
         inst_base->br = TransExtData::SINGLE_STEP;
     }
 
-    cpu->instruction_cache[pc_start] = bb_start;
+    cpu->block_cache.EndBlock(pc_start, block);
 
     return KEEP_GOING;
 }
@@ -948,7 +954,7 @@ unsigned InterpreterMainLoop(ARMul_State* cpu) {
 #define FETCH_INST                                                                                 \
     if (inst_base->br != TransExtData::NON_BRANCH)                                                 \
         goto DISPATCH;                                                                             \
-    inst_base = (arm_inst*)&trans_cache_buf[ptr]
+    inst_base = (arm_inst*)ptr
 
 #define INC_PC(l) ptr += sizeof(arm_inst) + l
 #define INC_PC_STUB ptr += sizeof(arm_inst)
@@ -1625,7 +1631,10 @@ unsigned InterpreterMainLoop(ARMul_State* cpu) {
     unsigned int addr;
     unsigned int num_instrs = 0;
 
-    std::size_t ptr;
+    u8* ptr;
+    // The block running, and the generation of the block cache it was looked up in
+    BlockHeader* block = nullptr;
+    u64 block_generation = 0;
 
     LOAD_NZCVT;
 DISPATCH : {
@@ -1640,16 +1649,41 @@ DISPATCH : {
     else
         cpu->Reg[15] &= 0xfffffffc;
 
-    // Find the cached instruction cream, otherwise translate it...
-    auto itr = cpu->instruction_cache.find(cpu->Reg[15]);
-    if (itr != cpu->instruction_cache.end()) {
-        ptr = itr->second;
-    } else if (cpu->NumInstrsToExecute != 1) {
-        if (InterpreterTranslateBlock(cpu, ptr, cpu->Reg[15]) == FETCH_EXCEPTION)
-            goto END;
-    } else {
-        if (InterpreterTranslateSingle(cpu, ptr, cpu->Reg[15]) == FETCH_EXCEPTION)
-            goto END;
+    {
+        BlockCache& block_cache = cpu->block_cache;
+        const u32 pc = cpu->Reg[15];
+        const bool block_valid =
+            block != nullptr && block_generation == block_cache.GetGeneration();
+
+        // Follow the link of the previous block if it still leads here, otherwise find the cached
+        // instruction cream, otherwise translate it...
+        BlockHeader* next_block = nullptr;
+        if (block_valid && block->successor_pc == pc &&
+            block->successor_generation == block_cache.GetGeneration()) {
+            next_block = block->successor;
+        } else {
+            next_block = block_cache.Find(pc);
+            if (next_block == nullptr) {
+                if (cpu->NumInstrsToExecute != 1) {
+                    if (InterpreterTranslateBlock(cpu, next_block, pc) == FETCH_EXCEPTION)
+                        goto END;
+                } else {
+                    if (InterpreterTranslateSingle(cpu, next_block, pc) == FETCH_EXCEPTION)
+                        goto END;
+                }
+            }
+
+            // Translating may have dropped every block, including the previous one
+            if (block_valid && block_generation == block_cache.GetGeneration()) {
+                block->successor = next_block;
+                block->successor_generation = block_cache.GetGeneration();
+                block->successor_pc = pc;
+            }
+        }
+
+        block = next_block;
+        block_generation = block_cache.GetGeneration();
+        ptr = block->Instructions();
     }
 
     // Find breakpoint if one exists within the block
@@ -1658,7 +1692,7 @@ DISPATCH : {
             GDBStub::GetNextBreakpointFromAddress(cpu->Reg[15], GDBStub::BreakpointType::Execute);
     }
 
-    inst_base = (arm_inst*)&trans_cache_buf[ptr];
+    inst_base = (arm_inst*)ptr;
     GOTO_NEXT_INST;
 }
 ADC_INST : {
@@ -8,6 +8,7 @@
 #include "audio_core/hle/hle.h"
 #include "audio_core/lle/lle.h"
 #include "common/logging/log.h"
+#include "common/subsystem_timer.h"
 #include "core/arm/arm_interface.h"
 #ifdef ARCHITECTURE_x86_64
 #include "core/arm/dynarmic/arm_dynarmic.h"
@@ -25,11 +26,14 @@
 #include "core/hle/service/service.h"
 #include "core/hle/service/sm/sm.h"
 #include "core/hw/hw.h"
+#include "core/idle_loop_detector.h"
 #include "core/loader/loader.h"
 #include "core/movie.h"
 #include "core/rpc/rpc_server.h"
+#include "core/savestate.h"
 #include "core/settings.h"
 #include "network/network.h"
+#include "video_core/gpu_thread.h"
 #include "video_core/video_core.h"
 
 namespace Core {
@@ -59,12 +63,19 @@ System::ResultStatus System::RunLoop(bool tight_loop) {
     // If we don't have a currently active thread then don't execute instructions,
     // instead advance to the next event and try to yield to the next thread
     if (kernel->GetThreadManager().GetCurrentThread() == nullptr) {
-        LOG_TRACE(Core_ARM11, "Idling");
-        timing->Idle();
-        timing->Advance();
-        PrepareReschedule();
+        // Threads are usually idle because they wait for the GPU to be done, so catch up with it
+        // before skipping ahead in time
+        if (VideoCore::g_gpu_thread && VideoCore::g_gpu_thread->Synchronize()) {
+            PrepareReschedule();
+        } else {
+            LOG_TRACE(Core_ARM11, "Idling");
+            timing->Idle();
+            timing->Advance();
+            PrepareReschedule();
+        }
     } else {
         timing->Advance();
+        Common::ScopedSubsystemTimer cpu_timer(Common::Subsystem::CPU);
         if (tight_loop) {
             cpu_core->Run();
         } else {
@@ -78,6 +89,7 @@ System::ResultStatus System::RunLoop(bool tight_loop) {
 
     HW::Update();
     Reschedule();
+    ProcessSaveStateRequests();
 
     if (reset_requested.exchange(false)) {
         Reset();
@@ -143,6 +155,17 @@ System::ResultStatus System::Load(EmuWindow& emu_window, const std::string& file
     }
     memory->SetCurrentPageTable(&kernel->GetCurrentProcess()->vm_manager.page_table);
     cheat_engine = std::make_unique<Cheats::CheatEngine>(*this);
+
+    u64 program_id = 0;
+    const bool has_program_id =
+        app_loader->ReadProgramId(program_id) == Loader::ResultStatus::Success;
+    idle_loop_detector->Configure(program_id);
+    if (Settings::values.snapshot_interval != 0 && has_program_id) {
+        snapshot_chain = std::make_unique<SnapshotChain>(
+            GetSnapshotDirectory(program_id), Settings::values.snapshot_keyframe_interval);
+        last_snapshot_ticks = timing->GetTicks();
+    }
+
     status = ResultStatus::Success;
     m_emu_window = &emu_window;
     m_filepath = filepath;
@@ -167,12 +190,52 @@ void System::Reschedule() {
     kernel->GetThreadManager().Reschedule();
 }
 
+void System::ProcessSaveStateRequests() {
+    const u32 save_slot = save_state_slot.exchange(0);
+    const u32 load_slot = load_state_slot.exchange(0);
+    const u32 rewind_snapshots = rewind_request.exchange(0);
+    const bool resume = resume_request.exchange(false);
+
+    u64 program_id = 0;
+    if (save_slot != 0 || load_slot != 0) {
+        app_loader->ReadProgramId(program_id);
+    }
+    if (save_slot != 0) {
+        SaveState(*this, GetSaveStatePath(program_id, save_slot));
+    }
+    if (load_slot != 0 && LoadState(*this, GetSaveStatePath(program_id, load_slot)) &&
+        snapshot_chain) {
+        snapshot_chain->Invalidate();
+    }
+
+    if (!snapshot_chain) {
+        return;
+    }
+
+    if (resume) {
+        snapshot_chain->Resume(*this);
+        last_snapshot_ticks = timing->GetTicks();
+    } else if (rewind_snapshots != 0) {
+        snapshot_chain->Restore(*this, rewind_snapshots - 1);
+        last_snapshot_ticks = timing->GetTicks();
+    } else if (timing->GetTicks() - last_snapshot_ticks >=
+               Settings::values.snapshot_interval * BASE_CLOCK_RATE_ARM11) {
+        snapshot_chain->TakeSnapshot(*this);
+        last_snapshot_ticks = timing->GetTicks();
+    }
+}
+
+bool System::CanResumeSnapshots() const {
+    return snapshot_chain && snapshot_chain->CanResume();
+}
+
 System::ResultStatus System::Init(EmuWindow& emu_window, u32 system_mode) {
     LOG_DEBUG(HW_Memory, "initialized OK");
 
     memory = std::make_unique<Memory::MemorySystem>();
 
     timing = std::make_unique<Timing>();
+    idle_loop_detector = std::make_unique<IdleLoopDetector>(*timing);
 
     kernel = std::make_unique<Kernel::KernelSystem>(*memory, *timing,
                                                     [this] { PrepareReschedule(); }, system_mode);
@@ -260,6 +323,10 @@ const Timing& System::CoreTiming() const {
     return *timing;
 }
 
+IdleLoopDetector& System::IdleDetector() {
+    return *idle_loop_detector;
+}
+
 Memory::MemorySystem& System::Memory() {
     return *memory;
 }
@@ -289,6 +356,12 @@ void System::Shutdown() {
                          perf_results.game_fps);
     Telemetry().AddField(Telemetry::FieldType::Performance, "Shutdown_Frametime",
                          perf_results.frametime * 1000.0);
+    if (idle_loop_detector->IsEnabled()) {
+        LOG_INFO(Core, "Skipped {} cycles in {} idle loops", idle_loop_detector->GetSkippedCycles(),
+                 idle_loop_detector->GetSkipCount());
+        Telemetry().AddField(Telemetry::FieldType::Performance, "Shutdown_IdleLoopSkippedCycles",
+                             idle_loop_detector->GetSkippedCycles());
+    }
 
     // Shutdown emulation session
     GDBStub::Shutdown();
@@ -298,9 +371,11 @@ void System::Shutdown() {
     telemetry_session.reset();
     rpc_server.reset();
     cheat_engine.reset();
+    snapshot_chain.reset();
     service_manager.reset();
     dsp_core.reset();
     cpu_core.reset();
+    idle_loop_detector.reset();
     timing.reset();
     app_loader.reset();
 
@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <memory>
 #include <string>
 #include "common/common_types.h"
@@ -47,6 +48,8 @@ class CheatEngine;
 
 namespace Core {
 
+class IdleLoopDetector;
+class SnapshotChain;
 class Timing;
 
 class System {
@@ -113,6 +116,31 @@ public:
         shutdown_requested = true;
     }
 
+    /// Request saving the emulation state to the given slot (starting at 1) of the current title
+    void RequestSaveState(u32 slot) {
+        save_state_slot = slot;
+    }
+
+    /// Request loading the emulation state from the given slot (starting at 1) of the current title
+    void RequestLoadState(u32 slot) {
+        load_state_slot = slot;
+    }
+
+    /// Request restoring the snapshot taken the given number of snapshots ago (starting at 1 for
+    /// the latest one). Only available if periodic snapshots are enabled.
+    void RequestRewind(u32 snapshots) {
+        rewind_request = snapshots;
+    }
+
+    /// Returns whether the snapshots of an earlier session of the loaded title, e.g. one which
+    /// crashed, can be resumed from
+    bool CanResumeSnapshots() const;
+
+    /// Request restoring the latest snapshot of the earlier session
+    void RequestResume() {
+        resume_request = true;
+    }
+
     /**
      * Load an executable application.
      * @param emu_window Reference to the host-system window used for video output and keyboard
@@ -190,6 +218,9 @@ public:
     /// Gets a const reference to the timing system
     const Timing& CoreTiming() const;
 
+    /// Gets a reference to the idle loop detector
+    IdleLoopDetector& IdleDetector();
+
     /// Gets a reference to the memory system
     Memory::MemorySystem& Memory();
 
@@ -241,6 +272,9 @@ private:
     /// Reschedule the core emulation
     void Reschedule();
 
+    /// Handles pending savestate requests
+    void ProcessSaveStateRequests();
+
     /// AppLoader used to load the current executing application
     std::unique_ptr<Loader::AppLoader> app_loader;
 
@@ -265,6 +299,12 @@ private:
     /// Cheats manager
     std::unique_ptr<Cheats::CheatEngine> cheat_engine;
 
+    /// Periodic snapshots of the emulated system, null if disabled
+    std::unique_ptr<SnapshotChain> snapshot_chain;
+    /// Emulated time of the latest snapshot, so that snapshots are taken at the same points when
+    /// replaying a movie
+    u64 last_snapshot_ticks = 0;
+
     /// RPC Server for scripting support
     std::unique_ptr<RPC::RPCServer> rpc_server;
 
@@ -273,6 +313,7 @@ private:
     std::unique_ptr<Memory::MemorySystem> memory;
     std::unique_ptr<Kernel::KernelSystem> kernel;
     std::unique_ptr<Timing> timing;
+    std::unique_ptr<IdleLoopDetector> idle_loop_detector;
 
 private:
     static System s_instance;
@@ -285,6 +326,11 @@ private:
 
     std::atomic<bool> reset_requested;
     std::atomic<bool> shutdown_requested;
+    /// Savestate slots to save to or load from, 0 if there is no request
+    std::atomic<u32> save_state_slot{0};
+    std::atomic<u32> load_state_slot{0};
+    std::atomic<u32> rewind_request{0};
+    std::atomic<bool> resume_request{false};
 };
 
 inline ARM_Interface& CPU() {
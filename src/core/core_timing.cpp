@@ -6,7 +6,9 @@
 #include <cinttypes>
 #include <tuple>
 #include "common/assert.h"
+#include "common/chunk_file.h"
 #include "common/logging/log.h"
+#include "common/subsystem_timer.h"
 #include "core/core_timing.h"
 
 namespace Core {
@@ -54,8 +56,8 @@ u64 Timing::GetIdleTicks() const {
     return static_cast<u64>(idled_cycles);
 }
 
-void Timing::ScheduleEvent(s64 cycles_into_future, const TimingEventType* event_type,
-                           u64 userdata) {
+TimingEventHandle Timing::ScheduleEvent(s64 cycles_into_future, const TimingEventType* event_type,
+                                        u64 userdata) {
     ASSERT(event_type != nullptr);
     s64 timeout = GetTicks() + cycles_into_future;
 
@@ -63,8 +65,7 @@ void Timing::ScheduleEvent(s64 cycles_into_future, const TimingEventType* event_
     if (!is_global_timer_sane)
         ForceExceptionCheck(cycles_into_future);
 
-    event_queue.emplace_back(Event{timeout, event_fifo_id++, userdata, event_type});
-    std::push_heap(event_queue.begin(), event_queue.end(), std::greater<>());
+    return QueueEvent(Event{timeout, event_fifo_id++, userdata, event_type});
 }
 
 void Timing::ScheduleEventThreadsafe(s64 cycles_into_future, const TimingEventType* event_type,
@@ -73,26 +74,36 @@ void Timing::ScheduleEventThreadsafe(s64 cycles_into_future, const TimingEventTy
 }
 
 void Timing::UnscheduleEvent(const TimingEventType* event_type, u64 userdata) {
-    auto itr = std::remove_if(event_queue.begin(), event_queue.end(), [&](const Event& e) {
-        return e.type == event_type && e.userdata == userdata;
-    });
+    const auto type_events = scheduled_events.find(event_type);
+    if (type_events == scheduled_events.end()) {
+        return;
+    }
+    const auto range = type_events->second.equal_range(userdata);
+    for (auto itr = range.first; itr != range.second; ++itr) {
+        DequeueEvent(itr->second);
+    }
+    type_events->second.erase(range.first, range.second);
+}
 
-    // Removing random items breaks the invariant so we have to re-establish it.
-    if (itr != event_queue.end()) {
-        event_queue.erase(itr, event_queue.end());
-        std::make_heap(event_queue.begin(), event_queue.end(), std::greater<>());
+bool Timing::UnscheduleEvent(TimingEventHandle handle) {
+    if (handle.slot >= event_slots.size() || event_slots[handle.slot].heap_index == FREE_SLOT ||
+        event_slots[handle.slot].event.fifo_order != handle.fifo_order) {
+        return false;
     }
+    ForgetEvent(handle.slot);
+    DequeueEvent(handle.slot);
+    return true;
 }
 
 void Timing::RemoveEvent(const TimingEventType* event_type) {
-    auto itr = std::remove_if(event_queue.begin(), event_queue.end(),
-                              [&](const Event& e) { return e.type == event_type; });
-
-    // Removing random items breaks the invariant so we have to re-establish it.
-    if (itr != event_queue.end()) {
-        event_queue.erase(itr, event_queue.end());
-        std::make_heap(event_queue.begin(), event_queue.end(), std::greater<>());
+    const auto type_events = scheduled_events.find(event_type);
+    if (type_events == scheduled_events.end()) {
+        return;
+    }
+    for (const auto& [userdata, slot] : type_events->second) {
+        DequeueEvent(slot);
     }
+    type_events->second.clear();
 }
 
 void Timing::RemoveNormalAndThreadsafeEvent(const TimingEventType* event_type) {
@@ -111,12 +122,12 @@ void Timing::ForceExceptionCheck(s64 cycles) {
 void Timing::MoveEvents() {
     for (Event ev; ts_queue.Pop(ev);) {
         ev.fifo_order = event_fifo_id++;
-        event_queue.emplace_back(std::move(ev));
-        std::push_heap(event_queue.begin(), event_queue.end(), std::greater<>());
+        QueueEvent(ev);
     }
 }
 
 void Timing::Advance() {
+    Common::ScopedSubsystemTimer timer(Common::Subsystem::CoreTiming);
     MoveEvents();
 
     s64 cycles_executed = slice_length - downcount;
@@ -125,10 +136,11 @@ void Timing::Advance() {
 
     is_global_timer_sane = true;
 
-    while (!event_queue.empty() && event_queue.front().time <= global_timer) {
-        Event evt = std::move(event_queue.front());
-        std::pop_heap(event_queue.begin(), event_queue.end(), std::greater<>());
-        event_queue.pop_back();
+    while (!event_queue.empty() && event_slots[event_queue.front()].event.time <= global_timer) {
+        const u32 slot = event_queue.front();
+        const Event evt = event_slots[slot].event;
+        ForgetEvent(slot);
+        DequeueEvent(slot);
         evt.type->callback(evt.userdata, global_timer - evt.time);
     }
 
@@ -136,8 +148,9 @@ void Timing::Advance() {
 
     // Still events left (scheduled in the future)
     if (!event_queue.empty()) {
-        slice_length = static_cast<int>(
-            std::min<s64>(event_queue.front().time - global_timer, MAX_SLICE_LENGTH));
+        const s64 next_event_time = event_slots[event_queue.front()].event.time;
+        slice_length =
+            static_cast<int>(std::min<s64>(next_event_time - global_timer, MAX_SLICE_LENGTH));
     }
 
     downcount = slice_length;
@@ -156,4 +169,150 @@ s64 Timing::GetDowncount() const {
     return downcount;
 }
 
+void Timing::DoState(PointerWrap& p) {
+    MoveEvents();
+
+    p.Do(global_timer);
+    p.Do(slice_length);
+    p.Do(downcount);
+    p.Do(event_fifo_id);
+    p.Do(idled_cycles);
+    p.Do(is_global_timer_sane);
+
+    u32 num_events = static_cast<u32>(event_queue.size());
+    p.Do(num_events);
+
+    std::vector<Event> events;
+    if (p.GetMode() == PointerWrap::MODE_READ) {
+        events.resize(num_events);
+    } else {
+        events.reserve(num_events);
+        for (const u32 slot : event_queue) {
+            events.push_back(event_slots[slot].event);
+        }
+    }
+
+    for (Event& event : events) {
+        p.Do(event.time);
+        p.Do(event.fifo_order);
+        p.Do(event.userdata);
+
+        std::string name = event.type != nullptr ? *event.type->name : "";
+        p.Do(name);
+        if (p.GetMode() == PointerWrap::MODE_READ) {
+            const auto type = event_types.find(name);
+            if (type == event_types.end()) {
+                LOG_ERROR(Core_Timing, "Savestate contains unknown event type \"{}\"", name);
+                p.SetError(PointerWrap::ERROR_FAILURE);
+                event.type = nullptr;
+                continue;
+            }
+            event.type = &type->second;
+        }
+    }
+
+    if (p.GetMode() == PointerWrap::MODE_READ) {
+        event_slots.clear();
+        free_event_slots.clear();
+        event_queue.clear();
+        scheduled_events.clear();
+        // The queue order only depends on the time and fifo order, which were restored as-is
+        for (const Event& event : events) {
+            if (event.type != nullptr) {
+                QueueEvent(event);
+            }
+        }
+    }
+}
+
+TimingEventHandle Timing::QueueEvent(const Event& event) {
+    u32 slot;
+    if (free_event_slots.empty()) {
+        slot = static_cast<u32>(event_slots.size());
+        event_slots.emplace_back();
+    } else {
+        slot = free_event_slots.back();
+        free_event_slots.pop_back();
+    }
+
+    const u32 heap_index = static_cast<u32>(event_queue.size());
+    event_slots[slot] = EventSlot{event, heap_index};
+    event_queue.push_back(slot);
+    SiftUp(heap_index);
+
+    scheduled_events[event.type].emplace(event.userdata, slot);
+    return TimingEventHandle{slot, event.fifo_order};
+}
+
+void Timing::DequeueEvent(u32 slot) {
+    const u32 heap_index = event_slots[slot].heap_index;
+    const u32 last_slot = event_queue.back();
+    event_queue.pop_back();
+    event_slots[slot].heap_index = FREE_SLOT;
+    free_event_slots.push_back(slot);
+
+    if (last_slot == slot) {
+        return;
+    }
+    // Fill the hole with the last event and restore the heap order around it
+    event_queue[heap_index] = last_slot;
+    event_slots[last_slot].heap_index = heap_index;
+    if (heap_index > 0 && IsEarlier(last_slot, event_queue[(heap_index - 1) / 2])) {
+        SiftUp(heap_index);
+    } else {
+        SiftDown(heap_index);
+    }
+}
+
+void Timing::ForgetEvent(u32 slot) {
+    const Event& event = event_slots[slot].event;
+    auto& type_events = scheduled_events[event.type];
+    const auto range = type_events.equal_range(event.userdata);
+    const auto itr = std::find_if(range.first, range.second,
+                                  [slot](const auto& entry) { return entry.second == slot; });
+    ASSERT(itr != range.second);
+    type_events.erase(itr);
+}
+
+bool Timing::IsEarlier(u32 left_slot, u32 right_slot) const {
+    return event_slots[left_slot].event < event_slots[right_slot].event;
+}
+
+void Timing::SiftUp(u32 heap_index) {
+    const u32 slot = event_queue[heap_index];
+    while (heap_index > 0) {
+        const u32 parent = (heap_index - 1) / 2;
+        if (!IsEarlier(slot, event_queue[parent])) {
+            break;
+        }
+        event_queue[heap_index] = event_queue[parent];
+        event_slots[event_queue[heap_index]].heap_index = heap_index;
+        heap_index = parent;
+    }
+    event_queue[heap_index] = slot;
+    event_slots[slot].heap_index = heap_index;
+}
+
+void Timing::SiftDown(u32 heap_index) {
+    const u32 slot = event_queue[heap_index];
+    const u32 size = static_cast<u32>(event_queue.size());
+    while (true) {
+        u32 child = heap_index * 2 + 1;
+        if (child >= size) {
+            break;
+        }
+        if (child + 1 < size && IsEarlier(event_queue[child + 1], event_queue[child])) {
+            ++child;
+        }
+        if (!IsEarlier(event_queue[child], slot)) {
+            break;
+        }
+        event_queue[heap_index] = event_queue[child];
+        event_slots[event_queue[heap_index]].heap_index = heap_index;
+        heap_index = child;
+    }
+    event_queue[heap_index] = slot;
+    event_slots[slot].heap_index = heap_index;
+}
+
 } // namespace Core
@@ -27,6 +27,8 @@
 #include "common/logging/log.h"
 #include "common/threadsafe_queue.h"
 
+class PointerWrap;
+
 // The timing we get from the assembly is 268,111,855.956 Hz
 // It is possible that this number isn't just an integer because the compiler could have
 // optimized the multiplication by a multiply-by-constant division.
@@ -132,6 +134,12 @@ struct TimingEventType {
     const std::string* name;
 };
 
+/// Identifies a scheduled event until it fires or is unscheduled
+struct TimingEventHandle {
+    u32 slot = std::numeric_limits<u32>::max();
+    u64 fifo_order = 0;
+};
+
 class Timing {
 public:
     ~Timing();
@@ -154,7 +162,8 @@ public:
      * event is scheduled earlier than the current values. Scheduling from a callback will not
      * update the downcount until the Advance() completes.
      */
-    void ScheduleEvent(s64 cycles_into_future, const TimingEventType* event_type, u64 userdata = 0);
+    TimingEventHandle ScheduleEvent(s64 cycles_into_future, const TimingEventType* event_type,
+                                    u64 userdata = 0);
 
     /**
      * This is to be called when outside of hle threads, such as the graphics thread, wants to
@@ -167,6 +176,9 @@ public:
 
     void UnscheduleEvent(const TimingEventType* event_type, u64 userdata);
 
+    /// Unschedules the given event, returns false if it already fired or was unscheduled
+    bool UnscheduleEvent(TimingEventHandle handle);
+
     /// We only permit one event of each type in the queue at a time.
     void RemoveEvent(const TimingEventType* event_type);
     void RemoveNormalAndThreadsafeEvent(const TimingEventType* event_type);
@@ -189,6 +201,9 @@ public:
 
     s64 GetDowncount() const;
 
+    /// Serializes the scheduled events, which are identified by the name of their event type
+    void DoState(PointerWrap& p);
+
 private:
     struct Event {
         s64 time;
@@ -200,6 +215,22 @@ private:
         bool operator<(const Event& right) const;
     };
 
+    /// Storage of a queued event, which keeps its place in event_queue while it is queued
+    struct EventSlot {
+        Event event;
+        u32 heap_index;
+    };
+
+    static constexpr u32 FREE_SLOT = std::numeric_limits<u32>::max();
+
+    TimingEventHandle QueueEvent(const Event& event);
+    /// Removes the event in the given slot from event_queue, but not from scheduled_events
+    void DequeueEvent(u32 slot);
+    void ForgetEvent(u32 slot);
+    bool IsEarlier(u32 left_slot, u32 right_slot) const;
+    void SiftUp(u32 heap_index);
+    void SiftDown(u32 heap_index);
+
     static constexpr int MAX_SLICE_LENGTH = 20000;
 
     s64 global_timer = 0;
@@ -210,11 +241,14 @@ private:
     // elements remain stable regardless of rehashes/resizing.
     std::unordered_map<std::string, TimingEventType> event_types;
 
-    // The queue is a min-heap using std::make_heap/push_heap/pop_heap.
-    // We don't use std::priority_queue because we need to be able to serialize, unserialize and
-    // erase arbitrary events (RemoveEvent()) regardless of the queue order. These aren't
-    // accomodated by the standard adaptor class.
-    std::vector<Event> event_queue;
+    // The queue is a min-heap of indices into event_slots, ordered by time and then fifo order.
+    // Every slot knows its position in the heap, so an event can be removed by handle in
+    // O(log n) without searching the queue or rebuilding the heap.
+    std::vector<EventSlot> event_slots;
+    std::vector<u32> free_event_slots;
+    std::vector<u32> event_queue;
+    // The slots of the queued events of each type by userdata, for unscheduling by type
+    std::unordered_map<const TimingEventType*, std::unordered_multimap<u64, u32>> scheduled_events;
     u64 event_fifo_id = 0;
     // the queue for storing the events from other threads threadsafe until they will be added
     // to the event_queue by the emu thread
@@ -4,6 +4,7 @@
 
 #include <utility>
 #include "common/assert.h"
+#include "common/chunk_file.h"
 #include "common/logging/log.h"
 #include "core/hle/kernel/errors.h"
 #include "core/hle/kernel/handle_table.h"
@@ -102,4 +103,24 @@ void HandleTable::Clear() {
     next_free_slot = 0;
 }
 
+std::vector<SharedPtr<Object>> HandleTable::GetObjects() const {
+    std::vector<SharedPtr<Object>> result;
+    for (const auto& object : objects) {
+        if (object != nullptr) {
+            result.push_back(object);
+        }
+    }
+    return result;
+}
+
+void HandleTable::DoState(PointerWrap& p) {
+    DoExpected(p, next_generation, "handle generation");
+    DoExpected(p, next_free_slot, "free handle slot");
+    for (std::size_t i = 0; i < MAX_COUNT; ++i) {
+        // Object ids start at 0, so empty slots are stored as 0 and objects as their id + 1
+        DoExpected(p, objects[i] != nullptr ? objects[i]->GetObjectId() + 1 : 0, "handle");
+        DoExpected(p, generations[i], "handle slot generation");
+    }
+}
+
 } // namespace Kernel
@@ -6,6 +6,7 @@
 
 #include <array>
 #include <cstddef>
+#include <vector>
 #include "common/common_types.h"
 #include "core/hle/kernel/object.h"
 #include "core/hle/result.h"
@@ -89,6 +90,15 @@ public:
     /// Closes all handles held in this table.
     void Clear();
 
+    /// Returns the objects referenced by the handles of this table.
+    std::vector<SharedPtr<Object>> GetObjects() const;
+
+    /**
+     * Serializes the handles. They aren't restored, the state can only be loaded if the same
+     * handles refer to the same objects as when it was saved.
+     */
+    void DoState(PointerWrap& p);
+
 private:
     /**
      * This is the maximum limit of handles allowed per process in CTR-OS. It can be further
@@ -2,14 +2,25 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <type_traits>
+#include "common/chunk_file.h"
+#include "common/logging/log.h"
+#include "core/hle/kernel/address_arbiter.h"
 #include "core/hle/kernel/client_port.h"
 #include "core/hle/kernel/config_mem.h"
+#include "core/hle/kernel/event.h"
 #include "core/hle/kernel/handle_table.h"
 #include "core/hle/kernel/kernel.h"
 #include "core/hle/kernel/memory.h"
+#include "core/hle/kernel/mutex.h"
 #include "core/hle/kernel/process.h"
 #include "core/hle/kernel/resource_limit.h"
+#include "core/hle/kernel/semaphore.h"
+#include "core/hle/kernel/server_port.h"
+#include "core/hle/kernel/server_session.h"
 #include "core/hle/kernel/shared_page.h"
+#include "core/hle/kernel/svc.h"
 #include "core/hle/kernel/thread.h"
 #include "core/hle/kernel/timer.h"
 
@@ -58,6 +69,510 @@ const ThreadManager& KernelSystem::GetThreadManager() const {
     return *thread_manager;
 }
 
+void DoExpected(PointerWrap& p, u32 value, const char* what) {
+    u32 stored = value;
+    p.Do(stored);
+    if (p.GetMode() == PointerWrap::MODE_READ && stored != value) {
+        LOG_ERROR(Kernel, "Savestate {} doesn't match ({} != {})", what, stored, value);
+        p.SetError(PointerWrap::ERROR_FAILURE);
+    }
+}
+
+/// Synchronization state of a kernel object, only the fields used by its type are stored
+struct ObjectState {
+    SharedPtr<Object> object;
+    std::vector<SharedPtr<Thread>> waiting_threads; ///< Waiting on the object or address arbiter
+    bool signaled = false;                          ///< Event and Timer
+    s32 count = 0;                                  ///< Semaphore available count, Mutex lock count
+    u32 priority = 0;                               ///< Mutex
+    SharedPtr<Thread> thread; ///< Mutex holding thread, ServerSession currently handled thread
+    u64 initial_delay = 0;    ///< Timer
+    u64 interval_delay = 0;   ///< Timer
+    std::vector<SharedPtr<ServerSession>> pending_sessions; ///< ServerPort
+    std::vector<SharedPtr<Thread>> pending_threads;         ///< ServerSession requesting threads
+};
+
+namespace {
+
+/// How the wakeup callback of a thread is stored
+enum class WakeupCallbackKind : u32 {
+    None,   ///< The thread has no callback
+    Stored, ///< The callback is one of the wait SVC callbacks, stored as its WakeupCallbackId
+    Other,  ///< The callback captures state, it can't be stored
+};
+
+/// Wait state of a thread
+struct ThreadState {
+    ThreadStatus status = ThreadStatus::Dead;
+    u32 nominal_priority = 0;
+    u32 current_priority = 0;
+    VAddr wait_address = 0;
+    std::vector<SharedPtr<WaitObject>> wait_objects;
+    std::vector<SharedPtr<Mutex>> held_mutexes;
+    std::vector<SharedPtr<Mutex>> pending_mutexes;
+    WakeupCallbackKind wakeup_callback_kind = WakeupCallbackKind::None;
+    WakeupCallbackId wakeup_callback_id{};
+};
+
+template <typename T>
+SharedPtr<T> FindObject(const ObjectMap& objects, u32 id) {
+    const auto it = objects.find(id);
+    if (it == objects.end()) {
+        return nullptr;
+    }
+    if constexpr (std::is_same_v<T, Object>) {
+        return it->second;
+    } else {
+        return DynamicObjectCast<T>(it->second);
+    }
+}
+
+/// Stores a reference to an object as its id, and resolves the id when loading
+template <typename T>
+void DoObject(PointerWrap& p, SharedPtr<T>& object, const ObjectMap& objects) {
+    // Object ids start at 0, so no object is stored as 0 and objects as their id + 1
+    u32 id = object != nullptr ? object->GetObjectId() + 1 : 0;
+    p.Do(id);
+    if (p.GetMode() != PointerWrap::MODE_READ) {
+        return;
+    }
+
+    object = id != 0 ? FindObject<T>(objects, id - 1) : nullptr;
+    if (id != 0 && object == nullptr) {
+        LOG_ERROR(Kernel, "Savestate references unknown kernel object {}", id - 1);
+        p.SetError(PointerWrap::ERROR_FAILURE);
+    }
+}
+
+template <typename T>
+void DoObjectList(PointerWrap& p, std::vector<SharedPtr<T>>& list, const ObjectMap& objects) {
+    u32 size = static_cast<u32>(list.size());
+    p.Do(size);
+    if (p.GetMode() == PointerWrap::MODE_READ) {
+        list.resize(size);
+    }
+    for (auto& object : list) {
+        DoObject(p, object, objects);
+    }
+}
+
+WakeupCallbackKind GetWakeupCallbackKind(const Thread& thread, WakeupCallbackId& id) {
+    if (!thread.wakeup_callback) {
+        return WakeupCallbackKind::None;
+    }
+    if (const auto target = thread.wakeup_callback.target<Thread::WakeupCallback*>()) {
+        for (u32 i = 0; i < static_cast<u32>(WakeupCallbackId::Count); ++i) {
+            if (*target == GetWakeupCallback(static_cast<WakeupCallbackId>(i))) {
+                id = static_cast<WakeupCallbackId>(i);
+                return WakeupCallbackKind::Stored;
+            }
+        }
+    }
+    return WakeupCallbackKind::Other;
+}
+
+ThreadState GetThreadState(const Thread& thread) {
+    ThreadState state;
+    state.status = thread.status;
+    state.nominal_priority = thread.nominal_priority;
+    state.current_priority = thread.current_priority;
+    state.wait_address = thread.wait_address;
+    state.wait_objects = thread.wait_objects;
+    state.held_mutexes.assign(thread.held_mutexes.begin(), thread.held_mutexes.end());
+    state.pending_mutexes.assign(thread.pending_mutexes.begin(), thread.pending_mutexes.end());
+    state.wakeup_callback_kind = GetWakeupCallbackKind(thread, state.wakeup_callback_id);
+    return state;
+}
+
+void DoThreadState(PointerWrap& p, ThreadState& state, const ObjectMap& objects) {
+    p.Do(state.status);
+    p.Do(state.nominal_priority);
+    p.Do(state.current_priority);
+    p.Do(state.wait_address);
+    DoObjectList(p, state.wait_objects, objects);
+    DoObjectList(p, state.held_mutexes, objects);
+    DoObjectList(p, state.pending_mutexes, objects);
+    p.Do(state.wakeup_callback_kind);
+    p.Do(state.wakeup_callback_id);
+}
+
+} // Anonymous namespace
+
+ObjectMap KernelSystem::GetStateObjects() const {
+    ObjectMap objects;
+    const auto add = [&objects](SharedPtr<Object> object) {
+        objects.emplace(object->GetObjectId(), std::move(object));
+    };
+
+    for (const auto& process : process_list) {
+        for (auto& object : process->handle_table.GetObjects()) {
+            add(std::move(object));
+        }
+    }
+    for (const auto& thread : thread_manager->thread_list) {
+        add(thread);
+        for (const auto& object : thread->wait_objects) {
+            add(object);
+        }
+        for (const auto& mutex : thread->held_mutexes) {
+            add(mutex);
+        }
+        for (const auto& mutex : thread->pending_mutexes) {
+            add(mutex);
+        }
+    }
+
+    // Sessions waiting to be accepted don't have a handle yet
+    std::vector<SharedPtr<ServerSession>> pending_sessions;
+    for (const auto& [id, object] : objects) {
+        if (const auto port = DynamicObjectCast<ServerPort>(object)) {
+            pending_sessions.insert(pending_sessions.end(), port->pending_sessions.begin(),
+                                    port->pending_sessions.end());
+        }
+    }
+    for (auto& session : pending_sessions) {
+        add(std::move(session));
+    }
+    return objects;
+}
+
+void KernelSystem::DoObjectState(PointerWrap& p, ObjectState& state, const ObjectMap& objects) {
+    DoObject(p, state.object, objects);
+    if (state.object == nullptr) {
+        return;
+    }
+
+    const bool saving = p.GetMode() != PointerWrap::MODE_READ;
+    if (const auto wait_object = DynamicObjectCast<WaitObject>(state.object)) {
+        if (saving) {
+            state.waiting_threads = wait_object->GetWaitingThreads();
+        }
+        DoObjectList(p, state.waiting_threads, objects);
+    }
+
+    switch (state.object->GetHandleType()) {
+    case HandleType::Event: {
+        const auto event = static_cast<Event*>(state.object.get());
+        if (saving) {
+            state.signaled = event->signaled;
+        }
+        p.Do(state.signaled);
+        break;
+    }
+    case HandleType::Semaphore: {
+        const auto semaphore = static_cast<Semaphore*>(state.object.get());
+        if (saving) {
+            state.count = semaphore->available_count;
+        }
+        p.Do(state.count);
+        break;
+    }
+    case HandleType::Mutex: {
+        const auto mutex = static_cast<Mutex*>(state.object.get());
+        if (saving) {
+            state.count = mutex->lock_count;
+            state.priority = mutex->priority;
+            state.thread = mutex->holding_thread;
+        }
+        p.Do(state.count);
+        p.Do(state.priority);
+        DoObject(p, state.thread, objects);
+        break;
+    }
+    case HandleType::Timer: {
+        const auto timer = static_cast<Timer*>(state.object.get());
+        if (saving) {
+            state.signaled = timer->signaled;
+            state.initial_delay = timer->initial_delay;
+            state.interval_delay = timer->interval_delay;
+        }
+        p.Do(state.signaled);
+        p.Do(state.initial_delay);
+        p.Do(state.interval_delay);
+        break;
+    }
+    case HandleType::ServerPort: {
+        const auto port = static_cast<ServerPort*>(state.object.get());
+        if (saving) {
+            state.pending_sessions = port->pending_sessions;
+        }
+        DoObjectList(p, state.pending_sessions, objects);
+        break;
+    }
+    case HandleType::ServerSession: {
+        const auto session = static_cast<ServerSession*>(state.object.get());
+        if (saving) {
+            state.pending_threads = session->pending_requesting_threads;
+            state.thread = session->currently_handling;
+        }
+        DoObjectList(p, state.pending_threads, objects);
+        DoObject(p, state.thread, objects);
+        break;
+    }
+    case HandleType::AddressArbiter: {
+        const auto arbiter = static_cast<AddressArbiter*>(state.object.get());
+        if (saving) {
+            state.waiting_threads = arbiter->waiting_threads;
+        }
+        DoObjectList(p, state.waiting_threads, objects);
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+void KernelSystem::RestoreObjectState(const ObjectState& state) {
+    if (const auto wait_object = DynamicObjectCast<WaitObject>(state.object)) {
+        for (const auto& thread : state.waiting_threads) {
+            wait_object->AddWaitingThread(thread);
+        }
+    }
+
+    // The waiting threads are added first, adding them recomputes the mutex priority
+    switch (state.object->GetHandleType()) {
+    case HandleType::Event:
+        static_cast<Event*>(state.object.get())->signaled = state.signaled;
+        break;
+    case HandleType::Semaphore:
+        static_cast<Semaphore*>(state.object.get())->available_count = state.count;
+        break;
+    case HandleType::Mutex: {
+        const auto mutex = static_cast<Mutex*>(state.object.get());
+        mutex->lock_count = state.count;
+        mutex->priority = state.priority;
+        mutex->holding_thread = state.thread;
+        break;
+    }
+    case HandleType::Timer: {
+        const auto timer = static_cast<Timer*>(state.object.get());
+        timer->signaled = state.signaled;
+        timer->initial_delay = state.initial_delay;
+        timer->interval_delay = state.interval_delay;
+        break;
+    }
+    case HandleType::ServerPort:
+        static_cast<ServerPort*>(state.object.get())->pending_sessions = state.pending_sessions;
+        break;
+    case HandleType::ServerSession: {
+        const auto session = static_cast<ServerSession*>(state.object.get());
+        session->pending_requesting_threads = state.pending_threads;
+        session->currently_handling = state.thread;
+        break;
+    }
+    case HandleType::AddressArbiter:
+        static_cast<AddressArbiter*>(state.object.get())->waiting_threads = state.waiting_threads;
+        break;
+    default:
+        break;
+    }
+}
+
+void KernelSystem::DoState(PointerWrap& p) {
+    // Any object created since the state was saved could be referenced by the guest
+    u32 object_id = next_object_id;
+    p.Do(object_id);
+    if (p.GetMode() == PointerWrap::MODE_READ && object_id != next_object_id) {
+        LOG_ERROR(Kernel, "Savestate was made with a different set of kernel objects");
+        p.SetError(PointerWrap::ERROR_FAILURE);
+        return;
+    }
+
+    // Objects can still have been destroyed, and memory mapped or unmapped
+    const bool loading = p.GetMode() == PointerWrap::MODE_READ;
+    DoExpected(p, static_cast<u32>(process_list.size()), "process count");
+    for (const auto& process : process_list) {
+        DoExpected(p, process->process_id, "process id");
+        DoExpected(p, process->memory_used, "process memory usage");
+        DoExpected(p, static_cast<u32>(process->vm_manager.vma_map.size()), "memory area count");
+        for (const auto& [base, vma] : process->vm_manager.vma_map) {
+            DoExpected(p, base, "memory area");
+            DoExpected(p, vma.size, "memory area size");
+            DoExpected(p, static_cast<u32>(vma.meminfo_state), "memory area state");
+            DoExpected(p, static_cast<u32>(vma.permissions), "memory area permissions");
+        }
+        process->handle_table.DoState(p);
+    }
+
+    const auto& thread_list = thread_manager->thread_list;
+    DoExpected(p, static_cast<u32>(thread_list.size()), "thread count");
+    DoExpected(p, thread_manager->next_thread_id, "next thread id");
+    for (const auto& thread : thread_list) {
+        DoExpected(p, thread->thread_id, "thread id");
+    }
+    if (loading && p.GetMode() != PointerWrap::MODE_READ) {
+        return;
+    }
+
+    // Everything is read and checked before any of it is applied, so that a failed load leaves
+    // the kernel untouched
+    const ObjectMap objects = GetStateObjects();
+    std::vector<ObjectState> object_states;
+    if (!loading) {
+        std::vector<u32> ids;
+        for (const auto& [id, object] : objects) {
+            ids.push_back(id);
+        }
+        std::sort(ids.begin(), ids.end());
+        object_states.resize(ids.size());
+        for (std::size_t i = 0; i < ids.size(); ++i) {
+            object_states[i].object = objects.at(ids[i]);
+        }
+    }
+    u32 object_count = static_cast<u32>(object_states.size());
+    p.Do(object_count);
+    if (loading) {
+        object_states.resize(object_count);
+    }
+    for (auto& state : object_states) {
+        DoObjectState(p, state, objects);
+    }
+
+    std::vector<ThreadState> thread_states(thread_list.size());
+    for (std::size_t i = 0; i < thread_list.size(); ++i) {
+        ThreadState& state = thread_states[i];
+        if (!loading) {
+            state = GetThreadState(*thread_list[i]);
+        }
+        DoThreadState(p, state, objects);
+    }
+
+    std::array<std::vector<SharedPtr<Thread>>, ThreadPrioLowest + 1> ready_threads;
+    for (u32 priority = ThreadPrioHighest; priority <= ThreadPrioLowest; ++priority) {
+        if (!loading) {
+            const auto& queue = thread_manager->ready_queue.get_queue(priority);
+            ready_threads[priority].assign(queue.begin(), queue.end());
+        }
+        DoObjectList(p, ready_threads[priority], objects);
+    }
+
+    SharedPtr<Thread> current_thread = thread_manager->current_thread;
+    DoObject(p, current_thread, objects);
+
+    if (loading) {
+        if (p.GetMode() != PointerWrap::MODE_READ) {
+            return;
+        }
+
+        for (std::size_t i = 0; i < thread_list.size(); ++i) {
+            const Thread& thread = *thread_list[i];
+            const ThreadState& state = thread_states[i];
+            if (state.status > ThreadStatus::Dead || state.current_priority > ThreadPrioLowest ||
+                state.nominal_priority > ThreadPrioLowest) {
+                LOG_ERROR(Kernel, "Savestate has an invalid state for thread {}",
+                          thread.thread_id);
+                p.SetError(PointerWrap::ERROR_FAILURE);
+                return;
+            }
+
+            // A callback with captured state can only be kept as it is, for the same wait
+            WakeupCallbackId id{};
+            const WakeupCallbackKind kind = GetWakeupCallbackKind(thread, id);
+            if (kind == WakeupCallbackKind::Other ||
+                state.wakeup_callback_kind == WakeupCallbackKind::Other) {
+                if (kind != state.wakeup_callback_kind || thread.status != state.status ||
+                    thread.wait_objects != state.wait_objects ||
+                    thread.wait_address != state.wait_address) {
+                    LOG_ERROR(Kernel, "Savestate has thread {} in a different unstored wait",
+                              thread.thread_id);
+                    p.SetError(PointerWrap::ERROR_FAILURE);
+                    return;
+                }
+            } else if (state.wakeup_callback_kind > WakeupCallbackKind::Other ||
+                       (state.wakeup_callback_kind == WakeupCallbackKind::Stored &&
+                        state.wakeup_callback_id >= WakeupCallbackId::Count)) {
+                LOG_ERROR(Kernel, "Savestate has an unknown wakeup callback for thread {}",
+                          thread.thread_id);
+                p.SetError(PointerWrap::ERROR_FAILURE);
+                return;
+            }
+        }
+
+        if (current_thread != nullptr && current_thread->owner_process != current_process) {
+            LOG_ERROR(Kernel, "Savestate was made while another process was running");
+            p.SetError(PointerWrap::ERROR_FAILURE);
+            return;
+        }
+
+        // Objects missing from the state had no waiting threads and no holder when it was saved
+        for (const auto& [id, object] : objects) {
+            if (const auto wait_object = DynamicObjectCast<WaitObject>(object)) {
+                const auto waiting_threads = wait_object->GetWaitingThreads();
+                for (const auto& thread : waiting_threads) {
+                    wait_object->RemoveWaitingThread(thread.get());
+                }
+            }
+            if (const auto mutex = DynamicObjectCast<Mutex>(object)) {
+                mutex->lock_count = 0;
+                mutex->holding_thread = nullptr;
+            } else if (const auto arbiter = DynamicObjectCast<AddressArbiter>(object)) {
+                arbiter->waiting_threads.clear();
+            }
+        }
+        for (const auto& state : object_states) {
+            RestoreObjectState(state);
+        }
+
+        for (std::size_t i = 0; i < thread_list.size(); ++i) {
+            Thread& thread = *thread_list[i];
+            const ThreadState& state = thread_states[i];
+            thread.status = state.status;
+            thread.nominal_priority = state.nominal_priority;
+            thread.current_priority = state.current_priority;
+            thread.wait_address = state.wait_address;
+            thread.wait_objects = state.wait_objects;
+            thread.held_mutexes.clear();
+            thread.held_mutexes.insert(state.held_mutexes.begin(), state.held_mutexes.end());
+            thread.pending_mutexes.clear();
+            thread.pending_mutexes.insert(state.pending_mutexes.begin(),
+                                          state.pending_mutexes.end());
+            if (state.wakeup_callback_kind == WakeupCallbackKind::None) {
+                thread.wakeup_callback = nullptr;
+            } else if (state.wakeup_callback_kind == WakeupCallbackKind::Stored) {
+                thread.wakeup_callback = GetWakeupCallback(state.wakeup_callback_id);
+            }
+        }
+
+        auto& ready_queue = thread_manager->ready_queue;
+        for (u32 priority = ThreadPrioHighest; priority <= ThreadPrioLowest; ++priority) {
+            const auto queue = ready_queue.get_queue(priority);
+            for (Thread* thread : queue) {
+                ready_queue.remove(priority, thread);
+            }
+        }
+        for (u32 priority = ThreadPrioHighest; priority <= ThreadPrioLowest; ++priority) {
+            for (const auto& thread : ready_threads[priority]) {
+                ready_queue.prepare(priority);
+                ready_queue.push_back(priority, thread.get());
+            }
+        }
+
+        thread_manager->current_thread = std::move(current_thread);
+    }
+
+    thread_manager->DoState(p);
+}
+
+void KernelSystem::DoObjectReference(PointerWrap& p, SharedPtr<Object>& object) const {
+    // Only loading needs to look up the objects
+    const ObjectMap objects =
+        p.GetMode() == PointerWrap::MODE_READ ? GetStateObjects() : ObjectMap{};
+    DoObject(p, object, objects);
+}
+
+void KernelSystem::DoObjectReference(PointerWrap& p, SharedPtr<Event>& event) const {
+    SharedPtr<Object> object = event;
+    DoObjectReference(p, object);
+    if (p.GetMode() == PointerWrap::MODE_READ) {
+        event = DynamicObjectCast<Event>(object);
+        if (object != nullptr && event == nullptr) {
+            LOG_ERROR(Kernel, "Savestate references kernel object {} as an event",
+                      object->GetObjectId());
+            p.SetError(PointerWrap::ERROR_FAILURE);
+        }
+    }
+}
+
 TimerManager& KernelSystem::GetTimerManager() {
     return *timer_manager;
 }
@@ -28,6 +28,8 @@ namespace Memory {
 class MemorySystem;
 }
 
+class PointerWrap;
+
 namespace Core {
 class Timing;
 }
@@ -38,6 +40,7 @@ class AddressArbiter;
 class Event;
 class Mutex;
 class CodeSet;
+class Object;
 class Process;
 class Thread;
 class Semaphore;
@@ -52,6 +55,7 @@ class ThreadManager;
 class TimerManager;
 class VMManager;
 struct AddressMapping;
+struct ObjectState;
 
 enum class ResetType {
     OneShot,
@@ -81,6 +85,12 @@ enum class MemoryRegion : u16 {
 template <typename T>
 using SharedPtr = boost::intrusive_ptr<T>;
 
+/// Stores the value in a savestate, or checks that it matches the stored one when loading
+void DoExpected(PointerWrap& p, u32 value, const char* what);
+
+/// Kernel objects by id, used to resolve the object references of a savestate
+using ObjectMap = std::unordered_map<u32, SharedPtr<Object>>;
+
 class KernelSystem {
 public:
     explicit KernelSystem(Memory::MemorySystem& memory, Core::Timing& timing,
@@ -234,6 +244,23 @@ public:
         prepare_reschedule_callback();
     }
 
+    /**
+     * Serializes the kernel state. Kernel objects aren't created or destroyed by loading a state,
+     * so it can only be loaded into a kernel with the same objects, handles and memory layout,
+     * like a later point of the session which saved it, or another session of the same title
+     * which created the same objects. The synchronization state of the objects and the wait
+     * state, priority and context of the threads are restored.
+     */
+    void DoState(PointerWrap& p);
+
+    /**
+     * Serializes a reference to a kernel object held by an HLE service, as the id of the object.
+     * Only objects whose state is stored, like the ones the guest has a handle to, can be
+     * referenced.
+     */
+    void DoObjectReference(PointerWrap& p, SharedPtr<Object>& object) const;
+    void DoObjectReference(PointerWrap& p, SharedPtr<Event>& event) const;
+
     /// Map of named ports managed by the kernel, which can be retrieved using the ConnectToPort
     std::unordered_map<std::string, SharedPtr<ClientPort>> named_ports;
 
@@ -244,6 +271,15 @@ public:
 private:
     void MemoryInit(u32 mem_type);
 
+    /// Returns the objects whose state is stored in savestates
+    ObjectMap GetStateObjects() const;
+
+    /// Serializes the synchronization state of an object, filling it from the object when saving
+    void DoObjectState(PointerWrap& p, ObjectState& state, const ObjectMap& objects);
+
+    /// Applies a loaded object state, after the waiting threads of all objects were removed
+    void RestoreObjectState(const ObjectState& state);
+
     std::function<void()> prepare_reschedule_callback;
 
     std::unique_ptr<ResourceLimitList> resource_limits;
@@ -44,6 +44,7 @@ ResultVal<SharedPtr<SharedMemory>> KernelSystem::CreateSharedMemory(
         ASSERT_MSG(offset, "Not enough space in region to allocate shared memory!");
 
         std::fill(memory.GetFCRAMPointer(*offset), memory.GetFCRAMPointer(*offset + size), 0);
+        memory.MarkRegionDirty(Memory::FCRAM_PADDR + *offset, size);
         shared_memory->backing_blocks = {{memory.GetFCRAMPointer(*offset), size}};
         shared_memory->holding_memory += MemoryRegionInfo::Interval(*offset, *offset + size);
         shared_memory->linear_heap_phys_offset = *offset;
@@ -89,6 +90,8 @@ SharedPtr<SharedMemory> KernelSystem::CreateSharedMemoryForApplet(
             {memory.GetFCRAMPointer(interval.lower()), interval.upper() - interval.lower()});
         std::fill(memory.GetFCRAMPointer(interval.lower()),
                   memory.GetFCRAMPointer(interval.upper()), 0);
+        memory.MarkRegionDirty(Memory::FCRAM_PADDR + interval.lower(),
+                               interval.upper() - interval.lower());
     }
     shared_memory->base_address = Memory::HEAP_VADDR + offset;
 
@@ -193,6 +196,10 @@ u8* SharedMemory::GetPointer(u32 offset) {
     if (backing_blocks.size() != 1) {
         LOG_WARNING(Kernel, "Unsafe GetPointer on discontinuous SharedMemory");
     }
+    // The caller may write anywhere in the block
+    for (const auto& block : backing_blocks) {
+        kernel.memory.MarkMemoryDirty(block.first, block.second);
+    }
     return backing_blocks[0].first + offset;
 }
 
@@ -37,6 +37,7 @@
 #include "core/hle/lock.h"
 #include "core/hle/result.h"
 #include "core/hle/service/service.h"
+#include "core/idle_loop_detector.h"
 
 namespace Kernel {
 
@@ -395,6 +396,69 @@ ResultCode SVC::CloseHandle(Handle handle) {
     return kernel.GetCurrentProcess()->handle_table.Close(handle);
 }
 
+// The wakeup callbacks of the wait SVCs are plain functions, so that savestates can store them by
+// their WakeupCallbackId
+
+static void WakeupWaitSynchronization1(ThreadWakeupReason reason, SharedPtr<Thread> thread,
+                                       SharedPtr<WaitObject> object) {
+    ASSERT(thread->status == ThreadStatus::WaitSynchAny);
+
+    if (reason == ThreadWakeupReason::Timeout) {
+        thread->SetWaitSynchronizationResult(RESULT_TIMEOUT);
+        return;
+    }
+
+    ASSERT(reason == ThreadWakeupReason::Signal);
+    thread->SetWaitSynchronizationResult(RESULT_SUCCESS);
+
+    // WaitSynchronization1 doesn't have an output index like WaitSynchronizationN, so we don't
+    // have to do anything else here.
+}
+
+static void WakeupWaitSynchronizationAll(ThreadWakeupReason reason, SharedPtr<Thread> thread,
+                                         SharedPtr<WaitObject> object) {
+    ASSERT(thread->status == ThreadStatus::WaitSynchAll);
+
+    if (reason == ThreadWakeupReason::Timeout) {
+        thread->SetWaitSynchronizationResult(RESULT_TIMEOUT);
+        return;
+    }
+
+    ASSERT(reason == ThreadWakeupReason::Signal);
+
+    thread->SetWaitSynchronizationResult(RESULT_SUCCESS);
+    // The wait_all case does not update the output index.
+}
+
+static void WakeupWaitSynchronizationAny(ThreadWakeupReason reason, SharedPtr<Thread> thread,
+                                         SharedPtr<WaitObject> object) {
+    ASSERT(thread->status == ThreadStatus::WaitSynchAny);
+
+    if (reason == ThreadWakeupReason::Timeout) {
+        thread->SetWaitSynchronizationResult(RESULT_TIMEOUT);
+        return;
+    }
+
+    ASSERT(reason == ThreadWakeupReason::Signal);
+
+    thread->SetWaitSynchronizationResult(RESULT_SUCCESS);
+    thread->SetWaitSynchronizationOutput(thread->GetWaitObjectIndex(object.get()));
+}
+
+Thread::WakeupCallback* GetWakeupCallback(WakeupCallbackId id) {
+    switch (id) {
+    case WakeupCallbackId::WaitSynchronization1:
+        return WakeupWaitSynchronization1;
+    case WakeupCallbackId::WaitSynchronizationAll:
+        return WakeupWaitSynchronizationAll;
+    case WakeupCallbackId::WaitSynchronizationAny:
+        return WakeupWaitSynchronizationAny;
+    default:
+        UNREACHABLE();
+        return nullptr;
+    }
+}
+
 /// Wait for a handle to synchronize, timeout after the specified nanoseconds
 ResultCode SVC::WaitSynchronization1(Handle handle, s64 nano_seconds) {
     auto object = kernel.GetCurrentProcess()->handle_table.Get<WaitObject>(handle);
@@ -418,21 +482,7 @@ ResultCode SVC::WaitSynchronization1(Handle handle, s64 nano_seconds) {
         // Create an event to wake the thread up after the specified nanosecond delay has passed
         thread->WakeAfterDelay(nano_seconds);
 
-        thread->wakeup_callback = [](ThreadWakeupReason reason, SharedPtr<Thread> thread,
-                                     SharedPtr<WaitObject> object) {
-            ASSERT(thread->status == ThreadStatus::WaitSynchAny);
-
-            if (reason == ThreadWakeupReason::Timeout) {
-                thread->SetWaitSynchronizationResult(RESULT_TIMEOUT);
-                return;
-            }
-
-            ASSERT(reason == ThreadWakeupReason::Signal);
-            thread->SetWaitSynchronizationResult(RESULT_SUCCESS);
-
-            // WaitSynchronization1 doesn't have an output index like WaitSynchronizationN, so we
-            // don't have to do anything else here.
-        };
+        thread->wakeup_callback = WakeupWaitSynchronization1;
 
         system.PrepareReschedule();
 
@@ -507,20 +557,7 @@ ResultCode SVC::WaitSynchronizationN(s32* out, VAddr handles_address, s32 handle
         // Create an event to wake the thread up after the specified nanosecond delay has passed
         thread->WakeAfterDelay(nano_seconds);
 
-        thread->wakeup_callback = [](ThreadWakeupReason reason, SharedPtr<Thread> thread,
-                                     SharedPtr<WaitObject> object) {
-            ASSERT(thread->status == ThreadStatus::WaitSynchAll);
-
-            if (reason == ThreadWakeupReason::Timeout) {
-                thread->SetWaitSynchronizationResult(RESULT_TIMEOUT);
-                return;
-            }
-
-            ASSERT(reason == ThreadWakeupReason::Signal);
-
-            thread->SetWaitSynchronizationResult(RESULT_SUCCESS);
-            // The wait_all case does not update the output index.
-        };
+        thread->wakeup_callback = WakeupWaitSynchronizationAll;
 
         system.PrepareReschedule();
 
@@ -567,20 +604,7 @@ ResultCode SVC::WaitSynchronizationN(s32* out, VAddr handles_address, s32 handle
         // Create an event to wake the thread up after the specified nanosecond delay has passed
         thread->WakeAfterDelay(nano_seconds);
 
-        thread->wakeup_callback = [](ThreadWakeupReason reason, SharedPtr<Thread> thread,
-                                     SharedPtr<WaitObject> object) {
-            ASSERT(thread->status == ThreadStatus::WaitSynchAny);
-
-            if (reason == ThreadWakeupReason::Timeout) {
-                thread->SetWaitSynchronizationResult(RESULT_TIMEOUT);
-                return;
-            }
-
-            ASSERT(reason == ThreadWakeupReason::Signal);
-
-            thread->SetWaitSynchronizationResult(RESULT_SUCCESS);
-            thread->SetWaitSynchronizationOutput(thread->GetWaitObjectIndex(object.get()));
-        };
+        thread->wakeup_callback = WakeupWaitSynchronizationAny;
 
         system.PrepareReschedule();
 
@@ -1568,6 +1592,21 @@ const SVC::FunctionDef* SVC::GetSVCInfo(u32 func_num) {
 
 MICROPROFILE_DEFINE(Kernel_SVC, "Kernel", "SVC", MP_RGB(70, 200, 70));
 
+/// Returns whether a thread calling the SVC over and over without being put to sleep is likely
+/// waiting for something to happen
+static bool IsIdleLoopSVC(u32 immediate) {
+    switch (immediate) {
+    case 0x0A: // SleepThread
+    case 0x22: // ArbitrateAddress
+    case 0x24: // WaitSynchronization1
+    case 0x25: // WaitSynchronizationN
+    case 0x28: // GetSystemTick
+        return true;
+    default:
+        return false;
+    }
+}
+
 void SVC::CallSVC(u32 immediate) {
     MICROPROFILE_SCOPE(Kernel_SVC);
 
@@ -1585,6 +1624,20 @@ void SVC::CallSVC(u32 immediate) {
             LOG_ERROR(Kernel_SVC, "unimplemented SVC function {}(..)", info->name);
         }
     }
+
+    if (IsIdleLoopSVC(immediate)) {
+        const Thread* thread = kernel.GetThreadManager().GetCurrentThread();
+        if (thread != nullptr && thread->status == ThreadStatus::Running) {
+            Core::IdleLoopDetector::Registers registers;
+            for (std::size_t i = 0; i < registers.size(); ++i) {
+                registers[i] = GetReg(i);
+            }
+            if (system.IdleDetector().OnSVC(thread->GetThreadId(), immediate,
+                                            system.CPU().GetPC(), registers)) {
+                system.CPU().PrepareReschedule();
+            }
+        }
+    }
 }
 
 SVC::SVC(Core::System& system) : system(system), kernel(system.Kernel()), memory(system.Memory()) {}
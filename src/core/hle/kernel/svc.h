@@ -6,6 +6,7 @@
 
 #include <memory>
 #include "common/common_types.h"
+#include "core/hle/kernel/thread.h"
 
 namespace Core {
 class System;
@@ -25,4 +26,16 @@ private:
     std::unique_ptr<SVC> impl;
 };
 
+/// Wakeup callbacks of the wait SVCs, identified by ids which stay the same across builds, so
+/// that savestates can store them
+enum class WakeupCallbackId : u32 {
+    WaitSynchronization1,
+    WaitSynchronizationAll,
+    WaitSynchronizationAny,
+    Count,
+};
+
+/// Returns the wakeup callback with the given id
+Thread::WakeupCallback* GetWakeupCallback(WakeupCallbackId id);
+
 } // namespace Kernel
@@ -7,6 +7,7 @@
 #include <unordered_map>
 #include <vector>
 #include "common/assert.h"
+#include "common/chunk_file.h"
 #include "common/common_types.h"
 #include "common/logging/log.h"
 #include "common/math_util.h"
@@ -477,4 +478,50 @@ const std::vector<SharedPtr<Thread>>& ThreadManager::GetThreadList() {
     return thread_list;
 }
 
+static void DoContextState(PointerWrap& p, ARM_Interface::ThreadContext& context) {
+    const bool reading = p.GetMode() == PointerWrap::MODE_READ;
+    for (std::size_t i = 0; i < 16; ++i) {
+        u32 value = context.GetCpuRegister(i);
+        p.Do(value);
+        if (reading) {
+            context.SetCpuRegister(i, value);
+        }
+    }
+    for (std::size_t i = 0; i < 64; ++i) {
+        u32 value = context.GetFpuRegister(i);
+        p.Do(value);
+        if (reading) {
+            context.SetFpuRegister(i, value);
+        }
+    }
+
+    u32 cpsr = context.GetCpsr();
+    u32 fpscr = context.GetFpscr();
+    u32 fpexc = context.GetFpexc();
+    p.Do(cpsr);
+    p.Do(fpscr);
+    p.Do(fpexc);
+    if (reading) {
+        context.SetCpsr(cpsr);
+        context.SetFpscr(fpscr);
+        context.SetFpexc(fpexc);
+    }
+}
+
+void ThreadManager::DoState(PointerWrap& p) {
+    if (current_thread && p.GetMode() != PointerWrap::MODE_READ) {
+        cpu->SaveContext(current_thread->context);
+    }
+
+    for (const auto& thread : thread_list) {
+        DoContextState(p, *thread->context);
+        p.Do(thread->last_running_ticks);
+    }
+
+    if (current_thread && p.GetMode() == PointerWrap::MODE_READ) {
+        cpu->LoadContext(current_thread->context);
+        cpu->SetCP15Register(CP15_THREAD_URO, current_thread->GetTLSAddress());
+    }
+}
+
 } // namespace Kernel
@@ -17,6 +17,8 @@
 #include "core/hle/kernel/wait_object.h"
 #include "core/hle/result.h"
 
+class PointerWrap;
+
 namespace Kernel {
 
 class Mutex;
@@ -101,6 +103,12 @@ public:
      */
     const std::vector<SharedPtr<Thread>>& GetThreadList();
 
+    /**
+     * Serializes the CPU context of all threads. The threads themselves aren't recreated, the
+     * kernel checks that the thread list matches and restores their wait state beforehand.
+     */
+    void DoState(PointerWrap& p);
+
     void SetCPU(ARM_Interface& cpu) {
         this->cpu = &cpu;
     }
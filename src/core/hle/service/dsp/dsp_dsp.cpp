@@ -4,6 +4,7 @@
 
 #include "audio_core/audio_types.h"
 #include "common/assert.h"
+#include "common/chunk_file.h"
 #include "common/logging/log.h"
 #include "core/core.h"
 #include "core/hle/ipc_helpers.h"
@@ -385,6 +386,15 @@ DSP_DSP::DSP_DSP(Core::System& system)
         [this]() { this->system.DSP().SetSemaphore(preset_semaphore); });
 }
 
+void DSP_DSP::DoState(PointerWrap& p) {
+    p.Do(preset_semaphore);
+    system.Kernel().DoObjectReference(p, interrupt_zero);
+    system.Kernel().DoObjectReference(p, interrupt_one);
+    for (auto& pipe : pipes) {
+        system.Kernel().DoObjectReference(p, pipe);
+    }
+}
+
 DSP_DSP::~DSP_DSP() {
     semaphore_event = nullptr;
     pipes = {};
@@ -394,6 +404,7 @@ void InstallInterfaces(Core::System& system) {
     auto& service_manager = system.ServiceManager();
     auto dsp = std::make_shared<DSP_DSP>(system);
     dsp->InstallAsService(service_manager);
+    service_manager.RegisterStateHandler("dsp::DSP", [dsp](PointerWrap& p) { dsp->DoState(p); });
     system.DSP().SetServiceToInterrupt(std::move(dsp));
 }
 
@@ -30,6 +30,9 @@ public:
     /// Signal interrupt on pipe
     void SignalInterrupt(InterruptType type, AudioCore::DspPipe pipe);
 
+    /// Serializes the semaphore and the interrupt events registered by the guest
+    void DoState(PointerWrap& p);
+
 private:
     /**
      * DSP_DSP::RecvData service function
@@ -28,6 +28,7 @@ void InstallInterfaces(Core::System& system) {
     auto& service_manager = system.ServiceManager();
     auto gpu = std::make_shared<GSP_GPU>(system);
     gpu->InstallAsService(service_manager);
+    service_manager.RegisterStateHandler("gsp::Gpu", [gpu](PointerWrap& p) { gpu->DoState(p); });
     gsp_gpu = gpu;
 
     std::make_shared<GSP_LCD>()->InstallAsService(service_manager);
@@ -4,6 +4,7 @@
 
 #include <vector>
 #include "common/bit_field.h"
+#include "common/chunk_file.h"
 #include "common/microprofile.h"
 #include "common/swap.h"
 #include "core/core.h"
@@ -821,6 +822,38 @@ GSP_GPU::GSP_GPU(Core::System& system) : ServiceFramework("gsp::Gpu", 2), system
     first_initialization = true;
 };
 
+void GSP_GPU::DoState(PointerWrap& p) {
+    p.Do(active_thread_id);
+    p.Do(first_initialization);
+
+    // The sessions themselves belong to the kernel, only the data attached to them is stored
+    u32 num_sessions = static_cast<u32>(connected_sessions.size());
+    p.Do(num_sessions);
+    if (num_sessions != connected_sessions.size()) {
+        LOG_ERROR(Service_GSP, "State has {} sessions, {} are connected", num_sessions,
+                  connected_sessions.size());
+        p.SetError(PointerWrap::ERROR_FAILURE);
+        return;
+    }
+    for (auto& session_info : connected_sessions) {
+        SessionData* data = static_cast<SessionData*>(session_info.data.get());
+        system.Kernel().DoObjectReference(p, data->interrupt_event);
+        p.Do(data->thread_id);
+        p.Do(data->registered);
+        if (data->thread_id >= MaxGSPThreads) {
+            p.SetError(PointerWrap::ERROR_FAILURE);
+            return;
+        }
+    }
+
+    if (p.GetMode() == PointerWrap::MODE_READ) {
+        used_thread_ids.fill(false);
+        for (const auto& session_info : connected_sessions) {
+            used_thread_ids[static_cast<SessionData*>(session_info.data.get())->thread_id] = true;
+        }
+    }
+}
+
 SessionData::SessionData() {
     // Assign a new thread id to this session when it connects. Note: In the real GSP service this
     // is done through a real thread (svcCreateThread) but we have to simulate it since our HLE
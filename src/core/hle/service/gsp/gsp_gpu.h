@@ -217,6 +217,9 @@ public:
      */
     FrameBufferUpdate* GetFrameBufferInfo(u32 thread_id, u32 screen_index);
 
+    /// Serializes the state of the service and of its sessions
+    void DoState(PointerWrap& p);
+
 private:
     /**
      * Signals that the specified interrupt type has occurred to userland code for the specified GSP
@@ -4,6 +4,7 @@
 
 #include <algorithm>
 #include <cmath>
+#include "common/chunk_file.h"
 #include "common/logging/log.h"
 #include "core/3ds.h"
 #include "core/core.h"
@@ -417,11 +418,21 @@ std::shared_ptr<Module> GetModule(Core::System& system) {
     return hid->GetModule();
 }
 
+void Module::DoState(PointerWrap& p) {
+    p.Do(next_pad_index);
+    p.Do(next_touch_index);
+    p.Do(next_accelerometer_index);
+    p.Do(next_gyroscope_index);
+    p.Do(enable_accelerometer_count);
+    p.Do(enable_gyroscope_count);
+}
+
 void InstallInterfaces(Core::System& system) {
     auto& service_manager = system.ServiceManager();
     auto hid = std::make_shared<Module>(system);
     std::make_shared<User>(hid)->InstallAsService(service_manager);
     std::make_shared<Spvr>(hid)->InstallAsService(service_manager);
+    service_manager.RegisterStateHandler("hid", [hid](PointerWrap& p) { hid->DoState(p); });
 }
 
 } // namespace Service::HID
@@ -303,6 +303,9 @@ public:
 
     const PadState& GetState() const;
 
+    /// Serializes the state of the module which isn't stored in its shared memory
+    void DoState(PointerWrap& p);
+
 private:
     void LoadInputDevices();
     void UpdatePadCallback(u64 userdata, s64 cycles_late);
@@ -142,8 +142,9 @@ struct MIC_U::Impl {
         }
 
         Frontend::Mic::Samples samples = mic->Read();
-        if (!samples.empty()) {
-            // write the samples to sharedmem page
+        if (!samples.empty() && shared_memory) {
+            // write the samples to sharedmem page, getting the pointer again marks it as written to
+            state.sharedmem_buffer = shared_memory->GetPointer();
             state.WriteSamples(samples);
         }
 
@@ -4,6 +4,7 @@
 
 #include <tuple>
 #include "common/assert.h"
+#include "common/chunk_file.h"
 #include "core/core.h"
 #include "core/hle/kernel/client_session.h"
 #include "core/hle/result.h"
@@ -65,4 +66,33 @@ ResultVal<Kernel::SharedPtr<Kernel::ClientSession>> ServiceManager::ConnectToSer
     return client_port->Connect();
 }
 
+void ServiceManager::RegisterStateHandler(std::string name, StateHandler handler) {
+    const bool inserted = state_handlers.emplace(std::move(name), std::move(handler)).second;
+    ASSERT_MSG(inserted, "Service module state registered twice");
+}
+
+void ServiceManager::DoState(PointerWrap& p) {
+    u32 count = static_cast<u32>(state_handlers.size());
+    p.Do(count);
+    if (p.GetMode() == PointerWrap::MODE_READ && count != state_handlers.size()) {
+        LOG_ERROR(Service, "Savestate has the state of {} service modules instead of {}", count,
+                  state_handlers.size());
+        p.SetError(PointerWrap::ERROR_FAILURE);
+        return;
+    }
+
+    for (auto& [name, handler] : state_handlers) {
+        std::string stored_name = name;
+        p.Do(stored_name);
+        if (p.GetMode() == PointerWrap::MODE_READ && stored_name != name) {
+            LOG_ERROR(Service, "Savestate has the state of service module {} instead of {}",
+                      stored_name, name);
+            p.SetError(PointerWrap::ERROR_FAILURE);
+            return;
+        }
+        handler(p);
+        p.DoMarker(name.c_str());
+    }
+}
+
 } // namespace Service::SM
@@ -4,6 +4,8 @@
 
 #pragma once
 
+#include <functional>
+#include <map>
 #include <memory>
 #include <string>
 #include <type_traits>
@@ -14,6 +16,8 @@
 #include "core/hle/result.h"
 #include "core/hle/service/service.h"
 
+class PointerWrap;
+
 namespace Core {
 class System;
 }
@@ -68,12 +72,32 @@ public:
         return std::static_pointer_cast<T>(port->hle_handler);
     }
 
+    /// Serializes the HLE state of a service module
+    using StateHandler = std::function<void(PointerWrap& p)>;
+
+    /**
+     * Registers the HLE state of a service module to be stored in savestates. The state of
+     * modules whose services are provided by LLE system modules is part of the emulated memory
+     * and kernel state instead.
+     * @param name Unique name identifying the module in savestates
+     * @param handler Function serializing the state of the module
+     */
+    void RegisterStateHandler(std::string name, StateHandler handler);
+
+    /// Serializes the HLE state of all service modules. States can only be loaded if they store
+    /// the same modules.
+    void DoState(PointerWrap& p);
+
 private:
     Core::System& system;
     std::weak_ptr<SRV> srv_interface;
 
     /// Map of registered services, retrieved using GetServicePort or ConnectToService.
     std::unordered_map<std::string, Kernel::SharedPtr<Kernel::ClientPort>> registered_services;
+
+    /// Functions serializing the HLE state of service modules, ordered by name to store them in
+    /// the same order every time
+    std::map<std::string, StateHandler> state_handlers;
 };
 
 } // namespace Service::SM
@@ -3,6 +3,7 @@
 // Refer to the license.txt file included.
 
 #include <cstring>
+#include "common/chunk_file.h"
 #include "common/common_funcs.h"
 #include "common/logging/log.h"
 #include "core/core.h"
@@ -687,9 +688,19 @@ Y2R_U::Y2R_U(Core::System& system) : ServiceFramework("y2r:u", 1), system(system
 
 Y2R_U::~Y2R_U() = default;
 
+void Y2R_U::DoState(PointerWrap& p) {
+    p.Do(conversion);
+    p.Do(dithering_weight_params);
+    p.Do(temporal_dithering_enabled);
+    p.Do(transfer_end_interrupt_enabled);
+    p.Do(spacial_dithering_enabled);
+}
+
 void InstallInterfaces(Core::System& system) {
     auto& service_manager = system.ServiceManager();
-    std::make_shared<Y2R_U>(system)->InstallAsService(service_manager);
+    auto y2r = std::make_shared<Y2R_U>(system);
+    y2r->InstallAsService(service_manager);
+    service_manager.RegisterStateHandler("y2r:u", [y2r](PointerWrap& p) { y2r->DoState(p); });
 }
 
 } // namespace Service::Y2R
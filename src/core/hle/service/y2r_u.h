@@ -152,6 +152,9 @@ public:
     explicit Y2R_U(Core::System& system);
     ~Y2R_U() override;
 
+    /// Serializes the conversion parameters
+    void DoState(PointerWrap& p);
+
 private:
     void SetInputFormat(Kernel::HLERequestContext& ctx);
     void GetInputFormat(Kernel::HLERequestContext& ctx);
@@ -3,9 +3,11 @@
 // Refer to the license.txt file included.
 
 #include <cstring>
+#include <functional>
 #include <numeric>
 #include <type_traits>
 #include "common/alignment.h"
+#include "common/chunk_file.h"
 #include "common/color.h"
 #include "common/common_types.h"
 #include "common/logging/log.h"
@@ -19,8 +21,10 @@
 #include "core/tracer/recorder.h"
 #include "video_core/command_processor.h"
 #include "video_core/debug_utils/debug_utils.h"
+#include "video_core/gpu_thread.h"
 #include "video_core/rasterizer_interface.h"
 #include "video_core/renderer_base.h"
+#include "video_core/texture/morton.h"
 #include "video_core/utils.h"
 #include "video_core/video_core.h"
 
@@ -34,6 +38,49 @@ const u64 frame_ticks = static_cast<u64>(BASE_CLOCK_RATE_ARM11 / SCREEN_REFRESH_
 /// Event id for CoreTiming
 static Core::TimingEventType* vblank_event;
 
+/// Emulated time after which the CPU waits for work submitted to the GPU thread to be done
+const u64 gpu_thread_sync_ticks = frame_ticks / 16;
+/// Event id for CoreTiming
+static Core::TimingEventType* gpu_thread_sync_event;
+/// Whether gpu_thread_sync_event is scheduled, it waits for all the work submitted until it fires
+static bool gpu_thread_sync_pending = false;
+
+/// Waits for the GPU thread, if there is one, and delivers the interrupts raised by its work
+static void SyncGPUThread() {
+    if (VideoCore::g_gpu_thread) {
+        VideoCore::g_gpu_thread->Synchronize();
+    }
+}
+
+static void GPUThreadSyncCallback(u64 userdata, s64 cycles_late) {
+    gpu_thread_sync_pending = false;
+    SyncGPUThread();
+}
+
+/**
+ * Runs PICA work on the GPU thread when there is one the rasterizer can be driven from, otherwise
+ * right away. The CPU waits for the work at the latest gpu_thread_sync_ticks later.
+ */
+static void RunGPUWork(std::function<void()> work) {
+    VideoCore::GPUThread* gpu_thread = VideoCore::g_gpu_thread.get();
+    // The recorder logs memory accesses of the work as they happen on the emulation thread
+    const bool recording = Pica::g_debug_context && Pica::g_debug_context->recorder;
+    if (gpu_thread == nullptr || recording ||
+        !VideoCore::g_renderer->Rasterizer()->SupportsGPUThread()) {
+        // Work that is still queued has to be done first
+        SyncGPUThread();
+        work();
+        return;
+    }
+
+    gpu_thread->Submit(std::move(work));
+    if (!gpu_thread_sync_pending) {
+        Core::System::GetInstance().CoreTiming().ScheduleEvent(gpu_thread_sync_ticks,
+                                                               gpu_thread_sync_event);
+        gpu_thread_sync_pending = true;
+    }
+}
+
 template <typename T>
 inline void Read(T& var, const u32 raw_addr) {
     u32 addr = raw_addr - HW::VADDR_GPU;
@@ -45,6 +92,9 @@ inline void Read(T& var, const u32 raw_addr) {
         return;
     }
 
+    // Games poll the registers to learn whether the GPU is done
+    SyncGPUThread();
+
     var = g_regs[addr / 4];
 }
 
@@ -127,6 +177,45 @@ static void MemoryFill(const Regs::MemoryFillConfig& config) {
     }
 }
 
+/**
+ * Converts between tiled and linear images of the same format and size a whole tile at a time.
+ * This covers display transfers which neither scale nor convert the pixels.
+ * @returns false if the transfer has to be done pixel by pixel instead
+ */
+static bool SwizzleDisplayTransfer(const Regs::DisplayTransferConfig& config, const u8* src_pointer,
+                                   u8* dst_pointer) {
+    const u32 width = config.output_width;
+    const u32 height = config.output_height;
+    if (config.scaling != config.NoScale || config.dont_swizzle ||
+        config.input_format != config.output_format || config.input_width != width ||
+        config.input_height != height || width % 8 != 0 || height % 8 != 0 ||
+        config.output_format > Regs::PixelFormat::RGBA4) {
+        return false;
+    }
+
+    const u32 bytes_per_pixel = GPU::Regs::BytesPerPixel(config.output_format);
+    const auto format = Pica::Texture::GetMortonCopyFormat(bytes_per_pixel);
+    const std::ptrdiff_t pitch = static_cast<std::ptrdiff_t>(width * bytes_per_pixel) *
+                                 (config.flip_vertically ? -1 : 1);
+
+    for (u32 y = 0; y < height; y += 8) {
+        // Linear row receiving the first row of this row of tiles
+        const u32 linear_y = config.flip_vertically ? height - 1 - y : y;
+        for (u32 x = 0; x < width; x += 8) {
+            const std::size_t tile_offset = (y * width + x * 8) * bytes_per_pixel;
+            const std::size_t linear_offset = (linear_y * width + x) * bytes_per_pixel;
+            if (config.input_linear) {
+                Pica::Texture::LinearToMorton(format, dst_pointer + tile_offset,
+                                              src_pointer + linear_offset, pitch);
+            } else {
+                Pica::Texture::MortonToLinear(format, src_pointer + tile_offset,
+                                              dst_pointer + linear_offset, pitch);
+            }
+        }
+    }
+    return true;
+}
+
 static void DisplayTransfer(const Regs::DisplayTransferConfig& config) {
     const PAddr src_addr = config.GetPhysicalInputAddress();
     const PAddr dst_addr = config.GetPhysicalOutputAddress();
@@ -194,6 +283,10 @@ static void DisplayTransfer(const Regs::DisplayTransferConfig& config) {
     Memory::RasterizerFlushRegion(config.GetPhysicalInputAddress(), input_size);
     Memory::RasterizerInvalidateRegion(config.GetPhysicalOutputAddress(), output_size);
 
+    if (SwizzleDisplayTransfer(config, src_pointer, dst_pointer)) {
+        return;
+    }
+
     for (u32 y = 0; y < output_height; ++y) {
         for (u32 x = 0; x < output_width; ++x) {
             Common::Vec4<u8> src_color;
@@ -407,19 +500,21 @@ inline void Write(u32 addr, const T data) {
         auto& config = g_regs.memory_fill_config[is_second_filler];
 
         if (config.trigger) {
-            MemoryFill(config);
-            LOG_TRACE(HW_GPU, "MemoryFill from {:#010X} to {:#010X}", config.GetStartAddress(),
-                      config.GetEndAddress());
-
-            // It seems that it won't signal interrupt if "address_start" is zero.
-            // TODO: hwtest this
-            if (config.GetStartAddress() != 0) {
-                if (!is_second_filler) {
-                    Service::GSP::SignalInterrupt(Service::GSP::InterruptId::PSC0);
-                } else {
-                    Service::GSP::SignalInterrupt(Service::GSP::InterruptId::PSC1);
+            RunGPUWork([config, is_second_filler] {
+                MemoryFill(config);
+                LOG_TRACE(HW_GPU, "MemoryFill from {:#010X} to {:#010X}",
+                          config.GetStartAddress(), config.GetEndAddress());
+
+                // It seems that it won't signal interrupt if "address_start" is zero.
+                // TODO: hwtest this
+                if (config.GetStartAddress() != 0) {
+                    if (!is_second_filler) {
+                        VideoCore::SignalGPUInterrupt(Service::GSP::InterruptId::PSC0);
+                    } else {
+                        VideoCore::SignalGPUInterrupt(Service::GSP::InterruptId::PSC1);
+                    }
                 }
-            }
+            });
 
             // Reset "trigger" flag and set the "finish" flag
             // NOTE: This was confirmed to happen on hardware even if "address_start" is zero.
@@ -430,8 +525,6 @@ inline void Write(u32 addr, const T data) {
     }
 
     case GPU_REG_INDEX(display_transfer_config.trigger): {
-        MICROPROFILE_SCOPE(GPU_DisplayTransfer);
-
         const auto& config = g_regs.display_transfer_config;
         if (config.trigger & 1) {
 
@@ -439,28 +532,35 @@ inline void Write(u32 addr, const T data) {
                 Pica::g_debug_context->OnEvent(Pica::DebugContext::Event::IncomingDisplayTransfer,
                                                nullptr);
 
-            if (config.is_texture_copy) {
-                TextureCopy(config);
-                LOG_TRACE(HW_GPU,
-                          "TextureCopy: {:#X} bytes from {:#010X}({}+{})-> "
-                          "{:#010X}({}+{}), flags {:#010X}",
-                          config.texture_copy.size, config.GetPhysicalInputAddress(),
-                          config.texture_copy.input_width * 16, config.texture_copy.input_gap * 16,
-                          config.GetPhysicalOutputAddress(), config.texture_copy.output_width * 16,
-                          config.texture_copy.output_gap * 16, config.flags);
-            } else {
-                DisplayTransfer(config);
-                LOG_TRACE(HW_GPU,
-                          "DisplayTransfer: {:#010X}({}x{})-> "
-                          "{:#010X}({}x{}), dst format {:x}, flags {:#010X}",
-                          config.GetPhysicalInputAddress(), config.input_width.Value(),
-                          config.input_height.Value(), config.GetPhysicalOutputAddress(),
-                          config.output_width.Value(), config.output_height.Value(),
-                          static_cast<u32>(config.output_format.Value()), config.flags);
-            }
+            RunGPUWork([config] {
+                MICROPROFILE_SCOPE(GPU_DisplayTransfer);
+
+                if (config.is_texture_copy) {
+                    TextureCopy(config);
+                    LOG_TRACE(HW_GPU,
+                              "TextureCopy: {:#X} bytes from {:#010X}({}+{})-> "
+                              "{:#010X}({}+{}), flags {:#010X}",
+                              config.texture_copy.size, config.GetPhysicalInputAddress(),
+                              config.texture_copy.input_width * 16,
+                              config.texture_copy.input_gap * 16,
+                              config.GetPhysicalOutputAddress(),
+                              config.texture_copy.output_width * 16,
+                              config.texture_copy.output_gap * 16, config.flags);
+                } else {
+                    DisplayTransfer(config);
+                    LOG_TRACE(HW_GPU,
+                              "DisplayTransfer: {:#010X}({}x{})-> "
+                              "{:#010X}({}x{}), dst format {:x}, flags {:#010X}",
+                              config.GetPhysicalInputAddress(), config.input_width.Value(),
+                              config.input_height.Value(), config.GetPhysicalOutputAddress(),
+                              config.output_width.Value(), config.output_height.Value(),
+                              static_cast<u32>(config.output_format.Value()), config.flags);
+                }
+
+                VideoCore::SignalGPUInterrupt(Service::GSP::InterruptId::PPF);
+            });
 
             g_regs.display_transfer_config.trigger = 0;
-            Service::GSP::SignalInterrupt(Service::GSP::InterruptId::PPF);
         }
         break;
     }
@@ -469,8 +569,6 @@ inline void Write(u32 addr, const T data) {
     case GPU_REG_INDEX(command_processor_config.trigger): {
         const auto& config = g_regs.command_processor_config;
         if (config.trigger & 1) {
-            MICROPROFILE_SCOPE(GPU_CmdlistProcessing);
-
             u32* buffer = (u32*)g_memory->GetPhysicalPointer(config.GetPhysicalAddress());
 
             if (Pica::g_debug_context && Pica::g_debug_context->recorder) {
@@ -478,7 +576,10 @@ inline void Write(u32 addr, const T data) {
                                                                 config.GetPhysicalAddress());
             }
 
-            Pica::CommandProcessor::ProcessCommandList(buffer, config.size);
+            RunGPUWork([address = config.GetPhysicalAddress(), size = config.size] {
+                MICROPROFILE_SCOPE(GPU_CmdlistProcessing);
+                Pica::CommandProcessor::ProcessCommandList(address, size);
+            });
 
             g_regs.command_processor_config.trigger = 0;
         }
@@ -512,6 +613,8 @@ template void Write<u8>(u32 addr, const u8 data);
 
 /// Update hardware
 static void VBlankCallback(u64 userdata, s64 cycles_late) {
+    // The frame is presented from the emulation thread
+    SyncGPUThread();
     VideoCore::g_renderer->SwapBuffers();
 
     // Signal to GSP that GPU interrupt has occurred
@@ -526,8 +629,7 @@ static void VBlankCallback(u64 userdata, s64 cycles_late) {
     Core::System::GetInstance().CoreTiming().ScheduleEvent(frame_ticks - cycles_late, vblank_event);
 }
 
-/// Initialize hardware
-void Init(Memory::MemorySystem& memory) {
+void InitRegisters(Memory::MemorySystem& memory) {
     g_memory = &memory;
     memset(&g_regs, 0, sizeof(g_regs));
 
@@ -556,9 +658,17 @@ void Init(Memory::MemorySystem& memory) {
     framebuffer_sub.stride = 3 * 240;
     framebuffer_sub.color_format.Assign(Regs::PixelFormat::RGB8);
     framebuffer_sub.active_fb = 0;
+}
+
+/// Initialize hardware
+void Init(Memory::MemorySystem& memory) {
+    InitRegisters(memory);
 
     Core::Timing& timing = Core::System::GetInstance().CoreTiming();
     vblank_event = timing.RegisterEvent("GPU::VBlankCallback", VBlankCallback);
+    gpu_thread_sync_event =
+        timing.RegisterEvent("GPU::GPUThreadSyncCallback", GPUThreadSyncCallback);
+    gpu_thread_sync_pending = false;
     timing.ScheduleEvent(frame_ticks, vblank_event);
 
     LOG_DEBUG(HW_GPU, "initialized OK");
@@ -569,4 +679,10 @@ void Shutdown() {
     LOG_DEBUG(HW_GPU, "shutdown OK");
 }
 
+void DoState(PointerWrap& p) {
+    p.DoVoid(&g_regs, sizeof(g_regs));
+    // Restored along with the scheduled events, so that the flag matches the loaded event queue
+    p.Do(gpu_thread_sync_pending);
+}
+
 } // namespace GPU
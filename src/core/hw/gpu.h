@@ -11,6 +11,8 @@
 #include "common/common_funcs.h"
 #include "common/common_types.h"
 
+class PointerWrap;
+
 namespace Memory {
 class MemorySystem;
 }
@@ -332,7 +334,16 @@ void Write(u32 addr, const T data);
 /// Initialize hardware
 void Init(Memory::MemorySystem& memory);
 
+/**
+ * Initialize the registers and the memory accessed by the GPU, without scheduling any events.
+ * Used to drive the GPU outside of a running system, e.g. to replay a CiTrace.
+ */
+void InitRegisters(Memory::MemorySystem& memory);
+
 /// Shutdown hardware
 void Shutdown();
 
+/// Serializes the registers and whether the CPU waits for the GPU thread at a scheduled time
+void DoState(PointerWrap& p);
+
 } // namespace GPU
@@ -0,0 +1,85 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include "common/logging/log.h"
+#include "common/string_util.h"
+#include "core/core_timing.h"
+#include "core/idle_loop_detector.h"
+#include "core/settings.h"
+
+namespace Core {
+
+IdleLoopDetector::IdleLoopDetector(Timing& timing) : timing(timing) {}
+
+/// svcGetSystemTick returns the tick in r0 and r1, which changes every time
+constexpr u32 SVC_GET_SYSTEM_TICK = 0x28;
+
+void IdleLoopDetector::Configure(u64 program_id) {
+    enabled = false;
+    threads.clear();
+    if (!Settings::values.skip_idle_loops) {
+        return;
+    }
+
+    const std::string titles = Common::StripSpaces(Settings::values.idle_loop_titles);
+    if (titles.empty()) {
+        enabled = true;
+    } else {
+        std::vector<std::string> entries;
+        Common::SplitString(titles, ',', entries);
+        for (const std::string& entry : entries) {
+            const std::string title = Common::StripSpaces(entry);
+            if (!title.empty() && std::strtoull(title.c_str(), nullptr, 16) == program_id) {
+                enabled = true;
+                break;
+            }
+        }
+    }
+    LOG_INFO(Core, "Idle loop skipping {} for title {:016X}", enabled ? "enabled" : "disabled",
+             program_id);
+}
+
+bool IdleLoopDetector::OnSVC(u32 thread_id, u32 svc, u32 pc, const Registers& registers) {
+    if (!enabled) {
+        return false;
+    }
+
+    Registers loop_registers = registers;
+    if (svc == SVC_GET_SYSTEM_TICK) {
+        loop_registers[0] = 0;
+        loop_registers[1] = 0;
+    }
+
+    LoopState& loop = threads[thread_id];
+    const u64 ticks = timing.GetTicks();
+    if (svc == loop.svc && pc == loop.pc && loop_registers == loop.registers &&
+        ticks - loop.ticks <= MAX_ITERATION_CYCLES) {
+        ++loop.iterations;
+    } else {
+        loop.iterations = 0;
+        loop.svc = svc;
+        loop.pc = pc;
+        loop.registers = loop_registers;
+    }
+    loop.ticks = ticks;
+
+    const s64 remaining_cycles = timing.GetDowncount();
+    if (loop.iterations < MIN_ITERATIONS || remaining_cycles <= 0) {
+        return false;
+    }
+
+    LOG_TRACE(Core, "Skipping {} cycles of thread {} idling at 0x{:08X}", remaining_cycles,
+              thread_id, pc);
+    timing.Idle();
+    skipped_cycles += static_cast<u64>(remaining_cycles);
+    ++skip_count;
+    // The loop continues in the next slice, which isn't a reason to stop recognizing it
+    loop.ticks = timing.GetTicks();
+    return true;
+}
+
+} // namespace Core
@@ -0,0 +1,86 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <unordered_map>
+#include "common/common_types.h"
+
+namespace Core {
+
+class Timing;
+
+/**
+ * Recognizes threads that busy-wait by calling the same SVC from the same place over and over,
+ * like titles polling svcGetSystemTick or a shared memory flag until something happens. An
+ * iteration only counts if it leaves the registers of the thread as they were, so the SVC result
+ * and whatever the loop polled are unchanged and the loop made no progress on anything. Nothing
+ * the guest can observe changes until the next scheduled event, so once a loop is recognized the
+ * rest of the timing slice is skipped instead of being emulated.
+ */
+class IdleLoopDetector {
+public:
+    explicit IdleLoopDetector(Timing& timing);
+
+    /**
+     * Enables the detector if idle loops are to be skipped for the given title. The titles are
+     * configured as a comma separated list of program IDs, an empty list allows every title.
+     */
+    void Configure(u64 program_id);
+
+    bool IsEnabled() const {
+        return enabled;
+    }
+
+    /// Registers r0 to lr of a thread
+    using Registers = std::array<u32, 15>;
+
+    /**
+     * Notes that an SVC returned to a still running thread.
+     * @param thread_id ID of the thread that called the SVC
+     * @param svc Number of the SVC
+     * @param pc Address the SVC returns to
+     * @param registers Registers of the thread after the SVC, including its result
+     * @returns whether the thread was found idling and the rest of the slice was skipped. The CPU
+     *          should stop executing it right away.
+     */
+    bool OnSVC(u32 thread_id, u32 svc, u32 pc, const Registers& registers);
+
+    /// Returns the number of cycles skipped over in idle loops so far
+    u64 GetSkippedCycles() const {
+        return skipped_cycles;
+    }
+
+    /// Returns how often an idle loop has been skipped so far
+    u64 GetSkipCount() const {
+        return skip_count;
+    }
+
+private:
+    /// A loop is only considered idle if this many iterations in a row looked idle
+    static constexpr u32 MIN_ITERATIONS = 16;
+    /// Iterations taking longer than this are assumed to do actual work
+    static constexpr u64 MAX_ITERATION_CYCLES = 2000;
+
+    /// The latest SVC of a thread, along with how many iterations in a row looked idle
+    struct LoopState {
+        u32 svc = 0;
+        u32 pc = 0;
+        u64 ticks = 0;
+        Registers registers{};
+        u32 iterations = 0;
+    };
+
+    Timing& timing;
+    bool enabled = false;
+
+    /// Threads take turns in their loops, so each of them is followed on its own
+    std::unordered_map<u32, LoopState> threads;
+
+    u64 skipped_cycles = 0;
+    u64 skip_count = 0;
+};
+
+} // namespace Core
@@ -9,12 +9,15 @@
 #include "common/common_types.h"
 #include "common/logging/log.h"
 #include "common/swap.h"
+#include "common/write_watch.h"
 #include "core/arm/arm_interface.h"
 #include "core/core.h"
 #include "core/hle/kernel/memory.h"
 #include "core/hle/kernel/process.h"
 #include "core/hle/lock.h"
 #include "core/memory.h"
+#include "video_core/command_processor.h"
+#include "video_core/gpu_thread.h"
 #include "video_core/renderer_base.h"
 #include "video_core/video_core.h"
 
@@ -56,9 +59,10 @@ private:
 
 class MemorySystem::Impl {
 public:
+    /// Writes to FCRAM are watched for snapshots, which only store the pages written to
+    Common::WriteWatchedMemory fcram{Memory::FCRAM_N3DS_SIZE};
     // Visual Studio would try to allocate these on compile time if they are std::array, which would
     // exceed the memory limit.
-    std::unique_ptr<u8[]> fcram = std::make_unique<u8[]>(Memory::FCRAM_N3DS_SIZE);
     std::unique_ptr<u8[]> vram = std::make_unique<u8[]>(Memory::VRAM_SIZE);
     std::unique_ptr<u8[]> n3ds_extra_ram = std::make_unique<u8[]>(Memory::N3DS_EXTRA_RAM_SIZE);
 
@@ -68,6 +72,12 @@ public:
 
     ARM_Interface* cpu = nullptr;
     AudioCore::DspInterface* dsp = nullptr;
+
+    void MarkMemoryDirty(const u8* pointer, std::size_t size) {
+        if (pointer >= fcram.data() && pointer < fcram.data() + FCRAM_N3DS_SIZE) {
+            fcram.MarkWritten(pointer - fcram.data(), size);
+        }
+    }
 };
 
 MemorySystem::MemorySystem() : impl(std::make_unique<Impl>()) {}
@@ -137,10 +147,10 @@ void MemorySystem::UnmapRegion(PageTable& page_table, VAddr base, u32 size) {
 
 u8* MemorySystem::GetPointerForRasterizerCache(VAddr addr) {
     if (addr >= LINEAR_HEAP_VADDR && addr < LINEAR_HEAP_VADDR_END) {
-        return impl->fcram.get() + (addr - LINEAR_HEAP_VADDR);
+        return impl->fcram.data() + (addr - LINEAR_HEAP_VADDR);
     }
     if (addr >= NEW_LINEAR_HEAP_VADDR && addr < NEW_LINEAR_HEAP_VADDR_END) {
-        return impl->fcram.get() + (addr - NEW_LINEAR_HEAP_VADDR);
+        return impl->fcram.data() + (addr - NEW_LINEAR_HEAP_VADDR);
     }
     if (addr >= VRAM_VADDR && addr < VRAM_VADDR_END) {
         return impl->vram.get() + (addr - VRAM_VADDR);
@@ -329,7 +339,7 @@ u8* MemorySystem::GetPhysicalPointer(PAddr address) {
         target_pointer = impl->dsp->GetDspMemory().data() + offset_into_region;
         break;
     case FCRAM_PADDR:
-        target_pointer = impl->fcram.get() + offset_into_region;
+        target_pointer = impl->fcram.data() + offset_into_region;
         break;
     case N3DS_EXTRA_RAM_PADDR:
         target_pointer = impl->n3ds_extra_ram.get() + offset_into_region;
@@ -410,39 +420,55 @@ void MemorySystem::RasterizerMarkRegionCached(PAddr start, u32 size, bool cached
     }
 }
 
+/// The GPU thread may still be working on memory the CPU is about to access
+static void SyncGPUThread() {
+    if (VideoCore::g_gpu_thread) {
+        VideoCore::g_gpu_thread->Synchronize();
+    }
+}
+
 void RasterizerFlushRegion(PAddr start, u32 size) {
     if (VideoCore::g_renderer == nullptr) {
         return;
     }
 
+    SyncGPUThread();
     VideoCore::g_renderer->Rasterizer()->FlushRegion(start, size);
 }
 
+/// Marks a region the GPU or a DMA is about to write to as dirty
+static void MarkRegionDirty(PAddr start, u32 size) {
+    if (VideoCore::g_memory) {
+        VideoCore::g_memory->MarkRegionDirty(start, size);
+    }
+}
+
 void RasterizerInvalidateRegion(PAddr start, u32 size) {
+    MarkRegionDirty(start, size);
     if (VideoCore::g_renderer == nullptr) {
         return;
     }
 
+    SyncGPUThread();
+    Pica::CommandProcessor::InvalidateCommandLists(start, size);
     VideoCore::g_renderer->Rasterizer()->InvalidateRegion(start, size);
 }
 
 void RasterizerFlushAndInvalidateRegion(PAddr start, u32 size) {
+    MarkRegionDirty(start, size);
+
     // Since pages are unmapped on shutdown after video core is shutdown, the renderer may be
     // null here
     if (VideoCore::g_renderer == nullptr) {
         return;
     }
 
+    SyncGPUThread();
+    Pica::CommandProcessor::InvalidateCommandLists(start, size);
     VideoCore::g_renderer->Rasterizer()->FlushAndInvalidateRegion(start, size);
 }
 
 void RasterizerFlushVirtualRegion(VAddr start, u32 size, FlushMode mode) {
-    // Since pages are unmapped on shutdown after video core is shutdown, the renderer may be
-    // null here
-    if (VideoCore::g_renderer == nullptr) {
-        return;
-    }
-
     VAddr end = start + size;
 
     auto CheckRegion = [&](VAddr region_start, VAddr region_end, PAddr paddr_region_start) {
@@ -456,15 +482,28 @@ void RasterizerFlushVirtualRegion(VAddr start, u32 size, FlushMode mode) {
         PAddr physical_start = paddr_region_start + (overlap_start - region_start);
         u32 overlap_size = overlap_end - overlap_start;
 
+        if (mode != FlushMode::Flush) {
+            MarkRegionDirty(physical_start, overlap_size);
+        }
+
+        // Since pages are unmapped on shutdown after video core is shutdown, the renderer may be
+        // null here
+        if (VideoCore::g_renderer == nullptr) {
+            return;
+        }
+
+        SyncGPUThread();
         auto* rasterizer = VideoCore::g_renderer->Rasterizer();
         switch (mode) {
         case FlushMode::Flush:
             rasterizer->FlushRegion(physical_start, overlap_size);
             break;
         case FlushMode::Invalidate:
+            Pica::CommandProcessor::InvalidateCommandLists(physical_start, overlap_size);
             rasterizer->InvalidateRegion(physical_start, overlap_size);
             break;
         case FlushMode::FlushAndInvalidate:
+            Pica::CommandProcessor::InvalidateCommandLists(physical_start, overlap_size);
             rasterizer->FlushAndInvalidateRegion(physical_start, overlap_size);
             break;
         }
@@ -800,17 +839,42 @@ void WriteMMIO<u64>(MMIORegionPointer mmio_handler, VAddr addr, const u64 data)
 }
 
 u32 MemorySystem::GetFCRAMOffset(u8* pointer) {
-    ASSERT(pointer >= impl->fcram.get() && pointer <= impl->fcram.get() + Memory::FCRAM_N3DS_SIZE);
-    return pointer - impl->fcram.get();
+    ASSERT(pointer >= impl->fcram.data() &&
+           pointer <= impl->fcram.data() + Memory::FCRAM_N3DS_SIZE);
+    return pointer - impl->fcram.data();
 }
 
 u8* MemorySystem::GetFCRAMPointer(u32 offset) {
     ASSERT(offset <= Memory::FCRAM_N3DS_SIZE);
-    return impl->fcram.get() + offset;
+    return impl->fcram.data() + offset;
 }
 
 void MemorySystem::SetDSP(AudioCore::DspInterface& dsp) {
     impl->dsp = &dsp;
 }
 
+void MemorySystem::MarkRegionDirty(PAddr start, u32 size) {
+    const u64 end = std::min<u64>(u64(start) + size, FCRAM_N3DS_PADDR_END);
+    if (start < FCRAM_PADDR || end <= start) {
+        return;
+    }
+    impl->fcram.MarkWritten(start - FCRAM_PADDR, static_cast<std::size_t>(end - start));
+}
+
+void MemorySystem::MarkMemoryDirty(const u8* pointer, std::size_t size) {
+    impl->MarkMemoryDirty(pointer, size);
+}
+
+std::vector<bool> MemorySystem::TakeDirtyPages() {
+    const std::vector<bool> blocks = impl->fcram.TakeWrittenBlocks();
+    const std::size_t block_size = impl->fcram.GetBlockSize();
+    std::vector<bool> dirty_pages(FCRAM_N3DS_SIZE / PAGE_SIZE);
+    for (std::size_t page = 0; page < dirty_pages.size(); ++page) {
+        const auto first_block = blocks.begin() + page * PAGE_SIZE / block_size;
+        const auto end_block = blocks.begin() + ((page + 1) * PAGE_SIZE - 1) / block_size + 1;
+        dirty_pages[page] = std::find(first_block, end_block, true) != end_block;
+    }
+    return dirty_pages;
+}
+
 } // namespace Memory
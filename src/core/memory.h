@@ -191,12 +191,14 @@ enum : VAddr {
 void RasterizerFlushRegion(PAddr start, u32 size);
 
 /**
- * Invalidates any externally cached rasterizer resources touching the given region.
+ * Invalidates any externally cached rasterizer resources touching the given region. As the region
+ * is about to be written to, also marks it as dirty.
  */
 void RasterizerInvalidateRegion(PAddr start, u32 size);
 
 /**
- * Flushes and invalidates any externally cached rasterizer resources touching the given region.
+ * Flushes and invalidates any externally cached rasterizer resources touching the given region. As
+ * the region is about to be written to, also marks it as dirty.
  */
 void RasterizerFlushAndInvalidateRegion(PAddr start, u32 size);
 
@@ -211,7 +213,7 @@ enum class FlushMode {
 
 /**
  * Flushes and invalidates any externally cached rasterizer resources touching the given virtual
- * address region.
+ * address region. Unless only flushing, also marks the region as dirty.
  */
 void RasterizerFlushVirtualRegion(VAddr start, u32 size, FlushMode mode);
 
@@ -298,6 +300,29 @@ public:
 
     void SetDSP(AudioCore::DspInterface& dsp);
 
+    /**
+     * Marks the FCRAM pages touching the given physical region as written to. Writes are noticed
+     * through host page protection, so this is only required ahead of writes the fault handler
+     * can't see, like writes by the host OS. Calling it ahead of large writes, like GPU and DMA
+     * transfers, avoids a fault per page. Thread-safe.
+     */
+    void MarkRegionDirty(PAddr start, u32 size);
+
+    /// Same as MarkRegionDirty, for a pointer into emulated memory. Does nothing for pointers
+    /// outside of FCRAM.
+    void MarkMemoryDirty(const u8* pointer, std::size_t size);
+
+    /**
+     * Returns which pages of FCRAM were written to since the previous call, and starts tracking
+     * writes to FCRAM if it wasn't already. All pages count as written to on the first call, and
+     * on every call if the host doesn't support write tracking.
+     *
+     * Pages which weren't written to since the previous call are write-protected on the host.
+     * Their page table entries are left as they are, so reads and later writes to a page take the
+     * fast path, only the first write to a page faults.
+     */
+    std::vector<bool> TakeDirtyPages();
+
 private:
     template <typename T>
     T Read(const VAddr vaddr);
@@ -0,0 +1,696 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <vector>
+#include <fmt/format.h>
+#include "audio_core/dsp_interface.h"
+#include "common/assert.h"
+#include "common/chunk_file.h"
+#include "common/common_paths.h"
+#include "common/compression.h"
+#include "common/file_util.h"
+#include "common/hash.h"
+#include "common/logging/log.h"
+#include "core/arm/arm_interface.h"
+#include "core/core.h"
+#include "core/core_timing.h"
+#include "core/hle/kernel/kernel.h"
+#include "core/hle/service/sm/sm.h"
+#include "core/hw/gpu.h"
+#include "core/hw/lcd.h"
+#include "core/memory.h"
+#include "core/savestate.h"
+#include "video_core/gpu_thread.h"
+#include "video_core/pica_state.h"
+#include "video_core/rasterizer_interface.h"
+#include "video_core/regs.h"
+#include "video_core/renderer_base.h"
+#include "video_core/video_core.h"
+
+namespace Core {
+
+namespace {
+
+constexpr std::array<char, 4> SAVESTATE_MAGIC{{'C', 'S', 'T', 'A'}};
+
+struct SaveStateHeader {
+    std::array<char, 4> magic;
+    u32 version;
+    u64 program_id;
+    u32 state_size;
+    u32 num_ram_regions;
+    /// Position in a snapshot chain, 0 for savestates outside of a chain
+    u32 sequence;
+    /// Sequence of the full snapshot the chain of deltas starts at, equal to sequence for full
+    /// states
+    u32 keyframe;
+    /// Hash of the state blob, checked before any of it is applied
+    u64 state_hash;
+
+    bool IsDelta() const {
+        return sequence != keyframe;
+    }
+};
+static_assert(std::is_trivially_copyable_v<SaveStateHeader>,
+              "SaveStateHeader must be trivially copyable");
+
+struct RamRegion {
+    PAddr paddr;
+    u32 size;
+};
+
+/// Emulated memory which is stored page by page, directly from and into emulated memory. FCRAM
+/// has to come first, as snapshots find its changed pages by index.
+constexpr std::size_t FCRAM_REGION = 0;
+constexpr std::array<RamRegion, 4> RAM_REGIONS{{
+    {Memory::FCRAM_PADDR, Memory::FCRAM_N3DS_SIZE},
+    {Memory::VRAM_PADDR, Memory::VRAM_SIZE},
+    {Memory::DSP_RAM_PADDR, Memory::DSP_RAM_SIZE},
+    {Memory::N3DS_EXTRA_RAM_PADDR, Memory::N3DS_EXTRA_RAM_SIZE},
+}};
+
+/// Serializes everything but the emulated memory
+void DoState(System& system, PointerWrap& p) {
+    // The kernel goes first, as it checks whether the state can be applied at all
+    system.Kernel().DoState(p);
+    p.DoMarker("Kernel");
+
+    system.CoreTiming().DoState(p);
+    p.DoMarker("CoreTiming");
+
+    system.ServiceManager().DoState(p);
+    p.DoMarker("Services");
+
+    system.DSP().DoState(p);
+    p.DoMarker("DSP");
+
+    GPU::DoState(p);
+    p.DoVoid(&LCD::g_regs, sizeof(LCD::g_regs));
+    p.DoMarker("HW");
+
+    Pica::g_state.DoState(p);
+    p.DoMarker("Pica");
+}
+
+/// Serializes everything but the emulated memory into a buffer, returns false if some of the
+/// state can't be stored
+bool SerializeState(System& system, std::vector<u8>& state) {
+    u8* ptr = nullptr;
+    PointerWrap measure(&ptr, PointerWrap::MODE_MEASURE);
+    DoState(system, measure);
+    if (measure.error == PointerWrap::ERROR_FAILURE) {
+        return false;
+    }
+    state.resize(reinterpret_cast<std::size_t>(ptr));
+
+    ptr = state.data();
+    PointerWrap p(&ptr, PointerWrap::MODE_WRITE);
+    DoState(system, p);
+    return p.error != PointerWrap::ERROR_FAILURE;
+}
+
+/// Restores everything but the emulated memory, returns false if the state doesn't match the
+/// running system
+bool DeserializeState(System& system, std::vector<u8>& state) {
+    u8* ptr = state.data();
+    PointerWrap p(&ptr, PointerWrap::MODE_READ);
+    DoState(system, p);
+    return p.error != PointerWrap::ERROR_FAILURE && ptr == state.data() + state.size();
+}
+
+bool IsZeroPage(const u8* page) {
+    u64 bits = 0;
+    for (std::size_t i = 0; i < Memory::PAGE_SIZE; i += sizeof(u64)) {
+        u64 word;
+        std::memcpy(&word, page + i, sizeof(u64));
+        bits |= word;
+    }
+    return bits == 0;
+}
+
+/// Selects the pages of a RAM region which are written to a state
+using PageSelector = std::function<bool(std::size_t region, u32 page, const u8* data)>;
+
+bool IsPageStored(const std::vector<u8>& page_map, u32 page) {
+    return (page_map[page / 8] >> (page % 8)) & 1;
+}
+
+/// Stored pages are compressed in chunks of at most this many consecutive pages
+constexpr u32 CHUNK_PAGES = 64;
+constexpr u32 CHUNK_SIZE = CHUNK_PAGES * Memory::PAGE_SIZE;
+
+/**
+ * Calls the function with each run of pages which are all stored or all not stored, splitting
+ * runs of stored pages into chunks. Stops at the first call returning false.
+ */
+template <typename Function>
+bool ForEachChunk(const std::vector<u8>& page_map, u32 num_pages, Function function) {
+    for (u32 page = 0; page < num_pages;) {
+        const bool stored = IsPageStored(page_map, page);
+        u32 end = page + 1;
+        while (end < num_pages && IsPageStored(page_map, end) == stored &&
+               (!stored || end - page < CHUNK_PAGES)) {
+            ++end;
+        }
+        if (!function(page, end, stored)) {
+            return false;
+        }
+        page = end;
+    }
+    return true;
+}
+
+/**
+ * Writes a memory region as a bitmap of the selected pages, followed by the contents of these
+ * pages. Full states select the non-zero pages, as most of the emulated memory is usually unused.
+ * The selected pages are compressed chunk by chunk, each chunk is stored as its size followed by
+ * the compressed data, or by the raw pages if they don't compress.
+ */
+bool WriteRamRegion(FileUtil::IOFile& file, std::size_t region, const u8* data, u32 size,
+                    const PageSelector& is_stored) {
+    const u32 num_pages = size / Memory::PAGE_SIZE;
+    std::vector<u8> page_map((num_pages + 7) / 8);
+    for (u32 page = 0; page < num_pages; ++page) {
+        if (is_stored(region, page, data + page * Memory::PAGE_SIZE)) {
+            page_map[page / 8] |= 1 << (page % 8);
+        }
+    }
+
+    file.WriteObject(num_pages);
+    file.WriteBytes(page_map.data(), page_map.size());
+
+    ForEachChunk(page_map, num_pages, [&](u32 first_page, u32 end_page, bool stored) {
+        if (!stored) {
+            return true;
+        }
+        const u8* const chunk = data + first_page * Memory::PAGE_SIZE;
+        const u32 chunk_size = (end_page - first_page) * Memory::PAGE_SIZE;
+        const std::vector<u8> compressed = Common::Compression::Compress(chunk, chunk_size);
+        if (compressed.size() < chunk_size) {
+            file.WriteObject(static_cast<u32>(compressed.size()));
+            file.WriteBytes(compressed.data(), compressed.size());
+        } else {
+            file.WriteObject(chunk_size);
+            file.WriteBytes(chunk, chunk_size);
+        }
+        return file.IsGood();
+    });
+
+    return file.IsGood();
+}
+
+/// Location of the pages of a RAM region stored in a state
+struct StoredRamRegion {
+    std::vector<u8> page_map;
+    u64 data_offset;
+};
+
+/**
+ * Reads the page bitmaps of all RAM regions of a state, and checks that the file contains all of
+ * the chunks they select. Leaves the file at the end of the state.
+ */
+bool ReadRamRegionMaps(FileUtil::IOFile& file, std::vector<StoredRamRegion>& regions) {
+    regions.resize(RAM_REGIONS.size());
+    for (std::size_t i = 0; i < RAM_REGIONS.size(); ++i) {
+        u32 num_pages = 0;
+        if (file.ReadBytes(&num_pages, sizeof(num_pages)) != sizeof(num_pages) ||
+            num_pages != RAM_REGIONS[i].size / Memory::PAGE_SIZE) {
+            return false;
+        }
+
+        std::vector<u8>& page_map = regions[i].page_map;
+        page_map.resize((num_pages + 7) / 8);
+        if (file.ReadBytes(page_map.data(), page_map.size()) != page_map.size()) {
+            return false;
+        }
+
+        regions[i].data_offset = file.Tell();
+        const bool is_intact =
+            ForEachChunk(page_map, num_pages, [&file](u32 first_page, u32 end_page, bool stored) {
+                u32 stored_size = 0;
+                return !stored ||
+                       (file.ReadBytes(&stored_size, sizeof(stored_size)) == sizeof(stored_size) &&
+                        stored_size <= (end_page - first_page) * Memory::PAGE_SIZE &&
+                        file.Seek(stored_size, SEEK_CUR));
+            });
+        if (!is_intact) {
+            return false;
+        }
+    }
+
+    return file.Tell() <= file.GetSize();
+}
+
+/// Reads the stored pages of a memory region. Pages which aren't stored are zero in full states
+/// and unchanged in deltas.
+bool ReadRamRegion(FileUtil::IOFile& file, const StoredRamRegion& region, u8* data, u32 size,
+                   bool is_delta) {
+    if (!file.Seek(region.data_offset, SEEK_SET)) {
+        return false;
+    }
+
+    std::vector<u8> compressed(CHUNK_SIZE);
+    const auto read_chunk = [&](u32 first_page, u32 end_page, bool stored) {
+        u8* const begin = data + first_page * Memory::PAGE_SIZE;
+        const u32 length = (end_page - first_page) * Memory::PAGE_SIZE;
+        if (!stored) {
+            if (!is_delta) {
+                std::memset(begin, 0, length);
+            }
+            return true;
+        }
+
+        u32 stored_size = 0;
+        if (file.ReadBytes(&stored_size, sizeof(stored_size)) != sizeof(stored_size) ||
+            stored_size > length) {
+            return false;
+        }
+        if (stored_size == length) {
+            return file.ReadBytes(begin, length) == length;
+        }
+        return file.ReadBytes(compressed.data(), stored_size) == stored_size &&
+               Common::Compression::Decompress(compressed.data(), stored_size, begin, length);
+    };
+    return ForEachChunk(region.page_map, size / Memory::PAGE_SIZE, read_chunk);
+}
+
+u64 GetProgramId(System& system) {
+    u64 program_id = 0;
+    system.GetAppLoader().ReadProgramId(program_id);
+    return program_id;
+}
+
+/// Finishes the work of the GPU and writes back its cached surfaces, so that the emulated memory is
+/// up to date
+void FlushGPU() {
+    if (VideoCore::g_gpu_thread) {
+        VideoCore::g_gpu_thread->Synchronize();
+    }
+    if (VideoCore::g_renderer) {
+        VideoCore::g_renderer->Rasterizer()->FlushAll();
+    }
+}
+
+bool WriteState(System& system, const std::string& path, u32 sequence, u32 keyframe,
+                const PageSelector& is_stored) {
+    FlushGPU();
+
+    std::vector<u8> state;
+    if (!SerializeState(system, state)) {
+        LOG_ERROR(Core, "The state of the emulated system can't be saved to {}", path);
+        return false;
+    }
+
+    if (!FileUtil::CreateFullPath(path)) {
+        LOG_ERROR(Core, "Failed to create the directory for savestate {}", path);
+        return false;
+    }
+
+    FileUtil::IOFile file(path, "wb");
+    if (!file.IsOpen()) {
+        LOG_ERROR(Core, "Failed to open savestate {} for writing", path);
+        return false;
+    }
+
+    SaveStateHeader header{};
+    header.magic = SAVESTATE_MAGIC;
+    header.version = SAVESTATE_VERSION;
+    header.program_id = GetProgramId(system);
+    header.state_size = static_cast<u32>(state.size());
+    header.num_ram_regions = static_cast<u32>(RAM_REGIONS.size());
+    header.sequence = sequence;
+    header.keyframe = keyframe;
+    header.state_hash = Common::ComputeHash64(state.data(), state.size());
+    file.WriteObject(header);
+    file.WriteBytes(state.data(), state.size());
+
+    Memory::MemorySystem& memory = system.Memory();
+    for (std::size_t i = 0; i < RAM_REGIONS.size(); ++i) {
+        const RamRegion& region = RAM_REGIONS[i];
+        if (!WriteRamRegion(file, i, memory.GetPhysicalPointer(region.paddr), region.size,
+                            is_stored)) {
+            LOG_ERROR(Core, "Failed to write savestate {}", path);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/// Opens a state and reads its header, checking that it has the current format
+bool ReadStateHeader(const std::string& path, FileUtil::IOFile& file, SaveStateHeader& header) {
+    file.Open(path, "rb");
+    if (!file.IsOpen()) {
+        LOG_ERROR(Core, "Failed to open savestate {}", path);
+        return false;
+    }
+
+    if (file.ReadBytes(&header, sizeof(header)) != sizeof(header) ||
+        header.magic != SAVESTATE_MAGIC) {
+        LOG_ERROR(Core, "{} is not a savestate", path);
+        return false;
+    }
+    if (header.version != SAVESTATE_VERSION) {
+        LOG_ERROR(Core, "Savestate {} has unsupported version {}", path, header.version);
+        return false;
+    }
+    return true;
+}
+
+/// Opens a state and validates its header, leaving the file at the start of the state blob
+bool OpenState(System& system, const std::string& path, FileUtil::IOFile& file,
+               SaveStateHeader& header) {
+    if (!ReadStateHeader(path, file, header)) {
+        return false;
+    }
+    if (header.program_id != GetProgramId(system)) {
+        LOG_ERROR(Core, "Savestate {} belongs to a different title ({:016X})", path,
+                  header.program_id);
+        return false;
+    }
+    if (header.num_ram_regions != RAM_REGIONS.size()) {
+        LOG_ERROR(Core, "Savestate {} is damaged", path);
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * Loads a chain of states, consisting of a full state followed by any number of deltas. The
+ * emulation state is taken from the last state of the chain, the memory is restored by applying
+ * all of them in order. Every state is validated before anything is applied.
+ */
+bool LoadStateChain(System& system, const std::vector<std::string>& paths) {
+    ASSERT(!paths.empty());
+
+    std::vector<FileUtil::IOFile> files(paths.size());
+    std::vector<SaveStateHeader> headers(paths.size());
+    std::vector<std::vector<StoredRamRegion>> ram_regions(paths.size());
+    std::vector<u8> state;
+    for (std::size_t i = 0; i < paths.size(); ++i) {
+        if (!OpenState(system, paths[i], files[i], headers[i])) {
+            return false;
+        }
+
+        const bool chained = i == 0 ? !headers[i].IsDelta()
+                                    : headers[i].keyframe == headers[0].sequence &&
+                                          headers[i].sequence == headers[i - 1].sequence + 1;
+        if (!chained) {
+            LOG_ERROR(Core, "Savestate {} doesn't continue the snapshot chain", paths[i]);
+            return false;
+        }
+
+        // Only the emulation state of the last state is needed
+        bool is_intact;
+        if (i + 1 == paths.size()) {
+            state.resize(headers[i].state_size);
+            is_intact = files[i].ReadBytes(state.data(), state.size()) == state.size() &&
+                        Common::ComputeHash64(state.data(), state.size()) == headers[i].state_hash;
+        } else {
+            is_intact = files[i].Seek(headers[i].state_size, SEEK_CUR);
+        }
+        if (!is_intact || !ReadRamRegionMaps(files[i], ram_regions[i])) {
+            LOG_ERROR(Core, "Savestate {} is damaged", paths[i]);
+            return false;
+        }
+    }
+
+    // Write back cached surfaces now, so that they don't overwrite the restored memory later
+    FlushGPU();
+
+    // Whether the state matches the running system is only known once it has been applied, so
+    // keep the current state to go back to
+    std::vector<u8> previous_state;
+    if (!SerializeState(system, previous_state)) {
+        LOG_ERROR(Core, "The state of the emulated system can't be replaced by {}", paths.back());
+        return false;
+    }
+    if (!DeserializeState(system, state)) {
+        LOG_ERROR(Core, "Savestate {} can't be loaded into the running system", paths.back());
+        const bool restored = DeserializeState(system, previous_state);
+        ASSERT_MSG(restored, "Failed to restore the state from before loading {}", paths.back());
+        return false;
+    }
+
+    Memory::MemorySystem& memory = system.Memory();
+    // The pages are read from the files straight into FCRAM, so they have to be writable for the
+    // host OS
+    memory.MarkRegionDirty(Memory::FCRAM_PADDR, Memory::FCRAM_N3DS_SIZE);
+    for (std::size_t i = 0; i < paths.size(); ++i) {
+        for (std::size_t region = 0; region < RAM_REGIONS.size(); ++region) {
+            if (!ReadRamRegion(files[i], ram_regions[i][region],
+                               memory.GetPhysicalPointer(RAM_REGIONS[region].paddr),
+                               RAM_REGIONS[region].size, headers[i].IsDelta())) {
+                LOG_CRITICAL(Core, "Failed to read savestate {}, emulated memory is corrupted",
+                             paths[i]);
+                return false;
+            }
+        }
+    }
+
+    // Drop everything that was derived from the previous state
+    system.CPU().ClearInstructionCache();
+    if (VideoCore::g_renderer) {
+        auto* rasterizer = VideoCore::g_renderer->Rasterizer();
+        for (const RamRegion& region : RAM_REGIONS) {
+            rasterizer->InvalidateRegion(region.paddr, region.size);
+        }
+        for (u32 id = 0; id < Pica::Regs::NUM_REGS; ++id) {
+            rasterizer->NotifyPicaRegisterChanged(id);
+        }
+    }
+
+    return true;
+}
+
+u64 GetElapsedMilliseconds(std::chrono::steady_clock::time_point start_time) {
+    const auto duration = std::chrono::steady_clock::now() - start_time;
+    return std::chrono::duration_cast<std::chrono::milliseconds>(duration).count();
+}
+
+} // Anonymous namespace
+
+std::string GetSaveStatePath(u64 program_id, u32 slot) {
+    return fmt::format("{}{:016X}.{:02d}.cst", FileUtil::GetUserPath(FileUtil::UserPath::StatesDir),
+                       program_id, slot);
+}
+
+std::string GetSnapshotDirectory(u64 program_id) {
+    return fmt::format("{}{:016X}" DIR_SEP, FileUtil::GetUserPath(FileUtil::UserPath::StatesDir),
+                       program_id);
+}
+
+bool SaveState(System& system, const std::string& path) {
+    const auto start_time = std::chrono::steady_clock::now();
+
+    const bool result = WriteState(system, path, 0, 0, [](std::size_t, u32, const u8* data) {
+        return !IsZeroPage(data);
+    });
+    if (result) {
+        LOG_INFO(Core, "Saved state to {} in {} ms", path, GetElapsedMilliseconds(start_time));
+    }
+    return result;
+}
+
+bool LoadState(System& system, const std::string& path) {
+    const auto start_time = std::chrono::steady_clock::now();
+
+    if (!LoadStateChain(system, {path})) {
+        return false;
+    }
+    LOG_INFO(Core, "Loaded state from {} in {} ms", path, GetElapsedMilliseconds(start_time));
+    return true;
+}
+
+SnapshotChain::SnapshotChain(std::string directory, u32 keyframe_interval)
+    : directory(std::move(directory)), keyframe_interval(std::max(keyframe_interval, 1U)) {
+    const std::vector<u32> sequences = FindSnapshots();
+    if (sequences.empty()) {
+        return;
+    }
+
+    // Only the snapshots from the keyframe of the latest one onwards can be restored, the chain
+    // may have been cut short by a crash while taking a snapshot
+    const u32 latest = sequences.back();
+    u32 first = latest;
+    while (first > 1 && std::binary_search(sequences.begin(), sequences.end(), first - 1)) {
+        --first;
+    }
+    FileUtil::IOFile file;
+    SaveStateHeader header;
+    if (!ReadStateHeader(GetSnapshotPath(latest), file, header) || header.sequence != latest ||
+        header.keyframe < first) {
+        LOG_WARNING(Core, "Discarding the snapshots in {}, they can't be restored",
+                    this->directory);
+        DeleteSnapshots();
+        return;
+    }
+    for (const u32 sequence : sequences) {
+        if (sequence < first) {
+            FileUtil::Delete(GetSnapshotPath(sequence));
+        }
+    }
+
+    first_sequence = first;
+    next_sequence = latest + 1;
+    current_keyframe = header.keyframe;
+    resume_sequence = latest;
+    LOG_INFO(Core, "Found {} snapshots of an earlier session in {}", GetNumSnapshots(),
+             this->directory);
+}
+
+bool SnapshotChain::TakeSnapshot(System& system) {
+    const auto start_time = std::chrono::steady_clock::now();
+
+    const u32 sequence = next_sequence;
+    const bool is_keyframe =
+        page_hashes.empty() || sequence - current_keyframe >= keyframe_interval;
+
+    // FCRAM is too large to hash, so its changed pages are the ones written to since the previous
+    // snapshot. Flush the GPU first, as writing back its surfaces marks pages as written to.
+    FlushGPU();
+    const std::vector<bool> dirty_pages = system.Memory().TakeDirtyPages();
+
+    std::vector<std::vector<u64>> new_hashes(RAM_REGIONS.size());
+    for (std::size_t i = 0; i < RAM_REGIONS.size(); ++i) {
+        if (i != FCRAM_REGION) {
+            new_hashes[i].resize(RAM_REGIONS[i].size / Memory::PAGE_SIZE);
+        }
+    }
+
+    u32 num_stored_pages = 0;
+    const std::string path = GetSnapshotPath(sequence);
+    const bool result =
+        WriteState(system, path, sequence, is_keyframe ? sequence : current_keyframe,
+                   [&](std::size_t region, u32 page, const u8* data) {
+                       bool stored;
+                       if (region == FCRAM_REGION) {
+                           stored = is_keyframe ? !IsZeroPage(data) : dirty_pages[page];
+                       } else {
+                           const u64 hash = Common::ComputeHash64(data, Memory::PAGE_SIZE);
+                           new_hashes[region][page] = hash;
+                           stored = is_keyframe ? !IsZeroPage(data)
+                                                : hash != page_hashes[region][page];
+                       }
+                       num_stored_pages += stored;
+                       return stored;
+                   });
+    if (!result) {
+        // The next snapshot can't be based on a snapshot which wasn't written
+        page_hashes.clear();
+        return false;
+    }
+
+    page_hashes = std::move(new_hashes);
+    ++next_sequence;
+
+    if (is_keyframe) {
+        // Keep the previous chain, so that there is always at least keyframe_interval snapshots
+        // to go back to
+        for (u32 old_sequence = first_sequence; old_sequence < current_keyframe; ++old_sequence) {
+            FileUtil::Delete(GetSnapshotPath(old_sequence));
+        }
+        first_sequence = current_keyframe;
+        current_keyframe = sequence;
+        if (resume_sequence < first_sequence) {
+            resume_sequence = 0;
+        }
+    }
+
+    LOG_DEBUG(Core, "Took {} snapshot {} with {} pages in {} ms",
+              is_keyframe ? "full" : "delta", sequence, num_stored_pages,
+              GetElapsedMilliseconds(start_time));
+    return true;
+}
+
+bool SnapshotChain::Restore(System& system, u32 age) {
+    if (age >= GetNumSnapshots()) {
+        LOG_ERROR(Core, "There are only {} snapshots", GetNumSnapshots());
+        return false;
+    }
+    return RestoreSequence(system, next_sequence - 1 - age);
+}
+
+bool SnapshotChain::Resume(System& system) {
+    if (!CanResume()) {
+        LOG_ERROR(Core, "There is no earlier session to resume");
+        return false;
+    }
+    return RestoreSequence(system, resume_sequence);
+}
+
+bool SnapshotChain::RestoreSequence(System& system, u32 target) {
+    const auto start_time = std::chrono::steady_clock::now();
+
+    FileUtil::IOFile file;
+    SaveStateHeader header;
+    if (!OpenState(system, GetSnapshotPath(target), file, header)) {
+        return false;
+    }
+    file.Close();
+
+    std::vector<std::string> paths;
+    for (u32 sequence = header.keyframe; sequence <= target; ++sequence) {
+        paths.push_back(GetSnapshotPath(sequence));
+    }
+    if (!LoadStateChain(system, paths)) {
+        return false;
+    }
+
+    // The memory no longer matches the latest snapshot
+    page_hashes.clear();
+
+    LOG_INFO(Core, "Restored snapshot {} from {} states in {} ms", target, paths.size(),
+             GetElapsedMilliseconds(start_time));
+    return true;
+}
+
+void SnapshotChain::Invalidate() {
+    page_hashes.clear();
+}
+
+u32 SnapshotChain::GetNumSnapshots() const {
+    return next_sequence - first_sequence;
+}
+
+bool SnapshotChain::CanResume() const {
+    return resume_sequence != 0;
+}
+
+std::string SnapshotChain::GetSnapshotPath(u32 sequence) const {
+    return fmt::format("{}{:08d}.cst", directory, sequence);
+}
+
+std::vector<u32> SnapshotChain::FindSnapshots() const {
+    std::vector<u32> sequences;
+    u64 num_entries;
+    FileUtil::ForeachDirectoryEntry(
+        &num_entries, directory,
+        [&sequences](u64*, const std::string&, const std::string& virtual_name) {
+            u32 sequence = 0;
+            char extension[4] = {};
+            if (std::sscanf(virtual_name.c_str(), "%8u.%3s", &sequence, extension) == 2 &&
+                std::strcmp(extension, "cst") == 0 && sequence != 0) {
+                sequences.push_back(sequence);
+            }
+            return true;
+        });
+    std::sort(sequences.begin(), sequences.end());
+    return sequences;
+}
+
+void SnapshotChain::DeleteSnapshots() const {
+    for (const u32 sequence : FindSnapshots()) {
+        FileUtil::Delete(GetSnapshotPath(sequence));
+    }
+}
+
+} // namespace Core
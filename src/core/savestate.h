@@ -0,0 +1,124 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include "common/common_types.h"
+
+namespace Core {
+
+class System;
+
+/// Version of the savestate format. Increase it whenever the serialized state changes.
+constexpr u32 SAVESTATE_VERSION = 3;
+
+/// Returns the path of the given savestate slot for the title with the given program ID
+std::string GetSaveStatePath(u64 program_id, u32 slot);
+
+/// Returns the directory of the snapshot chain for the title with the given program ID
+std::string GetSnapshotDirectory(u64 program_id);
+
+/**
+ * Saves the state of the emulated system to a file. Must be called from the emulation thread in
+ * between two runs of the CPU.
+ *
+ * The state holds the emulated memory, compressed in chunks of pages, the thread wait states and
+ * contexts, the synchronization state of the kernel objects, the scheduled events, the state of
+ * the HLE services which registered a state handler, the HLE DSP and the GPU state, along with
+ * what is needed to check that a state fits the running system when it is loaded. Kernel objects
+ * aren't created or destroyed by loading a state. States can't be saved while the LLE DSP is used.
+ * @returns true on success
+ */
+bool SaveState(System& system, const std::string& path);
+
+/**
+ * Restores the state of the emulated system from a file. Must be called from the emulation thread
+ * in between two runs of the CPU.
+ *
+ * States can be loaded by any session of the title which created the same kernel objects and
+ * handles and mapped the same memory, e.g. after booting it to the same point. States saved before
+ * a kernel object was created, a handle was closed or memory was mapped are rejected, since the
+ * guest may reference objects or memory the state doesn't know about. So are states which would
+ * move a thread into or out of a wait whose wakeup callback isn't one of the stored
+ * WakeupCallbackIds, like a wait on an HLE service or a timed address arbitration.
+ * @returns true on success. Damaged and rejected states leave the system unchanged, only an error
+ *          while reading the emulated memory can leave it partially restored.
+ */
+bool LoadState(System& system, const std::string& path);
+
+/**
+ * Periodic snapshots of the emulated system, stored as a chain of deltas. Each delta only contains
+ * the memory pages which changed since the previous snapshot, and every keyframe_interval
+ * snapshots a full snapshot starts a new chain. The changed pages of FCRAM are the ones the memory
+ * system saw being written to, only the smaller regions are compared by hashing their pages.
+ *
+ * The latest chain is kept on disk when the session ends, so that a session which crashed can be
+ * resumed from its latest snapshot. Like savestates, that only succeeds once the title created the
+ * same kernel objects again. All functions must be called from the emulation thread in between two
+ * runs of the CPU.
+ */
+class SnapshotChain {
+public:
+    /// Picks up the chain left in the directory by an earlier session, if there is one
+    SnapshotChain(std::string directory, u32 keyframe_interval);
+
+    /**
+     * Takes a new snapshot of the emulated system.
+     * @returns true on success
+     */
+    bool TakeSnapshot(System& system);
+
+    /**
+     * Restores an earlier snapshot.
+     * @param age Number of snapshots to go back, 0 restores the latest one
+     * @returns true on success
+     */
+    bool Restore(System& system, u32 age);
+
+    /// Makes the next snapshot a full one, must be called whenever the emulated memory was
+    /// replaced, e.g. by loading a savestate
+    void Invalidate();
+
+    /// Returns the number of snapshots which can be restored
+    u32 GetNumSnapshots() const;
+
+    /// Returns whether the latest snapshot of an earlier session is still on disk
+    bool CanResume() const;
+
+    /**
+     * Restores the latest snapshot of the earlier session.
+     * @returns true on success
+     */
+    bool Resume(System& system);
+
+private:
+    std::string GetSnapshotPath(u32 sequence) const;
+
+    /// Restores the snapshot with the given sequence number and the chain leading to it
+    bool RestoreSequence(System& system, u32 target);
+
+    /// Returns the sequence numbers of the snapshots in the directory
+    std::vector<u32> FindSnapshots() const;
+
+    /// Deletes all snapshots in the directory
+    void DeleteSnapshots() const;
+
+    std::string directory;
+    u32 keyframe_interval;
+
+    /// Sequence numbers of the next snapshot, the oldest one on disk and the latest full one
+    u32 next_sequence = 1;
+    u32 first_sequence = 1;
+    u32 current_keyframe = 1;
+    /// Sequence number of the latest snapshot of the earlier session, 0 if there is none
+    u32 resume_sequence = 0;
+
+    /// Hashes of the pages of each RAM region but FCRAM at the latest snapshot, empty if the next
+    /// snapshot has to be a full one
+    std::vector<std::vector<u64>> page_hashes;
+};
+
+} // namespace Core
@@ -25,9 +25,14 @@ void Apply() {
 
     VideoCore::g_hw_renderer_enabled = values.use_hw_renderer;
     VideoCore::g_shader_jit_enabled = values.use_shader_jit;
+    VideoCore::g_disk_shader_cache_enabled = values.use_disk_shader_cache;
     VideoCore::g_hw_shader_enabled = values.use_hw_shader;
     VideoCore::g_hw_shader_accurate_gs = values.shaders_accurate_gs;
     VideoCore::g_hw_shader_accurate_mul = values.shaders_accurate_mul;
+    VideoCore::g_sw_rasterizer_threads = values.sw_rasterizer_threads;
+    VideoCore::g_vertex_shader_threads = values.vertex_shader_threads;
+    VideoCore::g_texture_decode_threads = values.texture_decode_threads;
+    VideoCore::g_surface_cache_budget = values.surface_cache_budget;
 
     if (VideoCore::g_renderer) {
         VideoCore::g_renderer->UpdateCurrentFramebufferLayout();
@@ -70,12 +75,22 @@ void LogSetting(const std::string& name, const T& value) {
 void LogSettings() {
     LOG_INFO(Config, "Citra Configuration:");
     LogSetting("Core_UseCpuJit", Settings::values.use_cpu_jit);
+    LogSetting("Core_SnapshotInterval", Settings::values.snapshot_interval);
+    LogSetting("Core_SnapshotKeyframeInterval", Settings::values.snapshot_keyframe_interval);
+    LogSetting("Core_SkipIdleLoops", Settings::values.skip_idle_loops);
+    LogSetting("Core_IdleLoopTitles", Settings::values.idle_loop_titles);
     LogSetting("Renderer_UseGLES", Settings::values.use_gles);
     LogSetting("Renderer_UseHwRenderer", Settings::values.use_hw_renderer);
     LogSetting("Renderer_UseHwShader", Settings::values.use_hw_shader);
     LogSetting("Renderer_ShadersAccurateGs", Settings::values.shaders_accurate_gs);
     LogSetting("Renderer_ShadersAccurateMul", Settings::values.shaders_accurate_mul);
     LogSetting("Renderer_UseShaderJit", Settings::values.use_shader_jit);
+    LogSetting("Renderer_UseDiskShaderCache", Settings::values.use_disk_shader_cache);
+    LogSetting("Renderer_SwRasterizerThreads", Settings::values.sw_rasterizer_threads);
+    LogSetting("Renderer_VertexShaderThreads", Settings::values.vertex_shader_threads);
+    LogSetting("Renderer_TextureDecodeThreads", Settings::values.texture_decode_threads);
+    LogSetting("Renderer_SurfaceCacheBudget", Settings::values.surface_cache_budget);
+    LogSetting("Renderer_UseAsynchronousGpu", Settings::values.use_asynchronous_gpu);
     LogSetting("Renderer_UseResolutionFactor", Settings::values.resolution_factor);
     LogSetting("Renderer_VsyncEnabled", Settings::values.vsync_enabled);
     LogSetting("Renderer_UseFrameLimit", Settings::values.use_frame_limit);
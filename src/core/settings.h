@@ -126,6 +126,10 @@ struct Values {
 
     // Core
     bool use_cpu_jit;
+    u32 snapshot_interval;
+    u32 snapshot_keyframe_interval;
+    bool skip_idle_loops;
+    std::string idle_loop_titles;
 
     // Data Storage
     bool use_virtual_sd;
@@ -137,11 +141,18 @@ struct Values {
 
     // Renderer
     bool use_gles;
+    bool use_headless_renderer; ///< Set by frontends without a window, not configurable
     bool use_hw_renderer;
     bool use_hw_shader;
     bool shaders_accurate_gs;
     bool shaders_accurate_mul;
     bool use_shader_jit;
+    bool use_disk_shader_cache;
+    u16 sw_rasterizer_threads;
+    u16 vertex_shader_threads;
+    u16 texture_decode_threads;
+    u16 surface_cache_budget;
+    bool use_asynchronous_gpu;
     u16 resolution_factor;
     bool vsync_enabled;
     bool use_frame_limit;
@@ -0,0 +1,58 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <random>
+#include <vector>
+#include <catch2/catch.hpp>
+#include "common/compression.h"
+
+namespace Common::Compression {
+
+static std::vector<u8> RoundTrip(const std::vector<u8>& data) {
+    const std::vector<u8> compressed = Compress(data.data(), data.size());
+    std::vector<u8> output(data.size());
+    REQUIRE(Decompress(compressed.data(), compressed.size(), output.data(), output.size()));
+    return output;
+}
+
+TEST_CASE("Compression", "[common]") {
+    std::mt19937 random(1234);
+    std::vector<u8> data(0x10000);
+
+    SECTION("empty buffers") {
+        REQUIRE(RoundTrip({}).empty());
+    }
+
+    SECTION("random data") {
+        for (u8& byte : data) {
+            byte = static_cast<u8>(random());
+        }
+        REQUIRE(RoundTrip(data) == data);
+    }
+
+    SECTION("repetitive data shrinks") {
+        for (std::size_t i = 0; i < data.size(); ++i) {
+            data[i] = i % 3000 < 1000 ? static_cast<u8>(random() % 4) : static_cast<u8>(i / 7);
+        }
+        REQUIRE(Compress(data.data(), data.size()).size() < data.size() / 2);
+        REQUIRE(RoundTrip(data) == data);
+    }
+
+    SECTION("damaged data is rejected") {
+        std::fill(data.begin(), data.end(), 0x5A);
+        std::vector<u8> compressed = Compress(data.data(), data.size());
+        std::vector<u8> output(data.size());
+        REQUIRE(!Decompress(compressed.data(), compressed.size() - 1, output.data(),
+                            output.size()));
+        REQUIRE(!Decompress(compressed.data(), compressed.size(), output.data(),
+                            output.size() - 1));
+
+        // An offset pointing before the start of the output
+        compressed[2] = 0xFF;
+        compressed[3] = 0xFF;
+        REQUIRE(!Decompress(compressed.data(), compressed.size(), output.data(), output.size()));
+    }
+}
+
+} // namespace Common::Compression
@@ -0,0 +1,49 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <chrono>
+#include <thread>
+#include <catch2/catch.hpp>
+#include "common/subsystem_timer.h"
+
+namespace Common {
+
+TEST_CASE("SubsystemTimer", "[common]") {
+    using namespace std::chrono_literals;
+    constexpr auto CPU = static_cast<std::size_t>(Subsystem::CPU);
+    constexpr auto HLE = static_cast<std::size_t>(Subsystem::HLEServices);
+
+    ResetSubsystemTimes();
+
+    SECTION("disabled timers don't measure anything") {
+        SetSubsystemTimersEnabled(false);
+        {
+            ScopedSubsystemTimer timer(Subsystem::CPU);
+            std::this_thread::sleep_for(1ms);
+        }
+        const SubsystemTimes times = GetSubsystemTimes();
+        REQUIRE(times.calls[CPU] == 0);
+        REQUIRE(times.self_time[CPU].count() == 0);
+    }
+
+    SECTION("nested timers pause the enclosing one") {
+        SetSubsystemTimersEnabled(true);
+        {
+            ScopedSubsystemTimer cpu_timer(Subsystem::CPU);
+            {
+                ScopedSubsystemTimer hle_timer(Subsystem::HLEServices);
+                std::this_thread::sleep_for(20ms);
+            }
+        }
+        SetSubsystemTimersEnabled(false);
+
+        const SubsystemTimes times = GetSubsystemTimes();
+        REQUIRE(times.calls[CPU] == 1);
+        REQUIRE(times.calls[HLE] == 1);
+        REQUIRE(times.self_time[HLE] >= 20ms);
+        REQUIRE(times.self_time[CPU] < times.self_time[HLE]);
+    }
+}
+
+} // namespace Common
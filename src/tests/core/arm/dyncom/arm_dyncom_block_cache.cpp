@@ -0,0 +1,69 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <catch2/catch.hpp>
+#include "core/arm/dyncom/arm_dyncom_block_cache.h"
+
+namespace ArmTests {
+
+/// Translates a block of the given number of maximum-sized instructions
+static BlockHeader* AddBlock(BlockCache& cache, u32 pc, int num_instructions = 1) {
+    BlockHeader* block = cache.BeginBlock();
+    for (int i = 0; i < num_instructions && cache.HasRoomForInstruction(); ++i) {
+        BlockCache::AllocateInstruction(BlockCache::MAX_INSTRUCTION_SIZE);
+    }
+    cache.EndBlock(pc, block);
+    return block;
+}
+
+TEST_CASE("BlockCache finds blocks by their first instruction", "[arm_dyncom]") {
+    BlockCache cache;
+    REQUIRE(cache.Find(0x00100000) == nullptr);
+
+    BlockHeader* const arm_block = AddBlock(cache, 0x00100000);
+    BlockHeader* const thumb_block = AddBlock(cache, 0x00100002);
+    BlockHeader* const high_block = AddBlock(cache, 0xFFFFF000);
+    REQUIRE(cache.Find(0x00100000) == arm_block);
+    REQUIRE(cache.Find(0x00100002) == thumb_block);
+    REQUIRE(cache.Find(0xFFFFF000) == high_block);
+    REQUIRE(cache.Find(0x00100004) == nullptr);
+    REQUIRE(arm_block->Instructions() + BlockCache::MAX_INSTRUCTION_SIZE ==
+            reinterpret_cast<u8*>(thumb_block));
+}
+
+TEST_CASE("BlockCache invalidates only the touched pages", "[arm_dyncom]") {
+    BlockCache cache;
+    AddBlock(cache, 0x00100FFC);
+    AddBlock(cache, 0x00101000);
+    BlockHeader* const kept_block = AddBlock(cache, 0x00102000);
+
+    const u64 generation = cache.GetGeneration();
+    cache.Invalidate(0x00100FFE, 4);
+    REQUIRE(cache.GetGeneration() != generation);
+    REQUIRE(cache.Find(0x00100FFC) == nullptr);
+    REQUIRE(cache.Find(0x00101000) == nullptr);
+    REQUIRE(cache.Find(0x00102000) == kept_block);
+
+    cache.Clear();
+    REQUIRE(cache.Find(0x00102000) == nullptr);
+}
+
+TEST_CASE("BlockCache drops everything when the arena is full", "[arm_dyncom]") {
+    BlockCache cache;
+    BlockHeader* const first_block = AddBlock(cache, 0x00100000);
+    const u64 generation = cache.GetGeneration();
+
+    // Large blocks are split by the translator, so keep adding blocks until the arena wraps
+    u32 pc = 0x00200000;
+    while (cache.GetGeneration() == generation) {
+        AddBlock(cache, pc, 1024);
+        pc += 4;
+    }
+    REQUIRE(cache.Find(0x00100000) == nullptr);
+    REQUIRE(cache.Find(pc - 4) != nullptr);
+    // The arena starts over at its first chunk
+    REQUIRE(cache.Find(pc - 4) == first_block);
+}
+
+} // namespace ArmTests
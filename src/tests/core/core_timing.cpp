@@ -4,9 +4,13 @@
 
 #include <catch2/catch.hpp>
 
+#include <algorithm>
 #include <array>
 #include <bitset>
+#include <chrono>
 #include <string>
+#include <tuple>
+#include <vector>
 #include "common/file_util.h"
 #include "core/core.h"
 #include "core/core_timing.h"
@@ -226,3 +230,187 @@ TEST_CASE("CoreTiming[ChainScheduling]", "[core]") {
     REQUIRE(0 == reschedules);
     REQUIRE(MAX_SLICE_LENGTH == timing.GetDowncount());
 }
+
+TEST_CASE("CoreTiming[UnscheduleByHandle]", "[core]") {
+    Core::Timing timing;
+
+    Core::TimingEventType* cb_a = timing.RegisterEvent("callbackA", CallbackTemplate<0>);
+    Core::TimingEventType* cb_b = timing.RegisterEvent("callbackB", CallbackTemplate<1>);
+
+    // Enter slice 0
+    timing.Advance();
+
+    const Core::TimingEventHandle handle_a = timing.ScheduleEvent(100, cb_a, CB_IDS[0]);
+    const Core::TimingEventHandle handle_b = timing.ScheduleEvent(200, cb_b, CB_IDS[1]);
+    // Events with the same type and userdata are told apart by their handle
+    const Core::TimingEventHandle handle_a2 = timing.ScheduleEvent(300, cb_a, CB_IDS[0]);
+
+    REQUIRE(timing.UnscheduleEvent(handle_a));
+    REQUIRE(!timing.UnscheduleEvent(handle_a));
+
+    // Unscheduling doesn't shorten the slice, it just ends without running anything
+    callbacks_ran_flags = 0;
+    timing.AddTicks(timing.GetDowncount());
+    timing.Advance();
+    REQUIRE(callbacks_ran_flags.none());
+    REQUIRE(100 == timing.GetDowncount());
+
+    AdvanceAndCheck(timing, 1, 100);
+    REQUIRE(!timing.UnscheduleEvent(handle_b));
+    AdvanceAndCheck(timing, 0, MAX_SLICE_LENGTH);
+    REQUIRE(!timing.UnscheduleEvent(handle_a2));
+}
+
+TEST_CASE("CoreTiming[StaleHandle]", "[core]") {
+    Core::Timing timing;
+
+    Core::TimingEventType* cb_a = timing.RegisterEvent("callbackA", CallbackTemplate<0>);
+    Core::TimingEventType* cb_b = timing.RegisterEvent("callbackB", CallbackTemplate<1>);
+
+    // Enter slice 0
+    timing.Advance();
+
+    const Core::TimingEventHandle handle_a = timing.ScheduleEvent(100, cb_a, CB_IDS[0]);
+    REQUIRE(timing.UnscheduleEvent(handle_a));
+
+    // The new event reuses the slot of the unscheduled one, the old handle must not remove it
+    const Core::TimingEventHandle handle_b = timing.ScheduleEvent(100, cb_b, CB_IDS[1]);
+    REQUIRE(handle_b.slot == handle_a.slot);
+    REQUIRE(!timing.UnscheduleEvent(handle_a));
+
+    AdvanceAndCheck(timing, 1, MAX_SLICE_LENGTH);
+
+    // Neither handle refers to a queued event once the slot is free again
+    REQUIRE(!timing.UnscheduleEvent(handle_b));
+    REQUIRE(!timing.UnscheduleEvent(handle_a));
+}
+
+namespace QueueBenchmark {
+constexpr u32 NUM_USERDATA = 4096;
+constexpr u32 NUM_ROUNDS = 2000;
+constexpr u32 OPS_PER_ROUND = 64;
+
+struct Operation {
+    u64 userdata;
+    s64 cycles_into_future;
+};
+
+/// Reschedules events in rounds, like thread wakeups and timers do, each round ending in Advance
+static std::vector<std::vector<Operation>> MakeRounds() {
+    std::vector<std::vector<Operation>> rounds(NUM_ROUNDS);
+    u32 state = 1;
+    const auto next = [&state] {
+        state = state * 1664525 + 1013904223;
+        return state >> 8;
+    };
+    for (auto& round : rounds) {
+        for (u32 i = 0; i < OPS_PER_ROUND; ++i) {
+            round.push_back({next() % NUM_USERDATA, static_cast<s64>(next() % 100000)});
+        }
+    }
+    return rounds;
+}
+
+/// The queue as it was implemented before events kept their position in the heap
+class ReferenceQueue {
+public:
+    void Schedule(const Operation& op) {
+        queue.push_back({now + op.cycles_into_future, fifo_id++, op.userdata});
+        std::push_heap(queue.begin(), queue.end(), std::greater<>());
+        downcount = std::min(downcount, op.cycles_into_future);
+    }
+
+    void Unschedule(u64 userdata) {
+        auto itr = std::remove_if(queue.begin(), queue.end(), [&](const Event& e) {
+            return std::get<2>(e) == userdata;
+        });
+        if (itr != queue.end()) {
+            queue.erase(itr, queue.end());
+            std::make_heap(queue.begin(), queue.end(), std::greater<>());
+        }
+    }
+
+    void Advance(std::vector<u64>& fired) {
+        now += downcount;
+        while (!queue.empty() && std::get<0>(queue.front()) <= now) {
+            fired.push_back(std::get<2>(queue.front()));
+            std::pop_heap(queue.begin(), queue.end(), std::greater<>());
+            queue.pop_back();
+        }
+        downcount = queue.empty() ? MAX_SLICE_LENGTH
+                                  : std::min<s64>(std::get<0>(queue.front()) - now,
+                                                  MAX_SLICE_LENGTH);
+    }
+
+private:
+    using Event = std::tuple<s64, u64, u64>;
+    std::vector<Event> queue;
+    u64 fifo_id = 0;
+    s64 now = 0;
+    s64 downcount = MAX_SLICE_LENGTH;
+};
+
+
+/// Runs the rounds on Core::Timing, returns the userdata of the events in the order they fired
+static std::vector<u64> RunTiming(const std::vector<std::vector<Operation>>& rounds) {
+    std::vector<u64> fired;
+    Core::Timing timing;
+    Core::TimingEventType* type = timing.RegisterEvent(
+        "callback", [&fired](u64 userdata, s64 cycles_late) { fired.push_back(userdata); });
+    timing.Advance();
+
+    for (const auto& round : rounds) {
+        for (const Operation& op : round) {
+            timing.UnscheduleEvent(type, op.userdata);
+            timing.ScheduleEvent(op.cycles_into_future, type, op.userdata);
+        }
+        timing.AddTicks(timing.GetDowncount());
+        timing.Advance();
+    }
+    return fired;
+}
+
+/// Runs the rounds on ReferenceQueue, returns the userdata of the events in the order they fired
+static std::vector<u64> RunReference(const std::vector<std::vector<Operation>>& rounds) {
+    std::vector<u64> fired;
+    ReferenceQueue reference;
+    for (const auto& round : rounds) {
+        for (const Operation& op : round) {
+            reference.Unschedule(op.userdata);
+            reference.Schedule(op);
+        }
+        reference.Advance(fired);
+    }
+    return fired;
+}
+} // namespace QueueBenchmark
+
+TEST_CASE("CoreTiming[RescheduleOrder]", "[core]") {
+    using namespace QueueBenchmark;
+    // Fewer rounds than the benchmark still reuse every slot many times
+    auto rounds = MakeRounds();
+    rounds.resize(NUM_ROUNDS / 10);
+
+    // Events at the same time must still fire in the order they were scheduled
+    REQUIRE(RunTiming(rounds) == RunReference(rounds));
+}
+
+TEST_CASE("CoreTiming[UnscheduleEvent] throughput", "[.][benchmark][core]") {
+    using namespace QueueBenchmark;
+    const auto rounds = MakeRounds();
+
+    const auto start = std::chrono::steady_clock::now();
+    const std::vector<u64> fired = RunTiming(rounds);
+    const auto middle = std::chrono::steady_clock::now();
+    const std::vector<u64> reference_fired = RunReference(rounds);
+    const auto end = std::chrono::steady_clock::now();
+
+    REQUIRE(fired == reference_fired);
+
+    const double ops = 2.0 * NUM_ROUNDS * OPS_PER_ROUND;
+    const auto rate = [ops](auto duration) {
+        return ops / std::chrono::duration<double, std::micro>(duration).count();
+    };
+    WARN("Indexed queue: " << rate(middle - start) << " Mops/s, reference queue: "
+                           << rate(end - middle) << " Mops/s");
+}
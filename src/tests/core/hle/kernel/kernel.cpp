@@ -0,0 +1,90 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <vector>
+#include <catch2/catch.hpp>
+#include "common/chunk_file.h"
+#include "core/core_timing.h"
+#include "core/hle/kernel/event.h"
+#include "core/hle/kernel/handle_table.h"
+#include "core/hle/kernel/kernel.h"
+#include "core/hle/kernel/process.h"
+#include "core/hle/kernel/semaphore.h"
+#include "core/memory.h"
+
+namespace Kernel {
+
+static std::vector<u8> SaveKernel(KernelSystem& kernel) {
+    u8* ptr = nullptr;
+    PointerWrap measure(&ptr, PointerWrap::MODE_MEASURE);
+    kernel.DoState(measure);
+    std::vector<u8> state(reinterpret_cast<std::size_t>(ptr));
+
+    ptr = state.data();
+    PointerWrap p(&ptr, PointerWrap::MODE_WRITE);
+    kernel.DoState(p);
+    return state;
+}
+
+static bool LoadKernel(KernelSystem& kernel, std::vector<u8>& state) {
+    u8* ptr = state.data();
+    PointerWrap p(&ptr, PointerWrap::MODE_READ);
+    kernel.DoState(p);
+    return p.error != PointerWrap::ERROR_FAILURE && ptr == state.data() + state.size();
+}
+
+TEST_CASE("KernelSystem::DoState", "[core][kernel]") {
+    Core::Timing timing;
+    Memory::MemorySystem memory;
+    KernelSystem kernel(memory, timing, [] {}, 0);
+    auto process = kernel.CreateProcess(kernel.CreateCodeSet("", 0));
+
+    auto event = kernel.CreateEvent(ResetType::Sticky);
+    auto semaphore = kernel.CreateSemaphore(0, 2).Unwrap();
+    const Handle event_handle = process->handle_table.Create(event).Unwrap();
+    process->handle_table.Create(semaphore).Unwrap();
+
+    std::vector<u8> state = SaveKernel(kernel);
+
+    SECTION("restores the synchronization state of the objects") {
+        event->Signal();
+        semaphore->Release(2).Unwrap();
+
+        REQUIRE(LoadKernel(kernel, state));
+        REQUIRE(event->ShouldWait(nullptr));
+        REQUIRE(semaphore->available_count == 0);
+    }
+
+    SECTION("rejects states saved with other handles") {
+        event->Signal();
+        process->handle_table.Close(event_handle);
+
+        REQUIRE(!LoadKernel(kernel, state));
+        REQUIRE(!event->ShouldWait(nullptr));
+    }
+
+    SECTION("loads states saved by another kernel instance") {
+        Core::Timing other_timing;
+        Memory::MemorySystem other_memory;
+        KernelSystem other_kernel(other_memory, other_timing, [] {}, 0);
+        auto other_process = other_kernel.CreateProcess(other_kernel.CreateCodeSet("", 0));
+        auto other_event = other_kernel.CreateEvent(ResetType::Sticky);
+        auto other_semaphore = other_kernel.CreateSemaphore(0, 2).Unwrap();
+        other_process->handle_table.Create(other_event).Unwrap();
+        other_process->handle_table.Create(other_semaphore).Unwrap();
+
+        event->Signal();
+        state = SaveKernel(kernel);
+        REQUIRE(LoadKernel(other_kernel, state));
+        REQUIRE(!other_event->ShouldWait(nullptr));
+    }
+
+    SECTION("rejects states saved before an object was created") {
+        auto other_event = kernel.CreateEvent(ResetType::Sticky);
+
+        REQUIRE(!LoadKernel(kernel, state));
+    }
+}
+
+} // namespace Kernel
@@ -0,0 +1,107 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <catch2/catch.hpp>
+#include "core/core_timing.h"
+#include "core/idle_loop_detector.h"
+#include "core/settings.h"
+
+TEST_CASE("IdleLoopDetector", "[core]") {
+    Core::Timing timing;
+    Core::TimingEventType* event = timing.RegisterEvent("event", [](u64, s64) {});
+    Core::IdleLoopDetector detector(timing);
+
+    Settings::values.skip_idle_loops = true;
+    Settings::values.idle_loop_titles = "0004000000012300, 0004000000045600";
+
+    constexpr u32 THREAD_ID = 1;
+    constexpr u32 OTHER_THREAD_ID = 2;
+    constexpr u32 GET_SYSTEM_TICK = 0x28;
+    constexpr u32 WAIT_SYNCHRONIZATION_1 = 0x24;
+    constexpr u32 PC = 0x00100000;
+
+    // Registers after svcGetSystemTick, which returns the tick in r0 and r1
+    Core::IdleLoopDetector::Registers registers{};
+    registers[2] = 0x08000000;
+    const auto get_system_tick = [&](u32 thread_id) {
+        registers[0] = static_cast<u32>(timing.GetTicks());
+        registers[1] = static_cast<u32>(timing.GetTicks() >> 32);
+        return detector.OnSVC(thread_id, GET_SYSTEM_TICK, PC, registers);
+    };
+
+    SECTION("only allowed titles are skipped") {
+        detector.Configure(0x0004000000078900);
+        REQUIRE(!detector.IsEnabled());
+        detector.Configure(0x0004000000045600);
+        REQUIRE(detector.IsEnabled());
+    }
+
+    SECTION("tight loops are skipped up to the next event") {
+        detector.Configure(0x0004000000012300);
+        timing.Advance();
+        timing.ScheduleEvent(10000, event);
+
+        // The first iterations might be real work
+        for (int i = 0; i < 16; ++i) {
+            timing.AddTicks(100);
+            REQUIRE(!get_system_tick(THREAD_ID));
+        }
+        timing.AddTicks(100);
+        REQUIRE(get_system_tick(THREAD_ID));
+        REQUIRE(timing.GetDowncount() == 0);
+        REQUIRE(detector.GetSkippedCycles() == 10000 - 17 * 100);
+        REQUIRE(detector.GetSkipCount() == 1);
+
+        // The loop is still recognized in the next slice
+        timing.Advance();
+        timing.ScheduleEvent(5000, event);
+        timing.AddTicks(100);
+        REQUIRE(get_system_tick(THREAD_ID));
+        REQUIRE(detector.GetSkippedCycles() == 10000 - 17 * 100 + 4900);
+
+        // Anything else breaks the loop
+        timing.Advance();
+        timing.ScheduleEvent(5000, event);
+        timing.AddTicks(100);
+        REQUIRE(!detector.OnSVC(THREAD_ID, GET_SYSTEM_TICK, PC + 4, registers));
+    }
+
+    SECTION("loops making progress are not skipped") {
+        detector.Configure(0x0004000000012300);
+        timing.Advance();
+        timing.ScheduleEvent(10000, event);
+
+        // A loop computing something between reads of the tick changes its registers
+        for (int i = 0; i < 32; ++i) {
+            timing.AddTicks(100);
+            ++registers[3];
+            REQUIRE(!get_system_tick(THREAD_ID));
+        }
+
+        // So does a wait whose result changes
+        for (u32 i = 0; i < 32; ++i) {
+            timing.AddTicks(100);
+            registers[0] = i % 2;
+            REQUIRE(!detector.OnSVC(THREAD_ID, WAIT_SYNCHRONIZATION_1, PC, registers));
+        }
+        REQUIRE(detector.GetSkipCount() == 0);
+    }
+
+    SECTION("threads taking turns are followed separately") {
+        detector.Configure(0x0004000000012300);
+        timing.Advance();
+        timing.ScheduleEvent(10000, event);
+
+        for (int i = 0; i < 16; ++i) {
+            timing.AddTicks(100);
+            REQUIRE(!get_system_tick(THREAD_ID));
+            REQUIRE(!detector.OnSVC(OTHER_THREAD_ID, WAIT_SYNCHRONIZATION_1, PC + 8, registers));
+        }
+        timing.AddTicks(100);
+        REQUIRE(get_system_tick(THREAD_ID));
+    }
+
+    Settings::values.skip_idle_loops = false;
+    Settings::values.idle_loop_titles.clear();
+}
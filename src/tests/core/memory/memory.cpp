@@ -54,3 +54,57 @@ TEST_CASE("Memory::IsValidVirtualAddress", "[core][memory]") {
         CHECK(Memory::IsValidVirtualAddress(*process, Memory::CONFIG_MEMORY_VADDR) == false);
     }
 }
+
+TEST_CASE("Memory::TakeDirtyPages", "[core][memory]") {
+    Memory::MemorySystem memory;
+    auto page_table = std::make_unique<Memory::PageTable>();
+    page_table->pointers.fill(nullptr);
+    page_table->attributes.fill(Memory::PageType::Unmapped);
+    memory.RegisterPageTable(page_table.get());
+    memory.SetCurrentPageTable(page_table.get());
+
+    constexpr u32 first_page = 0x10;
+    constexpr VAddr addr = Memory::HEAP_VADDR;
+    memory.MapMemoryRegion(*page_table, addr, 2 * Memory::PAGE_SIZE,
+                           memory.GetFCRAMPointer(first_page * Memory::PAGE_SIZE));
+    memory.Write32(addr, 0x12345678);
+
+    // Everything counts as written to until writes are tracked
+    CHECK(memory.TakeDirtyPages()[first_page]);
+    CHECK_FALSE(memory.TakeDirtyPages()[first_page]);
+
+    SECTION("tracked pages stay mapped for reading") {
+        CHECK(page_table->pointers[addr >> Memory::PAGE_BITS] != nullptr);
+        CHECK(memory.Read32(addr) == 0x12345678);
+        CHECK_FALSE(memory.TakeDirtyPages()[first_page]);
+    }
+
+    SECTION("writes mark the page they touch") {
+        memory.Write32(addr + Memory::PAGE_SIZE, 0xABCD);
+        const std::vector<bool> dirty_pages = memory.TakeDirtyPages();
+        CHECK_FALSE(dirty_pages[first_page]);
+        CHECK(dirty_pages[first_page + 1]);
+        CHECK(memory.Read32(addr + Memory::PAGE_SIZE) == 0xABCD);
+
+        // The page is tracked again after taking the dirty pages
+        memory.Write8(addr + Memory::PAGE_SIZE, 0xEF);
+        CHECK(memory.TakeDirtyPages()[first_page + 1]);
+    }
+
+    SECTION("writes through pointers into FCRAM are noticed") {
+        memory.GetFCRAMPointer((first_page + 1) * Memory::PAGE_SIZE)[0x10] = 0x42;
+        const std::vector<bool> dirty_pages = memory.TakeDirtyPages();
+        CHECK_FALSE(dirty_pages[first_page]);
+        CHECK(dirty_pages[first_page + 1]);
+    }
+
+    SECTION("writes can be announced explicitly") {
+        memory.MarkRegionDirty(Memory::FCRAM_PADDR + first_page * Memory::PAGE_SIZE + 0xFFF, 2);
+        const std::vector<bool> dirty_pages = memory.TakeDirtyPages();
+        CHECK(dirty_pages[first_page]);
+        CHECK(dirty_pages[first_page + 1]);
+        CHECK_FALSE(dirty_pages[first_page + 2]);
+    }
+
+    memory.UnregisterPageTable(page_table.get());
+}
@@ -0,0 +1,133 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <chrono>
+#include <vector>
+#include <catch2/catch.hpp>
+#include "video_core/command_list_cache.h"
+#include "video_core/command_processor.h"
+
+namespace Pica::CommandProcessor {
+
+namespace {
+
+u32 MakeHeader(u32 id, u32 mask, u32 extra_data_length, bool group_commands) {
+    CommandHeader header{};
+    header.cmd_id.Assign(id);
+    header.parameter_mask.Assign(mask);
+    header.extra_data_length.Assign(extra_data_length);
+    header.group_commands.Assign(group_commands ? 1 : 0);
+    return header.hex;
+}
+
+} // Anonymous namespace
+
+static bool operator==(const DecodedCommand& lhs, const DecodedCommand& rhs) {
+    return lhs.value == rhs.value && lhs.id == rhs.id && lhs.mask == rhs.mask;
+}
+
+TEST_CASE("DecodeCommandList", "[video_core]") {
+    const std::vector<u32> list = {
+        0x11111111, MakeHeader(0x100, 0xF, 0, false),
+        // Consecutive registers, followed by a padding word
+        0x22222222, MakeHeader(0x200, 0x3, 1, true), 0x33333333, 0xDEADBEEF,
+        // Repeated writes to the same register
+        0x44444444, MakeHeader(0x2C1, 0xF, 2, false), 0x55555555, 0x66666666,
+    };
+
+    DecodedCommandList decoded;
+    DecodeCommandList(list.data(), static_cast<u32>(list.size()), decoded);
+
+    const std::vector<DecodedCommand> expected = {
+        {0x11111111, 0x100, 0xF}, {0x22222222, 0x200, 0x3}, {0x33333333, 0x201, 0x3},
+        {0x44444444, 0x2C1, 0xF}, {0x55555555, 0x2C1, 0xF}, {0x66666666, 0x2C1, 0xF},
+    };
+    REQUIRE(decoded.commands == expected);
+    REQUIRE(decoded.words_read == list.size());
+}
+
+TEST_CASE("CommandListCache", "[video_core]") {
+    std::vector<u32> list = {0x11111111, MakeHeader(0x100, 0xF, 0, false), 0x22222222,
+                             MakeHeader(0x101, 0xF, 0, false)};
+    const u32 length = static_cast<u32>(list.size());
+    constexpr PAddr address = 0x20001000;
+    CommandListCache cache;
+
+    const auto first = cache.Get(address, list.data(), length);
+    const auto second = cache.Get(address, list.data(), length);
+    REQUIRE(first == second);
+    REQUIRE(cache.GetStats().hits == 1);
+    REQUIRE(cache.GetStats().misses == 1);
+
+    SECTION("a changed list is decoded again") {
+        list[2] = 0x33333333;
+        const auto changed = cache.Get(address, list.data(), length);
+        REQUIRE(changed->commands[1].value == 0x33333333);
+        REQUIRE(cache.GetStats().misses == 2);
+    }
+
+    SECTION("a list submitted with another length is decoded again") {
+        const auto shorter = cache.Get(address, list.data(), 2);
+        REQUIRE(shorter->commands.size() == 1);
+        REQUIRE(cache.GetStats().misses == 2);
+    }
+
+    SECTION("writes to the list drop it") {
+        cache.Invalidate(address - 0x10, 0x10);
+        cache.Invalidate(address + length * sizeof(u32), 0x10);
+        REQUIRE(cache.GetStats().invalidations == 0);
+
+        cache.Invalidate(address + 4, 4);
+        REQUIRE(cache.GetStats().invalidations == 1);
+        cache.Get(address, list.data(), length);
+        REQUIRE(cache.GetStats().misses == 2);
+    }
+}
+
+TEST_CASE("CommandListCache throughput", "[.][benchmark][video_core]") {
+    // A list setting up a draw: mostly single register writes, with a few uniform uploads
+    std::vector<u32> list;
+    for (u32 i = 0; list.size() < 4096; ++i) {
+        if (i % 16 == 0) {
+            list.insert(list.end(), {i, MakeHeader(0x2C1, 0xF, 11, false)});
+            list.insert(list.end(), 12, i);
+        } else {
+            list.insert(list.end(), {i, MakeHeader(0x40 + i % 0x100, 0xF, 0, false)});
+        }
+    }
+    const u32 length = static_cast<u32>(list.size());
+    constexpr int iterations = 20000;
+
+    const auto measure = [&](auto&& process) {
+        u64 checksum = 0;
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; ++i) {
+            process([&checksum](const DecodedCommand& command) {
+                checksum += command.value ^ command.id;
+            });
+        }
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        return std::make_pair(iterations * length / elapsed.count() / 1e6, checksum);
+    };
+
+    DecodedCommandList decoded;
+    const auto [decode_rate, decode_checksum] = measure([&](auto&& write) {
+        DecodeCommandList(list.data(), length, decoded);
+        for (const auto& command : decoded.commands) {
+            write(command);
+        }
+    });
+
+    CommandListCache cache;
+    const auto [cached_rate, cached_checksum] = measure([&](auto&& write) {
+        for (const auto& command : cache.Get(0x20000000, list.data(), length)->commands) {
+            write(command);
+        }
+    });
+
+    REQUIRE(cached_checksum == decode_checksum);
+    WARN("decoding: " << decode_rate << " Mwords/s, cached: " << cached_rate << " Mwords/s");
+}
+
+} // namespace Pica::CommandProcessor
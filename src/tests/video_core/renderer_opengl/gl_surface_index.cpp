@@ -0,0 +1,173 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <set>
+#include <vector>
+#include <boost/icl/interval_map.hpp>
+#include <catch2/catch.hpp>
+#include "video_core/renderer_opengl/gl_surface_index.h"
+
+namespace OpenGL {
+
+namespace {
+
+/// The interval map the rasterizer cache used to keep its surfaces in
+using ReferenceIndex = boost::icl::interval_map<PAddr, std::set<int>>;
+
+struct Range {
+    PAddr start;
+    PAddr end;
+};
+
+/**
+ * Generates the ranges of surfaces like a game would create them: framebuffers and textures in
+ * VRAM and FCRAM, many of which share pages or overlap each other.
+ */
+std::vector<Range> GenerateSurfaceRanges(std::mt19937& rng, std::size_t count) {
+    constexpr PAddr VRAM = 0x18000000;
+    constexpr PAddr FCRAM = 0x20000000;
+    std::uniform_int_distribution<int> size_log2(6, 20);
+    std::uniform_int_distribution<u32> offset(0, 0x5FFFFF);
+    std::bernoulli_distribution in_vram(0.5);
+
+    std::vector<Range> ranges(count);
+    for (auto& range : ranges) {
+        const u32 size = 1u << size_log2(rng);
+        range.start = (in_vram(rng) ? VRAM : FCRAM) + (offset(rng) & ~63u);
+        range.end = range.start + size;
+    }
+    return ranges;
+}
+
+std::vector<int> LookupReference(const ReferenceIndex& index, PAddr start, PAddr end) {
+    std::vector<int> values;
+    const auto interval = ReferenceIndex::interval_type::right_open(start, end);
+    for (const auto& pair : boost::make_iterator_range(index.equal_range(interval))) {
+        for (const int value : pair.second) {
+            if (std::find(values.begin(), values.end(), value) == values.end()) {
+                values.push_back(value);
+            }
+        }
+    }
+    return values;
+}
+
+std::vector<int> Lookup(const SurfacePageIndex<int>& index, PAddr start, PAddr end) {
+    std::vector<int> values;
+    index.ForEachOverlapping(start, end, [&](int value) { values.push_back(value); });
+    return values;
+}
+
+} // Anonymous namespace
+
+TEST_CASE("SurfacePageIndex matches an interval map", "[video_core][renderer_opengl]") {
+    std::mt19937 rng(1234);
+    const auto ranges = GenerateSurfaceRanges(rng, 256);
+
+    SurfacePageIndex<int> index;
+    ReferenceIndex reference;
+    std::vector<bool> registered(ranges.size());
+    std::uniform_int_distribution<std::size_t> pick(0, ranges.size() - 1);
+    for (int step = 0; step < 4000; ++step) {
+        const std::size_t i = pick(rng);
+        const auto interval = ReferenceIndex::interval_type::right_open(ranges[i].start,
+                                                                         ranges[i].end);
+        if (registered[i]) {
+            index.Erase(static_cast<int>(i), ranges[i].start, ranges[i].end);
+            reference.subtract({interval, std::set<int>{static_cast<int>(i)}});
+        } else {
+            index.Insert(static_cast<int>(i), ranges[i].start, ranges[i].end);
+            reference.add({interval, std::set<int>{static_cast<int>(i)}});
+        }
+        registered[i] = !registered[i];
+
+        // Look up the range of another surface, as well as a few bytes written by the CPU
+        const auto& query = ranges[pick(rng)];
+        REQUIRE(Lookup(index, query.start, query.end) ==
+                LookupReference(reference, query.start, query.end));
+        REQUIRE(Lookup(index, query.start + 4, query.start + 8) ==
+                LookupReference(reference, query.start + 4, query.start + 8));
+
+        const u32 page = query.start >> SurfacePageIndex<int>::PAGE_BITS;
+        const PAddr page_start = page << SurfacePageIndex<int>::PAGE_BITS;
+        REQUIRE(index.GetPageCount(page) ==
+                LookupReference(reference, page_start, page_start + 0x1000).size());
+    }
+
+    auto all = index.GetAll();
+    std::sort(all.begin(), all.end());
+    std::vector<int> expected;
+    for (std::size_t i = 0; i < ranges.size(); ++i) {
+        if (registered[i]) {
+            expected.push_back(static_cast<int>(i));
+        }
+    }
+    REQUIRE(all == expected);
+    REQUIRE(index.Empty() == expected.empty());
+}
+
+TEST_CASE("SurfacePageIndex throughput", "[.][benchmark][renderer_opengl]") {
+    // Replays the pattern of a frame: surfaces come and go, each draw looks up its framebuffers
+    // and textures, and the CPU writes to pages holding surfaces
+    std::mt19937 rng(1234);
+    const auto ranges = GenerateSurfaceRanges(rng, 512);
+    std::uniform_int_distribution<std::size_t> pick(0, ranges.size() - 1);
+    std::vector<std::size_t> operations(200000);
+    for (auto& operation : operations) {
+        operation = pick(rng);
+    }
+
+    const auto measure = [&](auto&& insert, auto&& erase, auto&& lookup) {
+        std::vector<bool> registered(ranges.size());
+        std::size_t found = 0;
+        const auto start = std::chrono::steady_clock::now();
+        for (std::size_t step = 0; step < operations.size(); ++step) {
+            const std::size_t i = operations[step];
+            const auto& range = ranges[i];
+            if (step % 16 == 0) {
+                if (registered[i]) {
+                    erase(static_cast<int>(i), range.start, range.end);
+                } else {
+                    insert(static_cast<int>(i), range.start, range.end);
+                }
+                registered[i] = !registered[i];
+            } else if (step % 4 == 0) {
+                found += lookup(range.start + 16, range.start + 20);
+            } else {
+                found += lookup(range.start, range.end);
+            }
+        }
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        return std::make_pair(operations.size() / elapsed.count() / 1e6, found);
+    };
+
+    ReferenceIndex reference;
+    const auto [reference_rate, reference_found] = measure(
+        [&](int value, PAddr start, PAddr end) {
+            reference.add({ReferenceIndex::interval_type::right_open(start, end), {value}});
+        },
+        [&](int value, PAddr start, PAddr end) {
+            reference.subtract({ReferenceIndex::interval_type::right_open(start, end), {value}});
+        },
+        [&](PAddr start, PAddr end) { return LookupReference(reference, start, end).size(); });
+
+    SurfacePageIndex<int> index;
+    const auto [index_rate, index_found] = measure(
+        [&](int value, PAddr start, PAddr end) { index.Insert(value, start, end); },
+        [&](int value, PAddr start, PAddr end) { index.Erase(value, start, end); },
+        [&](PAddr start, PAddr end) {
+            std::size_t count = 0;
+            index.ForEachOverlapping(start, end, [&](int) { ++count; });
+            return count;
+        });
+
+    REQUIRE(index_found == reference_found);
+    WARN("interval map: " << reference_rate << " Mops/s, page index: " << index_rate
+                          << " Mops/s");
+}
+
+} // namespace OpenGL
@@ -0,0 +1,49 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <memory>
+#include <catch2/catch.hpp>
+#include <nihstro/inline_assembly.h>
+#include "video_core/shader/shader.h"
+
+using DestRegister = nihstro::DestRegister;
+using OpCode = nihstro::OpCode;
+using SourceRegister = nihstro::SourceRegister;
+
+static bool ReadsCarriedOverState(std::initializer_list<nihstro::InlineAsm> code) {
+    const auto shbin = nihstro::InlineAsm::CompileToRawBinary(code);
+
+    auto setup = std::make_unique<Pica::Shader::ShaderSetup>();
+    setup->program_code.fill(0);
+    setup->swizzle_data.fill(0);
+    std::transform(shbin.program.begin(), shbin.program.end(), setup->program_code.begin(),
+                   [](const auto& x) { return x.hex; });
+    std::transform(shbin.swizzle_table.begin(), shbin.swizzle_table.end(),
+                   setup->swizzle_data.begin(), [](const auto& x) { return x.hex; });
+
+    return Pica::Shader::ReadsCarriedOverState(*setup, 0, 0x1);
+}
+
+TEST_CASE("ReadsCarriedOverState", "[video_core][shader]") {
+    const auto sh_input = SourceRegister::MakeInput(0);
+    const auto sh_temp_src = SourceRegister::MakeTemporary(0);
+    const auto sh_temp_dest = DestRegister::MakeTemporary(0);
+    const auto sh_output = DestRegister::MakeOutput(0);
+
+    REQUIRE(!ReadsCarriedOverState({
+        // clang-format off
+        {OpCode::Id::MOV, sh_temp_dest, sh_input},
+        {OpCode::Id::MOV, sh_output, sh_temp_src},
+        {OpCode::Id::END},
+        // clang-format on
+    }));
+
+    REQUIRE(ReadsCarriedOverState({
+        // clang-format off
+        {OpCode::Id::MOV, sh_output, sh_temp_src},
+        {OpCode::Id::END},
+        // clang-format on
+    }));
+}
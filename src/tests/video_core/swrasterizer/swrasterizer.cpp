@@ -0,0 +1,285 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+#include <catch2/catch.hpp>
+#include "common/thread_pool.h"
+#include "core/memory.h"
+#include "video_core/pica_state.h"
+#include "video_core/shader/shader.h"
+#include "video_core/swrasterizer/swrasterizer.h"
+#include "video_core/video_core.h"
+
+namespace {
+
+using Pica::FramebufferRegs;
+using Pica::TexturingRegs;
+using Pica::float24;
+using Pica::Shader::OutputVertex;
+
+constexpr u32 WIDTH = 256;
+constexpr u32 HEIGHT = 240;
+constexpr u32 TEXTURE_SIZE = 64;
+
+constexpr PAddr COLOR_BUFFER = Memory::VRAM_PADDR;
+constexpr PAddr DEPTH_BUFFER = Memory::VRAM_PADDR + 0x100000;
+constexpr PAddr TEXTURE = Memory::VRAM_PADDR + 0x200000;
+
+// Raw float24 values of the viewport registers
+constexpr u32 FLOAT24_MINUS_ONE = 0xBF0000;
+constexpr u32 FLOAT24_HALF_WIDTH = 0x460000;  // 128.0
+constexpr u32 FLOAT24_HALF_HEIGHT = 0x45E000; // 120.0
+
+/// Sets up the memory and the PICA registers for drawing into a 256x240 RGBA8/D24S8 framebuffer
+class DrawEnvironment {
+public:
+    explicit DrawEnvironment(bool textured) {
+        VideoCore::g_memory = &memory;
+        Pica::g_state.Reset();
+
+        auto& regs = Pica::g_state.regs;
+        regs.rasterizer.viewport_size_x.Assign(FLOAT24_HALF_WIDTH);
+        regs.rasterizer.viewport_size_y.Assign(FLOAT24_HALF_HEIGHT);
+        regs.rasterizer.viewport_depth_range.Assign(FLOAT24_MINUS_ONE);
+        regs.lighting.disable.Assign(1);
+
+        auto& framebuffer = regs.framebuffer.framebuffer;
+        framebuffer.allow_color_write.Assign(0xF);
+        framebuffer.allow_depth_stencil_write.Assign(0x3);
+        framebuffer.color_format.Assign(FramebufferRegs::ColorFormat::RGBA8);
+        framebuffer.depth_format.Assign(FramebufferRegs::DepthFormat::D24S8);
+        framebuffer.color_buffer_address.Assign(COLOR_BUFFER / 8);
+        framebuffer.depth_buffer_address.Assign(DEPTH_BUFFER / 8);
+        framebuffer.width.Assign(WIDTH);
+        framebuffer.height.Assign(HEIGHT - 1);
+
+        // Blending and stencil updates make the result depend on the order of the fragments
+        auto& output_merger = regs.framebuffer.output_merger;
+        output_merger.alphablend_enable.Assign(1);
+        output_merger.alpha_blending.factor_source_rgb.Assign(
+            FramebufferRegs::BlendFactor::SourceAlpha);
+        output_merger.alpha_blending.factor_dest_rgb.Assign(
+            FramebufferRegs::BlendFactor::OneMinusSourceAlpha);
+        output_merger.alpha_blending.factor_source_a.Assign(FramebufferRegs::BlendFactor::One);
+        output_merger.alpha_blending.factor_dest_a.Assign(FramebufferRegs::BlendFactor::Zero);
+        output_merger.depth_test_enable.Assign(1);
+        output_merger.depth_test_func.Assign(FramebufferRegs::CompareFunc::LessThanOrEqual);
+        output_merger.depth_write_enable.Assign(1);
+        output_merger.red_enable.Assign(1);
+        output_merger.green_enable.Assign(1);
+        output_merger.blue_enable.Assign(1);
+        output_merger.alpha_enable.Assign(1);
+        output_merger.stencil_test.enable.Assign(1);
+        output_merger.stencil_test.func.Assign(FramebufferRegs::CompareFunc::Always);
+        output_merger.stencil_test.write_mask.Assign(0xFF);
+        output_merger.stencil_test.input_mask.Assign(0xFF);
+        output_merger.stencil_test.action_depth_pass.Assign(
+            FramebufferRegs::StencilAction::IncrementWrap);
+
+        // The default combiner passes the primary color through, modulate it with the texture
+        if (textured) {
+            std::mt19937 rng(42);
+            u8* texture = memory.GetPhysicalPointer(TEXTURE);
+            for (u32 i = 0; i < TEXTURE_SIZE * TEXTURE_SIZE * 4; ++i) {
+                texture[i] = static_cast<u8>(rng());
+            }
+
+            auto& texturing = regs.texturing;
+            texturing.main_config.texture0_enable.Assign(1);
+            texturing.texture0.width.Assign(TEXTURE_SIZE);
+            texturing.texture0.height.Assign(TEXTURE_SIZE);
+            texturing.texture0.wrap_s.Assign(TexturingRegs::TextureConfig::Repeat);
+            texturing.texture0.wrap_t.Assign(TexturingRegs::TextureConfig::Repeat);
+            texturing.texture0.address.Assign(TEXTURE / 8);
+            texturing.texture0_format.Assign(TexturingRegs::TextureFormat::RGBA8);
+
+            using TevStageConfig = TexturingRegs::TevStageConfig;
+            texturing.tev_stage0.color_source2.Assign(TevStageConfig::Source::Texture0);
+            texturing.tev_stage0.alpha_source2.Assign(TevStageConfig::Source::Texture0);
+            texturing.tev_stage0.color_op.Assign(TevStageConfig::Operation::Modulate);
+            texturing.tev_stage0.alpha_op.Assign(TevStageConfig::Operation::Modulate);
+        }
+    }
+
+    ~DrawEnvironment() {
+        Pica::g_state.Reset();
+        VideoCore::g_memory = nullptr;
+    }
+
+    /// Clears the color, depth and stencil buffers
+    void Clear() {
+        std::memset(memory.GetPhysicalPointer(COLOR_BUFFER), 0, WIDTH * HEIGHT * 4);
+        std::memset(memory.GetPhysicalPointer(DEPTH_BUFFER), 0xFF, WIDTH * HEIGHT * 4);
+    }
+
+    /// Returns the contents of the color buffer followed by those of the depth/stencil buffer
+    std::vector<u8> ReadFramebuffer() {
+        std::vector<u8> contents(WIDTH * HEIGHT * 8);
+        std::memcpy(contents.data(), memory.GetPhysicalPointer(COLOR_BUFFER), WIDTH * HEIGHT * 4);
+        std::memcpy(contents.data() + WIDTH * HEIGHT * 4, memory.GetPhysicalPointer(DEPTH_BUFFER),
+                    WIDTH * HEIGHT * 4);
+        return contents;
+    }
+
+private:
+    Memory::MemorySystem memory;
+};
+
+/// Generates a batch of random, overlapping triangles in clip space, covering the whole screen
+std::vector<OutputVertex> GenerateTriangles(std::size_t count, float max_size) {
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> center(-1.0f, 1.0f);
+    std::uniform_real_distribution<float> offset(-max_size, max_size);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    auto F = [](float value) { return float24::FromFloat32(value); };
+
+    std::vector<OutputVertex> vertices(count * 3);
+    for (std::size_t triangle = 0; triangle < count; ++triangle) {
+        const float x = center(rng);
+        const float y = center(rng);
+        const float z = -unit(rng);
+        for (std::size_t i = 0; i < 3; ++i) {
+            OutputVertex& vertex = vertices[triangle * 3 + i];
+            std::memset(&vertex, 0, sizeof(vertex));
+            vertex.pos = Common::MakeVec(F(x + offset(rng)), F(y + offset(rng)),
+                                         F(z + 0.1f * offset(rng)), F(1.0f));
+            vertex.color = Common::MakeVec(F(unit(rng)), F(unit(rng)), F(unit(rng)), F(unit(rng)));
+            vertex.tc0 = Common::MakeVec(F(4.0f * unit(rng)), F(4.0f * unit(rng)));
+        }
+    }
+    return vertices;
+}
+
+/// Generates quads covering the whole framebuffer, each drawing exactly WIDTH * HEIGHT fragments
+std::vector<OutputVertex> GenerateFullscreenLayers(std::size_t count) {
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    auto F = [](float value) { return float24::FromFloat32(value); };
+
+    static constexpr std::array<std::array<float, 2>, 6> corners{{
+        {-1.0f, -1.0f},
+        {1.0f, -1.0f},
+        {1.0f, 1.0f},
+        {-1.0f, -1.0f},
+        {1.0f, 1.0f},
+        {-1.0f, 1.0f},
+    }};
+
+    std::vector<OutputVertex> vertices(count * corners.size());
+    for (std::size_t i = 0; i < vertices.size(); ++i) {
+        const auto& corner = corners[i % corners.size()];
+        OutputVertex& vertex = vertices[i];
+        std::memset(&vertex, 0, sizeof(vertex));
+        vertex.pos = Common::MakeVec(F(corner[0]), F(corner[1]), F(-0.5f), F(1.0f));
+        vertex.color = Common::MakeVec(F(unit(rng)), F(unit(rng)), F(unit(rng)), F(unit(rng)));
+        vertex.tc0 = Common::MakeVec(F(2.0f * corner[0]), F(2.0f * corner[1]));
+    }
+    return vertices;
+}
+
+void Draw(VideoCore::SWRasterizer& rasterizer, const std::vector<OutputVertex>& vertices) {
+    for (std::size_t i = 0; i + 2 < vertices.size(); i += 3) {
+        rasterizer.AddTriangle(vertices[i], vertices[i + 1], vertices[i + 2]);
+    }
+    rasterizer.DrawTriangles();
+}
+
+/// Draws the batch with the given number of rasterizer threads, returning the framebuffer contents
+std::vector<u8> DrawWithThreads(DrawEnvironment& environment, u16 num_threads,
+                                const std::vector<OutputVertex>& vertices) {
+    VideoCore::g_sw_rasterizer_threads = num_threads;
+    VideoCore::SWRasterizer rasterizer;
+    environment.Clear();
+    Draw(rasterizer, vertices);
+    return environment.ReadFramebuffer();
+}
+
+} // Anonymous namespace
+
+TEST_CASE("SWRasterizer output is independent of the thread count",
+          "[video_core][swrasterizer]") {
+    const auto textured = GENERATE(false, true);
+    INFO("Textured " << textured);
+
+    DrawEnvironment environment(textured);
+    const auto vertices = GenerateTriangles(500, 0.4f);
+
+    const auto reference = DrawWithThreads(environment, 1, vertices);
+    for (u16 num_threads : {2, 3, 4, 8}) {
+        INFO("Threads " << num_threads);
+        const auto result = DrawWithThreads(environment, num_threads, vertices);
+        const auto mismatch = std::mismatch(result.begin(), result.end(), reference.begin());
+        INFO("First differing byte at offset " << mismatch.first - result.begin());
+        REQUIRE(mismatch.first == result.end());
+    }
+
+    VideoCore::g_sw_rasterizer_threads = 1;
+}
+
+TEST_CASE("SWRasterizer thread scaling", "[.][benchmark][swrasterizer]") {
+    DrawEnvironment environment(true);
+    const auto vertices = GenerateTriangles(2000, 0.3f);
+    constexpr int iterations = 16;
+
+    std::vector<u16> thread_counts{1, 2, 4};
+    const auto hardware_threads =
+        static_cast<u16>(Common::ThreadPool::GetHardwareThreadCount());
+    if (hardware_threads > 4) {
+        thread_counts.push_back(hardware_threads);
+    }
+
+    double single_thread_time = 0.0;
+    for (u16 num_threads : thread_counts) {
+        VideoCore::g_sw_rasterizer_threads = num_threads;
+        VideoCore::SWRasterizer rasterizer;
+        environment.Clear();
+        Draw(rasterizer, vertices);
+
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; ++i) {
+            Draw(rasterizer, vertices);
+        }
+        const std::chrono::duration<double, std::milli> elapsed =
+            std::chrono::steady_clock::now() - start;
+        const double time = elapsed.count() / iterations;
+        if (num_threads == 1) {
+            single_thread_time = time;
+        }
+        WARN(num_threads << " threads: " << time << " ms per batch, speed-up "
+                         << single_thread_time / time);
+    }
+
+    VideoCore::g_sw_rasterizer_threads = 1;
+}
+
+TEST_CASE("SWRasterizer fragment throughput", "[.][benchmark][swrasterizer]") {
+    const auto textured = GENERATE(false, true);
+
+    DrawEnvironment environment(textured);
+    constexpr std::size_t layers = 16;
+    const auto vertices = GenerateFullscreenLayers(layers);
+    constexpr int iterations = 8;
+
+    VideoCore::g_sw_rasterizer_threads = 1;
+    VideoCore::SWRasterizer rasterizer;
+    environment.Clear();
+    Draw(rasterizer, vertices);
+
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        Draw(rasterizer, vertices);
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    const double fragments = static_cast<double>(iterations * layers * WIDTH * HEIGHT);
+    WARN((textured ? "Textured" : "Flat-shaded")
+         << ": " << fragments / elapsed.count() / 1e6 << " Mfragments/s");
+}
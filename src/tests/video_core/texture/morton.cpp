@@ -0,0 +1,105 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <chrono>
+#include <random>
+#include <tuple>
+#include <vector>
+#include <catch2/catch.hpp>
+#include "video_core/texture/morton.h"
+
+namespace Pica::Texture {
+
+static std::vector<u8> GenerateData(std::size_t size) {
+    std::mt19937 rng(1234);
+    std::uniform_int_distribution<int> byte(0, 255);
+    std::vector<u8> data(size);
+    for (auto& value : data) {
+        value = static_cast<u8>(byte(rng));
+    }
+    return data;
+}
+
+TEST_CASE("Morton kernels match the reference implementation", "[video_core][texture]") {
+    const auto format = GENERATE(MortonFormat::Copy8, MortonFormat::Copy16, MortonFormat::Copy24,
+                                 MortonFormat::Copy32, MortonFormat::D24, MortonFormat::D24S8,
+                                 MortonFormat::SwapRGB8, MortonFormat::SwapRGBA8);
+    // Rows of 8 texels of at most 4 bytes, padded to tell apart writes beyond the tile
+    constexpr std::ptrdiff_t row_size = 40;
+    const bool flip = GENERATE(false, true);
+    const std::ptrdiff_t pitch = flip ? -row_size : row_size;
+    const std::ptrdiff_t first_row = flip ? 7 * row_size : 0;
+
+    const auto tile = GenerateData(64 * 4);
+    const auto linear = GenerateData(8 * row_size);
+
+    auto expected_linear = linear;
+    auto actual_linear = linear;
+    MortonToLinearReference(format, tile.data(), expected_linear.data() + first_row, pitch);
+    MortonToLinear(format, tile.data(), actual_linear.data() + first_row, pitch);
+    REQUIRE(actual_linear == expected_linear);
+
+    auto expected_tile = tile;
+    auto actual_tile = tile;
+    LinearToMortonReference(format, expected_tile.data(), linear.data() + first_row, pitch);
+    LinearToMorton(format, actual_tile.data(), linear.data() + first_row, pitch);
+    REQUIRE(actual_tile == expected_tile);
+}
+
+TEST_CASE("Morton kernel throughput", "[.][benchmark][texture]") {
+    // A 256x256 image, converted back and forth
+    constexpr u32 size = 256;
+    constexpr u32 tiles = size * size / 64;
+    constexpr int iterations = 64;
+    auto tiled = GenerateData(size * size * 4);
+    auto linear = GenerateData(size * size * 4);
+
+    const auto measure = [&](auto&& to_linear, auto&& to_morton, u32 bytes_per_texel) {
+        const std::ptrdiff_t pitch = size * bytes_per_texel;
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; ++i) {
+            for (u32 tile = 0; tile < tiles; ++tile) {
+                const u32 x = tile % (size / 8) * 8;
+                const u32 y = tile / (size / 8) * 8;
+                u8* linear_tile = linear.data() + y * pitch + x * bytes_per_texel;
+                u8* tiled_tile = tiled.data() + tile * 64 * bytes_per_texel;
+                if (i % 2 == 0) {
+                    to_linear(tiled_tile, linear_tile, pitch);
+                } else {
+                    to_morton(tiled_tile, linear_tile, pitch);
+                }
+            }
+        }
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        return static_cast<double>(size) * size * bytes_per_texel * iterations /
+               elapsed.count() / 1e9;
+    };
+
+    const std::tuple<const char*, MortonFormat, u32> formats[] = {
+        {"Copy8", MortonFormat::Copy8, 1},   {"Copy16", MortonFormat::Copy16, 2},
+        {"Copy24", MortonFormat::Copy24, 3}, {"Copy32", MortonFormat::Copy32, 4},
+        {"D24S8", MortonFormat::D24S8, 4},   {"SwapRGBA8", MortonFormat::SwapRGBA8, 4},
+    };
+    for (const auto& [name, format, bytes_per_texel] : formats) {
+        const double reference = measure(
+            [format = format](const u8* tile, u8* linear, std::ptrdiff_t pitch) {
+                MortonToLinearReference(format, tile, linear, pitch);
+            },
+            [format = format](u8* tile, const u8* linear, std::ptrdiff_t pitch) {
+                LinearToMortonReference(format, tile, linear, pitch);
+            },
+            bytes_per_texel);
+        const double kernel = measure(
+            [format = format](const u8* tile, u8* linear, std::ptrdiff_t pitch) {
+                MortonToLinear(format, tile, linear, pitch);
+            },
+            [format = format](u8* tile, const u8* linear, std::ptrdiff_t pitch) {
+                LinearToMorton(format, tile, linear, pitch);
+            },
+            bytes_per_texel);
+        WARN(name << ": " << reference << " GB/s per texel, " << kernel << " GB/s with kernels");
+    }
+}
+
+} // namespace Pica::Texture
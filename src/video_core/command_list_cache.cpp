@@ -0,0 +1,86 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include "common/hash.h"
+#include "video_core/command_list_cache.h"
+#include "video_core/command_processor.h"
+
+namespace Pica::CommandProcessor {
+
+/// Lists at so many addresses are only seen when games build them in a ring buffer, which is not
+/// worth caching
+constexpr std::size_t MAX_CACHED_LISTS = 1024;
+
+void DecodeCommandList(const u32* list, u32 length, DecodedCommandList& decoded) {
+    decoded.commands.clear();
+
+    const u32* current = list;
+    while (current < list + length) {
+        // Align read pointer to 8 bytes
+        if ((list - current) % 2 != 0)
+            ++current;
+
+        const u32 value = *current++;
+        const CommandHeader header = {*current++};
+        const u8 mask = static_cast<u8>(header.parameter_mask.Value());
+
+        decoded.commands.push_back({value, static_cast<u16>(header.cmd_id.Value()), mask});
+        for (unsigned i = 0; i < header.extra_data_length; ++i) {
+            const u32 id = header.cmd_id + (header.group_commands ? i + 1 : 0);
+            decoded.commands.push_back({*current++, static_cast<u16>(id), mask});
+        }
+    }
+
+    decoded.words_read = static_cast<u32>(current - list);
+    decoded.hash = Common::ComputeHash64(list, decoded.words_read * sizeof(u32));
+}
+
+std::shared_ptr<const DecodedCommandList> CommandListCache::Get(PAddr address, const u32* list,
+                                                                u32 length) {
+    auto it = entries.find(address);
+    if (it != entries.end()) {
+        const Entry& entry = it->second;
+        if (entry.length == length &&
+            Common::ComputeHash64(list, entry.list->words_read * sizeof(u32)) ==
+                entry.list->hash) {
+            ++stats.hits;
+            return entry.list;
+        }
+    } else {
+        if (entries.size() >= MAX_CACHED_LISTS) {
+            entries.clear();
+        }
+        it = entries.emplace(address, Entry{}).first;
+    }
+
+    ++stats.misses;
+    Entry& entry = it->second;
+    // Lists rewritten in place every frame reuse the storage of the previous contents, unless
+    // those are still being replayed
+    if (entry.list == nullptr || entry.list.use_count() > 1) {
+        entry.list = std::make_shared<DecodedCommandList>();
+    }
+    entry.length = length;
+    DecodeCommandList(list, length, *entry.list);
+    return entry.list;
+}
+
+void CommandListCache::Invalidate(PAddr address, u32 size) {
+    const PAddr end = address + size;
+    for (auto it = entries.begin(); it != entries.end();) {
+        const PAddr list_end = it->first + it->second.list->words_read * sizeof(u32);
+        if (it->first < end && address < list_end) {
+            it = entries.erase(it);
+            ++stats.invalidations;
+        } else {
+            ++it;
+        }
+    }
+}
+
+void CommandListCache::Clear() {
+    entries.clear();
+}
+
+} // namespace Pica::CommandProcessor
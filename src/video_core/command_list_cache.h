@@ -0,0 +1,74 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include "common/common_types.h"
+
+namespace Pica::CommandProcessor {
+
+/// A register write of a command list, with its header already taken apart
+struct DecodedCommand {
+    u32 value;
+    u16 id;
+    /// Parameter mask of the command header, one bit per byte of the register
+    u8 mask;
+};
+static_assert(sizeof(DecodedCommand) == 8, "DecodedCommand should stay compact");
+
+struct DecodedCommandList {
+    std::vector<DecodedCommand> commands;
+    /// Number of words read while decoding, which may go past the end of a malformed list
+    u32 words_read = 0;
+    /// Hash of the words read
+    u64 hash = 0;
+};
+
+/// Decodes a command list into the register writes it performs, in order
+void DecodeCommandList(const u32* list, u32 length, DecodedCommandList& decoded);
+
+/**
+ * Cache of decoded command lists, so that the static command buffers games submit every frame
+ * are not parsed again each time. Lists are keyed by their physical address, and a cached list is
+ * only used if the hash of its words still matches, which catches any write by the CPU. Writes by
+ * the GPU and DMA go through the rasterizer memory hooks, which drop the lists they overlap.
+ */
+class CommandListCache {
+public:
+    struct Stats {
+        u64 hits = 0;
+        u64 misses = 0;
+        u64 invalidations = 0;
+    };
+
+    /**
+     * Returns the decoded form of the list of the given length in words, decoding it if it is
+     * not cached or has changed
+     */
+    std::shared_ptr<const DecodedCommandList> Get(PAddr address, const u32* list, u32 length);
+
+    /// Drops the cached lists overlapping the given range of physical memory
+    void Invalidate(PAddr address, u32 size);
+
+    void Clear();
+
+    const Stats& GetStats() const {
+        return stats;
+    }
+
+private:
+    struct Entry {
+        std::shared_ptr<DecodedCommandList> list;
+        /// Length of the list as submitted, a list read with another length decodes differently
+        u32 length;
+    };
+
+    std::unordered_map<PAddr, Entry> entries;
+    Stats stats;
+};
+
+} // namespace Pica::CommandProcessor
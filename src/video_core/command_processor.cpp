@@ -2,20 +2,27 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <array>
 #include <cstddef>
 #include <memory>
+#include <unordered_map>
 #include <utility>
+#include <vector>
 #include "common/assert.h"
 #include "common/logging/log.h"
 #include "common/microprofile.h"
+#include "common/subsystem_timer.h"
+#include "common/thread_pool.h"
 #include "common/vector_math.h"
 #include "core/hle/service/gsp/gsp.h"
 #include "core/hw/gpu.h"
 #include "core/memory.h"
 #include "core/tracer/recorder.h"
+#include "video_core/command_list_cache.h"
 #include "video_core/command_processor.h"
 #include "video_core/debug_utils/debug_utils.h"
+#include "video_core/gpu_thread.h"
 #include "video_core/pica_state.h"
 #include "video_core/pica_types.h"
 #include "video_core/primitive_assembly.h"
@@ -47,6 +54,15 @@ static const u32 expand_bits_to_bytes[] = {
 
 MICROPROFILE_DEFINE(GPU_Drawing, "GPU", "Drawing", MP_RGB(50, 50, 240));
 
+static CommandListCache command_list_cache;
+
+/// Command list a write to a command buffer trigger register jumped to
+static struct {
+    bool pending = false;
+    PAddr address;
+    u32 size;
+} command_list_jump;
+
 static const char* GetShaderSetupTypeName(Shader::ShaderSetup& setup) {
     if (&setup == &g_state.vs) {
         return "vertex shader";
@@ -117,6 +133,175 @@ static void WriteUniformFloatReg(ShaderRegs& config, Shader::ShaderSetup& setup,
     }
 }
 
+/// Threads shading the vertices of a draw, null while vertices are shaded on the GPU thread
+static std::unique_ptr<Common::ThreadPool> vertex_shader_pool;
+
+/// Number of vertices loaded and shaded by one job of the vertex shader pool
+constexpr std::size_t VERTEX_SHADER_CHUNK_SIZE = 64;
+
+/// Returns the pool to shade vertices on, or nullptr if they are to be shaded serially
+static Common::ThreadPool* GetVertexShaderPool() {
+    std::size_t num_threads = VideoCore::g_vertex_shader_threads;
+    if (num_threads == 0) {
+        num_threads = Common::ThreadPool::GetHardwareThreadCount();
+    }
+
+    if (num_threads <= 1) {
+        vertex_shader_pool.reset();
+    } else if (!vertex_shader_pool || vertex_shader_pool->GetThreadCount() != num_threads) {
+        vertex_shader_pool = std::make_unique<Common::ThreadPool>(num_threads, "VertexShader");
+    }
+    return vertex_shader_pool.get();
+}
+
+/**
+ * Returns whether the vertex shader has to run on a single shader unit, because an invocation can
+ * see the registers the previous one left behind. Shading in parallel gives each chunk of vertices
+ * a fresh shader unit, which would change what such programs compute.
+ */
+static bool NeedsSerialShading() {
+    auto& setup = g_state.vs;
+    const u32 output_mask = g_state.regs.vs.output_mask;
+    const u32 entry_point = g_state.regs.vs.main_offset;
+
+    // Only accessed on the GPU thread
+    static std::unordered_map<u64, bool> serial_programs;
+    const u64 key = setup.GetProgramCodeHash() ^ setup.GetSwizzleDataHash() ^
+                    (static_cast<u64>(output_mask) << 32 | entry_point);
+    auto [it, inserted] = serial_programs.try_emplace(key);
+    if (inserted) {
+        it->second = Shader::ReadsCarriedOverState(setup, entry_point, output_mask);
+    }
+    return it->second;
+}
+
+/**
+ * Runs the vertex shader for a draw on the given pool, then submits the outputs to the geometry
+ * pipeline in draw order. Invocations only depend on the vertex, so indexed draws shade each
+ * distinct vertex once.
+ */
+static void ShadeVerticesInParallel(Common::ThreadPool& pool, Shader::ShaderEngine* shader_engine,
+                                    const VertexLoader& loader, u32 base_address, bool is_indexed,
+                                    const u8* index_address_8, bool index_u16) {
+    const auto& regs = g_state.regs;
+    const u32 num_vertices = regs.pipeline.num_vertices;
+
+    // Only accessed on the GPU thread, kept around to avoid reallocating them on every draw
+    static std::vector<u32> unique_vertices;
+    static std::vector<u32> output_indices;
+    static std::vector<Shader::AttributeBuffer> outputs;
+
+    std::size_t num_outputs = num_vertices;
+    if (is_indexed) {
+        const u16* index_address_16 = reinterpret_cast<const u16*>(index_address_8);
+        output_indices.resize(num_vertices);
+        for (u32 index = 0; index < num_vertices; ++index) {
+            output_indices[index] = index_u16 ? index_address_16[index] : index_address_8[index];
+        }
+
+        unique_vertices.assign(output_indices.begin(), output_indices.end());
+        std::sort(unique_vertices.begin(), unique_vertices.end());
+        unique_vertices.erase(std::unique(unique_vertices.begin(), unique_vertices.end()),
+                              unique_vertices.end());
+        for (u32& output_index : output_indices) {
+            output_index = static_cast<u32>(
+                std::lower_bound(unique_vertices.begin(), unique_vertices.end(), output_index) -
+                unique_vertices.begin());
+        }
+        num_outputs = unique_vertices.size();
+    }
+    outputs.resize(num_outputs);
+
+    const std::size_t num_chunks =
+        (num_outputs + VERTEX_SHADER_CHUNK_SIZE - 1) / VERTEX_SHADER_CHUNK_SIZE;
+    pool.ParallelFor(num_chunks, [&](std::size_t chunk) {
+        const std::size_t first = chunk * VERTEX_SHADER_CHUNK_SIZE;
+        const std::size_t count = std::min(VERTEX_SHADER_CHUNK_SIZE, num_outputs - first);
+
+        // Memory accesses are only tracked for the debug recorder, which is never active here
+        DebugUtils::MemoryAccessTracker memory_accesses;
+        std::array<Shader::AttributeBuffer, VERTEX_SHADER_CHUNK_SIZE> inputs;
+        if (is_indexed) {
+            for (std::size_t i = 0; i < count; ++i) {
+                loader.LoadVertex(base_address, static_cast<int>(first + i),
+                                  unique_vertices[first + i], inputs[i], memory_accesses);
+            }
+        } else {
+            loader.LoadVertices(base_address,
+                                regs.pipeline.vertex_offset + static_cast<u32>(first), count,
+                                inputs.data(), memory_accesses);
+        }
+
+        Shader::UnitState shader_unit;
+        for (std::size_t i = 0; i < count; ++i) {
+            shader_unit.LoadInput(regs.vs, inputs[i]);
+            shader_engine->Run(g_state.vs, shader_unit);
+            shader_unit.WriteOutput(regs.vs, outputs[first + i]);
+        }
+    });
+
+    for (u32 index = 0; index < num_vertices; ++index) {
+        g_state.geometry_pipeline.SubmitVertex(outputs[is_indexed ? output_indices[index] : index]);
+    }
+}
+
+/// How writing to a register affects immediate mode primitives that have not been drawn yet
+enum class BatchEffect : u8 {
+    /// The register only affects how vertices are shaded, which already happened for them
+    None,
+    /// The register configures the rasterizer, the batch has to be drawn before it changes
+    IfChanged,
+    /// Writing to the register has side effects whether or not its value changes
+    Always,
+};
+
+static std::array<BatchEffect, Regs::NUM_REGS> BuildBatchEffects() {
+    std::array<BatchEffect, Regs::NUM_REGS> effects;
+    effects.fill(BatchEffect::IfChanged);
+    const auto set_effect = [&effects](std::size_t first, std::size_t size, BatchEffect effect) {
+        std::fill_n(effects.begin() + first, size / sizeof(u32), effect);
+    };
+
+    set_effect(PICA_REG_INDEX(gs), sizeof(ShaderRegs), BatchEffect::None);
+    set_effect(PICA_REG_INDEX(vs), sizeof(ShaderRegs), BatchEffect::None);
+    set_effect(PICA_REG_INDEX(pipeline.vs_default_attributes_setup),
+               sizeof(PipelineRegs::vs_default_attributes_setup), BatchEffect::None);
+    set_effect(PICA_REG_INDEX(pipeline.command_buffer), sizeof(PipelineRegs::command_buffer),
+               BatchEffect::None);
+
+    set_effect(PICA_REG_INDEX(trigger_irq), sizeof(u32), BatchEffect::Always);
+    set_effect(PICA_REG_INDEX(pipeline.trigger_draw), sizeof(u32), BatchEffect::Always);
+    set_effect(PICA_REG_INDEX(pipeline.trigger_draw_indexed), sizeof(u32), BatchEffect::Always);
+    set_effect(PICA_REG_INDEX(lighting.lut_data), sizeof(LightingRegs::lut_data),
+               BatchEffect::Always);
+    set_effect(PICA_REG_INDEX(texturing.fog_lut_data), sizeof(TexturingRegs::fog_lut_data),
+               BatchEffect::Always);
+    set_effect(PICA_REG_INDEX(texturing.proctex_lut_data),
+               sizeof(TexturingRegs::proctex_lut_data), BatchEffect::Always);
+    return effects;
+}
+
+static const std::array<BatchEffect, Regs::NUM_REGS> batch_effects = BuildBatchEffects();
+
+/// Whether immediate mode primitives were sent to the rasterizer without being drawn yet
+static bool immediate_batch_pending = false;
+
+/// Draws the immediate mode primitives submitted since the last flush
+static void FlushImmediateBatch() {
+    if (!immediate_batch_pending) {
+        return;
+    }
+    immediate_batch_pending = false;
+
+    {
+        Common::ScopedSubsystemTimer timer(Common::Subsystem::Rasterizer);
+        VideoCore::g_renderer->Rasterizer()->DrawTriangles();
+    }
+    if (g_debug_context) {
+        g_debug_context->OnEvent(DebugContext::Event::FinishedPrimitiveBatch, nullptr);
+    }
+}
+
 static void WritePicaReg(u32 id, u32 value, u32 mask) {
     auto& regs = g_state.regs;
 
@@ -132,8 +317,16 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
     u32 old_value = regs.reg_array[id];
 
     const u32 write_mask = expand_bits_to_bytes[mask];
+    const u32 new_value = (old_value & ~write_mask) | (value & write_mask);
+
+    // Pending immediate mode primitives are drawn with the state they were submitted with
+    if (immediate_batch_pending &&
+        (batch_effects[id] == BatchEffect::Always ||
+         (batch_effects[id] == BatchEffect::IfChanged && new_value != old_value))) {
+        FlushImmediateBatch();
+    }
 
-    regs.reg_array[id] = (old_value & ~write_mask) | (value & write_mask);
+    regs.reg_array[id] = new_value;
 
     // Double check for is_pica_tracing to avoid call overhead
     if (DebugUtils::IsPicaTracing()) {
@@ -147,7 +340,7 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
     switch (id) {
     // Trigger IRQ
     case PICA_REG_INDEX(trigger_irq):
-        Service::GSP::SignalInterrupt(Service::GSP::InterruptId::P3D);
+        VideoCore::SignalGPUInterrupt(Service::GSP::InterruptId::P3D);
         break;
 
     case PICA_REG_INDEX(pipeline.triangle_topology):
@@ -218,6 +411,7 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
                     immediate_attribute_id += 1;
                 } else {
                     MICROPROFILE_SCOPE(GPU_Drawing);
+                    Common::ScopedSubsystemTimer shader_timer(Common::Subsystem::ShaderEngine);
                     immediate_attribute_id = 0;
 
                     Shader::OutputVertex::ValidateSemantics(regs.rasterizer);
@@ -245,14 +439,9 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
                     g_state.geometry_pipeline.Setup(shader_engine);
                     g_state.geometry_pipeline.SubmitVertex(output);
 
-                    // TODO: If drawing after every immediate mode triangle kills performance,
-                    // change it to flush triangles whenever a drawing config register changes
-                    // See: https://github.com/citra-emu/citra/pull/2866#issuecomment-327011550
-                    VideoCore::g_renderer->Rasterizer()->DrawTriangles();
-                    if (g_debug_context) {
-                        g_debug_context->OnEvent(DebugContext::Event::FinishedPrimitiveBatch,
-                                                 nullptr);
-                    }
+                    // Games send UI one primitive at a time, so the triangles are only drawn
+                    // once a register the rasterizer depends on changes or the list ends
+                    immediate_batch_pending = true;
                 }
             }
         }
@@ -267,10 +456,10 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
     case PICA_REG_INDEX_WORKAROUND(pipeline.command_buffer.trigger[1], 0x23d): {
         unsigned index =
             static_cast<unsigned>(id - PICA_REG_INDEX(pipeline.command_buffer.trigger[0]));
-        u32* head_ptr = (u32*)VideoCore::g_memory->GetPhysicalPointer(
-            regs.pipeline.command_buffer.GetPhysicalAddress(index));
-        g_state.cmd_list.head_ptr = g_state.cmd_list.current_ptr = head_ptr;
-        g_state.cmd_list.length = regs.pipeline.command_buffer.GetSize(index) / sizeof(u32);
+        // The rest of the current list is skipped
+        command_list_jump.pending = true;
+        command_list_jump.address = regs.pipeline.command_buffer.GetPhysicalAddress(index);
+        command_list_jump.size = regs.pipeline.command_buffer.GetSize(index);
         break;
     }
 
@@ -318,10 +507,9 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
         }
 
         // Processes information about internal vertex attributes to figure out how a vertex is
-        // loaded.
-        // Later, these can be compiled and cached.
+        // loaded. Loaders are cached per attribute layout.
         const u32 base_address = regs.pipeline.vertex_attributes.GetPhysicalBaseAddress();
-        VertexLoader loader(regs.pipeline);
+        const VertexLoader& loader = VertexLoader::GetCached(regs.pipeline);
         Shader::OutputVertex::ValidateSemantics(regs.rasterizer);
 
         // Load vertices
@@ -359,6 +547,13 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
 
         unsigned int vertex_cache_pos = 0;
 
+        // Non-indexed draws load their vertices in batches ahead of running the vertex shader
+        constexpr std::size_t VERTEX_BATCH_SIZE = 64;
+        std::array<Shader::AttributeBuffer, VERTEX_BATCH_SIZE> vertex_batch;
+
+        // Vertex loading is counted as part of the shader engine, triangles passed on by the
+        // geometry pipeline are charged to the rasterizer
+        Common::ScopedSubsystemTimer shader_timer(Common::Subsystem::ShaderEngine);
         auto* shader_engine = Shader::GetEngine();
         Shader::UnitState shader_unit;
 
@@ -369,58 +564,80 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
         if (g_state.geometry_pipeline.NeedIndexInput())
             ASSERT(is_indexed);
 
-        for (unsigned int index = 0; index < regs.pipeline.num_vertices; ++index) {
-            // Indexed rendering doesn't use the start offset
-            unsigned int vertex =
-                is_indexed ? (index_u16 ? index_address_16[index] : index_address_8[index])
-                           : (index + regs.pipeline.vertex_offset);
-
-            bool vertex_cache_hit = false;
-
-            if (is_indexed) {
-                if (g_state.geometry_pipeline.NeedIndexInput()) {
-                    g_state.geometry_pipeline.SubmitIndex(vertex);
-                    continue;
+        // The debugger inspects every shader invocation and the geometry shader may take the
+        // indices instead of the vertices, both need the vertices in order. Programs that can
+        // read the registers of the previous invocation need them on a single shader unit.
+        Common::ThreadPool* pool = GetVertexShaderPool();
+        if (pool && !g_debug_context && !g_state.geometry_pipeline.NeedIndexInput() &&
+            !NeedsSerialShading()) {
+            ShadeVerticesInParallel(*pool, shader_engine, loader, base_address, is_indexed,
+                                    index_address_8, index_u16);
+        } else {
+            for (unsigned int index = 0; index < regs.pipeline.num_vertices; ++index) {
+                // Indexed rendering doesn't use the start offset
+                unsigned int vertex =
+                    is_indexed ? (index_u16 ? index_address_16[index] : index_address_8[index])
+                               : (index + regs.pipeline.vertex_offset);
+
+                bool vertex_cache_hit = false;
+
+                if (!is_indexed && index % VERTEX_BATCH_SIZE == 0) {
+                    const std::size_t count = std::min<std::size_t>(
+                        VERTEX_BATCH_SIZE, regs.pipeline.num_vertices - index);
+                    loader.LoadVertices(base_address, vertex, count, vertex_batch.data(),
+                                        memory_accesses);
                 }
 
-                if (g_debug_context && Pica::g_debug_context->recorder) {
-                    int size = index_u16 ? 2 : 1;
-                    memory_accesses.AddAccess(base_address + index_info.offset + size * index,
-                                              size);
-                }
+                if (is_indexed) {
+                    if (g_state.geometry_pipeline.NeedIndexInput()) {
+                        g_state.geometry_pipeline.SubmitIndex(vertex);
+                        continue;
+                    }
+
+                    if (g_debug_context && Pica::g_debug_context->recorder) {
+                        int size = index_u16 ? 2 : 1;
+                        memory_accesses.AddAccess(base_address + index_info.offset + size * index,
+                                                  size);
+                    }
 
-                for (unsigned int i = 0; i < VERTEX_CACHE_SIZE; ++i) {
-                    if (vertex_cache_valid[i] && vertex == vertex_cache_ids[i]) {
-                        vs_output = vertex_cache[i];
-                        vertex_cache_hit = true;
-                        break;
+                    for (unsigned int i = 0; i < VERTEX_CACHE_SIZE; ++i) {
+                        if (vertex_cache_valid[i] && vertex == vertex_cache_ids[i]) {
+                            vs_output = vertex_cache[i];
+                            vertex_cache_hit = true;
+                            break;
+                        }
                     }
                 }
-            }
 
-            if (!vertex_cache_hit) {
-                // Initialize data for the current vertex
-                Shader::AttributeBuffer input;
-                loader.LoadVertex(base_address, index, vertex, input, memory_accesses);
+                if (!vertex_cache_hit) {
+                    // Initialize data for the current vertex
+                    Shader::AttributeBuffer indexed_input;
+                    Shader::AttributeBuffer* input = &vertex_batch[index % VERTEX_BATCH_SIZE];
+                    if (is_indexed) {
+                        loader.LoadVertex(base_address, index, vertex, indexed_input,
+                                          memory_accesses);
+                        input = &indexed_input;
+                    }
 
-                // Send to vertex shader
-                if (g_debug_context)
-                    g_debug_context->OnEvent(DebugContext::Event::VertexShaderInvocation,
-                                             (void*)&input);
-                shader_unit.LoadInput(regs.vs, input);
-                shader_engine->Run(g_state.vs, shader_unit);
-                shader_unit.WriteOutput(regs.vs, vs_output);
+                    // Send to vertex shader
+                    if (g_debug_context)
+                        g_debug_context->OnEvent(DebugContext::Event::VertexShaderInvocation,
+                                                 (void*)input);
+                    shader_unit.LoadInput(regs.vs, *input);
+                    shader_engine->Run(g_state.vs, shader_unit);
+                    shader_unit.WriteOutput(regs.vs, vs_output);
 
-                if (is_indexed) {
-                    vertex_cache[vertex_cache_pos] = vs_output;
-                    vertex_cache_valid[vertex_cache_pos] = true;
-                    vertex_cache_ids[vertex_cache_pos] = vertex;
-                    vertex_cache_pos = (vertex_cache_pos + 1) % VERTEX_CACHE_SIZE;
+                    if (is_indexed) {
+                        vertex_cache[vertex_cache_pos] = vs_output;
+                        vertex_cache_valid[vertex_cache_pos] = true;
+                        vertex_cache_ids[vertex_cache_pos] = vertex;
+                        vertex_cache_pos = (vertex_cache_pos + 1) % VERTEX_CACHE_SIZE;
+                    }
                 }
-            }
 
-            // Send to geometry pipeline
-            g_state.geometry_pipeline.SubmitVertex(vs_output);
+                // Send to geometry pipeline
+                g_state.geometry_pipeline.SubmitVertex(vs_output);
+            }
         }
 
         for (auto& range : memory_accesses.ranges) {
@@ -428,7 +645,10 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
                 VideoCore::g_memory->GetPhysicalPointer(range.first), range.second, range.first);
         }
 
-        VideoCore::g_renderer->Rasterizer()->DrawTriangles();
+        {
+            Common::ScopedSubsystemTimer timer(Common::Subsystem::Rasterizer);
+            VideoCore::g_renderer->Rasterizer()->DrawTriangles();
+        }
         if (g_debug_context) {
             g_debug_context->OnEvent(DebugContext::Event::FinishedPrimitiveBatch, nullptr);
         }
@@ -651,26 +871,57 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
                                  reinterpret_cast<void*>(&id));
 }
 
-void ProcessCommandList(const u32* list, u32 size) {
-    g_state.cmd_list.head_ptr = g_state.cmd_list.current_ptr = list;
-    g_state.cmd_list.length = size / sizeof(u32);
+void InvalidateCommandLists(PAddr addr, u32 size) {
+    command_list_cache.Invalidate(addr, size);
+}
 
-    while (g_state.cmd_list.current_ptr < g_state.cmd_list.head_ptr + g_state.cmd_list.length) {
+void Shutdown() {
+    const auto& stats = command_list_cache.GetStats();
+    const u64 lookups = stats.hits + stats.misses;
+    LOG_INFO(HW_GPU, "Command list cache: {} hits, {} misses ({:.1f}% hit rate), {} invalidations",
+             stats.hits, stats.misses, lookups ? 100.0 * stats.hits / lookups : 0.0,
+             stats.invalidations);
+    command_list_cache = {};
+
+    immediate_batch_pending = false;
+    command_list_jump.pending = false;
+    vertex_shader_pool.reset();
+}
 
-        // Align read pointer to 8 bytes
-        if ((g_state.cmd_list.head_ptr - g_state.cmd_list.current_ptr) % 2 != 0)
-            ++g_state.cmd_list.current_ptr;
+void ProcessCommandList(PAddr list, u32 size) {
+    Common::ScopedSubsystemTimer timer(Common::Subsystem::GPUCommandList);
 
-        u32 value = *g_state.cmd_list.current_ptr++;
-        const CommandHeader header = {*g_state.cmd_list.current_ptr++};
+    PAddr address = list;
+    while (true) {
+        const u32* head_ptr =
+            reinterpret_cast<const u32*>(VideoCore::g_memory->GetPhysicalPointer(address));
+        if (head_ptr == nullptr) {
+            LOG_ERROR(HW_GPU, "Command list at {:08X} is not in emulated memory", address);
+            break;
+        }
+        g_state.cmd_list.head_ptr = g_state.cmd_list.current_ptr = head_ptr;
+        g_state.cmd_list.length = size / sizeof(u32);
 
-        WritePicaReg(header.cmd_id, value, header.parameter_mask);
+        // Static lists are replayed from the writes they decoded to the last time
+        const auto decoded = command_list_cache.Get(address, head_ptr, g_state.cmd_list.length);
+        for (const DecodedCommand& command : decoded->commands) {
+            WritePicaReg(command.id, command.value, command.mask);
+            if (command_list_jump.pending) {
+                break;
+            }
+        }
+        g_state.cmd_list.current_ptr = head_ptr + decoded->words_read;
 
-        for (unsigned i = 0; i < header.extra_data_length; ++i) {
-            u32 cmd = header.cmd_id + (header.group_commands ? i + 1 : 0);
-            WritePicaReg(cmd, *g_state.cmd_list.current_ptr++, header.parameter_mask);
+        if (!command_list_jump.pending) {
+            break;
         }
+        command_list_jump.pending = false;
+        address = command_list_jump.address;
+        size = command_list_jump.size;
     }
+
+    // The end of a list is a sync point, the CPU may read back or overwrite what was drawn
+    FlushImmediateBatch();
 }
 
 } // namespace Pica::CommandProcessor
@@ -32,6 +32,13 @@ static_assert(std::is_standard_layout<CommandHeader>::value == true,
               "CommandHeader does not use standard layout");
 static_assert(sizeof(CommandHeader) == sizeof(u32), "CommandHeader has incorrect size!");
 
-void ProcessCommandList(const u32* list, u32 size);
+/// Runs the command list of the given size in bytes at the given physical address
+void ProcessCommandList(PAddr list, u32 size);
+
+/// Drops the decoded command lists overlapping the given range of physical memory
+void InvalidateCommandLists(PAddr addr, u32 size);
+
+/// Stops the worker threads used for shading vertices and clears the command list cache
+void Shutdown();
 
 } // namespace Pica::CommandProcessor
@@ -0,0 +1,93 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include "common/thread.h"
+#include "core/hle/service/gsp/gsp.h"
+#include "video_core/gpu_thread.h"
+
+namespace VideoCore {
+
+std::unique_ptr<GPUThread> g_gpu_thread;
+std::atomic<bool> g_gpu_interrupts_enabled{true};
+
+GPUThread::GPUThread() : thread([this] { ThreadLoop(); }) {}
+
+GPUThread::~GPUThread() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop = true;
+    }
+    work_available.notify_one();
+    thread.join();
+}
+
+void GPUThread::Submit(std::function<void()> work) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        queue.push_back(std::move(work));
+    }
+    work_available.notify_one();
+}
+
+bool GPUThread::Synchronize() {
+    if (IsGPUThread()) {
+        return false;
+    }
+
+    std::vector<Service::GSP::InterruptId> interrupts;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        work_done.wait(lock, [this] { return queue.empty() && !busy; });
+        interrupts.swap(deferred_interrupts);
+    }
+
+    for (const auto interrupt_id : interrupts) {
+        Service::GSP::SignalInterrupt(interrupt_id);
+    }
+    return !interrupts.empty();
+}
+
+void GPUThread::DeferInterrupt(Service::GSP::InterruptId interrupt_id) {
+    std::lock_guard<std::mutex> lock(mutex);
+    deferred_interrupts.push_back(interrupt_id);
+}
+
+void GPUThread::ThreadLoop() {
+    Common::SetCurrentThreadName("GPU");
+
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        work_available.wait(lock, [this] { return stop || !queue.empty(); });
+        // Work that was already submitted is finished before stopping
+        if (queue.empty()) {
+            return;
+        }
+
+        std::function<void()> work = std::move(queue.front());
+        queue.pop_front();
+        busy = true;
+
+        lock.unlock();
+        work();
+        lock.lock();
+
+        busy = false;
+        if (queue.empty()) {
+            work_done.notify_all();
+        }
+    }
+}
+
+void SignalGPUInterrupt(Service::GSP::InterruptId interrupt_id) {
+    if (!g_gpu_interrupts_enabled) {
+        return;
+    }
+    if (g_gpu_thread && g_gpu_thread->IsGPUThread()) {
+        g_gpu_thread->DeferInterrupt(interrupt_id);
+    } else {
+        Service::GSP::SignalInterrupt(interrupt_id);
+    }
+}
+
+} // namespace VideoCore
@@ -0,0 +1,82 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "common/common_funcs.h"
+#include "common/common_types.h"
+
+namespace Service::GSP {
+enum class InterruptId : u8;
+} // namespace Service::GSP
+
+namespace VideoCore {
+
+/**
+ * Runs the work of the PICA GPU, i.e. command lists, memory fills and display transfers, on a
+ * thread of its own so that it overlaps with CPU emulation. Work runs in the order it was
+ * submitted in.
+ *
+ * Like on the real console, the CPU only learns that the GPU is done through GSP interrupts. The
+ * interrupts raised by the work are held back until the emulation thread reaches a sync point and
+ * calls Synchronize(), which waits for the GPU to catch up. Sync points are the rasterizer memory
+ * hooks, reads of GPU registers, VBlank, and the CPU going idle, so that interrupts are delivered
+ * at the same emulated time however fast the host runs the GPU thread.
+ */
+class GPUThread : NonCopyable {
+public:
+    GPUThread();
+    ~GPUThread();
+
+    /// Queues work to run on the GPU thread after all work submitted before it
+    void Submit(std::function<void()> work);
+
+    /**
+     * Waits until all submitted work has completed, then signals the GSP interrupts it raised.
+     * Does nothing when called from the GPU thread itself.
+     * @returns whether any interrupt was signalled
+     */
+    bool Synchronize();
+
+    /// Holds back an interrupt raised by the work running on the GPU thread until the next sync
+    void DeferInterrupt(Service::GSP::InterruptId interrupt_id);
+
+    bool IsGPUThread() const {
+        return std::this_thread::get_id() == thread.get_id();
+    }
+
+private:
+    void ThreadLoop();
+
+    std::mutex mutex;
+    std::condition_variable work_available;
+    std::condition_variable work_done;
+    std::deque<std::function<void()>> queue;
+    std::vector<Service::GSP::InterruptId> deferred_interrupts;
+    bool busy = false;
+    bool stop = false;
+
+    std::thread thread;
+};
+
+/// The thread PICA work runs on, or nullptr if it runs on the emulation thread
+extern std::unique_ptr<GPUThread> g_gpu_thread;
+
+/// Whether SignalGPUInterrupt delivers interrupts, false when the GPU runs without any guest
+/// software to receive them, e.g. when replaying a CiTrace
+extern std::atomic<bool> g_gpu_interrupts_enabled;
+
+/// Signals a GSP interrupt raised by the GPU, deferring it to the next sync point when called from
+/// the GPU thread
+void SignalGPUInterrupt(Service::GSP::InterruptId interrupt_id);
+
+} // namespace VideoCore
@@ -3,6 +3,9 @@
 // Refer to the license.txt file included.
 
 #include <cstring>
+#include "common/chunk_file.h"
+#include "common/subsystem_timer.h"
+#include "video_core/command_processor.h"
 #include "video_core/geometry_pipeline.h"
 #include "video_core/pica.h"
 #include "video_core/pica_state.h"
@@ -18,6 +21,7 @@ void Init() {
 }
 
 void Shutdown() {
+    CommandProcessor::Shutdown();
     Shader::Shutdown();
 }
 
@@ -31,6 +35,7 @@ State::State() : geometry_pipeline(*this) {
         using Pica::Shader::OutputVertex;
         auto AddTriangle = [this](const OutputVertex& v0, const OutputVertex& v1,
                                   const OutputVertex& v2) {
+            Common::ScopedSubsystemTimer timer(Common::Subsystem::Rasterizer);
             VideoCore::g_renderer->Rasterizer()->AddTriangle(v0, v1, v2);
         };
         primitive_assembler.SubmitVertex(
@@ -51,4 +56,39 @@ void State::Reset() {
     Zero(immediate);
     primitive_assembler.Reconfigure(PipelineRegs::TriangleTopology::List);
 }
+
+void State::DoState(PointerWrap& p) {
+    p.DoVoid(&regs, sizeof(regs));
+
+    for (Shader::ShaderSetup* setup : {&vs, &gs}) {
+        p.DoVoid(&setup->uniforms, sizeof(setup->uniforms));
+        p.DoArray(setup->program_code.data(), static_cast<int>(setup->program_code.size()));
+        p.DoArray(setup->swizzle_data.data(), static_cast<int>(setup->swizzle_data.size()));
+        if (p.GetMode() == PointerWrap::MODE_READ) {
+            setup->MarkProgramCodeDirty();
+            setup->MarkSwizzleDataDirty();
+        }
+    }
+
+    p.DoVoid(&input_default_attributes, sizeof(input_default_attributes));
+    p.DoVoid(&proctex, sizeof(proctex));
+    p.DoVoid(&lighting, sizeof(lighting));
+    p.DoVoid(&fog, sizeof(fog));
+
+    p.DoVoid(&immediate.input_vertex, sizeof(immediate.input_vertex));
+    p.Do(immediate.current_attribute);
+
+    p.DoVoid(&gs_unit.registers, sizeof(gs_unit.registers));
+    p.DoArray(gs_unit.conditional_code, 2);
+    p.DoArray(gs_unit.address_registers, 3);
+
+    if (p.GetMode() == PointerWrap::MODE_READ) {
+        // States are saved between command lists, and the pipelines are set up again from the
+        // registers on the next draw
+        Zero(cmd_list);
+        immediate.reset_geometry_pipeline = true;
+        gs_unit.ConfigOutput(regs.gs);
+        primitive_assembler.Reconfigure(regs.pipeline.triangle_topology);
+    }
+}
 } // namespace Pica
@@ -13,6 +13,8 @@
 #include "video_core/regs.h"
 #include "video_core/shader/shader.h"
 
+class PointerWrap;
+
 namespace Pica {
 
 /// Struct used to describe current Pica state
@@ -20,6 +22,9 @@ struct State {
     State();
     void Reset();
 
+    /// Serializes the GPU state which isn't derived from other state or emulated memory
+    void DoState(PointerWrap& p);
+
     /// Pica registers
     Regs regs;
 
@@ -17,6 +17,19 @@ struct OutputVertex;
 
 namespace VideoCore {
 
+/// Counters of the cache of surfaces kept on the host GPU by hardware rasterizers
+struct SurfaceCacheStats {
+    u64 hits = 0;
+    u64 misses = 0;
+    u64 evictions = 0;
+    /// Bytes of emulated memory loaded into surfaces
+    u64 bytes_uploaded = 0;
+    /// Bytes of surfaces written back to emulated memory
+    u64 bytes_flushed = 0;
+    /// Host GPU memory currently taken by cached surfaces
+    u64 cached_bytes = 0;
+};
+
 class RasterizerInterface {
 public:
     virtual ~RasterizerInterface() {}
@@ -71,5 +84,16 @@ public:
     virtual bool AccelerateDrawBatch(bool is_indexed) {
         return false;
     }
+
+    /// Whether the rasterizer may be driven from the GPU thread, which doesn't own the render
+    /// context
+    virtual bool SupportsGPUThread() const {
+        return false;
+    }
+
+    /// Returns the counters of the surface cache, all zero if the rasterizer has none
+    virtual SurfaceCacheStats GetSurfaceCacheStats() const {
+        return {};
+    }
 };
 } // namespace VideoCore
@@ -0,0 +1,129 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include "common/assert.h"
+#include "common/color.h"
+#include "common/logging/log.h"
+#include "core/core.h"
+#include "core/core_timing.h"
+#include "core/frontend/emu_window.h"
+#include "core/hw/lcd.h"
+#include "core/memory.h"
+#include "core/tracer/recorder.h"
+#include "video_core/debug_utils/debug_utils.h"
+#include "video_core/renderer_headless/renderer_headless.h"
+#include "video_core/video_core.h"
+
+namespace Headless {
+
+RendererHeadless::RendererHeadless(EmuWindow& window) : RendererBase{window} {}
+RendererHeadless::~RendererHeadless() = default;
+
+Core::System::ResultStatus RendererHeadless::Init() {
+    if (VideoCore::g_hw_renderer_enabled) {
+        LOG_CRITICAL(Render, "The headless renderer requires the software rasterizer");
+        return Core::System::ResultStatus::ErrorVideoCore;
+    }
+
+    RefreshRasterizerSetting();
+    return Core::System::ResultStatus::Success;
+}
+
+void RendererHeadless::ShutDown() {}
+
+void RendererHeadless::SetFrameCallback(FrameCallback callback) {
+    frame_callback = std::move(callback);
+}
+
+void RendererHeadless::SwapBuffers() {
+    if (frame_callback) {
+        LoadScreen(0, screens[0]);
+        LoadScreen(1, screens[1]);
+        frame_callback(screens);
+    }
+
+    if (VideoCore::g_renderer_screenshot_requested) {
+        LOG_ERROR(Render, "Screenshots aren't supported by the headless renderer");
+        VideoCore::g_renderer_screenshot_requested = false;
+    }
+
+    m_current_frame++;
+
+    auto& system = Core::System::GetInstance();
+    system.perf_stats.EndSystemFrame();
+    render_window.PollEvents();
+    system.frame_limiter.DoFrameLimiting(system.CoreTiming().GetGlobalTimeUs());
+    system.perf_stats.BeginSystemFrame();
+
+    if (Pica::g_debug_context && Pica::g_debug_context->recorder) {
+        Pica::g_debug_context->recorder->FrameFinished();
+    }
+}
+
+void RendererHeadless::LoadScreen(std::size_t screen_id, ScreenFrame& screen) {
+    const auto& framebuffer = GPU::g_regs.framebuffer_config[screen_id];
+    const LCD::Regs::ColorFill& color_fill =
+        screen_id == 0 ? LCD::g_regs.color_fill_top : LCD::g_regs.color_fill_bottom;
+
+    // The framebuffers are stored rotated by 90 degrees, so that each row of the framebuffer is a
+    // column of the screen, starting at its bottom
+    screen.width = framebuffer.height;
+    screen.height = framebuffer.width;
+    screen.pixels.resize(screen.width * screen.height * 4);
+
+    if (color_fill.is_enabled) {
+        for (std::size_t i = 0; i < screen.pixels.size(); i += 4) {
+            screen.pixels[i] = static_cast<u8>(color_fill.color_r);
+            screen.pixels[i + 1] = static_cast<u8>(color_fill.color_g);
+            screen.pixels[i + 2] = static_cast<u8>(color_fill.color_b);
+            screen.pixels[i + 3] = 0xFF;
+        }
+        return;
+    }
+
+    const PAddr framebuffer_addr =
+        framebuffer.active_fb == 0 ? framebuffer.address_left1 : framebuffer.address_left2;
+    const u32 bpp = GPU::Regs::BytesPerPixel(framebuffer.color_format);
+    Memory::RasterizerFlushRegion(framebuffer_addr, framebuffer.stride * framebuffer.height);
+
+    const u8* framebuffer_data = VideoCore::g_memory->GetPhysicalPointer(framebuffer_addr);
+    if (framebuffer_data == nullptr) {
+        LOG_ERROR(Render, "Framebuffer at {:08X} is not in emulated memory", framebuffer_addr);
+        std::fill(screen.pixels.begin(), screen.pixels.end(), 0);
+        return;
+    }
+
+    const auto decode = [&framebuffer](const u8* pixel) -> Common::Vec4<u8> {
+        switch (framebuffer.color_format) {
+        case GPU::Regs::PixelFormat::RGBA8:
+            return Color::DecodeRGBA8(pixel);
+        case GPU::Regs::PixelFormat::RGB8:
+            return Color::DecodeRGB8(pixel);
+        case GPU::Regs::PixelFormat::RGB565:
+            return Color::DecodeRGB565(pixel);
+        case GPU::Regs::PixelFormat::RGB5A1:
+            return Color::DecodeRGB5A1(pixel);
+        case GPU::Regs::PixelFormat::RGBA4:
+            return Color::DecodeRGBA4(pixel);
+        default:
+            UNREACHABLE();
+        }
+    };
+
+    for (u32 x = 0; x < screen.width; ++x) {
+        const u8* column = framebuffer_data + x * framebuffer.stride;
+        for (u32 y = 0; y < screen.height; ++y) {
+            const Common::Vec4<u8> color = decode(column + (screen.height - 1 - y) * bpp);
+            u8* const out = &screen.pixels[(y * screen.width + x) * 4];
+            out[0] = color.r();
+            out[1] = color.g();
+            out[2] = color.b();
+            // The LCDs ignore alpha
+            out[3] = 0xFF;
+        }
+    }
+}
+
+} // namespace Headless
@@ -0,0 +1,52 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <functional>
+#include <vector>
+#include "common/common_types.h"
+#include "core/hw/gpu.h"
+#include "video_core/renderer_base.h"
+
+namespace Headless {
+
+/// Contents of one screen, as RGBA8 pixels in display orientation
+struct ScreenFrame {
+    u32 width = 0;
+    u32 height = 0;
+    std::vector<u8> pixels;
+};
+
+/**
+ * Renderer for frontends without a window or graphics context. It rasterizes with the software
+ * rasterizer and, instead of presenting frames, hands the screens read back from the emulated
+ * framebuffers to the frontend.
+ */
+class RendererHeadless : public RendererBase {
+public:
+    /// Called with the top and bottom screens of each finished frame
+    using FrameCallback = std::function<void(const std::array<ScreenFrame, 2>& screens)>;
+
+    explicit RendererHeadless(EmuWindow& window);
+    ~RendererHeadless() override;
+
+    void SwapBuffers() override;
+    Core::System::ResultStatus Init() override;
+    void ShutDown() override;
+
+    /// Sets the callback receiving the finished frames. Frames are only read back from emulated
+    /// memory while a callback is set.
+    void SetFrameCallback(FrameCallback callback);
+
+    /// Reads the given screen from emulated memory, as the LCDs would currently display it
+    void LoadScreen(std::size_t screen_id, ScreenFrame& screen);
+
+private:
+    FrameCallback frame_callback;
+    std::array<ScreenFrame, 2> screens;
+};
+
+} // namespace Headless
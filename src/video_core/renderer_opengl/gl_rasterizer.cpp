@@ -1349,6 +1349,10 @@ void RasterizerOpenGL::NotifyPicaRegisterChanged(u32 id) {
     }
 }
 
+VideoCore::SurfaceCacheStats RasterizerOpenGL::GetSurfaceCacheStats() const {
+    return res_cache.GetStats();
+}
+
 void RasterizerOpenGL::FlushAll() {
     MICROPROFILE_SCOPE(OpenGL_CacheManagement);
     res_cache.FlushAll();
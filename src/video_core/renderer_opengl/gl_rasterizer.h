@@ -53,6 +53,7 @@ public:
     bool AccelerateDisplay(const GPU::Regs::FramebufferConfig& config, PAddr framebuffer_addr,
                            u32 pixel_stride, ScreenInfo& screen_info) override;
     bool AccelerateDrawBatch(bool is_indexed) override;
+    VideoCore::SurfaceCacheStats GetSurfaceCacheStats() const override;
 
 private:
     struct SamplerInfo {
@@ -29,7 +29,7 @@
 #include "video_core/renderer_opengl/gl_rasterizer_cache.h"
 #include "video_core/renderer_opengl/gl_state.h"
 #include "video_core/renderer_opengl/gl_vars.h"
-#include "video_core/utils.h"
+#include "video_core/texture/morton.h"
 #include "video_core/video_core.h"
 
 namespace OpenGL {
@@ -163,52 +163,49 @@ constexpr auto RangeFromInterval(Map& map, const Interval& interval) {
     return boost::make_iterator_range(map.equal_range(interval));
 }
 
+static Pica::Texture::MortonFormat GetMortonFormat(PixelFormat format, bool morton_to_gl) {
+    using Pica::Texture::MortonFormat;
+    switch (format) {
+    case PixelFormat::RGBA8:
+        // GLES does not have ABGR formats, so the bytes are swapped when uploading
+        return morton_to_gl && GLES ? MortonFormat::SwapRGBA8 : MortonFormat::Copy32;
+    case PixelFormat::RGB8:
+        return morton_to_gl && GLES ? MortonFormat::SwapRGB8 : MortonFormat::Copy24;
+    case PixelFormat::D24:
+        return MortonFormat::D24;
+    case PixelFormat::D24S8:
+        return MortonFormat::D24S8;
+    default:
+        return Pica::Texture::GetMortonCopyFormat(SurfaceParams::GetFormatBpp(format) / 8);
+    }
+}
+
 template <bool morton_to_gl, PixelFormat format>
 static void MortonCopyTile(u32 stride, u8* tile_buffer, u8* gl_buffer) {
-    constexpr u32 bytes_per_pixel = SurfaceParams::GetFormatBpp(format) / 8;
     constexpr u32 gl_bytes_per_pixel = CachedSurface::GetGLBytesPerPixel(format);
-    for (u32 y = 0; y < 8; ++y) {
-        for (u32 x = 0; x < 8; ++x) {
-            u8* tile_ptr = tile_buffer + VideoCore::MortonInterleave(x, y) * bytes_per_pixel;
-            u8* gl_ptr = gl_buffer + ((7 - y) * stride + x) * gl_bytes_per_pixel;
-            if (morton_to_gl) {
-                if (format == PixelFormat::D24S8) {
-                    gl_ptr[0] = tile_ptr[3];
-                    std::memcpy(gl_ptr + 1, tile_ptr, 3);
-                } else if (format == PixelFormat::RGBA8 && GLES) {
-                    // because GLES does not have ABGR format
-                    // so we will do byteswapping here
-                    gl_ptr[0] = tile_ptr[3];
-                    gl_ptr[1] = tile_ptr[2];
-                    gl_ptr[2] = tile_ptr[1];
-                    gl_ptr[3] = tile_ptr[0];
-                } else if (format == PixelFormat::RGB8 && GLES) {
-                    gl_ptr[0] = tile_ptr[2];
-                    gl_ptr[1] = tile_ptr[1];
-                    gl_ptr[2] = tile_ptr[0];
-                } else {
-                    std::memcpy(gl_ptr, tile_ptr, bytes_per_pixel);
-                }
-            } else {
-                if (format == PixelFormat::D24S8) {
-                    std::memcpy(tile_ptr, gl_ptr + 1, 3);
-                    tile_ptr[3] = gl_ptr[0];
-                } else {
-                    std::memcpy(tile_ptr, gl_ptr, bytes_per_pixel);
-                }
-            }
-        }
+    const auto morton_format = GetMortonFormat(format, morton_to_gl);
+
+    // OpenGL stores the rows bottom to top, so the tile is flipped
+    const std::ptrdiff_t pitch = -static_cast<std::ptrdiff_t>(stride * gl_bytes_per_pixel);
+    u8* gl_row = gl_buffer - 7 * pitch;
+    if (morton_to_gl) {
+        Pica::Texture::MortonToLinear(morton_format, tile_buffer, gl_row, pitch);
+    } else {
+        Pica::Texture::LinearToMorton(morton_format, tile_buffer, gl_row, pitch);
     }
 }
 
+/// Number of tiles converted by one job of the surface decode pool
+constexpr u32 MORTON_COPY_CHUNK_SIZE = 64;
+
 template <bool morton_to_gl, PixelFormat format>
-static void MortonCopy(u32 stride, u32 height, u8* gl_buffer, PAddr base, PAddr start, PAddr end) {
+static void MortonCopy(u32 stride, u32 height, u8* gl_buffer, PAddr base, PAddr start, PAddr end,
+                       Common::ThreadPool* pool) {
     constexpr u32 bytes_per_pixel = SurfaceParams::GetFormatBpp(format) / 8;
     constexpr u32 tile_size = bytes_per_pixel * 64;
 
     constexpr u32 gl_bytes_per_pixel = CachedSurface::GetGLBytesPerPixel(format);
     static_assert(gl_bytes_per_pixel >= bytes_per_pixel, "");
-    gl_buffer += gl_bytes_per_pixel - bytes_per_pixel;
 
     const PAddr aligned_down_start = base + Common::AlignDown(start - base, tile_size);
     const PAddr aligned_start = base + Common::AlignUp(start - base, tile_size);
@@ -216,57 +213,70 @@ static void MortonCopy(u32 stride, u32 height, u8* gl_buffer, PAddr base, PAddr
 
     ASSERT(!morton_to_gl || (aligned_start == start && aligned_end == end));
 
-    const u32 begin_pixel_index = (aligned_down_start - base) / bytes_per_pixel;
-    u32 x = (begin_pixel_index % (stride * 8)) / 8;
-    u32 y = (begin_pixel_index / (stride * 8)) * 8;
-
-    gl_buffer += ((height - 8 - y) * stride + x) * gl_bytes_per_pixel;
-
-    auto glbuf_next_tile = [&] {
-        x = (x + 8) % stride;
-        gl_buffer += 8 * gl_bytes_per_pixel;
-        if (!x) {
-            y += 8;
-            gl_buffer -= stride * 9 * gl_bytes_per_pixel;
-        }
+    // Returns the bottom left pixel of the given tile of the surface in the OpenGL buffer
+    const auto get_gl_tile = [&](u32 tile_index) {
+        const u32 pixel_index = tile_index * 64;
+        const u32 x = (pixel_index % (stride * 8)) / 8;
+        const u32 y = (pixel_index / (stride * 8)) * 8;
+        return gl_buffer + ((height - 8 - y) * stride + x) * gl_bytes_per_pixel;
     };
 
     u8* tile_buffer = VideoCore::g_memory->GetPhysicalPointer(start);
 
     if (start < aligned_start && !morton_to_gl) {
         std::array<u8, tile_size> tmp_buf;
-        MortonCopyTile<morton_to_gl, format>(stride, &tmp_buf[0], gl_buffer);
+        MortonCopyTile<morton_to_gl, format>(stride, &tmp_buf[0],
+                                             get_gl_tile((aligned_down_start - base) / tile_size));
         std::memcpy(tile_buffer, &tmp_buf[start - aligned_down_start],
                     std::min(aligned_start, end) - start);
 
         tile_buffer += aligned_start - start;
-        glbuf_next_tile();
     }
 
-    const u8* const buffer_end = tile_buffer + aligned_end - aligned_start;
-    PAddr current_paddr = aligned_start;
-    while (tile_buffer < buffer_end) {
+    u32 num_tiles = 0;
+    for (PAddr current_paddr = aligned_start; current_paddr < aligned_end;
+         current_paddr += tile_size, ++num_tiles) {
         // Pokemon Super Mystery Dungeon will try to use textures that go beyond
         // the end address of VRAM. Stop reading if reaches invalid address
         if (!VideoCore::g_memory->IsValidPhysicalAddress(current_paddr) ||
             !VideoCore::g_memory->IsValidPhysicalAddress(current_paddr + tile_size)) {
             LOG_ERROR(Render_OpenGL, "Out of bound texture");
+            // Don't write back the partial tile at the end either
+            end = current_paddr;
             break;
         }
-        MortonCopyTile<morton_to_gl, format>(stride, tile_buffer, gl_buffer);
-        tile_buffer += tile_size;
-        current_paddr += tile_size;
-        glbuf_next_tile();
     }
 
+    // Tiles only touch their own part of the OpenGL buffer and memory, convert them in parallel
+    const u32 first_tile = (aligned_start - base) / tile_size;
+    const auto copy_tiles = [&](u32 begin, u32 count) {
+        for (u32 i = begin; i < begin + count; ++i) {
+            MortonCopyTile<morton_to_gl, format>(stride, tile_buffer + i * tile_size,
+                                                 get_gl_tile(first_tile + i));
+        }
+    };
+    if (pool != nullptr && num_tiles > MORTON_COPY_CHUNK_SIZE) {
+        const u32 num_chunks = (num_tiles + MORTON_COPY_CHUNK_SIZE - 1) / MORTON_COPY_CHUNK_SIZE;
+        pool->ParallelFor(num_chunks, [&](std::size_t chunk) {
+            const u32 begin = static_cast<u32>(chunk) * MORTON_COPY_CHUNK_SIZE;
+            copy_tiles(begin, std::min(MORTON_COPY_CHUNK_SIZE, num_tiles - begin));
+        });
+    } else {
+        copy_tiles(0, num_tiles);
+    }
+    tile_buffer += num_tiles * tile_size;
+
     if (end > std::max(aligned_start, aligned_end) && !morton_to_gl) {
         std::array<u8, tile_size> tmp_buf;
-        MortonCopyTile<morton_to_gl, format>(stride, &tmp_buf[0], gl_buffer);
+        MortonCopyTile<morton_to_gl, format>(stride, &tmp_buf[0],
+                                             get_gl_tile(first_tile + num_tiles));
         std::memcpy(tile_buffer, &tmp_buf[0], end - aligned_end);
     }
 }
 
-static constexpr std::array<void (*)(u32, u32, u8*, PAddr, PAddr, PAddr), 18> morton_to_gl_fns = {
+using MortonCopyFunction = void (*)(u32, u32, u8*, PAddr, PAddr, PAddr, Common::ThreadPool*);
+
+static constexpr std::array<MortonCopyFunction, 18> morton_to_gl_fns = {
     MortonCopy<true, PixelFormat::RGBA8>,  // 0
     MortonCopy<true, PixelFormat::RGB8>,   // 1
     MortonCopy<true, PixelFormat::RGB5A1>, // 2
@@ -287,7 +297,7 @@ static constexpr std::array<void (*)(u32, u32, u8*, PAddr, PAddr, PAddr), 18> mo
     MortonCopy<true, PixelFormat::D24S8> // 17
 };
 
-static constexpr std::array<void (*)(u32, u32, u8*, PAddr, PAddr, PAddr), 18> gl_to_morton_fns = {
+static constexpr std::array<MortonCopyFunction, 18> gl_to_morton_fns = {
     MortonCopy<false, PixelFormat::RGBA8>,  // 0
     MortonCopy<false, PixelFormat::RGB8>,   // 1
     MortonCopy<false, PixelFormat::RGB5A1>, // 2
@@ -728,7 +738,8 @@ void RasterizerCacheOpenGL::CopySurface(const Surface& src_surface, const Surfac
 }
 
 MICROPROFILE_DEFINE(OpenGL_SurfaceLoad, "OpenGL", "Surface Load", MP_RGB(128, 192, 64));
-void CachedSurface::LoadGLBuffer(PAddr load_start, PAddr load_end) {
+void CachedSurface::LoadGLBuffer(PAddr load_start, PAddr load_end,
+                                 Common::ThreadPool* pool) {
     ASSERT(type != SurfaceType::Fill);
     const bool need_swap =
         GLES && (pixel_format == PixelFormat::RGBA8 || pixel_format == PixelFormat::RGB8);
@@ -790,23 +801,47 @@ void CachedSurface::LoadGLBuffer(PAddr load_start, PAddr load_end) {
             const auto rect = GetSubRect(FromInterval(load_interval));
             ASSERT(FromInterval(load_interval).GetInterval() == load_interval);
 
-            for (unsigned y = rect.bottom; y < rect.top; ++y) {
-                for (unsigned x = rect.left; x < rect.right; ++x) {
-                    auto vec4 =
-                        Pica::Texture::LookupTexture(texture_src_data, x, height - 1 - y, tex_info);
-                    const std::size_t offset = (x + (width * y)) * 4;
-                    std::memcpy(&gl_buffer[offset], vec4.AsArray(), 4);
+            if (load_start == addr && load_end == end) {
+                // Decode the texture a row of tiles at a time, then flip the rows into the OpenGL
+                // buffer
+                const auto decode_tile_row = [&](std::size_t tile_row) {
+                    Pica::Texture::TextureInfo row_info = tex_info;
+                    row_info.height = 8;
+                    std::vector<Common::Vec4<u8>> texels(width * 8);
+                    Pica::Texture::DecodeTexture(texture_src_data + tile_row * tex_info.stride,
+                                                 row_info, texels.data());
+                    for (unsigned fine_y = 0; fine_y < 8; ++fine_y) {
+                        const std::size_t y = height - 1 - (tile_row * 8 + fine_y);
+                        std::memcpy(&gl_buffer[width * y * 4], &texels[width * fine_y], width * 4);
+                    }
+                };
+                if (pool != nullptr) {
+                    pool->ParallelFor(height / 8, decode_tile_row);
+                } else {
+                    for (std::size_t tile_row = 0; tile_row < height / 8; ++tile_row) {
+                        decode_tile_row(tile_row);
+                    }
+                }
+            } else {
+                for (unsigned y = rect.bottom; y < rect.top; ++y) {
+                    for (unsigned x = rect.left; x < rect.right; ++x) {
+                        auto vec4 = Pica::Texture::LookupTexture(texture_src_data, x,
+                                                                 height - 1 - y, tex_info);
+                        const std::size_t offset = (x + (width * y)) * 4;
+                        std::memcpy(&gl_buffer[offset], vec4.AsArray(), 4);
+                    }
                 }
             }
         } else {
-            morton_to_gl_fns[static_cast<std::size_t>(pixel_format)](stride, height, &gl_buffer[0],
-                                                                     addr, load_start, load_end);
+            morton_to_gl_fns[static_cast<std::size_t>(pixel_format)](
+                stride, height, &gl_buffer[0], addr, load_start, load_end, pool);
         }
     }
 }
 
 MICROPROFILE_DEFINE(OpenGL_SurfaceFlush, "OpenGL", "Surface Flush", MP_RGB(128, 192, 64));
-void CachedSurface::FlushGLBuffer(PAddr flush_start, PAddr flush_end) {
+void CachedSurface::FlushGLBuffer(PAddr flush_start, PAddr flush_end,
+                                  Common::ThreadPool* pool) {
     u8* const dst_buffer = VideoCore::g_memory->GetPhysicalPointer(addr);
     if (dst_buffer == nullptr)
         return;
@@ -826,6 +861,7 @@ void CachedSurface::FlushGLBuffer(PAddr flush_start, PAddr flush_end) {
     ASSERT(flush_start >= addr && flush_end <= end);
     const u32 start_offset = flush_start - addr;
     const u32 end_offset = flush_end - addr;
+    VideoCore::g_memory->MarkRegionDirty(flush_start, flush_end - flush_start);
 
     if (type == SurfaceType::Fill) {
         const u32 coarse_start_offset = start_offset - (start_offset % fill_size);
@@ -845,8 +881,8 @@ void CachedSurface::FlushGLBuffer(PAddr flush_start, PAddr flush_end) {
         ASSERT(type == SurfaceType::Color);
         std::memcpy(dst_buffer + start_offset, &gl_buffer[start_offset], flush_end - flush_start);
     } else {
-        gl_to_morton_fns[static_cast<std::size_t>(pixel_format)](stride, height, &gl_buffer[0],
-                                                                 addr, flush_start, flush_end);
+        gl_to_morton_fns[static_cast<std::size_t>(pixel_format)](
+            stride, height, &gl_buffer[0], addr, flush_start, flush_end, pool);
     }
 }
 
@@ -1017,82 +1053,79 @@ Surface FindMatch(const SurfaceCache& surface_cache, const SurfaceParams& params
     u32 match_scale = 0;
     SurfaceInterval match_interval{};
 
-    for (auto& pair : RangeFromInterval(surface_cache, params.GetInterval())) {
-        for (auto& surface : pair.second) {
-            bool res_scale_matched = match_scale_type == ScaleMatch::Exact
-                                         ? (params.res_scale == surface->res_scale)
-                                         : (params.res_scale <= surface->res_scale);
-            // validity will be checked in GetCopyableInterval
-            bool is_valid =
-                find_flags & MatchFlags::Copy
-                    ? true
-                    : surface->IsRegionValid(validate_interval.value_or(params.GetInterval()));
-
-            if (!(find_flags & MatchFlags::Invalid) && !is_valid)
-                continue;
-
-            auto IsMatch_Helper = [&](auto check_type, auto match_fn) {
-                if (!(find_flags & check_type))
-                    return;
-
-                bool matched;
-                SurfaceInterval surface_interval;
-                std::tie(matched, surface_interval) = match_fn();
-                if (!matched)
-                    return;
-
-                if (!res_scale_matched && match_scale_type != ScaleMatch::Ignore &&
-                    surface->type != SurfaceType::Fill)
-                    return;
-
-                // Found a match, update only if this is better than the previous one
-                auto UpdateMatch = [&] {
-                    match_surface = surface;
-                    match_valid = is_valid;
-                    match_scale = surface->res_scale;
-                    match_interval = surface_interval;
-                };
+    surface_cache.ForEachOverlapping(params.addr, params.end, [&](const Surface& surface) {
+        bool res_scale_matched = match_scale_type == ScaleMatch::Exact
+                                     ? (params.res_scale == surface->res_scale)
+                                     : (params.res_scale <= surface->res_scale);
+        // validity will be checked in GetCopyableInterval
+        bool is_valid =
+            find_flags & MatchFlags::Copy
+                ? true
+                : surface->IsRegionValid(validate_interval.value_or(params.GetInterval()));
+
+        if (!(find_flags & MatchFlags::Invalid) && !is_valid)
+            return;
+
+        auto IsMatch_Helper = [&](auto check_type, auto match_fn) {
+            if (!(find_flags & check_type))
+                return;
+
+            bool matched;
+            SurfaceInterval surface_interval;
+            std::tie(matched, surface_interval) = match_fn();
+            if (!matched)
+                return;
+
+            if (!res_scale_matched && match_scale_type != ScaleMatch::Ignore &&
+                surface->type != SurfaceType::Fill)
+                return;
+
+            // Found a match, update only if this is better than the previous one
+            auto UpdateMatch = [&] {
+                match_surface = surface;
+                match_valid = is_valid;
+                match_scale = surface->res_scale;
+                match_interval = surface_interval;
+            };
 
-                if (surface->res_scale > match_scale) {
-                    UpdateMatch();
-                    return;
-                } else if (surface->res_scale < match_scale) {
-                    return;
-                }
+            if (surface->res_scale > match_scale) {
+                UpdateMatch();
+                return;
+            } else if (surface->res_scale < match_scale) {
+                return;
+            }
 
-                if (is_valid && !match_valid) {
-                    UpdateMatch();
-                    return;
-                } else if (is_valid != match_valid) {
-                    return;
-                }
+            if (is_valid && !match_valid) {
+                UpdateMatch();
+                return;
+            } else if (is_valid != match_valid) {
+                return;
+            }
 
-                if (boost::icl::length(surface_interval) > boost::icl::length(match_interval)) {
-                    UpdateMatch();
-                }
-            };
-            IsMatch_Helper(std::integral_constant<MatchFlags, MatchFlags::Exact>{}, [&] {
-                return std::make_pair(surface->ExactMatch(params), surface->GetInterval());
-            });
-            IsMatch_Helper(std::integral_constant<MatchFlags, MatchFlags::SubRect>{}, [&] {
-                return std::make_pair(surface->CanSubRect(params), surface->GetInterval());
-            });
-            IsMatch_Helper(std::integral_constant<MatchFlags, MatchFlags::Copy>{}, [&] {
-                ASSERT(validate_interval);
-                auto copy_interval =
-                    params.FromInterval(*validate_interval).GetCopyableInterval(surface);
-                bool matched = boost::icl::length(copy_interval & *validate_interval) != 0 &&
-                               surface->CanCopy(params, copy_interval);
-                return std::make_pair(matched, copy_interval);
-            });
-            IsMatch_Helper(std::integral_constant<MatchFlags, MatchFlags::Expand>{}, [&] {
-                return std::make_pair(surface->CanExpand(params), surface->GetInterval());
-            });
-            IsMatch_Helper(std::integral_constant<MatchFlags, MatchFlags::TexCopy>{}, [&] {
-                return std::make_pair(surface->CanTexCopy(params), surface->GetInterval());
-            });
-        }
-    }
+            if (boost::icl::length(surface_interval) > boost::icl::length(match_interval)) {
+                UpdateMatch();
+            }
+        };
+        IsMatch_Helper(std::integral_constant<MatchFlags, MatchFlags::Exact>{}, [&] {
+            return std::make_pair(surface->ExactMatch(params), surface->GetInterval());
+        });
+        IsMatch_Helper(std::integral_constant<MatchFlags, MatchFlags::SubRect>{}, [&] {
+            return std::make_pair(surface->CanSubRect(params), surface->GetInterval());
+        });
+        IsMatch_Helper(std::integral_constant<MatchFlags, MatchFlags::Copy>{}, [&] {
+            ASSERT(validate_interval);
+            auto copy_interval = params.FromInterval(*validate_interval).GetCopyableInterval(surface);
+            bool matched = boost::icl::length(copy_interval & *validate_interval) != 0 &&
+                           surface->CanCopy(params, copy_interval);
+            return std::make_pair(matched, copy_interval);
+        });
+        IsMatch_Helper(std::integral_constant<MatchFlags, MatchFlags::Expand>{}, [&] {
+            return std::make_pair(surface->CanExpand(params), surface->GetInterval());
+        });
+        IsMatch_Helper(std::integral_constant<MatchFlags, MatchFlags::TexCopy>{}, [&] {
+            return std::make_pair(surface->CanTexCopy(params), surface->GetInterval());
+        });
+    });
     return match_surface;
 }
 
@@ -1148,8 +1181,58 @@ void main() {
 
 RasterizerCacheOpenGL::~RasterizerCacheOpenGL() {
     FlushAll();
-    while (!surface_cache.empty())
-        UnregisterSurface(*surface_cache.begin()->second.begin());
+    for (const auto& surface : surface_cache.GetAll())
+        UnregisterSurface(surface);
+
+    LOG_INFO(Render_OpenGL,
+             "Surface cache: {} hits, {} misses, {} evictions, {} bytes uploaded, {} bytes flushed",
+             stats.hits, stats.misses, stats.evictions, stats.bytes_uploaded, stats.bytes_flushed);
+}
+
+Common::ThreadPool* RasterizerCacheOpenGL::GetDecodePool() {
+    std::size_t num_threads = VideoCore::g_texture_decode_threads;
+    if (num_threads == 0) {
+        num_threads = Common::ThreadPool::GetHardwareThreadCount();
+    }
+
+    if (num_threads <= 1) {
+        decode_pool.reset();
+    } else if (!decode_pool || decode_pool->GetThreadCount() != num_threads) {
+        decode_pool = std::make_unique<Common::ThreadPool>(num_threads, "SurfaceDecode");
+    }
+    return decode_pool.get();
+}
+
+void RasterizerCacheOpenGL::TouchSurface(const Surface& surface) {
+    surface->last_used = current_tick;
+}
+
+void RasterizerCacheOpenGL::EnforceMemoryBudget() {
+    ++current_tick;
+
+    const std::size_t budget = std::size_t{VideoCore::g_surface_cache_budget} * 1024 * 1024;
+    if (budget == 0 || stats.cached_bytes <= budget) {
+        return;
+    }
+
+    // Evict down to a bit below the budget, so that eviction doesn't run again at the next draw
+    const std::size_t target = budget - budget / 8;
+    auto surfaces = surface_cache.GetAll();
+    std::sort(surfaces.begin(), surfaces.end(), [](const Surface& lhs, const Surface& rhs) {
+        return lhs->last_used < rhs->last_used;
+    });
+    for (const auto& surface : surfaces) {
+        if (stats.cached_bytes <= target) {
+            break;
+        }
+        if (surface->GetHostSizeInBytes() == 0) {
+            continue;
+        }
+        FlushRegion(surface->addr, surface->size, surface);
+        UnregisterSurface(surface);
+        ++stats.evictions;
+    }
+    LOG_DEBUG(Render_OpenGL, "Evicted surfaces down to {} bytes", stats.cached_bytes);
 }
 
 MICROPROFILE_DEFINE(OpenGL_BlitSurface, "OpenGL", "BlitSurface", MP_RGB(128, 192, 64));
@@ -1241,7 +1324,10 @@ Surface RasterizerCacheOpenGL::GetSurface(const SurfaceParams& params, ScaleMatc
     Surface surface =
         FindMatch<MatchFlags::Exact | MatchFlags::Invalid>(surface_cache, params, match_res_scale);
 
-    if (surface == nullptr) {
+    if (surface != nullptr) {
+        ++stats.hits;
+    } else {
+        ++stats.misses;
         u16 target_res_scale = params.res_scale;
         if (match_res_scale != ScaleMatch::Exact) {
             // This surface may have a subrect of another surface with a higher res_scale, find it
@@ -1272,6 +1358,7 @@ Surface RasterizerCacheOpenGL::GetSurface(const SurfaceParams& params, ScaleMatc
         ValidateSurface(surface, params.addr, params.size);
     }
 
+    TouchSurface(surface);
     return surface;
 }
 
@@ -1285,6 +1372,9 @@ SurfaceRect_Tuple RasterizerCacheOpenGL::GetSurfaceSubRect(const SurfaceParams&
     // Attempt to find encompassing surface
     Surface surface = FindMatch<MatchFlags::SubRect | MatchFlags::Invalid>(surface_cache, params,
                                                                            match_res_scale);
+    if (surface != nullptr) {
+        ++stats.hits;
+    }
 
     // Check if FindMatch failed because of res scaling
     // If that's the case create a new surface with
@@ -1298,6 +1388,7 @@ SurfaceRect_Tuple RasterizerCacheOpenGL::GetSurfaceSubRect(const SurfaceParams&
             SurfaceParams new_params = *surface;
             new_params.res_scale = params.res_scale;
 
+            ++stats.misses;
             surface = CreateSurface(new_params);
             RegisterSurface(surface);
         }
@@ -1327,6 +1418,7 @@ SurfaceRect_Tuple RasterizerCacheOpenGL::GetSurfaceSubRect(const SurfaceParams&
                 new_params.size / aligned_params.BytesInPixels(aligned_params.stride);
             ASSERT(new_params.size % aligned_params.BytesInPixels(aligned_params.stride) == 0);
 
+            ++stats.misses;
             Surface new_surface = CreateSurface(new_params);
             DuplicateSurface(surface, new_surface);
 
@@ -1351,6 +1443,7 @@ SurfaceRect_Tuple RasterizerCacheOpenGL::GetSurfaceSubRect(const SurfaceParams&
         ValidateSurface(surface, aligned_params.addr, aligned_params.size);
     }
 
+    TouchSurface(surface);
     return std::make_tuple(surface, surface->GetScaledSubRect(params));
 }
 
@@ -1483,13 +1576,16 @@ SurfaceSurfaceRect_Tuple RasterizerCacheOpenGL::GetFramebufferSurfaces(
     const auto& regs = Pica::g_state.regs;
     const auto& config = regs.framebuffer.framebuffer;
 
+    // No surfaces are in use between draws
+    EnforceMemoryBudget();
+
     // update resolution_scale_factor and reset cache if changed
     static u16 resolution_scale_factor = VideoCore::GetResolutionScaleFactor();
     if (resolution_scale_factor != VideoCore::GetResolutionScaleFactor()) {
         resolution_scale_factor = VideoCore::GetResolutionScaleFactor();
         FlushAll();
-        while (!surface_cache.empty())
-            UnregisterSurface(*surface_cache.begin()->second.begin());
+        for (const auto& surface : surface_cache.GetAll())
+            UnregisterSurface(surface);
         texture_cube_cache.clear();
     }
 
@@ -1588,6 +1684,7 @@ Surface RasterizerCacheOpenGL::GetFillSurface(const GPU::Regs::MemoryFillConfig&
     }
 
     RegisterSurface(new_surface);
+    TouchSurface(new_surface);
     return new_surface;
 }
 
@@ -1598,6 +1695,8 @@ SurfaceRect_Tuple RasterizerCacheOpenGL::GetTexCopySurface(const SurfaceParams&
         surface_cache, params, ScaleMatch::Ignore);
 
     if (match_surface != nullptr) {
+        ++stats.hits;
+        TouchSurface(match_surface);
         ValidateSurface(match_surface, params.addr, params.size);
 
         SurfaceParams match_subrect;
@@ -1613,6 +1712,8 @@ SurfaceRect_Tuple RasterizerCacheOpenGL::GetTexCopySurface(const SurfaceParams&
         }
 
         rect = match_surface->GetScaledSubRect(match_subrect);
+    } else {
+        ++stats.misses;
     }
 
     return std::make_tuple(match_surface, rect);
@@ -1692,7 +1793,8 @@ void RasterizerCacheOpenGL::ValidateSurface(const Surface& surface, PAddr addr,
 
         // Load data from 3DS memory
         FlushRegion(params.addr, params.size);
-        surface->LoadGLBuffer(params.addr, params.end);
+        surface->LoadGLBuffer(params.addr, params.end, GetDecodePool());
+        stats.bytes_uploaded += params.size;
         surface->UploadGLTexture(surface->GetSubRect(params), read_framebuffer.handle,
                                  draw_framebuffer.handle);
         surface->invalid_regions.erase(params.GetInterval());
@@ -1724,7 +1826,9 @@ void RasterizerCacheOpenGL::FlushRegion(PAddr addr, u32 size, Surface flush_surf
             surface->DownloadGLTexture(surface->GetSubRect(params), read_framebuffer.handle,
                                        draw_framebuffer.handle);
         }
-        surface->FlushGLBuffer(boost::icl::first(interval), boost::icl::last_next(interval));
+        surface->FlushGLBuffer(boost::icl::first(interval), boost::icl::last_next(interval),
+                               GetDecodePool());
+        stats.bytes_flushed += boost::icl::length(interval);
         flushed_intervals += interval;
     }
     // Reset dirty regions
@@ -1749,29 +1853,27 @@ void RasterizerCacheOpenGL::InvalidateRegion(PAddr addr, u32 size, const Surface
         region_owner->invalid_regions.erase(invalid_interval);
     }
 
-    for (auto& pair : RangeFromInterval(surface_cache, invalid_interval)) {
-        for (auto& cached_surface : pair.second) {
-            if (cached_surface == region_owner)
-                continue;
+    surface_cache.ForEachOverlapping(addr, addr + size, [&](const Surface& cached_surface) {
+        if (cached_surface == region_owner)
+            return;
 
-            // If cpu is invalidating this region we want to remove it
-            // to (likely) mark the memory pages as uncached
-            if (region_owner == nullptr && size <= 8) {
-                FlushRegion(cached_surface->addr, cached_surface->size, cached_surface);
-                remove_surfaces.emplace(cached_surface);
-                continue;
-            }
+        // If cpu is invalidating this region we want to remove it
+        // to (likely) mark the memory pages as uncached
+        if (region_owner == nullptr && size <= 8) {
+            FlushRegion(cached_surface->addr, cached_surface->size, cached_surface);
+            remove_surfaces.emplace(cached_surface);
+            return;
+        }
 
-            const auto interval = cached_surface->GetInterval() & invalid_interval;
-            cached_surface->invalid_regions.insert(interval);
+        const auto interval = cached_surface->GetInterval() & invalid_interval;
+        cached_surface->invalid_regions.insert(interval);
 
-            // Remove only "empty" fill surfaces to avoid destroying and recreating OGL textures
-            if (cached_surface->type == SurfaceType::Fill &&
-                cached_surface->IsSurfaceFullyInvalid()) {
-                remove_surfaces.emplace(cached_surface);
-            }
+        // Remove only "empty" fill surfaces to avoid destroying and recreating OGL textures
+        if (cached_surface->type == SurfaceType::Fill &&
+            cached_surface->IsSurfaceFullyInvalid()) {
+            remove_surfaces.emplace(cached_surface);
         }
-    }
+    });
 
     if (region_owner != nullptr)
         dirty_regions.set({invalid_interval, region_owner});
@@ -1815,8 +1917,9 @@ void RasterizerCacheOpenGL::RegisterSurface(const Surface& surface) {
         return;
     }
     surface->registered = true;
-    surface_cache.add({surface->GetInterval(), SurfaceSet{surface}});
+    surface_cache.Insert(surface, surface->addr, surface->end);
     UpdatePagesCachedCount(surface->addr, surface->size, 1);
+    stats.cached_bytes += surface->GetHostSizeInBytes();
 }
 
 void RasterizerCacheOpenGL::UnregisterSurface(const Surface& surface) {
@@ -1824,42 +1927,29 @@ void RasterizerCacheOpenGL::UnregisterSurface(const Surface& surface) {
         return;
     }
     surface->registered = false;
+    surface_cache.Erase(surface, surface->addr, surface->end);
     UpdatePagesCachedCount(surface->addr, surface->size, -1);
-    surface_cache.subtract({surface->GetInterval(), SurfaceSet{surface}});
+    stats.cached_bytes -= surface->GetHostSizeInBytes();
 }
 
 void RasterizerCacheOpenGL::UpdatePagesCachedCount(PAddr addr, u32 size, int delta) {
-    const u32 num_pages =
-        ((addr + size - 1) >> Memory::PAGE_BITS) - (addr >> Memory::PAGE_BITS) + 1;
     const u32 page_start = addr >> Memory::PAGE_BITS;
-    const u32 page_end = page_start + num_pages;
-
-    // Interval maps will erase segments if count reaches 0, so if delta is negative we have to
-    // subtract after iterating
-    const auto pages_interval = PageMap::interval_type::right_open(page_start, page_end);
-    if (delta > 0)
-        cached_pages.add({pages_interval, delta});
-
-    for (auto& pair : RangeFromInterval(cached_pages, pages_interval)) {
-        const auto interval = pair.first & pages_interval;
-        const int count = pair.second;
-
-        const PAddr interval_start_addr = boost::icl::first(interval) << Memory::PAGE_BITS;
-        const PAddr interval_end_addr = boost::icl::last_next(interval) << Memory::PAGE_BITS;
-        const u32 interval_size = interval_end_addr - interval_start_addr;
-
-        if (delta > 0 && count == delta)
-            VideoCore::g_memory->RasterizerMarkRegionCached(interval_start_addr, interval_size,
-                                                            true);
-        else if (delta < 0 && count == -delta)
-            VideoCore::g_memory->RasterizerMarkRegionCached(interval_start_addr, interval_size,
-                                                            false);
-        else
-            ASSERT(count >= 0);
-    }
-
-    if (delta < 0)
-        cached_pages.add({pages_interval, delta});
+    const u32 page_end = ((addr + size - 1) >> Memory::PAGE_BITS) + 1;
+
+    // The index already counts the surfaces touching each page, only the pages that just gained
+    // their first or lost their last surface change state. Mark them in contiguous runs.
+    const std::size_t changed_count = delta > 0 ? 1 : 0;
+    u32 run_start = page_start;
+    for (u32 page = page_start; page <= page_end; ++page) {
+        if (page < page_end && surface_cache.GetPageCount(page) == changed_count) {
+            continue;
+        }
+        if (run_start < page) {
+            VideoCore::g_memory->RasterizerMarkRegionCached(
+                run_start << Memory::PAGE_BITS, (page - run_start) << Memory::PAGE_BITS, delta > 0);
+        }
+        run_start = page + 1;
+    }
 }
 
 } // namespace OpenGL
@@ -25,10 +25,13 @@
 #include "common/common_funcs.h"
 #include "common/common_types.h"
 #include "common/math_util.h"
+#include "common/thread_pool.h"
 #include "core/hw/gpu.h"
+#include "video_core/rasterizer_interface.h"
 #include "video_core/regs_framebuffer.h"
 #include "video_core/regs_texturing.h"
 #include "video_core/renderer_opengl/gl_resource_manager.h"
+#include "video_core/renderer_opengl/gl_surface_index.h"
 #include "video_core/texture/texture_decode.h"
 
 namespace OpenGL {
@@ -81,18 +84,15 @@ using SurfaceSet = std::set<Surface>;
 
 using SurfaceRegions = boost::icl::interval_set<PAddr>;
 using SurfaceMap = boost::icl::interval_map<PAddr, Surface>;
-using SurfaceCache = boost::icl::interval_map<PAddr, SurfaceSet>;
+using SurfaceCache = SurfacePageIndex<Surface>;
 
-using SurfaceInterval = SurfaceCache::interval_type;
-static_assert(std::is_same<SurfaceRegions::interval_type, SurfaceCache::interval_type>() &&
-                  std::is_same<SurfaceMap::interval_type, SurfaceCache::interval_type>(),
+using SurfaceInterval = SurfaceRegions::interval_type;
+static_assert(std::is_same<SurfaceMap::interval_type, SurfaceInterval>(),
               "incorrect interval types");
 
 using SurfaceRect_Tuple = std::tuple<Surface, Common::Rectangle<u32>>;
 using SurfaceSurfaceRect_Tuple = std::tuple<Surface, Surface, Common::Rectangle<u32>>;
 
-using PageMap = boost::icl::interval_map<u32, int>;
-
 enum class ScaleMatch {
     Exact,   // only accept same res scale
     Upscale, // only allow higher scale than params
@@ -349,6 +349,8 @@ struct CachedSurface : SurfaceParams, std::enable_shared_from_this<CachedSurface
     }
 
     bool registered = false;
+    /// Tick of the surface cache the surface was last returned at, for LRU eviction
+    u64 last_used = 0;
     SurfaceRegions invalid_regions;
 
     u32 fill_size = 0; /// Number of bytes to read from fill_data
@@ -365,12 +367,19 @@ struct CachedSurface : SurfaceParams, std::enable_shared_from_this<CachedSurface
                          : SurfaceParams::GetFormatBpp(format) / 8;
     }
 
+    /// Returns the host GPU memory taken by the texture of the surface
+    std::size_t GetHostSizeInBytes() const {
+        return type == SurfaceType::Fill ? 0
+                                         : std::size_t{GetScaledWidth()} * GetScaledHeight() *
+                                               GetGLBytesPerPixel(pixel_format);
+    }
+
     std::unique_ptr<u8[]> gl_buffer;
     std::size_t gl_buffer_size = 0;
 
-    // Read/Write data in 3DS memory to/from gl_buffer
-    void LoadGLBuffer(PAddr load_start, PAddr load_end);
-    void FlushGLBuffer(PAddr flush_start, PAddr flush_end);
+    // Read/Write data in 3DS memory to/from gl_buffer, converting tiles on the given pool if any
+    void LoadGLBuffer(PAddr load_start, PAddr load_end, Common::ThreadPool* pool = nullptr);
+    void FlushGLBuffer(PAddr flush_start, PAddr flush_end, Common::ThreadPool* pool = nullptr);
 
     // Upload/Download data in gl_buffer in/to this surface's texture
     void UploadGLTexture(const Common::Rectangle<u32>& rect, GLuint read_fb_handle,
@@ -458,6 +467,10 @@ public:
     /// Flush all cached resources tracked by this cache manager
     void FlushAll();
 
+    const VideoCore::SurfaceCacheStats& GetStats() const {
+        return stats;
+    }
+
 private:
     void DuplicateSurface(const Surface& src_surface, const Surface& dest_surface);
 
@@ -473,11 +486,21 @@ private:
     /// Remove surface from the cache
     void UnregisterSurface(const Surface& surface);
 
-    /// Increase/decrease the number of surface in pages touching the specified region
+    /// Marks the pages of a surface which was just registered (delta 1) or unregistered (delta -1)
+    /// as cached or uncached if it is their first or last surface
     void UpdatePagesCachedCount(PAddr addr, u32 size, int delta);
 
+    /// Returns the pool to convert surfaces on, or nullptr if they are to be converted serially
+    Common::ThreadPool* GetDecodePool();
+
+    /// Marks a surface as used by the current draw
+    void TouchSurface(const Surface& surface);
+
+    /// Evicts the least recently used surfaces while the cache exceeds its memory budget, writing
+    /// back dirty surfaces first. Must only be called while no surface is in use.
+    void EnforceMemoryBudget();
+
     SurfaceCache surface_cache;
-    PageMap cached_pages;
     SurfaceMap dirty_regions;
     SurfaceSet remove_surfaces;
 
@@ -492,5 +515,11 @@ private:
     GLint d24s8_abgr_viewport_u_id;
 
     std::unordered_map<TextureCubeConfig, CachedTextureCube> texture_cube_cache;
+
+    std::unique_ptr<Common::ThreadPool> decode_pool;
+
+    /// Advanced at every draw, surfaces returned since then have it as their last_used tick
+    u64 current_tick = 1;
+    VideoCore::SurfaceCacheStats stats;
 };
 } // namespace OpenGL
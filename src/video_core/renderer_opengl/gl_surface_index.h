@@ -0,0 +1,168 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <tuple>
+#include <vector>
+#include "common/assert.h"
+#include "common/common_types.h"
+
+namespace OpenGL {
+
+/**
+ * Index of values covering ranges of physical memory, like the surfaces of the rasterizer cache,
+ * bucketed by the 4 KiB pages they touch. Looking up the values overlapping a range only walks the
+ * buckets of its pages, and unlike with an interval map, adding or removing a value does not split
+ * or merge the segments of the values around it.
+ */
+template <typename T>
+class SurfacePageIndex {
+public:
+    static constexpr u32 PAGE_BITS = 12;
+
+    /// Adds a value covering [start, end), empty ranges are not indexed
+    void Insert(const T& value, PAddr start, PAddr end) {
+        if (start >= end) {
+            return;
+        }
+        const u32 first_page = start >> PAGE_BITS;
+        for (u32 page = first_page; page <= (end - 1) >> PAGE_BITS; ++page) {
+            auto& block = blocks[page >> BLOCK_BITS];
+            if (!block) {
+                block = std::make_unique<Block>();
+            }
+            auto& bucket = (*block)[page & BLOCK_MASK];
+            auto& entries = page == first_page ? bucket.starting : bucket.continuing;
+            entries.push_back({value, start, end});
+        }
+        ++num_values;
+    }
+
+    /// Removes a value previously added with the same range
+    void Erase(const T& value, PAddr start, PAddr end) {
+        if (start >= end) {
+            return;
+        }
+        const u32 first_page = start >> PAGE_BITS;
+        for (u32 page = first_page; page <= (end - 1) >> PAGE_BITS; ++page) {
+            auto& bucket = (*blocks[page >> BLOCK_BITS])[page & BLOCK_MASK];
+            auto& entries = page == first_page ? bucket.starting : bucket.continuing;
+            const auto it = std::find_if(entries.begin(), entries.end(), [&](const Entry& entry) {
+                return entry.value == value && entry.start == start && entry.end == end;
+            });
+            ASSERT(it != entries.end());
+            *it = std::move(entries.back());
+            entries.pop_back();
+        }
+        --num_values;
+    }
+
+    /**
+     * Calls func(value) once for each value overlapping [start, end). The values are visited in
+     * the order an interval map of them would first list them: by the start of their overlap with
+     * the range, then by value. func must not modify the index.
+     */
+    template <typename Func>
+    void ForEachOverlapping(PAddr start, PAddr end, Func&& func) const {
+        if (start >= end) {
+            return;
+        }
+
+        const u32 first_page = start >> PAGE_BITS;
+        const u32 last_page = (end - 1) >> PAGE_BITS;
+        std::vector<std::tuple<PAddr, const T*>> matches;
+        const auto add_matches = [&](const std::vector<Entry>& entries) {
+            for (const Entry& entry : entries) {
+                if (entry.start < end && start < entry.end) {
+                    matches.emplace_back(std::max(entry.start, start), &entry.value);
+                }
+            }
+        };
+        for (u32 page = first_page; page <= last_page; ++page) {
+            const auto& block = blocks[page >> BLOCK_BITS];
+            if (!block) {
+                // Skip to the first page of the next block
+                page |= BLOCK_MASK;
+                continue;
+            }
+            // Values starting before the range are taken from its first page, every other value
+            // from the page it starts in
+            const auto& bucket = (*block)[page & BLOCK_MASK];
+            if (page == first_page) {
+                add_matches(bucket.continuing);
+            }
+            add_matches(bucket.starting);
+        }
+
+        std::sort(matches.begin(), matches.end(), [](const auto& lhs, const auto& rhs) {
+            return std::get<0>(lhs) != std::get<0>(rhs) ? std::get<0>(lhs) < std::get<0>(rhs)
+                                                        : *std::get<1>(lhs) < *std::get<1>(rhs);
+        });
+        for (const auto& match : matches) {
+            func(*std::get<1>(match));
+        }
+    }
+
+    /// Returns the number of values touching the given page
+    std::size_t GetPageCount(u32 page) const {
+        const auto& block = blocks[page >> BLOCK_BITS];
+        if (!block) {
+            return 0;
+        }
+        const auto& bucket = (*block)[page & BLOCK_MASK];
+        return bucket.starting.size() + bucket.continuing.size();
+    }
+
+    /// Returns every value in the index, each once
+    std::vector<T> GetAll() const {
+        std::vector<T> values;
+        values.reserve(num_values);
+        for (std::size_t block_index = 0; block_index < blocks.size(); ++block_index) {
+            if (!blocks[block_index]) {
+                continue;
+            }
+            for (const auto& bucket : *blocks[block_index]) {
+                for (const Entry& entry : bucket.starting) {
+                    values.push_back(entry.value);
+                }
+            }
+        }
+        return values;
+    }
+
+    bool Empty() const {
+        return num_values == 0;
+    }
+
+private:
+    struct Entry {
+        T value;
+        PAddr start;
+        PAddr end;
+    };
+
+    struct Bucket {
+        /// Values starting in the page
+        std::vector<Entry> starting;
+        /// Values starting in an earlier page and extending into this one
+        std::vector<Entry> continuing;
+    };
+
+    /// Buckets are allocated in blocks of consecutive pages, as surfaces only live in a few
+    /// regions of the address space
+    static constexpr u32 BLOCK_BITS = 10;
+    static constexpr std::size_t BLOCK_SIZE = std::size_t{1} << BLOCK_BITS;
+    static constexpr u32 BLOCK_MASK = BLOCK_SIZE - 1;
+    using Block = std::array<Bucket, BLOCK_SIZE>;
+
+    std::array<std::unique_ptr<Block>, std::size_t{1} << (32 - PAGE_BITS - BLOCK_BITS)> blocks;
+    std::size_t num_values = 0;
+};
+
+} // namespace OpenGL
@@ -2,8 +2,12 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <cmath>
 #include <cstring>
+#include <map>
+#include <utility>
+#include <vector>
 #include "common/bit_set.h"
 #include "common/logging/log.h"
 #include "common/microprofile.h"
@@ -132,6 +136,317 @@ void GSUnitState::ConfigOutput(const ShaderRegs& config) {
     emitter.output_mask = config.output_mask;
 }
 
+namespace {
+
+using nihstro::Instruction;
+using nihstro::OpCode;
+using nihstro::SwizzlePattern;
+
+/// Upper bound on the instructions ReadsCarriedOverState walks through before giving up
+constexpr std::size_t MAX_ANALYSIS_STEPS = 0x10000;
+
+/// Components of the registers written so far on a path through a shader program
+struct WrittenRegisters {
+    std::array<u8, 16> temporary{};
+    std::array<u8, 16> output{};
+    u8 address = 0; ///< One bit each for a0, a1 and aL
+    bool conditional_code = false;
+
+    /// Returns whether every component written in `other` is also written here
+    bool Contains(const WrittenRegisters& other) const {
+        for (std::size_t i = 0; i < temporary.size(); ++i) {
+            if ((other.temporary[i] & ~temporary[i]) || (other.output[i] & ~output[i]))
+                return false;
+        }
+        return !(other.address & ~address) && (conditional_code || !other.conditional_code);
+    }
+};
+
+/// Lanes of each source an arithmetic instruction reads, and whether it writes its destination
+struct InstructionUse {
+    u8 src1 = 0;
+    u8 src2 = 0;
+    u8 src3 = 0;
+    bool writes_dest = false;
+};
+
+/// Returns the components of the destination register an instruction writes
+u8 GetDestComponents(const SwizzlePattern& swizzle) {
+    u8 components = 0;
+    for (int i = 0; i < 4; ++i) {
+        if (swizzle.DestComponentEnabled(i))
+            components |= 1 << i;
+    }
+    return components;
+}
+
+InstructionUse GetInstructionUse(OpCode::Id opcode, const SwizzlePattern& swizzle) {
+    const u8 dest_lanes = GetDestComponents(swizzle);
+    switch (opcode) {
+    case OpCode::Id::ADD:
+    case OpCode::Id::MUL:
+    case OpCode::Id::MAX:
+    case OpCode::Id::MIN:
+    case OpCode::Id::SGE:
+    case OpCode::Id::SGEI:
+    case OpCode::Id::SLT:
+    case OpCode::Id::SLTI:
+        return {dest_lanes, dest_lanes, 0, true};
+    case OpCode::Id::MOV:
+    case OpCode::Id::FLR:
+        return {dest_lanes, 0, 0, true};
+    case OpCode::Id::RCP:
+    case OpCode::Id::RSQ:
+    case OpCode::Id::EX2:
+    case OpCode::Id::LG2:
+        return {0x1, 0, 0, true};
+    case OpCode::Id::DP3:
+        return {0x7, 0x7, 0, true};
+    case OpCode::Id::DP4:
+        return {0xF, 0xF, 0, true};
+    case OpCode::Id::DPH:
+    case OpCode::Id::DPHI:
+        return {0x7, 0xF, 0, true};
+    case OpCode::Id::MOVA:
+        return {static_cast<u8>(dest_lanes & 0x3), 0, 0, false};
+    case OpCode::Id::CMP:
+        return {0x3, 0x3, 0, false};
+    case OpCode::Id::MAD:
+    case OpCode::Id::MADI:
+        return {dest_lanes, dest_lanes, dest_lanes, true};
+    default:
+        // The shader engines don't implement these, they don't touch any register
+        return {};
+    }
+}
+
+/// Translates the lanes of a source an instruction reads into the register components it reads
+template <SwizzlePattern::Selector (SwizzlePattern::*GetSelector)(int) const>
+u8 GetComponents(const SwizzlePattern& swizzle, u8 lanes) {
+    u8 components = 0;
+    for (int i = 0; i < 4; ++i) {
+        if (lanes & (1 << i))
+            components |= 1 << static_cast<int>((swizzle.*GetSelector)(i));
+    }
+    return components;
+}
+
+/// Returns whether reading the given components of a source register only sees written values
+bool IsWritten(const WrittenRegisters& written, const SourceRegister& reg, u8 components,
+               unsigned address_register_index) {
+    if (components == 0)
+        return true;
+
+    if (address_register_index != 0) {
+        if (!(written.address & (1 << (address_register_index - 1))))
+            return false;
+        // Relative reads may land on any input or temporary register
+        return reg.GetRegisterType() == RegisterType::FloatUniform;
+    }
+
+    if (reg.GetRegisterType() == RegisterType::Temporary)
+        return (written.temporary[reg.GetIndex()] & components) == components;
+    return true;
+}
+
+void Write(WrittenRegisters& written, const DestRegister& dest, u8 components) {
+    if (dest.GetRegisterType() == RegisterType::Output) {
+        written.output[dest.GetIndex()] |= components;
+    } else if (dest.GetRegisterType() == RegisterType::Temporary) {
+        written.temporary[dest.GetIndex()] |= components;
+    }
+}
+
+/**
+ * Records the registers an arithmetic instruction writes.
+ * @returns false if the instruction reads a register that has not been written yet
+ */
+bool RunArithmetic(const std::array<u32, MAX_SWIZZLE_DATA_LENGTH>& swizzle_data,
+                   const Instruction& instr, WrittenRegisters& written) {
+    const OpCode::Id opcode = instr.opcode.Value().EffectiveOpCode();
+
+    if (instr.opcode.Value().GetInfo().type == OpCode::Type::MultiplyAdd) {
+        const SwizzlePattern swizzle = {swizzle_data[instr.mad.operand_desc_id]};
+        const InstructionUse use = GetInstructionUse(opcode, swizzle);
+        const bool is_inverted = opcode == OpCode::Id::MADI;
+        const unsigned address = instr.mad.address_register_index;
+        const bool reads_written =
+            IsWritten(written, instr.mad.GetSrc1(is_inverted),
+                      GetComponents<&SwizzlePattern::GetSelectorSrc1>(swizzle, use.src1), 0) &&
+            IsWritten(written, instr.mad.GetSrc2(is_inverted),
+                      GetComponents<&SwizzlePattern::GetSelectorSrc2>(swizzle, use.src2),
+                      is_inverted ? 0 : address) &&
+            IsWritten(written, instr.mad.GetSrc3(is_inverted),
+                      GetComponents<&SwizzlePattern::GetSelectorSrc3>(swizzle, use.src3),
+                      is_inverted ? address : 0);
+        if (use.writes_dest)
+            Write(written, instr.mad.dest.Value(), GetDestComponents(swizzle));
+        return reads_written;
+    }
+
+    const SwizzlePattern swizzle = {swizzle_data[instr.common.operand_desc_id]};
+    const InstructionUse use = GetInstructionUse(opcode, swizzle);
+    const bool is_inverted =
+        0 != (instr.opcode.Value().GetInfo().subtype & OpCode::Info::SrcInversed);
+    const unsigned address = instr.common.address_register_index;
+    const bool reads_written =
+        IsWritten(written, instr.common.GetSrc1(is_inverted),
+                  GetComponents<&SwizzlePattern::GetSelectorSrc1>(swizzle, use.src1),
+                  is_inverted ? 0 : address) &&
+        IsWritten(written, instr.common.GetSrc2(is_inverted),
+                  GetComponents<&SwizzlePattern::GetSelectorSrc2>(swizzle, use.src2),
+                  is_inverted ? address : 0);
+    if (use.writes_dest) {
+        Write(written, instr.common.dest.Value(), GetDestComponents(swizzle));
+    } else if (opcode == OpCode::Id::MOVA) {
+        written.address |= GetDestComponents(swizzle) & 0x3;
+    } else if (opcode == OpCode::Id::CMP) {
+        written.conditional_code = true;
+    }
+    return reads_written;
+}
+
+/// A point reached while walking through a shader program
+struct Path {
+    u32 program_counter;
+    /// Final and return address of each call, loop and conditional block entered
+    std::vector<std::pair<u32, u32>> call_stack;
+    WrittenRegisters written;
+};
+
+} // Anonymous namespace
+
+bool ReadsCarriedOverState(const ShaderSetup& setup, unsigned int entry_point, u32 output_mask) {
+    const auto& program_code = setup.program_code;
+
+    // Points already walked through, along with the registers written when reaching them
+    std::map<std::vector<std::pair<u32, u32>>, std::vector<WrittenRegisters>> visited;
+    // Outputs written when reaching END on each path, and on any path
+    std::vector<std::array<u8, 16>> end_outputs;
+    std::array<u8, 16> any_outputs{};
+
+    std::vector<Path> paths{{entry_point, {}, {}}};
+    std::size_t steps = 0;
+    while (!paths.empty()) {
+        Path path = std::move(paths.back());
+        paths.pop_back();
+
+        bool path_done = false;
+        while (!path_done) {
+            if (++steps > MAX_ANALYSIS_STEPS)
+                return true;
+
+            u32& program_counter = path.program_counter;
+            auto& call_stack = path.call_stack;
+            while (!call_stack.empty() && program_counter == call_stack.back().first) {
+                program_counter = call_stack.back().second;
+                call_stack.pop_back();
+            }
+            if (program_counter >= MAX_PROGRAM_CODE_LENGTH || call_stack.size() > 16)
+                return true;
+
+            // Reaching a point again with more registers written than before reads nothing new
+            auto key = call_stack;
+            key.emplace_back(program_counter, 0);
+            auto& seen = visited[key];
+            if (std::any_of(seen.begin(), seen.end(), [&path](const WrittenRegisters& written) {
+                    return path.written.Contains(written);
+                })) {
+                for (std::size_t i = 0; i < any_outputs.size(); ++i)
+                    any_outputs[i] |= path.written.output[i];
+                break;
+            }
+            seen.push_back(path.written);
+
+            const Instruction instr = {program_code[program_counter]};
+            const OpCode::Type type = instr.opcode.Value().GetInfo().type;
+            if (type == OpCode::Type::Arithmetic || type == OpCode::Type::MultiplyAdd) {
+                if (!RunArithmetic(setup.swizzle_data, instr, path.written))
+                    return true;
+                ++program_counter;
+                continue;
+            }
+
+            const u32 dest_offset = instr.flow_control.dest_offset;
+            const u32 num_instructions = instr.flow_control.num_instructions;
+            // Walks through the other outcome of a branch later on
+            auto branch = [&paths, &path](u32 target) -> Path& {
+                paths.push_back(path);
+                paths.back().program_counter = target;
+                return paths.back();
+            };
+
+            const OpCode::Id opcode = instr.opcode.Value();
+            if ((opcode == OpCode::Id::JMPC || opcode == OpCode::Id::CALLC ||
+                 opcode == OpCode::Id::IFC) &&
+                !path.written.conditional_code) {
+                return true;
+            }
+
+            switch (opcode) {
+            case OpCode::Id::END:
+                end_outputs.push_back(path.written.output);
+                for (std::size_t i = 0; i < any_outputs.size(); ++i)
+                    any_outputs[i] |= path.written.output[i];
+                path_done = true;
+                break;
+
+            case OpCode::Id::JMPC:
+            case OpCode::Id::JMPU:
+                branch(dest_offset);
+                ++program_counter;
+                break;
+
+            case OpCode::Id::CALL:
+                call_stack.emplace_back(dest_offset + num_instructions, program_counter + 1);
+                program_counter = dest_offset;
+                break;
+
+            case OpCode::Id::CALLC:
+            case OpCode::Id::CALLU:
+                branch(dest_offset)
+                    .call_stack.emplace_back(dest_offset + num_instructions, program_counter + 1);
+                ++program_counter;
+                break;
+
+            case OpCode::Id::IFC:
+            case OpCode::Id::IFU:
+                branch(dest_offset)
+                    .call_stack.emplace_back(dest_offset + num_instructions,
+                                             dest_offset + num_instructions);
+                call_stack.emplace_back(dest_offset, dest_offset + num_instructions);
+                ++program_counter;
+                break;
+
+            case OpCode::Id::LOOP:
+                // Later iterations only run with more registers written than the first one
+                path.written.address |= 0x4;
+                call_stack.emplace_back(dest_offset + 1, dest_offset + 1);
+                ++program_counter;
+                break;
+
+            case OpCode::Id::NOP:
+                ++program_counter;
+                break;
+
+            default:
+                // Geometry shader instructions, or ones the shader engines don't implement
+                return true;
+            }
+        }
+    }
+
+    // Output components written on some path but not on another keep the values of the previous
+    // invocation on the latter
+    for (const auto& written_outputs : end_outputs) {
+        for (std::size_t i = 0; i < written_outputs.size(); ++i) {
+            if ((output_mask & (1 << i)) && (any_outputs[i] & ~written_outputs[i]))
+                return true;
+        }
+    }
+    return false;
+}
+
 MICROPROFILE_DEFINE(GPU_Shader, "GPU", "Shader", MP_RGB(50, 50, 240));
 
 #ifdef ARCHITECTURE_x86_64
@@ -237,6 +237,19 @@ private:
     u64 swizzle_data_hash = 0xDEADC0DE;
 };
 
+/**
+ * Checks whether an invocation of the program can observe the registers an earlier invocation on
+ * the same shader unit left behind. That is the case when a path through the program reads a
+ * temporary, address register or conditional code before writing it, or doesn't write all the
+ * output components other paths write. The analysis is conservative, it may also return true for
+ * programs that never do so.
+ *
+ * @param setup Shader setup holding the program code and swizzle data
+ * @param entry_point Offset of the first instruction to run
+ * @param output_mask Mask of the output registers copied out of the shader unit
+ */
+bool ReadsCarriedOverState(const ShaderSetup& setup, unsigned int entry_point, u32 output_mask);
+
 class ShaderEngine {
 public:
     virtual ~ShaderEngine() = default;
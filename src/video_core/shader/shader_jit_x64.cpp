@@ -2,15 +2,120 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <fmt/format.h>
+#include "common/common_paths.h"
+#include "common/file_util.h"
+#include "common/hash.h"
+#include "common/logging/log.h"
 #include "common/microprofile.h"
+#include "common/thread.h"
+#include "core/core.h"
+#include "core/loader/loader.h"
 #include "video_core/shader/shader.h"
 #include "video_core/shader/shader_jit_x64.h"
 #include "video_core/shader/shader_jit_x64_compiler.h"
+#include "video_core/video_core.h"
 
 namespace Pica::Shader {
 
-JitX64Engine::JitX64Engine() = default;
-JitX64Engine::~JitX64Engine() = default;
+MICROPROFILE_DEFINE(GPU_ShaderCompile, "GPU", "Shader Compile", MP_RGB(100, 100, 255));
+
+// Disk cache entries are stored as an array of u32 containing the length of the program code and
+// of the swizzle data, followed by both arrays with their trailing zeros removed.
+static constexpr u32 DISK_CACHE_HEADER_SIZE = 2;
+
+template <std::size_t N>
+static u32 GetTrimmedLength(const std::array<u32, N>& data) {
+    const auto last = std::find_if(data.rbegin(), data.rend(), [](u32 word) { return word != 0; });
+    return static_cast<u32>(data.rend() - last);
+}
+
+class JitX64Engine::DiskCacheReader : public LinearDiskCacheReader<DiskCacheKey, u32> {
+public:
+    explicit DiskCacheReader(JitX64Engine& engine) : engine(engine) {}
+
+    void Read(const DiskCacheKey& key, const u32* value, u32 value_size) override {
+        if (key.emitter_version != EMITTER_VERSION || value_size < DISK_CACHE_HEADER_SIZE) {
+            ++num_stale_entries;
+            return;
+        }
+
+        const u32 code_length = value[0];
+        const u32 swizzle_length = value[1];
+        if (code_length > MAX_PROGRAM_CODE_LENGTH || swizzle_length > MAX_SWIZZLE_DATA_LENGTH ||
+            value_size != DISK_CACHE_HEADER_SIZE + code_length + swizzle_length) {
+            ++num_stale_entries;
+            return;
+        }
+
+        auto program = std::make_unique<ShaderProgram>();
+        const u32* code_begin = value + DISK_CACHE_HEADER_SIZE;
+        std::copy(code_begin, code_begin + code_length, program->program_code.begin());
+        std::copy(code_begin + code_length, code_begin + code_length + swizzle_length,
+                  program->swizzle_data.begin());
+
+        // Make sure the entry is intact, as it would otherwise be used for a different program
+        program->code_hash =
+            Common::ComputeHash64(&program->program_code, sizeof(program->program_code));
+        program->swizzle_hash =
+            Common::ComputeHash64(&program->swizzle_data, sizeof(program->swizzle_data));
+        if (program->code_hash != key.code_hash || program->swizzle_hash != key.swizzle_hash) {
+            ++num_stale_entries;
+            return;
+        }
+
+        const u64 cache_key = key.code_hash ^ key.swizzle_hash;
+        if (engine.stored_shaders.insert(cache_key).second) {
+            engine.pending_shaders.emplace(cache_key, std::move(program));
+        }
+    }
+
+    u32 num_stale_entries = 0;
+
+private:
+    JitX64Engine& engine;
+};
+
+JitX64Engine::JitX64Engine() {
+    auto& system = Core::System::GetInstance();
+    u64 program_id = 0;
+    if (!VideoCore::g_disk_shader_cache_enabled || !system.IsPoweredOn() ||
+        system.GetAppLoader().ReadProgramId(program_id) != Loader::ResultStatus::Success ||
+        program_id == 0) {
+        return;
+    }
+
+    disk_cache_path =
+        fmt::format("{}shader_jit" DIR_SEP "{:016X}.bin",
+                    FileUtil::GetUserPath(FileUtil::UserPath::CacheDir), program_id);
+    if (!FileUtil::CreateFullPath(disk_cache_path)) {
+        LOG_ERROR(HW_GPU, "Failed to create the shader disk cache directory for {}",
+                  disk_cache_path);
+        disk_cache_path.clear();
+        return;
+    }
+
+    // Reading the file is cheap compared to compiling the shaders in it, so only the latter
+    // happens asynchronously
+    LoadDiskCache();
+    if (!pending_shaders.empty()) {
+        preload_thread = std::thread([this] { PreloadShaders(); });
+    }
+}
+
+JitX64Engine::~JitX64Engine() {
+    stop_preload = true;
+    if (preload_thread.joinable()) {
+        preload_thread.join();
+    }
+
+    if (!disk_cache_path.empty()) {
+        disk_cache.Close();
+        LOG_INFO(HW_GPU, "Shader disk cache: {} hits, {} misses", disk_cache_hits.load(),
+                 disk_cache_misses.load());
+    }
+}
 
 void JitX64Engine::SetupBatch(ShaderSetup& setup, unsigned int entry_point) {
     ASSERT(entry_point < MAX_PROGRAM_CODE_LENGTH);
@@ -24,8 +129,7 @@ void JitX64Engine::SetupBatch(ShaderSetup& setup, unsigned int entry_point) {
     if (iter != cache.end()) {
         setup.engine_data.cached_shader = iter->second.get();
     } else {
-        auto shader = std::make_unique<JitShader>();
-        shader->Compile(&setup.program_code, &setup.swizzle_data);
+        auto shader = LoadOrCompileShader(setup, code_hash, swizzle_hash);
         setup.engine_data.cached_shader = shader.get();
         cache.emplace_hint(iter, cache_key, std::move(shader));
     }
@@ -42,4 +146,139 @@ void JitX64Engine::Run(const ShaderSetup& setup, UnitState& state) const {
     shader->Run(setup, state, setup.engine_data.entry_point);
 }
 
+void JitX64Engine::InvalidateDiskCache() {
+    if (disk_cache_path.empty()) {
+        return;
+    }
+
+    stop_preload = true;
+    if (preload_thread.joinable()) {
+        preload_thread.join();
+    }
+
+    std::lock_guard<std::mutex> lock(disk_cache_mutex);
+    pending_shaders.clear();
+    preloaded_shaders.clear();
+    stored_shaders.clear();
+
+    disk_cache.Close();
+    FileUtil::Delete(disk_cache_path);
+
+    // Reopening a missing file creates an empty cache to which new shaders are added
+    DiskCacheReader reader(*this);
+    disk_cache.OpenAndRead(disk_cache_path.c_str(), reader);
+    LOG_INFO(HW_GPU, "Invalidated shader disk cache {}", disk_cache_path);
+}
+
+std::unique_ptr<JitShader> JitX64Engine::LoadOrCompileShader(const ShaderSetup& setup,
+                                                             u64 code_hash, u64 swizzle_hash) {
+    const u64 cache_key = code_hash ^ swizzle_hash;
+    bool stored = false;
+
+    if (!disk_cache_path.empty()) {
+        std::lock_guard<std::mutex> lock(disk_cache_mutex);
+
+        const auto preloaded = preloaded_shaders.find(cache_key);
+        if (preloaded != preloaded_shaders.end()) {
+            auto shader = std::move(preloaded->second);
+            preloaded_shaders.erase(preloaded);
+            ++disk_cache_hits;
+            return shader;
+        }
+
+        // Shaders which haven't been compiled by the preload thread yet are compiled here, but
+        // still came from the disk cache and must not be added to it again
+        stored = stored_shaders.count(cache_key) != 0;
+        if (stored) {
+            pending_shaders.erase(cache_key);
+            ++disk_cache_hits;
+        } else {
+            stored_shaders.insert(cache_key);
+        }
+    }
+
+    auto shader = std::make_unique<JitShader>();
+    {
+        MICROPROFILE_SCOPE(GPU_ShaderCompile);
+        shader->Compile(&setup.program_code, &setup.swizzle_data);
+    }
+
+    if (!disk_cache_path.empty() && !stored) {
+        ++disk_cache_misses;
+        std::lock_guard<std::mutex> lock(disk_cache_mutex);
+        AppendToDiskCache(code_hash, swizzle_hash, setup.program_code, setup.swizzle_data);
+    }
+    return shader;
+}
+
+void JitX64Engine::LoadDiskCache() {
+    DiskCacheReader reader(*this);
+    const u32 num_entries = disk_cache.OpenAndRead(disk_cache_path.c_str(), reader);
+
+    // Rewrite the cache without entries from older emitter versions or damaged entries, so that
+    // they don't have to be skipped on every boot
+    if (reader.num_stale_entries != 0) {
+        LOG_INFO(HW_GPU, "Removing {} stale entries from the shader disk cache",
+                 reader.num_stale_entries);
+        disk_cache.Close();
+        FileUtil::Delete(disk_cache_path);
+        disk_cache.OpenAndRead(disk_cache_path.c_str(), reader);
+        for (const auto& entry : pending_shaders) {
+            const ShaderProgram& program = *entry.second;
+            AppendToDiskCache(program.code_hash, program.swizzle_hash, program.program_code,
+                              program.swizzle_data);
+        }
+    }
+
+    LOG_INFO(HW_GPU, "Loaded {} of {} shaders from the shader disk cache", pending_shaders.size(),
+             num_entries);
+}
+
+void JitX64Engine::PreloadShaders() {
+    Common::SetCurrentThreadName("ShaderPreload");
+
+    while (!stop_preload) {
+        u64 cache_key;
+        std::unique_ptr<ShaderProgram> program;
+        {
+            std::lock_guard<std::mutex> lock(disk_cache_mutex);
+            if (pending_shaders.empty()) {
+                break;
+            }
+            auto iter = pending_shaders.begin();
+            cache_key = iter->first;
+            program = std::move(iter->second);
+            pending_shaders.erase(iter);
+        }
+
+        auto shader = std::make_unique<JitShader>();
+        shader->Compile(&program->program_code, &program->swizzle_data);
+
+        std::lock_guard<std::mutex> lock(disk_cache_mutex);
+        preloaded_shaders.emplace(cache_key, std::move(shader));
+    }
+}
+
+void JitX64Engine::AppendToDiskCache(u64 code_hash, u64 swizzle_hash,
+                                     const std::array<u32, MAX_PROGRAM_CODE_LENGTH>& program_code,
+                                     const std::array<u32, MAX_SWIZZLE_DATA_LENGTH>& swizzle_data) {
+    const u32 code_length = GetTrimmedLength(program_code);
+    const u32 swizzle_length = GetTrimmedLength(swizzle_data);
+
+    std::vector<u32> value;
+    value.reserve(DISK_CACHE_HEADER_SIZE + code_length + swizzle_length);
+    value.push_back(code_length);
+    value.push_back(swizzle_length);
+    value.insert(value.end(), program_code.begin(), program_code.begin() + code_length);
+    value.insert(value.end(), swizzle_data.begin(), swizzle_data.begin() + swizzle_length);
+
+    DiskCacheKey key{};
+    key.code_hash = code_hash;
+    key.swizzle_hash = swizzle_hash;
+    key.emitter_version = EMITTER_VERSION;
+
+    disk_cache.Append(key, value.data(), static_cast<u32>(value.size()));
+    disk_cache.Sync();
+}
+
 } // namespace Pica::Shader
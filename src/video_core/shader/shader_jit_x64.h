@@ -4,9 +4,16 @@
 
 #pragma once
 
+#include <array>
+#include <atomic>
 #include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
 #include <unordered_map>
+#include <unordered_set>
 #include "common/common_types.h"
+#include "common/linear_disk_cache.h"
 #include "video_core/shader/shader.h"
 
 namespace Pica::Shader {
@@ -15,14 +22,80 @@ class JitShader;
 
 class JitX64Engine final : public ShaderEngine {
 public:
+    /// Version of the code emitted by JitShader. Increase this whenever code generation changes,
+    /// so that shaders stored by older versions are invalidated.
+    static constexpr u32 EMITTER_VERSION = 1;
+
     JitX64Engine();
     ~JitX64Engine() override;
 
     void SetupBatch(ShaderSetup& setup, unsigned int entry_point) override;
     void Run(const ShaderSetup& setup, UnitState& state) const override;
 
+    /// Number of new shaders that were found in the disk cache
+    u64 GetDiskCacheHits() const {
+        return disk_cache_hits;
+    }
+
+    /// Number of new shaders that had to be compiled and were added to the disk cache
+    u64 GetDiskCacheMisses() const {
+        return disk_cache_misses;
+    }
+
+    /// Deletes all shaders stored on disk for the current title
+    void InvalidateDiskCache();
+
 private:
+    struct DiskCacheKey {
+        u64 code_hash;
+        u64 swizzle_hash;
+        u32 emitter_version;
+        u32 padding;
+    };
+
+    /// Shader program stored in the disk cache, waiting to be compiled
+    struct ShaderProgram {
+        u64 code_hash;
+        u64 swizzle_hash;
+        std::array<u32, MAX_PROGRAM_CODE_LENGTH> program_code{};
+        std::array<u32, MAX_SWIZZLE_DATA_LENGTH> swizzle_data{};
+    };
+
+    class DiskCacheReader;
+
+    /// Returns the shader for the given program, taking it from the disk cache if possible
+    std::unique_ptr<JitShader> LoadOrCompileShader(const ShaderSetup& setup, u64 code_hash,
+                                                   u64 swizzle_hash);
+
+    /// Opens the disk cache and reads the shader programs stored in it
+    void LoadDiskCache();
+
+    /// Compiles the shader programs read from the disk cache, runs on the preload thread
+    void PreloadShaders();
+
+    /// Adds the given shader program to the disk cache, disk_cache_mutex must be held
+    void AppendToDiskCache(u64 code_hash, u64 swizzle_hash,
+                           const std::array<u32, MAX_PROGRAM_CODE_LENGTH>& program_code,
+                           const std::array<u32, MAX_SWIZZLE_DATA_LENGTH>& swizzle_data);
+
     std::unordered_map<u64, std::unique_ptr<JitShader>> cache;
+
+    /// Path of the disk cache of the current title, empty if the disk cache is disabled
+    std::string disk_cache_path;
+    LinearDiskCache<DiskCacheKey, u32> disk_cache;
+
+    /// Protects the disk cache file as well as the shaders loaded from it
+    std::mutex disk_cache_mutex;
+    std::unordered_map<u64, std::unique_ptr<ShaderProgram>> pending_shaders;
+    std::unordered_map<u64, std::unique_ptr<JitShader>> preloaded_shaders;
+    /// Keys of all shaders in the disk cache file
+    std::unordered_set<u64> stored_shaders;
+
+    std::thread preload_thread;
+    std::atomic<bool> stop_preload{false};
+
+    std::atomic<u64> disk_cache_hits{0};
+    std::atomic<u64> disk_cache_misses{0};
 };
 
 } // namespace Pica::Shader
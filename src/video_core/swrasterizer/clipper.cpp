@@ -86,6 +86,13 @@ static void InitScreenCoordinates(Vertex& vtx) {
 }
 
 void ProcessTriangle(const OutputVertex& v0, const OutputVertex& v1, const OutputVertex& v2) {
+    ProcessTriangle(v0, v1, v2, [](const Vertex& vtx0, const Vertex& vtx1, const Vertex& vtx2) {
+        Rasterizer::ProcessTriangle(vtx0, vtx1, vtx2);
+    });
+}
+
+void ProcessTriangle(const OutputVertex& v0, const OutputVertex& v1, const OutputVertex& v2,
+                     const TriangleHandler& handler) {
     using boost::container::static_vector;
 
     // Clipping a planar n-gon against a plane will remove at least 1 vertex and introduces 2 at
@@ -190,7 +197,7 @@ void ProcessTriangle(const OutputVertex& v0, const OutputVertex& v1, const Outpu
             vtx2.screenpos.x.ToFloat32(), vtx2.screenpos.y.ToFloat32(),
             vtx2.screenpos.z.ToFloat32());
 
-        Rasterizer::ProcessTriangle(vtx0, vtx1, vtx2);
+        handler(vtx0, vtx1, vtx2);
     }
 }
 
@@ -4,16 +4,30 @@
 
 #pragma once
 
+#include <functional>
+
 namespace Pica {
 namespace Shader {
 struct OutputVertex;
 }
 
+namespace Rasterizer {
+struct Vertex;
+}
+
 namespace Clipper {
 
 using Shader::OutputVertex;
 
+using TriangleHandler = std::function<void(const Rasterizer::Vertex&, const Rasterizer::Vertex&,
+                                            const Rasterizer::Vertex&)>;
+
 void ProcessTriangle(const OutputVertex& v0, const OutputVertex& v1, const OutputVertex& v2);
 
+/// Clips the given triangle and passes the resulting triangles to the handler instead of the
+/// rasterizer
+void ProcessTriangle(const OutputVertex& v0, const OutputVertex& v1, const OutputVertex& v2,
+                     const TriangleHandler& handler);
+
 } // namespace Clipper
 } // namespace Pica
@@ -0,0 +1,115 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include "common/assert.h"
+#include "video_core/swrasterizer/coverage.h"
+
+#ifdef ARCHITECTURE_x86_64
+#include <immintrin.h>
+#include "common/x64/cpu_detect.h"
+#endif
+
+// The AVX2 kernel is compiled for AVX2 regardless of the global compiler flags and only called
+// after the CPU has been checked for support. MSVC accepts the intrinsics without this.
+#if defined(ARCHITECTURE_x86_64) && (defined(__GNUC__) || defined(__clang__))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define TARGET_AVX2
+#endif
+
+namespace Pica::Rasterizer {
+
+u32 ComputeCoverageScalar(const EdgeFunctions& edges, unsigned count) {
+    DEBUG_ASSERT(count <= MAX_COVERAGE_SPAN);
+
+    s32 w0 = edges.w[0];
+    s32 w1 = edges.w[1];
+    s32 w2 = edges.w[2];
+    u32 mask = 0;
+    for (unsigned i = 0; i < count; ++i) {
+        // A negative value in any of the edge functions shows up in the sign bit of the OR
+        if ((w0 | w1 | w2) >= 0) {
+            mask |= 1u << i;
+        }
+        w0 += edges.step[0];
+        w1 += edges.step[1];
+        w2 += edges.step[2];
+    }
+    return mask;
+}
+
+#ifdef ARCHITECTURE_x86_64
+
+u32 ComputeCoverageSSE2(const EdgeFunctions& edges, unsigned count) {
+    DEBUG_ASSERT(count <= MAX_COVERAGE_SPAN);
+
+    auto SetupLanes = [](s32 w, s32 step) {
+        return _mm_add_epi32(_mm_set1_epi32(w),
+                             _mm_set_epi32(3 * step, 2 * step, step, 0));
+    };
+
+    __m128i w0 = SetupLanes(edges.w[0], edges.step[0]);
+    __m128i w1 = SetupLanes(edges.w[1], edges.step[1]);
+    __m128i w2 = SetupLanes(edges.w[2], edges.step[2]);
+    const __m128i step0 = _mm_set1_epi32(4 * edges.step[0]);
+    const __m128i step1 = _mm_set1_epi32(4 * edges.step[1]);
+    const __m128i step2 = _mm_set1_epi32(4 * edges.step[2]);
+
+    u32 mask = 0;
+    for (unsigned i = 0; i < count; i += 4) {
+        const __m128i any = _mm_or_si128(_mm_or_si128(w0, w1), w2);
+        const u32 outside = static_cast<u32>(_mm_movemask_ps(_mm_castsi128_ps(any)));
+        mask |= (~outside & 0xF) << i;
+
+        w0 = _mm_add_epi32(w0, step0);
+        w1 = _mm_add_epi32(w1, step1);
+        w2 = _mm_add_epi32(w2, step2);
+    }
+
+    return count == MAX_COVERAGE_SPAN ? mask : mask & ((1u << count) - 1);
+}
+
+TARGET_AVX2 u32 ComputeCoverageAVX2(const EdgeFunctions& edges, unsigned count) {
+    DEBUG_ASSERT(count <= MAX_COVERAGE_SPAN);
+
+    const __m256i lanes = _mm256_set_epi32(7, 6, 5, 4, 3, 2, 1, 0);
+    auto SetupLanes = [lanes](s32 w, s32 step) TARGET_AVX2 {
+        return _mm256_add_epi32(_mm256_set1_epi32(w),
+                                _mm256_mullo_epi32(lanes, _mm256_set1_epi32(step)));
+    };
+
+    __m256i w0 = SetupLanes(edges.w[0], edges.step[0]);
+    __m256i w1 = SetupLanes(edges.w[1], edges.step[1]);
+    __m256i w2 = SetupLanes(edges.w[2], edges.step[2]);
+    const __m256i step0 = _mm256_set1_epi32(8 * edges.step[0]);
+    const __m256i step1 = _mm256_set1_epi32(8 * edges.step[1]);
+    const __m256i step2 = _mm256_set1_epi32(8 * edges.step[2]);
+
+    u32 mask = 0;
+    for (unsigned i = 0; i < count; i += 8) {
+        const __m256i any = _mm256_or_si256(_mm256_or_si256(w0, w1), w2);
+        const u32 outside = static_cast<u32>(_mm256_movemask_ps(_mm256_castsi256_ps(any)));
+        mask |= (~outside & 0xFF) << i;
+
+        w0 = _mm256_add_epi32(w0, step0);
+        w1 = _mm256_add_epi32(w1, step1);
+        w2 = _mm256_add_epi32(w2, step2);
+    }
+
+    return count == MAX_COVERAGE_SPAN ? mask : mask & ((1u << count) - 1);
+}
+
+#endif
+
+CoverageFunction GetCoverageFunction() {
+#ifdef ARCHITECTURE_x86_64
+    static const CoverageFunction function =
+        Common::GetCPUCaps().avx2 ? ComputeCoverageAVX2 : ComputeCoverageSSE2;
+    return function;
+#else
+    return ComputeCoverageScalar;
+#endif
+}
+
+} // namespace Pica::Rasterizer
@@ -0,0 +1,46 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include "common/common_types.h"
+
+namespace Pica::Rasterizer {
+
+/// Maximum number of fragments a coverage function handles per call
+constexpr unsigned MAX_COVERAGE_SPAN = 32;
+
+/**
+ * Values of the three (biased) edge functions of a triangle at the first fragment of a span,
+ * along with their increments when moving one fragment to the right. A fragment is covered if
+ * none of its edge function values is negative.
+ */
+struct EdgeFunctions {
+    std::array<s32, 3> w;
+    std::array<s32, 3> step;
+};
+
+/**
+ * Computes which fragments of a horizontal span are covered by a triangle.
+ * @param edges Edge function values at the first fragment of the span
+ * @param count Number of fragments in the span, at most MAX_COVERAGE_SPAN
+ * @return Bit mask with bit i set if fragment i of the span is covered
+ */
+using CoverageFunction = u32 (*)(const EdgeFunctions& edges, unsigned count);
+
+u32 ComputeCoverageScalar(const EdgeFunctions& edges, unsigned count);
+
+#ifdef ARCHITECTURE_x86_64
+/// Evaluates 4 consecutive fragments of the span per step, SSE2 is baseline on x86-64
+u32 ComputeCoverageSSE2(const EdgeFunctions& edges, unsigned count);
+
+/// Evaluates 8 consecutive fragments of the span per step, requires AVX2
+u32 ComputeCoverageAVX2(const EdgeFunctions& edges, unsigned count);
+#endif
+
+/// Returns the fastest coverage function supported by the host CPU
+CoverageFunction GetCoverageFunction();
+
+} // namespace Pica::Rasterizer
@@ -0,0 +1,493 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include "common/assert.h"
+#include "common/color.h"
+#include "common/logging/log.h"
+#include "common/microprofile.h"
+#include "video_core/regs.h"
+#include "video_core/swrasterizer/fragment_pipeline.h"
+#include "video_core/swrasterizer/framebuffer.h"
+#include "video_core/swrasterizer/texturing.h"
+
+namespace Pica::Rasterizer {
+
+using TevStageConfig = TexturingRegs::TevStageConfig;
+
+MICROPROFILE_DEFINE(GPU_FragmentPipeline, "GPU", "Fragment Pipeline Build", MP_RGB(200, 150, 50));
+
+FragmentPipelineConfig FragmentPipelineConfig::BuildFromRegs(const Pica::Regs& regs) {
+    FragmentPipelineConfig res;
+
+    auto& state = res.state;
+
+    const auto& tev_stages = regs.texturing.GetTevStages();
+    DEBUG_ASSERT(state.tev_stages.size() == tev_stages.size());
+    for (std::size_t i = 0; i < tev_stages.size(); i++) {
+        const auto& tev_stage = tev_stages[i];
+        state.tev_stages[i].sources_raw = tev_stage.sources_raw;
+        state.tev_stages[i].modifiers_raw = tev_stage.modifiers_raw;
+        state.tev_stages[i].ops_raw = tev_stage.ops_raw;
+        state.tev_stages[i].scales_raw = tev_stage.scales_raw;
+    }
+
+    state.combiner_buffer_input =
+        regs.texturing.tev_combiner_buffer_input.update_mask_rgb.Value() |
+        regs.texturing.tev_combiner_buffer_input.update_mask_a.Value() << 4;
+
+    const auto& alpha_test = regs.framebuffer.output_merger.alpha_test;
+    state.alpha_test_func =
+        alpha_test.enable ? alpha_test.func.Value() : FramebufferRegs::CompareFunc::Always;
+    state.alpha_test_ref = alpha_test.enable ? alpha_test.ref.Value() : 0;
+
+    const auto& framebuffer = regs.framebuffer.framebuffer;
+    state.color_format = framebuffer.color_format;
+    state.depth_format = framebuffer.depth_format;
+    state.allow_color_write = framebuffer.allow_color_write != 0;
+    state.allow_depth_stencil_write = framebuffer.allow_depth_stencil_write != 0;
+
+    const auto& output_merger = regs.framebuffer.output_merger;
+    state.depth_test_enable = output_merger.depth_test_enable;
+    state.depth_test_func = output_merger.depth_test_func;
+    state.depth_write_enable = output_merger.depth_write_enable;
+    state.stencil_test_enable = output_merger.stencil_test.enable;
+    state.stencil_test_func = output_merger.stencil_test.func;
+
+    state.alphablend_enable = output_merger.alphablend_enable;
+    state.blend_equation_rgb = output_merger.alpha_blending.blend_equation_rgb;
+    state.blend_equation_a = output_merger.alpha_blending.blend_equation_a;
+    state.factor_source_rgb = output_merger.alpha_blending.factor_source_rgb;
+    state.factor_dest_rgb = output_merger.alpha_blending.factor_dest_rgb;
+    state.factor_source_a = output_merger.alpha_blending.factor_source_a;
+    state.factor_dest_a = output_merger.alpha_blending.factor_dest_a;
+    state.logic_op = output_merger.logic_op;
+    state.color_write_mask = output_merger.red_enable | output_merger.green_enable << 1 |
+                             output_merger.blue_enable << 2 | output_merger.alpha_enable << 3;
+
+    return res;
+}
+
+static bool IsKnownSource(TevStageConfig::Source source) {
+    using Source = TevStageConfig::Source;
+    switch (source) {
+    case Source::PrimaryColor:
+    case Source::PrimaryFragmentColor:
+    case Source::SecondaryFragmentColor:
+    case Source::Texture0:
+    case Source::Texture1:
+    case Source::Texture2:
+    case Source::Texture3:
+    case Source::PreviousBuffer:
+    case Source::Constant:
+    case Source::Previous:
+        return true;
+    default:
+        return false;
+    }
+}
+
+static bool IsKnownColorModifier(TevStageConfig::ColorModifier modifier) {
+    using ColorModifier = TevStageConfig::ColorModifier;
+    switch (modifier) {
+    case ColorModifier::SourceColor:
+    case ColorModifier::OneMinusSourceColor:
+    case ColorModifier::SourceAlpha:
+    case ColorModifier::OneMinusSourceAlpha:
+    case ColorModifier::SourceRed:
+    case ColorModifier::OneMinusSourceRed:
+    case ColorModifier::SourceGreen:
+    case ColorModifier::OneMinusSourceGreen:
+    case ColorModifier::SourceBlue:
+    case ColorModifier::OneMinusSourceBlue:
+        return true;
+    default:
+        return false;
+    }
+}
+
+static bool IsKnownOperation(TevStageConfig::Operation op, bool alpha) {
+    using Operation = TevStageConfig::Operation;
+    switch (op) {
+    case Operation::Replace:
+    case Operation::Modulate:
+    case Operation::Add:
+    case Operation::AddSigned:
+    case Operation::Lerp:
+    case Operation::Subtract:
+    case Operation::MultiplyThenAdd:
+    case Operation::AddThenMultiply:
+        return true;
+    case Operation::Dot3_RGB:
+    case Operation::Dot3_RGBA:
+        return !alpha;
+    default:
+        return false;
+    }
+}
+
+/// Returns whether the stage outputs the result of the previous stage unmodified
+static bool IsPassThroughStage(const TevStageConfig& stage) {
+    using Source = TevStageConfig::Source;
+    using Operation = TevStageConfig::Operation;
+    return stage.color_op == Operation::Replace && stage.alpha_op == Operation::Replace &&
+           stage.color_source1 == Source::Previous && stage.alpha_source1 == Source::Previous &&
+           stage.color_modifier1 == TevStageConfig::ColorModifier::SourceColor &&
+           stage.alpha_modifier1 == TevStageConfig::AlphaModifier::SourceAlpha &&
+           stage.GetColorMultiplier() == 1 && stage.GetAlphaMultiplier() == 1;
+}
+
+/// Returns the mask of comparison results the function passes for, see FragmentPipeline::Compare
+static u32 GetCompareMask(FramebufferRegs::CompareFunc func) {
+    switch (func) {
+    case FramebufferRegs::CompareFunc::Never:
+        return 0b000;
+    case FramebufferRegs::CompareFunc::Always:
+        return 0b111;
+    case FramebufferRegs::CompareFunc::Equal:
+        return 0b010;
+    case FramebufferRegs::CompareFunc::NotEqual:
+        return 0b101;
+    case FramebufferRegs::CompareFunc::LessThan:
+        return 0b001;
+    case FramebufferRegs::CompareFunc::LessThanOrEqual:
+        return 0b011;
+    case FramebufferRegs::CompareFunc::GreaterThan:
+        return 0b100;
+    case FramebufferRegs::CompareFunc::GreaterThanOrEqual:
+        return 0b110;
+    }
+    return 0b000;
+}
+
+FragmentPipeline::FragmentPipeline(const FragmentPipelineConfig& config) {
+    const auto& state = config.state;
+
+    std::array<TevStageConfig, 6> tev_stages;
+    for (std::size_t i = 0; i < tev_stages.size(); ++i) {
+        tev_stages[i].sources_raw = state.tev_stages[i].sources_raw;
+        tev_stages[i].modifiers_raw = state.tev_stages[i].modifiers_raw;
+        tev_stages[i].ops_raw = state.tev_stages[i].ops_raw;
+        tev_stages[i].const_color = 0;
+        tev_stages[i].scales_raw = state.tev_stages[i].scales_raw;
+    }
+
+    // Stages after the last one which does any work can't affect the output. Buffer updates
+    // don't matter here, as there is no later stage left to read the buffer.
+    num_stages = tev_stages.size();
+    while (num_stages > 0 && IsPassThroughStage(tev_stages[num_stages - 1])) {
+        --num_stages;
+    }
+
+    for (std::size_t i = 0; i < num_stages; ++i) {
+        const auto& tev_stage = tev_stages[i];
+        auto& stage = stages[i];
+
+        stage.color_sources = {static_cast<u8>(tev_stage.color_source1.Value()),
+                               static_cast<u8>(tev_stage.color_source2.Value()),
+                               static_cast<u8>(tev_stage.color_source3.Value())};
+        stage.alpha_sources = {static_cast<u8>(tev_stage.alpha_source1.Value()),
+                               static_cast<u8>(tev_stage.alpha_source2.Value()),
+                               static_cast<u8>(tev_stage.alpha_source3.Value())};
+        stage.color_modifiers = {tev_stage.color_modifier1, tev_stage.color_modifier2,
+                                 tev_stage.color_modifier3};
+        stage.alpha_modifiers = {tev_stage.alpha_modifier1, tev_stage.alpha_modifier2,
+                                 tev_stage.alpha_modifier3};
+        stage.color_op = tev_stage.color_op;
+        stage.alpha_op = tev_stage.alpha_op;
+        stage.color_multiplier = tev_stage.GetColorMultiplier();
+        stage.alpha_multiplier = tev_stage.GetAlphaMultiplier();
+        stage.updates_buffer_color = i < 4 && (state.combiner_buffer_input & (1 << i)) != 0;
+        stage.updates_buffer_alpha = i < 4 && (state.combiner_buffer_input & (0x10 << i)) != 0;
+
+        const bool uses_alpha_combiner =
+            stage.color_op != TevStageConfig::Operation::Dot3_RGBA;
+        for (std::size_t j = 0; j < 3; ++j) {
+            supported &= IsKnownSource(static_cast<TevStageConfig::Source>(stage.color_sources[j]));
+            supported &= IsKnownColorModifier(stage.color_modifiers[j]);
+            if (uses_alpha_combiner) {
+                supported &=
+                    IsKnownSource(static_cast<TevStageConfig::Source>(stage.alpha_sources[j]));
+            }
+        }
+        supported &= IsKnownOperation(stage.color_op, false);
+        if (uses_alpha_combiner) {
+            supported &= IsKnownOperation(stage.alpha_op, true);
+        }
+    }
+
+    const u32 alpha_test_mask = GetCompareMask(state.alpha_test_func);
+    for (u32 alpha = 0; alpha < alpha_test_pass.size(); ++alpha) {
+        alpha_test_pass[alpha] = Compare(alpha_test_mask, alpha, state.alpha_test_ref);
+    }
+
+    stencil_test_enable = state.stencil_test_enable != 0 &&
+                          state.depth_format == FramebufferRegs::DepthFormat::D24S8;
+    stencil_test_mask = GetCompareMask(state.stencil_test_func);
+    depth_test_enable = state.depth_test_enable != 0;
+    depth_test_mask = GetCompareMask(state.depth_test_func);
+    depth_write_enable = state.allow_depth_stencil_write != 0 && state.depth_write_enable != 0;
+    stencil_write_enable = state.allow_depth_stencil_write != 0;
+    color_write_enable = state.allow_color_write != 0;
+
+    switch (state.color_format) {
+    case FramebufferRegs::ColorFormat::RGBA8:
+        color_bytes_per_pixel = 4;
+        decode_color = Color::DecodeRGBA8;
+        encode_color = Color::EncodeRGBA8;
+        break;
+    case FramebufferRegs::ColorFormat::RGB8:
+        color_bytes_per_pixel = 3;
+        decode_color = Color::DecodeRGB8;
+        encode_color = Color::EncodeRGB8;
+        break;
+    case FramebufferRegs::ColorFormat::RGB5A1:
+        color_bytes_per_pixel = 2;
+        decode_color = Color::DecodeRGB5A1;
+        encode_color = Color::EncodeRGB5A1;
+        break;
+    case FramebufferRegs::ColorFormat::RGB565:
+        color_bytes_per_pixel = 2;
+        decode_color = Color::DecodeRGB565;
+        encode_color = Color::EncodeRGB565;
+        break;
+    case FramebufferRegs::ColorFormat::RGBA4:
+        color_bytes_per_pixel = 2;
+        decode_color = Color::DecodeRGBA4;
+        encode_color = Color::EncodeRGBA4;
+        break;
+    default:
+        LOG_CRITICAL(Render_Software, "Unknown framebuffer color format {:x}",
+                     static_cast<u32>(state.color_format));
+        UNIMPLEMENTED();
+        color_bytes_per_pixel = 0;
+        decode_color = [](const u8*) { return Common::Vec4<u8>{0, 0, 0, 0}; };
+        encode_color = [](const Common::Vec4<u8>&, u8*) {};
+        break;
+    }
+
+    switch (state.depth_format) {
+    case FramebufferRegs::DepthFormat::D16:
+        depth_bytes_per_pixel = 2;
+        max_depth = 0xFFFF;
+        decode_depth = Color::DecodeD16;
+        encode_depth = Color::EncodeD16;
+        break;
+    case FramebufferRegs::DepthFormat::D24:
+        depth_bytes_per_pixel = 3;
+        max_depth = 0xFFFFFF;
+        decode_depth = Color::DecodeD24;
+        encode_depth = Color::EncodeD24;
+        break;
+    case FramebufferRegs::DepthFormat::D24S8:
+        depth_bytes_per_pixel = 4;
+        max_depth = 0xFFFFFF;
+        decode_depth = [](const u8* pixel) { return Color::DecodeD24S8(pixel).x; };
+        encode_depth = Color::EncodeD24X8;
+        break;
+    default:
+        LOG_CRITICAL(HW_GPU, "Unimplemented depth format {}",
+                     static_cast<u32>(state.depth_format));
+        UNIMPLEMENTED();
+        depth_bytes_per_pixel = 0;
+        max_depth = 0;
+        decode_depth = [](const u8*) { return 0u; };
+        encode_depth = [](u32, u8*) {};
+        break;
+    }
+
+    // Each blend factor is a channel of one of the inputs, inverted for the OneMinus factors
+    auto DecodeBlendFactor = [](FramebufferRegs::BlendFactor factor) -> BlendFactorSource {
+        using BlendFactor = FramebufferRegs::BlendFactor;
+        switch (factor) {
+        case BlendFactor::Zero:
+            return {BlendInput::Zero, 0x00};
+        case BlendFactor::One:
+            return {BlendInput::Zero, 0xFF};
+        case BlendFactor::SourceColor:
+            return {BlendInput::SourceColor, 0x00};
+        case BlendFactor::OneMinusSourceColor:
+            return {BlendInput::SourceColor, 0xFF};
+        case BlendFactor::DestColor:
+            return {BlendInput::DestColor, 0x00};
+        case BlendFactor::OneMinusDestColor:
+            return {BlendInput::DestColor, 0xFF};
+        case BlendFactor::SourceAlpha:
+            return {BlendInput::SourceAlpha, 0x00};
+        case BlendFactor::OneMinusSourceAlpha:
+            return {BlendInput::SourceAlpha, 0xFF};
+        case BlendFactor::DestAlpha:
+            return {BlendInput::DestAlpha, 0x00};
+        case BlendFactor::OneMinusDestAlpha:
+            return {BlendInput::DestAlpha, 0xFF};
+        case BlendFactor::ConstantColor:
+            return {BlendInput::ConstantColor, 0x00};
+        case BlendFactor::OneMinusConstantColor:
+            return {BlendInput::ConstantColor, 0xFF};
+        case BlendFactor::ConstantAlpha:
+            return {BlendInput::ConstantAlpha, 0x00};
+        case BlendFactor::OneMinusConstantAlpha:
+            return {BlendInput::ConstantAlpha, 0xFF};
+        case BlendFactor::SourceAlphaSaturate:
+            return {BlendInput::SourceAlphaSaturate, 0x00};
+        default:
+            LOG_CRITICAL(HW_GPU, "Unknown blend factor {:x}", static_cast<u32>(factor));
+            UNIMPLEMENTED();
+            return {BlendInput::SourceColor, 0x00};
+        }
+    };
+
+    alphablend_enable = state.alphablend_enable != 0;
+    if (alphablend_enable) {
+        const auto source_rgb = DecodeBlendFactor(state.factor_source_rgb);
+        const auto dest_rgb = DecodeBlendFactor(state.factor_dest_rgb);
+        source_factors = {source_rgb, source_rgb, source_rgb,
+                          DecodeBlendFactor(state.factor_source_a)};
+        dest_factors = {dest_rgb, dest_rgb, dest_rgb, DecodeBlendFactor(state.factor_dest_a)};
+    }
+    blend_equation_rgb = state.blend_equation_rgb;
+    blend_equation_a = state.blend_equation_a;
+    logic_op = state.logic_op;
+
+    for (std::size_t i = 0; i < 4; ++i) {
+        color_write_mask[i] = (state.color_write_mask & (1 << i)) != 0 ? 0xFF : 0x00;
+    }
+}
+
+Common::Vec4<u8> FragmentPipeline::CombineTev(TevSources& sources,
+                                              const std::array<Common::Vec4<u8>, 6>& constants,
+                                              const Common::Vec4<u8>& buffer_color) const {
+    using Source = TevStageConfig::Source;
+
+    Common::Vec4<u8> combiner_output = {0, 0, 0, 0};
+    Common::Vec4<u8> combiner_buffer = {0, 0, 0, 0};
+    Common::Vec4<u8> next_combiner_buffer = buffer_color;
+
+    for (std::size_t i = 0; i < num_stages; ++i) {
+        const auto& stage = stages[i];
+
+        sources[static_cast<std::size_t>(Source::PreviousBuffer)] = combiner_buffer;
+        sources[static_cast<std::size_t>(Source::Constant)] = constants[i];
+        sources[static_cast<std::size_t>(Source::Previous)] = combiner_output;
+
+        const Common::Vec3<u8> color_result[3] = {
+            GetColorModifier(stage.color_modifiers[0], sources[stage.color_sources[0]]),
+            GetColorModifier(stage.color_modifiers[1], sources[stage.color_sources[1]]),
+            GetColorModifier(stage.color_modifiers[2], sources[stage.color_sources[2]]),
+        };
+        const auto color_output = ColorCombine(stage.color_op, color_result);
+
+        u8 alpha_output;
+        if (stage.color_op == TevStageConfig::Operation::Dot3_RGBA) {
+            // result of Dot3_RGBA operation is also placed to the alpha component
+            alpha_output = color_output.x;
+        } else {
+            const std::array<u8, 3> alpha_result = {{
+                GetAlphaModifier(stage.alpha_modifiers[0], sources[stage.alpha_sources[0]]),
+                GetAlphaModifier(stage.alpha_modifiers[1], sources[stage.alpha_sources[1]]),
+                GetAlphaModifier(stage.alpha_modifiers[2], sources[stage.alpha_sources[2]]),
+            }};
+            alpha_output = AlphaCombine(stage.alpha_op, alpha_result);
+        }
+
+        combiner_output[0] = std::min(255u, color_output.r() * stage.color_multiplier);
+        combiner_output[1] = std::min(255u, color_output.g() * stage.color_multiplier);
+        combiner_output[2] = std::min(255u, color_output.b() * stage.color_multiplier);
+        combiner_output[3] = std::min(255u, alpha_output * stage.alpha_multiplier);
+
+        combiner_buffer = next_combiner_buffer;
+
+        if (stage.updates_buffer_color) {
+            next_combiner_buffer.r() = combiner_output.r();
+            next_combiner_buffer.g() = combiner_output.g();
+            next_combiner_buffer.b() = combiner_output.b();
+        }
+
+        if (stage.updates_buffer_alpha) {
+            next_combiner_buffer.a() = combiner_output.a();
+        }
+    }
+
+    return combiner_output;
+}
+
+Common::Vec4<u8> FragmentPipeline::Blend(const Common::Vec4<u8>& source,
+                                         const Common::Vec4<u8>& dest,
+                                         const Common::Vec4<u8>& blend_const) const {
+    Common::Vec4<u8> blend_output;
+    if (alphablend_enable) {
+        const u8 saturate = std::min(source.a(), static_cast<u8>(255 - dest.a()));
+        const std::array<Common::Vec4<u8>, static_cast<std::size_t>(BlendInput::Count)> inputs{{
+            {0, 0, 0, 0},
+            source,
+            dest,
+            {source.a(), source.a(), source.a(), source.a()},
+            {dest.a(), dest.a(), dest.a(), dest.a()},
+            blend_const,
+            {blend_const.a(), blend_const.a(), blend_const.a(), blend_const.a()},
+            // Returns 1.0 for the alpha channel
+            {saturate, saturate, saturate, 255},
+        }};
+
+        Common::Vec4<u8> source_factor;
+        Common::Vec4<u8> dest_factor;
+        for (std::size_t i = 0; i < 4; ++i) {
+            const auto& source_input = inputs[static_cast<std::size_t>(source_factors[i].input)];
+            const auto& dest_input = inputs[static_cast<std::size_t>(dest_factors[i].input)];
+            source_factor[i] = source_input[i] ^ source_factors[i].invert_mask;
+            dest_factor[i] = dest_input[i] ^ dest_factors[i].invert_mask;
+        }
+
+        blend_output =
+            EvaluateBlendEquation(source, source_factor, dest, dest_factor, blend_equation_rgb);
+        blend_output.a() =
+            EvaluateBlendEquation(source, source_factor, dest, dest_factor, blend_equation_a).a();
+    } else {
+        blend_output = Common::MakeVec(LogicOp(source.r(), dest.r(), logic_op),
+                                       LogicOp(source.g(), dest.g(), logic_op),
+                                       LogicOp(source.b(), dest.b(), logic_op),
+                                       LogicOp(source.a(), dest.a(), logic_op));
+    }
+
+    for (std::size_t i = 0; i < 4; ++i) {
+        blend_output[i] =
+            (blend_output[i] & color_write_mask[i]) | (dest[i] & ~color_write_mask[i]);
+    }
+    return blend_output;
+}
+
+const FragmentPipeline& GetFragmentPipeline(const Pica::Regs& regs) {
+    static std::mutex cache_mutex;
+    static std::unordered_map<FragmentPipelineConfig, std::unique_ptr<FragmentPipeline>> cache;
+
+    // Consecutive triangles almost always share their configuration, so remember the last
+    // pipeline per thread to avoid taking the lock for each of them
+    thread_local FragmentPipelineConfig last_config;
+    thread_local const FragmentPipeline* last_pipeline = nullptr;
+
+    const auto config = FragmentPipelineConfig::BuildFromRegs(regs);
+    if (last_pipeline != nullptr && config == last_config) {
+        return *last_pipeline;
+    }
+
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    auto& pipeline = cache[config];
+    if (!pipeline) {
+        MICROPROFILE_SCOPE(GPU_FragmentPipeline);
+        pipeline = std::make_unique<FragmentPipeline>(config);
+        if (!pipeline->IsSupported()) {
+            LOG_DEBUG(HW_GPU, "Fragment pipeline {:016x} not supported, using fallback path",
+                      config.Hash());
+        }
+    }
+
+    last_config = config;
+    last_pipeline = pipeline.get();
+    return *last_pipeline;
+}
+
+} // namespace Pica::Rasterizer
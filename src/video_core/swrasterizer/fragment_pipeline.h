@@ -0,0 +1,256 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <functional>
+#include "common/common_types.h"
+#include "common/hash.h"
+#include "common/vector_math.h"
+#include "video_core/regs_framebuffer.h"
+#include "video_core/regs_texturing.h"
+
+namespace Pica {
+struct Regs;
+}
+
+namespace Pica::Rasterizer {
+
+// Doesn't include const_color, which varies a lot between draws. It is passed to the pipeline
+// separately instead.
+struct TevStageConfigRaw {
+    u32 sources_raw;
+    u32 modifiers_raw;
+    u32 ops_raw;
+    u32 scales_raw;
+};
+
+struct FragmentPipelineConfigState {
+    std::array<TevStageConfigRaw, 6> tev_stages;
+    u32 combiner_buffer_input;
+    FramebufferRegs::CompareFunc alpha_test_func;
+    u32 alpha_test_ref;
+
+    FramebufferRegs::ColorFormat color_format;
+    FramebufferRegs::DepthFormat depth_format;
+    u32 allow_color_write;
+    u32 allow_depth_stencil_write;
+
+    u32 depth_test_enable;
+    FramebufferRegs::CompareFunc depth_test_func;
+    u32 depth_write_enable;
+    u32 stencil_test_enable;
+    FramebufferRegs::CompareFunc stencil_test_func;
+
+    u32 alphablend_enable;
+    FramebufferRegs::BlendEquation blend_equation_rgb;
+    FramebufferRegs::BlendEquation blend_equation_a;
+    FramebufferRegs::BlendFactor factor_source_rgb;
+    FramebufferRegs::BlendFactor factor_dest_rgb;
+    FramebufferRegs::BlendFactor factor_source_a;
+    FramebufferRegs::BlendFactor factor_dest_a;
+    FramebufferRegs::LogicOp logic_op;
+    u32 color_write_mask;
+};
+
+/**
+ * This struct contains all register state the software FragmentPipeline is specialized for, and
+ * is used as the key of the pipeline cache.
+ */
+struct FragmentPipelineConfig : Common::HashableStruct<FragmentPipelineConfigState> {
+    /// Construct a FragmentPipelineConfig with the given Pica register configuration.
+    static FragmentPipelineConfig BuildFromRegs(const Pica::Regs& regs);
+};
+
+/// Fragment inputs of the texture combiners, indexed by TevStageConfig::Source
+using TevSources = std::array<Common::Vec4<u8>, 16>;
+
+/**
+ * The fixed-function stages of the software fragment pipeline, decoded once for a specific
+ * register configuration. Compared to evaluating the registers directly, combiner sources and
+ * blend factors become plain table lookups, trailing pass-through combiner stages are dropped, the
+ * alpha, stencil and depth tests become bit tests, and the framebuffer formats are resolved to
+ * conversion functions.
+ *
+ * The stages are only pre-decoded, no code is generated for them. Lighting and fog aren't part of
+ * the pipeline and still evaluate the registers.
+ */
+class FragmentPipeline {
+public:
+    explicit FragmentPipeline(const FragmentPipelineConfig& config);
+
+    /// Returns false if the texture combiners use unknown inputs or operations, in which case the
+    /// register-driven combiner path must be used. The other stages are always available.
+    bool IsSupported() const {
+        return supported;
+    }
+
+    /**
+     * Runs the texture combiners.
+     * @param sources Fragment inputs, the Previous, PreviousBuffer and Constant entries are
+     *                overwritten while running the stages
+     * @param constants Constant color of each stage
+     * @param buffer_color Initial color of the combiner buffer
+     */
+    Common::Vec4<u8> CombineTev(TevSources& sources,
+                                const std::array<Common::Vec4<u8>, 6>& constants,
+                                const Common::Vec4<u8>& buffer_color) const;
+
+    bool AlphaTestPasses(u8 alpha) const {
+        return alpha_test_pass[alpha];
+    }
+
+    /// Returns whether stencil testing and updates apply, which requires a D24S8 depth buffer
+    bool IsStencilTestEnabled() const {
+        return stencil_test_enable;
+    }
+
+    bool StencilTestPasses(u8 ref, u8 dest) const {
+        return Compare(stencil_test_mask, ref, dest);
+    }
+
+    bool IsDepthTestEnabled() const {
+        return depth_test_enable;
+    }
+
+    bool DepthTestPasses(u32 z, u32 ref_z) const {
+        return Compare(depth_test_mask, z, ref_z);
+    }
+
+    bool IsDepthWriteEnabled() const {
+        return depth_write_enable;
+    }
+
+    bool IsStencilWriteEnabled() const {
+        return stencil_write_enable;
+    }
+
+    bool IsColorWriteEnabled() const {
+        return color_write_enable;
+    }
+
+    /// Largest value of the depth buffer format, fragment depths in [0, 1] are scaled by it
+    u32 GetMaxDepth() const {
+        return max_depth;
+    }
+
+    u32 GetColorBytesPerPixel() const {
+        return color_bytes_per_pixel;
+    }
+
+    u32 GetDepthBytesPerPixel() const {
+        return depth_bytes_per_pixel;
+    }
+
+    Common::Vec4<u8> ReadColor(const u8* pixel) const {
+        return decode_color(pixel);
+    }
+
+    void WriteColor(const Common::Vec4<u8>& color, u8* pixel) const {
+        encode_color(color, pixel);
+    }
+
+    u32 ReadDepth(const u8* pixel) const {
+        return decode_depth(pixel);
+    }
+
+    void WriteDepth(u32 depth, u8* pixel) const {
+        encode_depth(depth, pixel);
+    }
+
+    /**
+     * Combines the fragment color with the framebuffer color, using either alpha blending or the
+     * logic op, then applies the color write mask.
+     * @param source Output color of the texture combiners
+     * @param dest Current framebuffer color
+     * @param blend_const Constant blend color
+     */
+    Common::Vec4<u8> Blend(const Common::Vec4<u8>& source, const Common::Vec4<u8>& dest,
+                           const Common::Vec4<u8>& blend_const) const;
+
+private:
+    /// Values a blend factor can be taken from
+    enum class BlendInput : u8 {
+        Zero,
+        SourceColor,
+        DestColor,
+        SourceAlpha,
+        DestAlpha,
+        ConstantColor,
+        ConstantAlpha,
+        SourceAlphaSaturate,
+        Count,
+    };
+
+    /// Blend factor of one channel, which is the input channel, optionally inverted
+    struct BlendFactorSource {
+        BlendInput input;
+        u8 invert_mask;
+    };
+
+    /**
+     * Evaluates a comparison against a mask of the results it passes for. Bit 0 of the mask is
+     * for a < b, bit 1 for a == b and bit 2 for a > b.
+     */
+    static bool Compare(u32 mask, u32 a, u32 b) {
+        return ((mask >> ((a >= b) + (a > b))) & 1) != 0;
+    }
+
+    struct Stage {
+        std::array<u8, 3> color_sources;
+        std::array<u8, 3> alpha_sources;
+        std::array<TexturingRegs::TevStageConfig::ColorModifier, 3> color_modifiers;
+        std::array<TexturingRegs::TevStageConfig::AlphaModifier, 3> alpha_modifiers;
+        TexturingRegs::TevStageConfig::Operation color_op;
+        TexturingRegs::TevStageConfig::Operation alpha_op;
+        u32 color_multiplier;
+        u32 alpha_multiplier;
+        bool updates_buffer_color;
+        bool updates_buffer_alpha;
+    };
+
+    bool supported = true;
+    std::array<Stage, 6> stages;
+    std::size_t num_stages = 0;
+    std::array<bool, 256> alpha_test_pass;
+
+    bool stencil_test_enable;
+    u32 stencil_test_mask;
+    bool depth_test_enable;
+    u32 depth_test_mask;
+    bool depth_write_enable;
+    bool stencil_write_enable;
+    bool color_write_enable;
+
+    u32 max_depth;
+    u32 color_bytes_per_pixel;
+    u32 depth_bytes_per_pixel;
+    Common::Vec4<u8> (*decode_color)(const u8* pixel);
+    void (*encode_color)(const Common::Vec4<u8>& color, u8* pixel);
+    u32 (*decode_depth)(const u8* pixel);
+    void (*encode_depth)(u32 depth, u8* pixel);
+
+    bool alphablend_enable;
+    std::array<BlendFactorSource, 4> source_factors;
+    std::array<BlendFactorSource, 4> dest_factors;
+    FramebufferRegs::BlendEquation blend_equation_rgb;
+    FramebufferRegs::BlendEquation blend_equation_a;
+    FramebufferRegs::LogicOp logic_op;
+    Common::Vec4<u8> color_write_mask;
+};
+
+/// Returns the fragment pipeline for the given register state, building it if necessary
+const FragmentPipeline& GetFragmentPipeline(const Pica::Regs& regs);
+
+} // namespace Pica::Rasterizer
+
+namespace std {
+template <>
+struct hash<Pica::Rasterizer::FragmentPipelineConfig> {
+    std::size_t operator()(const Pica::Rasterizer::FragmentPipelineConfig& k) const {
+        return k.Hash();
+    }
+};
+} // namespace std
@@ -39,6 +39,20 @@ struct Vertex : Shader::OutputVertex {
     }
 };
 
+/// Pixel-space rectangle [x0, x1) x [y0, y1), used to restrict rasterization to a screen tile
+struct TileRect {
+    u32 x0;
+    u32 y0;
+    u32 x1;
+    u32 y1;
+};
+
 void ProcessTriangle(const Vertex& v0, const Vertex& v1, const Vertex& v2);
 
+/// Only rasterizes the fragments of the given triangle which lie inside the given tile
+void ProcessTriangle(const Vertex& v0, const Vertex& v1, const Vertex& v2, const TileRect& tile);
+
+/// Returns a conservative pixel-space bounding box of the fragments covered by the triangle
+TileRect GetTriangleBounds(const Vertex& v0, const Vertex& v1, const Vertex& v2);
+
 } // namespace Pica::Rasterizer
@@ -2,15 +2,222 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include "common/microprofile.h"
+#include "common/thread_pool.h"
+#include "core/memory.h"
+#include "video_core/pica_state.h"
+#include "video_core/regs_framebuffer.h"
+#include "video_core/regs_texturing.h"
 #include "video_core/swrasterizer/clipper.h"
 #include "video_core/swrasterizer/swrasterizer.h"
+#include "video_core/swrasterizer/texture_cache.h"
+#include "video_core/video_core.h"
 
 namespace VideoCore {
 
+using Pica::Rasterizer::TileRect;
+using Pica::Rasterizer::Vertex;
+
+MICROPROFILE_DEFINE(GPU_Binning, "GPU", "Triangle Binning", MP_RGB(50, 50, 240));
+
+static std::unique_ptr<Common::ThreadPool> CreateThreadPool() {
+    std::size_t num_threads = g_sw_rasterizer_threads;
+    if (num_threads == 0) {
+        num_threads = Common::ThreadPool::GetHardwareThreadCount();
+    }
+
+    // A single thread gains nothing from binning, so rasterize immediately in that case
+    if (num_threads <= 1) {
+        return nullptr;
+    }
+    return std::make_unique<Common::ThreadPool>(num_threads, "SwRasterizer");
+}
+
+SWRasterizer::SWRasterizer() : thread_pool(CreateThreadPool()) {}
+
+SWRasterizer::~SWRasterizer() = default;
+
 void SWRasterizer::AddTriangle(const Pica::Shader::OutputVertex& v0,
                                const Pica::Shader::OutputVertex& v1,
                                const Pica::Shader::OutputVertex& v2) {
-    Pica::Clipper::ProcessTriangle(v0, v1, v2);
+    if (!thread_pool) {
+        Pica::Clipper::ProcessTriangle(v0, v1, v2);
+        return;
+    }
+
+    Pica::Clipper::ProcessTriangle(
+        v0, v1, v2, [this](const Vertex& vtx0, const Vertex& vtx1, const Vertex& vtx2) {
+            triangle_queue.push_back(
+                {vtx0, vtx1, vtx2, Pica::Rasterizer::GetTriangleBounds(vtx0, vtx1, vtx2)});
+        });
+}
+
+void SWRasterizer::DrawTriangles() {
+    FlushTriangleQueue();
+    Pica::Rasterizer::FinishTextureCacheDraw();
+
+    // The fragments were written straight to memory, assume the largest pixel size for both buffers
+    const auto& framebuffer = Pica::g_state.regs.framebuffer.framebuffer;
+    const u32 buffer_size = framebuffer.GetWidth() * framebuffer.GetHeight() * 4;
+    g_memory->MarkRegionDirty(framebuffer.GetColorBufferPhysicalAddress(), buffer_size);
+    g_memory->MarkRegionDirty(framebuffer.GetDepthBufferPhysicalAddress(), buffer_size);
+
+    // Pick up changes to the thread count setting between batches
+    const std::size_t current_threads = thread_pool ? thread_pool->GetThreadCount() : 1;
+    const std::size_t wanted_threads =
+        g_sw_rasterizer_threads == 0 ? Common::ThreadPool::GetHardwareThreadCount()
+                                     : g_sw_rasterizer_threads.load();
+    if (std::max<std::size_t>(wanted_threads, 1) != current_threads) {
+        thread_pool = CreateThreadPool();
+    }
+}
+
+// Queued triangles are always drawn by the end of a batch, the flushes below only make sure that
+// the framebuffer memory is up to date should a region be accessed in the middle of one.
+
+void SWRasterizer::FlushAll() {
+    FlushTriangleQueue();
+}
+
+void SWRasterizer::FlushRegion(PAddr addr, u32 size) {
+    FlushTriangleQueue();
+}
+
+void SWRasterizer::InvalidateRegion(PAddr addr, u32 size) {
+    FlushTriangleQueue();
+    Pica::Rasterizer::InvalidateDecodedTextures(addr, size);
+}
+
+void SWRasterizer::FlushAndInvalidateRegion(PAddr addr, u32 size) {
+    FlushTriangleQueue();
+    Pica::Rasterizer::InvalidateDecodedTextures(addr, size);
+}
+
+bool SWRasterizer::CanRasterizeInParallel(const TileRect& bounds) const {
+    const auto& regs = Pica::g_state.regs;
+    const auto& framebuffer = regs.framebuffer.framebuffer;
+
+    // Pixels outside of the framebuffer alias other pixels in memory, so only triangles which
+    // stay inside of it are guaranteed to touch disjoint memory in different tiles.
+    if (bounds.x1 > framebuffer.GetWidth() || bounds.y1 > framebuffer.GetHeight()) {
+        return false;
+    }
+
+    // Assume the largest pixel size for both buffers, this also covers shadow map rendering
+    const u32 buffer_size = framebuffer.GetWidth() * framebuffer.GetHeight() * 4;
+    const PAddr color_begin = framebuffer.GetColorBufferPhysicalAddress();
+    const PAddr depth_begin = framebuffer.GetDepthBufferPhysicalAddress();
+
+    auto Overlaps = [](PAddr begin_a, u32 size_a, PAddr begin_b, u32 size_b) {
+        return begin_a < begin_b + size_b && begin_b < begin_a + size_a;
+    };
+
+    if (Overlaps(color_begin, buffer_size, depth_begin, buffer_size)) {
+        return false;
+    }
+
+    // A draw sampling from its own render target depends on the exact order in which the
+    // fragments are written, which is only preserved within a tile.
+    const auto textures = regs.texturing.GetTextures();
+    for (std::size_t i = 0; i < textures.size(); ++i) {
+        const auto& texture = textures[i];
+        if (!texture.enabled) {
+            continue;
+        }
+
+        const u32 size = Pica::TexturingRegs::NibblesPerPixel(texture.format) *
+                         texture.config.width * texture.config.height / 2;
+
+        std::vector<PAddr> addresses{texture.config.GetPhysicalAddress()};
+        if (i == 0 && (texture.config.type == Pica::TexturingRegs::TextureConfig::TextureCube ||
+                       texture.config.type == Pica::TexturingRegs::TextureConfig::ShadowCube)) {
+            using CubeFace = Pica::TexturingRegs::CubeFace;
+            for (auto face : {CubeFace::PositiveX, CubeFace::NegativeX, CubeFace::PositiveY,
+                              CubeFace::NegativeY, CubeFace::PositiveZ, CubeFace::NegativeZ}) {
+                addresses.push_back(regs.texturing.GetCubePhysicalAddress(face));
+            }
+        }
+
+        for (PAddr address : addresses) {
+            if (Overlaps(address, size, color_begin, buffer_size) ||
+                Overlaps(address, size, depth_begin, buffer_size)) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+void SWRasterizer::FlushTriangleQueue() {
+    if (triangle_queue.empty()) {
+        return;
+    }
+
+    TileRect bounds{~0u, ~0u, 0, 0};
+    for (const auto& triangle : triangle_queue) {
+        bounds.x0 = std::min(bounds.x0, triangle.bounds.x0);
+        bounds.y0 = std::min(bounds.y0, triangle.bounds.y0);
+        bounds.x1 = std::max(bounds.x1, triangle.bounds.x1);
+        bounds.y1 = std::max(bounds.y1, triangle.bounds.y1);
+    }
+
+    if (!CanRasterizeInParallel(bounds)) {
+        for (const auto& triangle : triangle_queue) {
+            Pica::Rasterizer::ProcessTriangle(triangle.v0, triangle.v1, triangle.v2);
+        }
+        triangle_queue.clear();
+        return;
+    }
+
+    // Bin the triangles into screen tiles. Each bin lists its triangles in submission order, so
+    // every pixel still sees its fragments in the same order as on the sequential path.
+    const u32 tiles_x = (bounds.x1 + TILE_SIZE - 1) / TILE_SIZE;
+    const u32 tiles_y = (bounds.y1 + TILE_SIZE - 1) / TILE_SIZE;
+    {
+        MICROPROFILE_SCOPE(GPU_Binning);
+        if (tile_bins.size() < tiles_x * tiles_y) {
+            tile_bins.resize(tiles_x * tiles_y);
+        }
+
+        for (u32 index = 0; index < triangle_queue.size(); ++index) {
+            const TileRect& rect = triangle_queue[index].bounds;
+            if (rect.x0 >= rect.x1 || rect.y0 >= rect.y1) {
+                continue;
+            }
+
+            for (u32 tile_y = rect.y0 / TILE_SIZE; tile_y <= (rect.y1 - 1) / TILE_SIZE; ++tile_y) {
+                for (u32 tile_x = rect.x0 / TILE_SIZE; tile_x <= (rect.x1 - 1) / TILE_SIZE;
+                     ++tile_x) {
+                    auto& bin = tile_bins[tile_y * tiles_x + tile_x];
+                    if (bin.empty()) {
+                        active_tiles.push_back(tile_y * tiles_x + tile_x);
+                    }
+                    bin.push_back(index);
+                }
+            }
+        }
+    }
+
+    thread_pool->ParallelFor(active_tiles.size(), [&](std::size_t i) {
+        const u32 tile_index = active_tiles[i];
+        const u32 tile_x = tile_index % tiles_x;
+        const u32 tile_y = tile_index / tiles_x;
+        const TileRect tile{tile_x * TILE_SIZE, tile_y * TILE_SIZE, (tile_x + 1) * TILE_SIZE,
+                            (tile_y + 1) * TILE_SIZE};
+
+        for (u32 index : tile_bins[tile_index]) {
+            const auto& triangle = triangle_queue[index];
+            Pica::Rasterizer::ProcessTriangle(triangle.v0, triangle.v1, triangle.v2, tile);
+        }
+    });
+
+    for (u32 tile_index : active_tiles) {
+        tile_bins[tile_index].clear();
+    }
+    active_tiles.clear();
+    triangle_queue.clear();
 }
 
 } // namespace VideoCore
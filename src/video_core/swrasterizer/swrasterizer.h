@@ -4,8 +4,15 @@
 
 #pragma once
 
+#include <memory>
+#include <vector>
 #include "common/common_types.h"
 #include "video_core/rasterizer_interface.h"
+#include "video_core/swrasterizer/rasterizer.h"
+
+namespace Common {
+class ThreadPool;
+} // namespace Common
 
 namespace Pica::Shader {
 struct OutputVertex;
@@ -14,14 +21,45 @@ struct OutputVertex;
 namespace VideoCore {
 
 class SWRasterizer : public RasterizerInterface {
+public:
+    SWRasterizer();
+    ~SWRasterizer() override;
+
     void AddTriangle(const Pica::Shader::OutputVertex& v0, const Pica::Shader::OutputVertex& v1,
                      const Pica::Shader::OutputVertex& v2) override;
-    void DrawTriangles() override {}
+    void DrawTriangles() override;
     void NotifyPicaRegisterChanged(u32 id) override {}
-    void FlushAll() override {}
-    void FlushRegion(PAddr addr, u32 size) override {}
-    void InvalidateRegion(PAddr addr, u32 size) override {}
-    void FlushAndInvalidateRegion(PAddr addr, u32 size) override {}
+    void FlushAll() override;
+    void FlushRegion(PAddr addr, u32 size) override;
+    void InvalidateRegion(PAddr addr, u32 size) override;
+    void FlushAndInvalidateRegion(PAddr addr, u32 size) override;
+    bool SupportsGPUThread() const override {
+        return true;
+    }
+
+private:
+    struct Triangle {
+        Pica::Rasterizer::Vertex v0;
+        Pica::Rasterizer::Vertex v1;
+        Pica::Rasterizer::Vertex v2;
+        Pica::Rasterizer::TileRect bounds;
+    };
+
+    /// Width and height in pixels of the screen tiles triangles are binned into
+    static constexpr u32 TILE_SIZE = 32;
+
+    /// Returns whether the queued triangles can be rasterized tile by tile in parallel
+    bool CanRasterizeInParallel(const Pica::Rasterizer::TileRect& bounds) const;
+
+    /// Rasterizes all queued triangles, then clears the queue
+    void FlushTriangleQueue();
+
+    /// Worker pool for the binned rasterizer, null if triangles are rasterized immediately
+    std::unique_ptr<Common::ThreadPool> thread_pool;
+
+    std::vector<Triangle> triangle_queue;
+    std::vector<std::vector<u32>> tile_bins;
+    std::vector<u32> active_tiles;
 };
 
 } // namespace VideoCore
@@ -0,0 +1,152 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+#include "common/hash.h"
+#include "common/logging/log.h"
+#include "common/microprofile.h"
+#include "core/memory.h"
+#include "video_core/swrasterizer/texture_cache.h"
+#include "video_core/texture/texture_decode.h"
+#include "video_core/video_core.h"
+
+namespace Pica::Rasterizer {
+
+MICROPROFILE_DEFINE(GPU_TextureDecode, "GPU", "Texture Decoding", MP_RGB(100, 100, 255));
+
+TextureCacheKey TextureCacheKey::FromTextureInfo(const Texture::TextureInfo& info) {
+    TextureCacheKey key;
+    key.state.address = info.physical_address;
+    key.state.width = info.width;
+    key.state.height = info.height;
+    key.state.format = info.format;
+    return key;
+}
+
+DecodedTexture::DecodedTexture(const u8* source, const Texture::TextureInfo& info)
+    : width(info.width), texels(info.width * info.height) {
+    MICROPROFILE_SCOPE(GPU_TextureDecode);
+
+    Texture::DecodeTexture(source, info, texels.data());
+}
+
+namespace {
+
+struct CacheEntry {
+    PAddr end;
+    u64 hash;
+    /// The draw the contents were last compared against the source data in
+    u64 validated_draw;
+    std::shared_ptr<const DecodedTexture> texture;
+};
+
+/// Decoded textures which were not used in the current draw are dropped above this size
+constexpr std::size_t MAX_CACHED_BYTES = 64 * 1024 * 1024;
+
+std::mutex cache_mutex;
+std::unordered_map<TextureCacheKey, CacheEntry> cache;
+std::size_t cached_bytes = 0;
+
+/// Starts at 1 so that the thread local lookups below never match before the first draw
+std::atomic<u64> current_draw{1};
+
+void EvictUnusedTextures(u64 draw) {
+    for (auto it = cache.begin(); it != cache.end();) {
+        if (it->second.validated_draw != draw) {
+            cached_bytes -= it->second.texture->GetSizeInBytes();
+            it = cache.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+} // Anonymous namespace
+
+std::shared_ptr<const DecodedTexture> GetDecodedTexture(const Texture::TextureInfo& info) {
+    // A triangle samples up to three textures, remember the latest ones per thread to avoid
+    // taking the lock for each triangle
+    struct RecentLookup {
+        TextureCacheKey key;
+        u64 draw = 0;
+        std::shared_ptr<const DecodedTexture> texture;
+    };
+    thread_local std::array<RecentLookup, 4> recent_lookups;
+    thread_local std::size_t next_recent_lookup = 0;
+
+    const auto key = TextureCacheKey::FromTextureInfo(info);
+    const u64 draw = current_draw;
+    for (const auto& lookup : recent_lookups) {
+        if (lookup.draw == draw && lookup.key == key) {
+            return lookup.texture;
+        }
+    }
+
+    // Textures are cached as whole tiles, anything else is looked up texel by texel
+    if (info.width == 0 || info.height == 0 || info.width % 8 != 0 || info.height % 8 != 0 ||
+        info.format > TexturingRegs::TextureFormat::ETC1A4) {
+        return nullptr;
+    }
+
+    const u32 size = static_cast<u32>(info.stride * (info.height / 8));
+    const u8* source = VideoCore::g_memory->GetPhysicalPointer(info.physical_address);
+    if (source == nullptr ||
+        VideoCore::g_memory->GetPhysicalPointer(info.physical_address + size - 1) !=
+            source + size - 1) {
+        LOG_DEBUG(HW_GPU, "Texture at 0x{:08X} is not contiguous in memory, not caching it",
+                  info.physical_address);
+        return nullptr;
+    }
+
+    std::shared_ptr<const DecodedTexture> texture;
+    {
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        auto& entry = cache[key];
+        if (entry.validated_draw != draw) {
+            const u64 hash = Common::ComputeHash64(source, size);
+            if (!entry.texture || entry.hash != hash) {
+                if (entry.texture) {
+                    cached_bytes -= entry.texture->GetSizeInBytes();
+                }
+                entry.end = info.physical_address + size;
+                entry.hash = hash;
+                entry.texture = std::make_shared<DecodedTexture>(source, info);
+                cached_bytes += entry.texture->GetSizeInBytes();
+            }
+            entry.validated_draw = draw;
+        }
+        texture = entry.texture;
+
+        if (cached_bytes > MAX_CACHED_BYTES) {
+            EvictUnusedTextures(draw);
+        }
+    }
+
+    recent_lookups[next_recent_lookup] = {key, draw, texture};
+    next_recent_lookup = (next_recent_lookup + 1) % recent_lookups.size();
+    return texture;
+}
+
+void FinishTextureCacheDraw() {
+    ++current_draw;
+}
+
+void InvalidateDecodedTextures(PAddr addr, u32 size) {
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    for (auto it = cache.begin(); it != cache.end();) {
+        if (it->first.state.address < addr + size && addr < it->second.end) {
+            cached_bytes -= it->second.texture->GetSizeInBytes();
+            it = cache.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    // Don't let the per-thread lookups hand out the dropped textures
+    ++current_draw;
+}
+
+} // namespace Pica::Rasterizer
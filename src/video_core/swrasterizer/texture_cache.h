@@ -0,0 +1,77 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <vector>
+#include "common/common_types.h"
+#include "common/hash.h"
+#include "common/vector_math.h"
+#include "video_core/regs_texturing.h"
+
+namespace Pica::Texture {
+struct TextureInfo;
+}
+
+namespace Pica::Rasterizer {
+
+struct TextureCacheKeyState {
+    PAddr address;
+    u32 width;
+    u32 height;
+    TexturingRegs::TextureFormat format;
+};
+
+/// Identifies a texture in the decoded texture cache, its contents are validated separately
+struct TextureCacheKey : Common::HashableStruct<TextureCacheKeyState> {
+    static TextureCacheKey FromTextureInfo(const Texture::TextureInfo& info);
+};
+
+/// A texture decoded to RGBA8, so that sampling it is a plain array access
+class DecodedTexture {
+public:
+    DecodedTexture(const u8* source, const Texture::TextureInfo& info);
+
+    /// Returns the texel at the given coordinates, equivalent to Texture::LookupTexture
+    Common::Vec4<u8> Lookup(unsigned int x, unsigned int y) const {
+        return texels[y * width + x];
+    }
+
+    std::size_t GetSizeInBytes() const {
+        return texels.size() * sizeof(Common::Vec4<u8>);
+    }
+
+private:
+    unsigned int width;
+    std::vector<Common::Vec4<u8>> texels;
+};
+
+/**
+ * Returns the given texture decoded to RGBA8, decoding it if it is not cached yet. The contents of
+ * a cached texture are compared against a hash of the source data the first time it is used in
+ * each draw, which catches writes by the CPU as well as by the rasterizer itself.
+ * May be called from multiple threads.
+ * @returns the decoded texture, or nullptr if the texture does not lie in emulated memory, its
+ *          size is not a multiple of the tile size or its format is unknown
+ */
+std::shared_ptr<const DecodedTexture> GetDecodedTexture(const Texture::TextureInfo& info);
+
+/// Marks the end of a draw, cached textures are validated again before their next use
+void FinishTextureCacheDraw();
+
+/// Drops the cached textures overlapping the given range of physical memory
+void InvalidateDecodedTextures(PAddr addr, u32 size);
+
+} // namespace Pica::Rasterizer
+
+namespace std {
+template <>
+struct hash<Pica::Rasterizer::TextureCacheKey> {
+    std::size_t operator()(const Pica::Rasterizer::TextureCacheKey& k) const {
+        return k.Hash();
+    }
+};
+} // namespace std
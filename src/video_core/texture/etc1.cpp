@@ -4,12 +4,18 @@
 
 #include <algorithm>
 #include <array>
+#include <cstring>
 #include "common/bit_field.h"
 #include "common/color.h"
 #include "common/common_types.h"
+#include "common/swap.h"
 #include "common/vector_math.h"
 #include "video_core/texture/etc1.h"
 
+#ifdef ARCHITECTURE_x86_64
+#include <emmintrin.h>
+#endif
+
 namespace Pica::Texture {
 
 namespace {
@@ -117,6 +123,134 @@ union ETC1Tile {
     }
 };
 
+/// Returns the alpha of texel (x, y) from the 4-bit values preceding the colors of an ETC1A4 tile
+u8 GetETC1Alpha(u64 alpha, unsigned int x, unsigned int y) {
+    return Color::Convert4To8((alpha >> (4 * (x * 4 + y))) & 0xF);
+}
+
+#ifdef ARCHITECTURE_x86_64
+
+/**
+ * Decodes a subtile four texels at a time. The table lookups of all texels are done at once on
+ * vectors of 16 bytes, where byte 4 * y + x holds texel (x, y). Since the magnitude of a modifier
+ * never exceeds 255, applying it with saturating arithmetic clamps the result like the hardware.
+ */
+void DecodeETC1Subtile(u64 value, u64 alpha, Common::Vec4<u8>* texels, std::size_t stride) {
+    const ETC1Tile tile{value};
+
+    // The lookup values are stored per texel in column major order, select them for each byte
+    const __m128i texel_bits_low = _mm_setr_epi16(0x0001, 0x0010, 0x0100, 0x1000, //
+                                                  0x0002, 0x0020, 0x0200, 0x2000);
+    const __m128i texel_bits_high = _mm_setr_epi16(0x0004, 0x0040, 0x0400, 0x4000, //
+                                                   0x0008, 0x0080, 0x0800, -0x8000);
+    const auto expand_bits = [&](u16 bits) {
+        const __m128i word = _mm_set1_epi16(static_cast<s16>(bits));
+        const __m128i low =
+            _mm_cmpeq_epi16(_mm_and_si128(word, texel_bits_low), texel_bits_low);
+        const __m128i high =
+            _mm_cmpeq_epi16(_mm_and_si128(word, texel_bits_high), texel_bits_high);
+        return _mm_packs_epi16(low, high);
+    };
+    const auto select = [](__m128i mask, __m128i a, __m128i b) {
+        return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+    };
+
+    // Texels of the second half of the subtile, which is split horizontally when flipped
+    const __m128i second_half =
+        tile.flip ? _mm_setr_epi32(0, 0, -1, -1) : _mm_set1_epi32(static_cast<s32>(0xFFFF0000));
+
+    const auto& table_1 = etc1_modifier_table[tile.table_index_1];
+    const auto& table_2 = etc1_modifier_table[tile.table_index_2];
+    const __m128i small_modifiers = select(second_half, _mm_set1_epi8(table_2[0]),
+                                           _mm_set1_epi8(table_1[0]));
+    const __m128i large_modifiers = select(second_half, _mm_set1_epi8(table_2[1]),
+                                           _mm_set1_epi8(table_1[1]));
+    const __m128i modifiers = select(expand_bits(static_cast<u16>(tile.table_subindexes)),
+                                     large_modifiers, small_modifiers);
+    const __m128i negate = expand_bits(static_cast<u16>(tile.negation_flags));
+    const __m128i additions = _mm_andnot_si128(negate, modifiers);
+    const __m128i subtractions = _mm_and_si128(negate, modifiers);
+
+    // Base colors of both halves as RGBA8 texels with zero alpha
+    std::array<u32, 2> base_colors;
+    for (unsigned int half = 0; half < 2; ++half) {
+        Common::Vec3<u8> color;
+        if (tile.differential_mode) {
+            Common::Vec3<int> base{static_cast<int>(tile.differential.r),
+                                   static_cast<int>(tile.differential.g),
+                                   static_cast<int>(tile.differential.b)};
+            if (half == 1) {
+                base.r() += static_cast<int>(tile.differential.dr);
+                base.g() += static_cast<int>(tile.differential.dg);
+                base.b() += static_cast<int>(tile.differential.db);
+            }
+            color = {Color::Convert5To8(static_cast<u8>(base.r())),
+                     Color::Convert5To8(static_cast<u8>(base.g())),
+                     Color::Convert5To8(static_cast<u8>(base.b()))};
+        } else if (half == 0) {
+            color = {Color::Convert4To8(static_cast<u8>(tile.separate.r1)),
+                     Color::Convert4To8(static_cast<u8>(tile.separate.g1)),
+                     Color::Convert4To8(static_cast<u8>(tile.separate.b1))};
+        } else {
+            color = {Color::Convert4To8(static_cast<u8>(tile.separate.r2)),
+                     Color::Convert4To8(static_cast<u8>(tile.separate.g2)),
+                     Color::Convert4To8(static_cast<u8>(tile.separate.b2))};
+        }
+        base_colors[half] = color.r() | (color.g() << 8) | (color.b() << 16);
+    }
+
+    alignas(16) std::array<u8, 16> alphas;
+    for (unsigned int y = 0; y < 4; ++y) {
+        for (unsigned int x = 0; x < 4; ++x) {
+            alphas[y * 4 + x] = GetETC1Alpha(alpha, x, y);
+        }
+    }
+    const __m128i alpha_bytes = _mm_load_si128(reinterpret_cast<const __m128i*>(alphas.data()));
+
+    // Widens the bytes of the texels of row y to RGB or alpha channels
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i rgb_mask = _mm_set1_epi32(0x00FFFFFF);
+    const auto row_rgb = [&](__m128i bytes, unsigned int y) {
+        const __m128i pairs = y < 2 ? _mm_unpacklo_epi8(bytes, bytes)
+                                    : _mm_unpackhi_epi8(bytes, bytes);
+        const __m128i quads = y % 2 == 0 ? _mm_unpacklo_epi16(pairs, pairs)
+                                         : _mm_unpackhi_epi16(pairs, pairs);
+        return _mm_and_si128(quads, rgb_mask);
+    };
+    const auto row_alpha = [&](unsigned int y) {
+        const __m128i pairs = y < 2 ? _mm_unpacklo_epi8(zero, alpha_bytes)
+                                    : _mm_unpackhi_epi8(zero, alpha_bytes);
+        return y % 2 == 0 ? _mm_unpacklo_epi16(zero, pairs) : _mm_unpackhi_epi16(zero, pairs);
+    };
+
+    for (unsigned int y = 0; y < 4; ++y) {
+        const bool second_row_half = tile.flip && y >= 2;
+        const __m128i base =
+            tile.flip ? _mm_set1_epi32(static_cast<s32>(base_colors[second_row_half ? 1 : 0]))
+                      : _mm_setr_epi32(static_cast<s32>(base_colors[0]),
+                                       static_cast<s32>(base_colors[0]),
+                                       static_cast<s32>(base_colors[1]),
+                                       static_cast<s32>(base_colors[1]));
+        __m128i row = _mm_adds_epu8(base, row_rgb(additions, y));
+        row = _mm_subs_epu8(row, row_rgb(subtractions, y));
+        row = _mm_or_si128(row, row_alpha(y));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(texels + y * stride), row);
+    }
+}
+
+#else
+
+void DecodeETC1Subtile(u64 value, u64 alpha, Common::Vec4<u8>* texels, std::size_t stride) {
+    const ETC1Tile tile{value};
+    for (unsigned int y = 0; y < 4; ++y) {
+        for (unsigned int x = 0; x < 4; ++x) {
+            texels[y * stride + x] = Common::MakeVec(tile.GetRGB(x, y), GetETC1Alpha(alpha, x, y));
+        }
+    }
+}
+
+#endif // ARCHITECTURE_x86_64
+
 } // anonymous namespace
 
 Common::Vec3<u8> SampleETC1Subtile(u64 value, unsigned int x, unsigned int y) {
@@ -124,4 +258,22 @@ Common::Vec3<u8> SampleETC1Subtile(u64 value, unsigned int x, unsigned int y) {
     return tile.GetRGB(x, y);
 }
 
+void DecodeETC1Tile(const u8* source, bool has_alpha, Common::Vec4<u8>* texels,
+                    std::size_t stride) {
+    for (unsigned int subtile = 0; subtile < 4; ++subtile) {
+        // Without alpha values, all of them read as 0xF
+        u64_le alpha = ~u64{0};
+        if (has_alpha) {
+            std::memcpy(&alpha, source, sizeof(u64));
+            source += sizeof(u64);
+        }
+        u64_le value;
+        std::memcpy(&value, source, sizeof(u64));
+        source += sizeof(u64);
+
+        DecodeETC1Subtile(value, alpha, texels + (subtile / 2) * 4 * stride + (subtile % 2) * 4,
+                          stride);
+    }
+}
+
 } // namespace Pica::Texture
@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <cstddef>
 #include "common/common_types.h"
 #include "common/vector_math.h"
 
@@ -11,4 +12,13 @@ namespace Pica::Texture {
 
 Common::Vec3<u8> SampleETC1Subtile(u64 value, unsigned int x, unsigned int y);
 
+/**
+ * Decodes an 8x8 ETC1 or ETC1A4 tile, made up of four 4x4 subtiles, to RGBA8.
+ * @param source Pointer to the beginning of the tile
+ * @param has_alpha Whether the tile is ETC1A4, texels of ETC1 tiles are opaque
+ * @param texels Receives the texels, texel (x, y) of the tile is written to texels[y * stride + x]
+ */
+void DecodeETC1Tile(const u8* source, bool has_alpha, Common::Vec4<u8>* texels,
+                    std::size_t stride);
+
 } // namespace Pica::Texture
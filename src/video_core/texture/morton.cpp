@@ -0,0 +1,427 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <array>
+#include <cstring>
+#include "video_core/texture/morton.h"
+#include "video_core/utils.h"
+
+#ifdef ARCHITECTURE_x86_64
+#include <emmintrin.h>
+#endif
+
+namespace Pica::Texture {
+
+using VideoCore::MortonInterleave;
+
+// The kernels below walk a tile in groups of 8 consecutive texels, which hold texels [x, x + 4)
+// of the rows y and y + 1 for even y and x divisible by 4, in the order
+//   (x, y), (x + 1, y), (x, y + 1), (x + 1, y + 1), (x + 2, y), (x + 3, y), (x + 2, y + 1), ...
+// Unlike a texel by texel copy, this needs no table lookups and allows for wide loads and stores.
+
+constexpr u32 GetGroupTexelX(u32 i) {
+    return (i & 1) | ((i >> 2) << 1);
+}
+
+constexpr u32 GetGroupTexelY(u32 i) {
+    return (i >> 1) & 1;
+}
+
+struct CopyTexel8 {
+    static constexpr u32 tile_size = 1;
+    static constexpr u32 linear_size = 1;
+    static void ToLinear(const u8* tile, u8* linear) {
+        linear[0] = tile[0];
+    }
+    static void ToMorton(u8* tile, const u8* linear) {
+        tile[0] = linear[0];
+    }
+};
+
+struct CopyTexel16 {
+    static constexpr u32 tile_size = 2;
+    static constexpr u32 linear_size = 2;
+    static void ToLinear(const u8* tile, u8* linear) {
+        std::memcpy(linear, tile, 2);
+    }
+    static void ToMorton(u8* tile, const u8* linear) {
+        std::memcpy(tile, linear, 2);
+    }
+};
+
+struct CopyTexel24 {
+    static constexpr u32 tile_size = 3;
+    static constexpr u32 linear_size = 3;
+    static void ToLinear(const u8* tile, u8* linear) {
+        std::memcpy(linear, tile, 3);
+    }
+    static void ToMorton(u8* tile, const u8* linear) {
+        std::memcpy(tile, linear, 3);
+    }
+};
+
+struct CopyTexel32 {
+    static constexpr u32 tile_size = 4;
+    static constexpr u32 linear_size = 4;
+    static void ToLinear(const u8* tile, u8* linear) {
+        std::memcpy(linear, tile, 4);
+    }
+    static void ToMorton(u8* tile, const u8* linear) {
+        std::memcpy(tile, linear, 4);
+    }
+};
+
+struct D24Texel {
+    static constexpr u32 tile_size = 3;
+    static constexpr u32 linear_size = 4;
+    static void ToLinear(const u8* tile, u8* linear) {
+        linear[0] = 0;
+        std::memcpy(linear + 1, tile, 3);
+    }
+    static void ToMorton(u8* tile, const u8* linear) {
+        std::memcpy(tile, linear + 1, 3);
+    }
+};
+
+struct D24S8Texel {
+    static constexpr u32 tile_size = 4;
+    static constexpr u32 linear_size = 4;
+    static void ToLinear(const u8* tile, u8* linear) {
+        linear[0] = tile[3];
+        std::memcpy(linear + 1, tile, 3);
+    }
+    static void ToMorton(u8* tile, const u8* linear) {
+        std::memcpy(tile, linear + 1, 3);
+        tile[3] = linear[0];
+    }
+};
+
+struct SwapRGB8Texel {
+    static constexpr u32 tile_size = 3;
+    static constexpr u32 linear_size = 3;
+    static void ToLinear(const u8* tile, u8* linear) {
+        linear[0] = tile[2];
+        linear[1] = tile[1];
+        linear[2] = tile[0];
+    }
+    static void ToMorton(u8* tile, const u8* linear) {
+        ToLinear(linear, tile);
+    }
+};
+
+struct SwapRGBA8Texel {
+    static constexpr u32 tile_size = 4;
+    static constexpr u32 linear_size = 4;
+    static void ToLinear(const u8* tile, u8* linear) {
+        linear[0] = tile[3];
+        linear[1] = tile[2];
+        linear[2] = tile[1];
+        linear[3] = tile[0];
+    }
+    static void ToMorton(u8* tile, const u8* linear) {
+        ToLinear(linear, tile);
+    }
+};
+
+template <typename Texel>
+static void MortonToLinearTexels(const u8* tile, u8* linear, std::ptrdiff_t pitch) {
+    for (u32 y = 0; y < 8; ++y) {
+        for (u32 x = 0; x < 8; ++x) {
+            Texel::ToLinear(tile + MortonInterleave(x, y) * Texel::tile_size,
+                            linear + y * pitch + x * Texel::linear_size);
+        }
+    }
+}
+
+template <typename Texel>
+static void LinearToMortonTexels(u8* tile, const u8* linear, std::ptrdiff_t pitch) {
+    for (u32 y = 0; y < 8; ++y) {
+        for (u32 x = 0; x < 8; ++x) {
+            Texel::ToMorton(tile + MortonInterleave(x, y) * Texel::tile_size,
+                            linear + y * pitch + x * Texel::linear_size);
+        }
+    }
+}
+
+template <typename Texel>
+static void MortonToLinearGroups(const u8* tile, u8* linear, std::ptrdiff_t pitch) {
+    for (u32 y = 0; y < 8; y += 2) {
+        for (u32 x = 0; x < 8; x += 4) {
+            const u8* group = tile + MortonInterleave(x, y) * Texel::tile_size;
+            for (u32 i = 0; i < 8; ++i) {
+                Texel::ToLinear(group + i * Texel::tile_size,
+                                linear + (y + GetGroupTexelY(i)) * pitch +
+                                    (x + GetGroupTexelX(i)) * Texel::linear_size);
+            }
+        }
+    }
+}
+
+template <typename Texel>
+static void LinearToMortonGroups(u8* tile, const u8* linear, std::ptrdiff_t pitch) {
+    for (u32 y = 0; y < 8; y += 2) {
+        for (u32 x = 0; x < 8; x += 4) {
+            u8* group = tile + MortonInterleave(x, y) * Texel::tile_size;
+            for (u32 i = 0; i < 8; ++i) {
+                Texel::ToMorton(group + i * Texel::tile_size,
+                                linear + (y + GetGroupTexelY(i)) * pitch +
+                                    (x + GetGroupTexelX(i)) * Texel::linear_size);
+            }
+        }
+    }
+}
+
+// Texel layouts which are the same on both sides are copied in pairs of horizontally adjacent
+// texels, which are stored next to each other in a tile
+
+template <u32 bytes_per_texel>
+static void MortonToLinearPairs(const u8* tile, u8* linear, std::ptrdiff_t pitch) {
+    constexpr u32 pair_size = 2 * bytes_per_texel;
+    for (u32 y = 0; y < 8; y += 2) {
+        for (u32 x = 0; x < 8; x += 4) {
+            const u8* group = tile + MortonInterleave(x, y) * bytes_per_texel;
+            u8* row0 = linear + y * pitch + x * bytes_per_texel;
+            u8* row1 = row0 + pitch;
+            std::memcpy(row0, group, pair_size);
+            std::memcpy(row1, group + pair_size, pair_size);
+            std::memcpy(row0 + pair_size, group + 2 * pair_size, pair_size);
+            std::memcpy(row1 + pair_size, group + 3 * pair_size, pair_size);
+        }
+    }
+}
+
+template <u32 bytes_per_texel>
+static void LinearToMortonPairs(u8* tile, const u8* linear, std::ptrdiff_t pitch) {
+    constexpr u32 pair_size = 2 * bytes_per_texel;
+    for (u32 y = 0; y < 8; y += 2) {
+        for (u32 x = 0; x < 8; x += 4) {
+            u8* group = tile + MortonInterleave(x, y) * bytes_per_texel;
+            const u8* row0 = linear + y * pitch + x * bytes_per_texel;
+            const u8* row1 = row0 + pitch;
+            std::memcpy(group, row0, pair_size);
+            std::memcpy(group + pair_size, row1, pair_size);
+            std::memcpy(group + 2 * pair_size, row0 + pair_size, pair_size);
+            std::memcpy(group + 3 * pair_size, row1 + pair_size, pair_size);
+        }
+    }
+}
+
+// A group of 8-bit texels fits into a 64-bit word, with the two texel pairs of each row in its
+// 16-bit lanes 0 and 2 (row y) and 1 and 3 (row y + 1)
+
+static void MortonToLinear8(const u8* tile, u8* linear, std::ptrdiff_t pitch) {
+    for (u32 y = 0; y < 8; y += 2) {
+        for (u32 x = 0; x < 8; x += 4) {
+            u64 group;
+            std::memcpy(&group, tile + MortonInterleave(x, y), sizeof(group));
+            const u32 row0 = static_cast<u32>((group & 0xFFFF) | ((group >> 16) & 0xFFFF0000));
+            const u32 row1 =
+                static_cast<u32>(((group >> 16) & 0xFFFF) | ((group >> 32) & 0xFFFF0000));
+            std::memcpy(linear + y * pitch + x, &row0, sizeof(row0));
+            std::memcpy(linear + (y + 1) * pitch + x, &row1, sizeof(row1));
+        }
+    }
+}
+
+static void LinearToMorton8(u8* tile, const u8* linear, std::ptrdiff_t pitch) {
+    for (u32 y = 0; y < 8; y += 2) {
+        for (u32 x = 0; x < 8; x += 4) {
+            u32 row0;
+            u32 row1;
+            std::memcpy(&row0, linear + y * pitch + x, sizeof(row0));
+            std::memcpy(&row1, linear + (y + 1) * pitch + x, sizeof(row1));
+            const u64 group = (row0 & 0xFFFF) | (static_cast<u64>(row1 & 0xFFFF) << 16) |
+                              (static_cast<u64>(row0 >> 16) << 32) |
+                              (static_cast<u64>(row1 >> 16) << 48);
+            std::memcpy(tile + MortonInterleave(x, y), &group, sizeof(group));
+        }
+    }
+}
+
+#ifdef ARCHITECTURE_x86_64
+
+// A group of 16-bit texels fills one SSE register, swapping its 32-bit lanes 1 and 2 moves row y
+// into the lower and row y + 1 into the upper half. The swap is its own inverse.
+
+static void MortonToLinear16SSE2(const u8* tile, u8* linear, std::ptrdiff_t pitch) {
+    for (u32 y = 0; y < 8; y += 2) {
+        for (u32 x = 0; x < 8; x += 4) {
+            __m128i group = _mm_loadu_si128(
+                reinterpret_cast<const __m128i*>(tile + MortonInterleave(x, y) * 2));
+            group = _mm_shuffle_epi32(group, _MM_SHUFFLE(3, 1, 2, 0));
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(linear + y * pitch + x * 2), group);
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(linear + (y + 1) * pitch + x * 2),
+                             _mm_unpackhi_epi64(group, group));
+        }
+    }
+}
+
+static void LinearToMorton16SSE2(u8* tile, const u8* linear, std::ptrdiff_t pitch) {
+    for (u32 y = 0; y < 8; y += 2) {
+        for (u32 x = 0; x < 8; x += 4) {
+            const __m128i row0 =
+                _mm_loadl_epi64(reinterpret_cast<const __m128i*>(linear + y * pitch + x * 2));
+            const __m128i row1 = _mm_loadl_epi64(
+                reinterpret_cast<const __m128i*>(linear + (y + 1) * pitch + x * 2));
+            const __m128i group =
+                _mm_shuffle_epi32(_mm_unpacklo_epi64(row0, row1), _MM_SHUFFLE(3, 1, 2, 0));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(tile + MortonInterleave(x, y) * 2),
+                             group);
+        }
+    }
+}
+
+// A group of 32-bit texels fills two SSE registers, each holding a 2x2 block. The texel
+// conversions of the 32-bit formats are applied to whole registers.
+
+struct CopyLanes32 {
+    static __m128i ToLinear(__m128i texels) {
+        return texels;
+    }
+    static __m128i ToMorton(__m128i texels) {
+        return texels;
+    }
+};
+
+struct D24S8Lanes {
+    // Rotates the stencil from the highest into the lowest byte and back
+    static __m128i ToLinear(__m128i texels) {
+        return _mm_or_si128(_mm_slli_epi32(texels, 8), _mm_srli_epi32(texels, 24));
+    }
+    static __m128i ToMorton(__m128i texels) {
+        return _mm_or_si128(_mm_srli_epi32(texels, 8), _mm_slli_epi32(texels, 24));
+    }
+};
+
+struct SwapRGBA8Lanes {
+    static __m128i ToLinear(__m128i texels) {
+        // Swap the 16-bit halves of each texel, then the bytes of each half
+        texels = _mm_shufflelo_epi16(texels, _MM_SHUFFLE(2, 3, 0, 1));
+        texels = _mm_shufflehi_epi16(texels, _MM_SHUFFLE(2, 3, 0, 1));
+        return _mm_or_si128(_mm_slli_epi16(texels, 8), _mm_srli_epi16(texels, 8));
+    }
+    static __m128i ToMorton(__m128i texels) {
+        return ToLinear(texels);
+    }
+};
+
+template <typename Lanes>
+static void MortonToLinear32SSE2(const u8* tile, u8* linear, std::ptrdiff_t pitch) {
+    for (u32 y = 0; y < 8; y += 2) {
+        for (u32 x = 0; x < 8; x += 4) {
+            const u8* group = tile + MortonInterleave(x, y) * 4;
+            const __m128i left =
+                Lanes::ToLinear(_mm_loadu_si128(reinterpret_cast<const __m128i*>(group)));
+            const __m128i right =
+                Lanes::ToLinear(_mm_loadu_si128(reinterpret_cast<const __m128i*>(group + 16)));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(linear + y * pitch + x * 4),
+                             _mm_unpacklo_epi64(left, right));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(linear + (y + 1) * pitch + x * 4),
+                             _mm_unpackhi_epi64(left, right));
+        }
+    }
+}
+
+template <typename Lanes>
+static void LinearToMorton32SSE2(u8* tile, const u8* linear, std::ptrdiff_t pitch) {
+    for (u32 y = 0; y < 8; y += 2) {
+        for (u32 x = 0; x < 8; x += 4) {
+            const __m128i row0 =
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(linear + y * pitch + x * 4));
+            const __m128i row1 = _mm_loadu_si128(
+                reinterpret_cast<const __m128i*>(linear + (y + 1) * pitch + x * 4));
+            u8* group = tile + MortonInterleave(x, y) * 4;
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(group),
+                             Lanes::ToMorton(_mm_unpacklo_epi64(row0, row1)));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(group + 16),
+                             Lanes::ToMorton(_mm_unpackhi_epi64(row0, row1)));
+        }
+    }
+}
+
+#endif // ARCHITECTURE_x86_64
+
+using MortonToLinearFunction = void (*)(const u8*, u8*, std::ptrdiff_t);
+using LinearToMortonFunction = void (*)(u8*, const u8*, std::ptrdiff_t);
+
+// Indexed by MortonFormat
+#ifdef ARCHITECTURE_x86_64
+static constexpr std::array<MortonToLinearFunction, 8> morton_to_linear_fns = {
+    MortonToLinear8,
+    MortonToLinear16SSE2,
+    MortonToLinearPairs<3>,
+    MortonToLinear32SSE2<CopyLanes32>,
+    MortonToLinearGroups<D24Texel>,
+    MortonToLinear32SSE2<D24S8Lanes>,
+    MortonToLinearGroups<SwapRGB8Texel>,
+    MortonToLinear32SSE2<SwapRGBA8Lanes>,
+};
+
+static constexpr std::array<LinearToMortonFunction, 8> linear_to_morton_fns = {
+    LinearToMorton8,
+    LinearToMorton16SSE2,
+    LinearToMortonPairs<3>,
+    LinearToMorton32SSE2<CopyLanes32>,
+    LinearToMortonGroups<D24Texel>,
+    LinearToMorton32SSE2<D24S8Lanes>,
+    LinearToMortonGroups<SwapRGB8Texel>,
+    LinearToMorton32SSE2<SwapRGBA8Lanes>,
+};
+#else
+static constexpr std::array<MortonToLinearFunction, 8> morton_to_linear_fns = {
+    MortonToLinear8,
+    MortonToLinearPairs<2>,
+    MortonToLinearPairs<3>,
+    MortonToLinearPairs<4>,
+    MortonToLinearGroups<D24Texel>,
+    MortonToLinearGroups<D24S8Texel>,
+    MortonToLinearGroups<SwapRGB8Texel>,
+    MortonToLinearGroups<SwapRGBA8Texel>,
+};
+
+static constexpr std::array<LinearToMortonFunction, 8> linear_to_morton_fns = {
+    LinearToMorton8,
+    LinearToMortonPairs<2>,
+    LinearToMortonPairs<3>,
+    LinearToMortonPairs<4>,
+    LinearToMortonGroups<D24Texel>,
+    LinearToMortonGroups<D24S8Texel>,
+    LinearToMortonGroups<SwapRGB8Texel>,
+    LinearToMortonGroups<SwapRGBA8Texel>,
+};
+#endif
+
+static constexpr std::array<MortonToLinearFunction, 8> morton_to_linear_reference_fns = {
+    MortonToLinearTexels<CopyTexel8>,    MortonToLinearTexels<CopyTexel16>,
+    MortonToLinearTexels<CopyTexel24>,   MortonToLinearTexels<CopyTexel32>,
+    MortonToLinearTexels<D24Texel>,      MortonToLinearTexels<D24S8Texel>,
+    MortonToLinearTexels<SwapRGB8Texel>, MortonToLinearTexels<SwapRGBA8Texel>,
+};
+
+static constexpr std::array<LinearToMortonFunction, 8> linear_to_morton_reference_fns = {
+    LinearToMortonTexels<CopyTexel8>,    LinearToMortonTexels<CopyTexel16>,
+    LinearToMortonTexels<CopyTexel24>,   LinearToMortonTexels<CopyTexel32>,
+    LinearToMortonTexels<D24Texel>,      LinearToMortonTexels<D24S8Texel>,
+    LinearToMortonTexels<SwapRGB8Texel>, LinearToMortonTexels<SwapRGBA8Texel>,
+};
+
+void MortonToLinear(MortonFormat format, const u8* tile, u8* linear, std::ptrdiff_t pitch) {
+    morton_to_linear_fns[static_cast<std::size_t>(format)](tile, linear, pitch);
+}
+
+void LinearToMorton(MortonFormat format, u8* tile, const u8* linear, std::ptrdiff_t pitch) {
+    linear_to_morton_fns[static_cast<std::size_t>(format)](tile, linear, pitch);
+}
+
+void MortonToLinearReference(MortonFormat format, const u8* tile, u8* linear,
+                             std::ptrdiff_t pitch) {
+    morton_to_linear_reference_fns[static_cast<std::size_t>(format)](tile, linear, pitch);
+}
+
+void LinearToMortonReference(MortonFormat format, u8* tile, const u8* linear,
+                             std::ptrdiff_t pitch) {
+    linear_to_morton_reference_fns[static_cast<std::size_t>(format)](tile, linear, pitch);
+}
+
+} // namespace Pica::Texture
@@ -0,0 +1,60 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+#include "common/common_types.h"
+
+namespace Pica::Texture {
+
+/**
+ * Texel layouts converted between the tiled layout of the PICA, which stores images as 8x8 tiles
+ * with their texels in Morton order, and linear rows as expected by host APIs. Most layouts are
+ * the same on both sides and only differ in the texel size.
+ */
+enum class MortonFormat {
+    Copy8,     ///< 8-bit texels, e.g. I8, A8 and IA4
+    Copy16,    ///< 16-bit texels, e.g. RGB5A1, RGB565, RGBA4, IA8, RG8 and D16
+    Copy24,    ///< 24-bit texels, e.g. RGB8
+    Copy32,    ///< 32-bit texels, e.g. RGBA8
+    D24,       ///< 24-bit depth, stored in the upper three bytes of 32-bit linear texels
+    D24S8,     ///< 24-bit depth and stencil, with the stencil in the lowest byte of linear texels
+    SwapRGB8,  ///< RGB8 with the byte order of linear texels reversed
+    SwapRGBA8, ///< RGBA8 with the byte order of linear texels reversed
+};
+
+/**
+ * Converts an 8x8 tile to 8 rows of a linear image.
+ * @param tile Tile with its texels in Morton order
+ * @param linear First texel of the linear row receiving the first row of the tile, which is the
+ *               bottom one in the PICA's coordinate system
+ * @param pitch Byte offset from one linear row to the next, negative to flip the tile vertically
+ */
+void MortonToLinear(MortonFormat format, const u8* tile, u8* linear, std::ptrdiff_t pitch);
+
+/// Converts 8 rows of a linear image to an 8x8 tile, the inverse of MortonToLinear
+void LinearToMorton(MortonFormat format, u8* tile, const u8* linear, std::ptrdiff_t pitch);
+
+/// Texel by texel implementations of the conversions, used to validate and benchmark the kernels
+void MortonToLinearReference(MortonFormat format, const u8* tile, u8* linear,
+                             std::ptrdiff_t pitch);
+void LinearToMortonReference(MortonFormat format, u8* tile, const u8* linear,
+                             std::ptrdiff_t pitch);
+
+/// Returns the format copying texels of the given size unchanged
+constexpr MortonFormat GetMortonCopyFormat(u32 bytes_per_texel) {
+    switch (bytes_per_texel) {
+    case 1:
+        return MortonFormat::Copy8;
+    case 2:
+        return MortonFormat::Copy16;
+    case 3:
+        return MortonFormat::Copy24;
+    default:
+        return MortonFormat::Copy32;
+    }
+}
+
+} // namespace Pica::Texture
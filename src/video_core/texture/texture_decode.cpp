@@ -2,6 +2,8 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <array>
 #include "common/assert.h"
 #include "common/color.h"
 #include "common/logging/log.h"
@@ -10,6 +12,7 @@
 #include "common/vector_math.h"
 #include "video_core/regs_texturing.h"
 #include "video_core/texture/etc1.h"
+#include "video_core/texture/morton.h"
 #include "video_core/texture/texture_decode.h"
 #include "video_core/utils.h"
 
@@ -71,75 +74,63 @@ Common::Vec4<u8> LookupTexture(const u8* source, unsigned int x, unsigned int y,
     return LookupTexelInTile(tile, fine_x, fine_y, info, disable_alpha);
 }
 
-Common::Vec4<u8> LookupTexelInTile(const u8* source, unsigned int x, unsigned int y,
-                                   const TextureInfo& info, bool disable_alpha) {
-    DEBUG_ASSERT(x < 8);
-    DEBUG_ASSERT(y < 8);
-
-    using VideoCore::MortonInterleave;
-
-    switch (info.format) {
+/// Decodes a texel of one of the formats with at least 8 bits per texel
+static Common::Vec4<u8> DecodeTexel(const u8* source, TextureFormat format, bool disable_alpha) {
+    switch (format) {
     case TextureFormat::RGBA8: {
-        auto res = Color::DecodeRGBA8(source + MortonInterleave(x, y) * 4);
+        auto res = Color::DecodeRGBA8(source);
         return {res.r(), res.g(), res.b(), static_cast<u8>(disable_alpha ? 255 : res.a())};
     }
 
     case TextureFormat::RGB8: {
-        auto res = Color::DecodeRGB8(source + MortonInterleave(x, y) * 3);
+        auto res = Color::DecodeRGB8(source);
         return {res.r(), res.g(), res.b(), 255};
     }
 
     case TextureFormat::RGB5A1: {
-        auto res = Color::DecodeRGB5A1(source + MortonInterleave(x, y) * 2);
+        auto res = Color::DecodeRGB5A1(source);
         return {res.r(), res.g(), res.b(), static_cast<u8>(disable_alpha ? 255 : res.a())};
     }
 
     case TextureFormat::RGB565: {
-        auto res = Color::DecodeRGB565(source + MortonInterleave(x, y) * 2);
+        auto res = Color::DecodeRGB565(source);
         return {res.r(), res.g(), res.b(), 255};
     }
 
     case TextureFormat::RGBA4: {
-        auto res = Color::DecodeRGBA4(source + MortonInterleave(x, y) * 2);
+        auto res = Color::DecodeRGBA4(source);
         return {res.r(), res.g(), res.b(), static_cast<u8>(disable_alpha ? 255 : res.a())};
     }
 
     case TextureFormat::IA8: {
-        const u8* source_ptr = source + MortonInterleave(x, y) * 2;
-
         if (disable_alpha) {
             // Show intensity as red, alpha as green
-            return {source_ptr[1], source_ptr[0], 0, 255};
+            return {source[1], source[0], 0, 255};
         } else {
-            return {source_ptr[1], source_ptr[1], source_ptr[1], source_ptr[0]};
+            return {source[1], source[1], source[1], source[0]};
         }
     }
 
     case TextureFormat::RG8: {
-        auto res = Color::DecodeRG8(source + MortonInterleave(x, y) * 2);
+        auto res = Color::DecodeRG8(source);
         return {res.r(), res.g(), 0, 255};
     }
 
     case TextureFormat::I8: {
-        const u8* source_ptr = source + MortonInterleave(x, y);
-        return {*source_ptr, *source_ptr, *source_ptr, 255};
+        return {*source, *source, *source, 255};
     }
 
     case TextureFormat::A8: {
-        const u8* source_ptr = source + MortonInterleave(x, y);
-
         if (disable_alpha) {
-            return {*source_ptr, *source_ptr, *source_ptr, 255};
+            return {*source, *source, *source, 255};
         } else {
-            return {0, 0, 0, *source_ptr};
+            return {0, 0, 0, *source};
         }
     }
 
     case TextureFormat::IA4: {
-        const u8* source_ptr = source + MortonInterleave(x, y);
-
-        u8 i = Color::Convert4To8(((*source_ptr) & 0xF0) >> 4);
-        u8 a = Color::Convert4To8((*source_ptr) & 0xF);
+        u8 i = Color::Convert4To8(((*source) & 0xF0) >> 4);
+        u8 a = Color::Convert4To8((*source) & 0xF);
 
         if (disable_alpha) {
             // Show intensity as red, alpha as green
@@ -149,6 +140,35 @@ Common::Vec4<u8> LookupTexelInTile(const u8* source, unsigned int x, unsigned in
         }
     }
 
+    default:
+        // Unknown formats decode to zero, DecodeTile doesn't pass any other format here
+        return {};
+    }
+}
+
+Common::Vec4<u8> LookupTexelInTile(const u8* source, unsigned int x, unsigned int y,
+                                   const TextureInfo& info, bool disable_alpha) {
+    DEBUG_ASSERT(x < 8);
+    DEBUG_ASSERT(y < 8);
+
+    using VideoCore::MortonInterleave;
+
+    switch (info.format) {
+    case TextureFormat::RGBA8:
+    case TextureFormat::RGB8:
+    case TextureFormat::RGB5A1:
+    case TextureFormat::RGB565:
+    case TextureFormat::RGBA4:
+    case TextureFormat::IA8:
+    case TextureFormat::RG8:
+    case TextureFormat::I8:
+    case TextureFormat::A8:
+    case TextureFormat::IA4: {
+        const std::size_t bytes_per_texel = CalculateTileSize(info.format) / TILE_SIZE;
+        return DecodeTexel(source + MortonInterleave(x, y) * bytes_per_texel, info.format,
+                           disable_alpha);
+    }
+
     case TextureFormat::I4: {
         u32 morton_offset = MortonInterleave(x, y);
         const u8* source_ptr = source + morton_offset / 2;
@@ -211,6 +231,75 @@ Common::Vec4<u8> LookupTexelInTile(const u8* source, unsigned int x, unsigned in
     }
 }
 
+void DecodeTile(const u8* source, const TextureInfo& info, Common::Vec4<u8>* texels) {
+    switch (info.format) {
+    case TextureFormat::ETC1:
+    case TextureFormat::ETC1A4:
+        DecodeETC1Tile(source, info.format == TextureFormat::ETC1A4, texels, 8);
+        return;
+
+    case TextureFormat::I4:
+    case TextureFormat::A4:
+        // Texels of these formats are not individually addressable, decode them one by one
+        for (unsigned int y = 0; y < 8; ++y) {
+            for (unsigned int x = 0; x < 8; ++x) {
+                texels[y * 8 + x] = LookupTexelInTile(source, x, y, info, false);
+            }
+        }
+        return;
+
+    case TextureFormat::RGBA8:
+    case TextureFormat::RGB8:
+    case TextureFormat::RGB5A1:
+    case TextureFormat::RGB565:
+    case TextureFormat::RGBA4:
+    case TextureFormat::IA8:
+    case TextureFormat::RG8:
+    case TextureFormat::I8:
+    case TextureFormat::A8:
+    case TextureFormat::IA4: {
+        const std::size_t bytes_per_texel = CalculateTileSize(info.format) / TILE_SIZE;
+        std::array<u8, 4 * TILE_SIZE> linear;
+        MortonToLinear(GetMortonCopyFormat(static_cast<u32>(bytes_per_texel)), source,
+                       linear.data(), 8 * bytes_per_texel);
+        for (std::size_t i = 0; i < TILE_SIZE; ++i) {
+            texels[i] = DecodeTexel(&linear[i * bytes_per_texel], info.format, false);
+        }
+        return;
+    }
+
+    default:
+        // Formats 14 and 15 are not known to exist, show them as transparent black
+        std::fill_n(texels, TILE_SIZE, Common::Vec4<u8>{0, 0, 0, 0});
+        return;
+    }
+}
+
+void DecodeTexture(const u8* source, const TextureInfo& info, Common::Vec4<u8>* texels) {
+    const std::size_t tile_size = CalculateTileSize(info.format);
+    for (unsigned int y = 0; y < info.height; y += 8) {
+        const u8* tile = source + (y / 8) * info.stride;
+        const unsigned int rows = std::min(8u, info.height - y);
+        for (unsigned int x = 0; x < info.width; x += 8, tile += tile_size) {
+            const unsigned int columns = std::min(8u, info.width - x);
+            Common::Vec4<u8>* tile_texels = texels + y * info.width + x;
+            if ((info.format == TextureFormat::ETC1 || info.format == TextureFormat::ETC1A4) &&
+                rows == 8 && columns == 8) {
+                DecodeETC1Tile(tile, info.format == TextureFormat::ETC1A4, tile_texels,
+                               info.width);
+                continue;
+            }
+
+            // Tiles cut off by the edges of the texture only have part of their texels copied
+            std::array<Common::Vec4<u8>, TILE_SIZE> decoded_tile;
+            DecodeTile(tile, info, decoded_tile.data());
+            for (unsigned int fine_y = 0; fine_y < rows; ++fine_y) {
+                std::copy_n(&decoded_tile[fine_y * 8], columns, tile_texels + fine_y * info.width);
+            }
+        }
+    }
+}
+
 TextureInfo TextureInfo::FromPicaRegister(const TexturingRegs::TextureConfig& config,
                                           const TexturingRegs::TextureFormat& format) {
     TextureInfo info;
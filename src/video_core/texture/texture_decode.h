@@ -55,4 +55,25 @@ Common::Vec4<u8> LookupTexture(const u8* source, unsigned int x, unsigned int y,
 Common::Vec4<u8> LookupTexelInTile(const u8* source, unsigned int x, unsigned int y,
                                    const TextureInfo& info, bool disable_alpha);
 
+/**
+ * Decodes a whole 8x8 texture tile, which is faster than looking up its texels one by one.
+ *
+ * @param source Pointer to the beginning of the tile.
+ * @param info TextureInfo describing the texture format.
+ * @param texels Receives the 64 texels of the tile, row by row starting at y = 0. They are all zero
+ *               if the format is unknown.
+ */
+void DecodeTile(const u8* source, const TextureInfo& info, Common::Vec4<u8>* texels);
+
+/**
+ * Decodes a whole texture to RGBA8.
+ *
+ * @param source Pointer to the beginning of the texture.
+ * @param info TextureInfo describing the texture. Tiles reaching past its width or height are
+ *             read in whole, but only their texels inside the texture are written.
+ * @param texels Receives info.width * info.height texels, texel (x, y) of the texture, as looked up
+ *               by LookupTexture, is written to texels[y * info.width + x].
+ */
+void DecodeTexture(const u8* source, const TextureInfo& info, Common::Vec4<u8>* texels);
+
 } // namespace Pica::Texture
@@ -1,9 +1,13 @@
+#include <algorithm>
+#include <cstring>
 #include <memory>
+#include <unordered_map>
 #include <boost/range/algorithm/fill.hpp>
 #include "common/alignment.h"
 #include "common/assert.h"
 #include "common/bit_field.h"
 #include "common/common_types.h"
+#include "common/hash.h"
 #include "common/logging/log.h"
 #include "common/vector_math.h"
 #include "core/memory.h"
@@ -15,19 +19,129 @@
 #include "video_core/vertex_loader.h"
 #include "video_core/video_core.h"
 
+#ifdef ARCHITECTURE_x86_64
+#include <emmintrin.h>
+#endif
+
 namespace Pica {
 
+using VertexAttributeFormat = PipelineRegs::VertexAttributeFormat;
+
+static_assert(sizeof(Common::Vec4<float24>) == 4 * sizeof(float),
+              "Vertex attributes are converted as four packed floats");
+
+/**
+ * Converts one attribute of a single vertex. Missing components are set to (0, 0, 0, 1). This is
+ * *not* carried over from the default attribute settings even if they're enabled for this
+ * attribute.
+ */
+template <VertexAttributeFormat format, u32 elements>
+static void LoadAttribute(const u8* source, Common::Vec4<float24>& attribute) {
+#ifdef ARCHITECTURE_x86_64
+    // Only as many bytes as the attribute is large are read, since the vertex arrays may end right
+    // at the end of an emulated memory region
+    __m128 value;
+    if constexpr (format == VertexAttributeFormat::FLOAT) {
+        alignas(16) float data[4] = {0.0f, 0.0f, 0.0f, 1.0f};
+        std::memcpy(data, source, elements * sizeof(float));
+        value = _mm_load_ps(data);
+    } else {
+        __m128i data;
+        if constexpr (format == VertexAttributeFormat::SHORT) {
+            u64 raw = 0;
+            std::memcpy(&raw, source, elements * sizeof(s16));
+            data = _mm_cvtsi64_si128(static_cast<s64>(raw));
+            data = _mm_srai_epi32(_mm_unpacklo_epi16(data, data), 16);
+        } else {
+            u32 raw = 0;
+            std::memcpy(&raw, source, elements);
+            data = _mm_cvtsi32_si128(static_cast<s32>(raw));
+            data = _mm_unpacklo_epi8(data, data);
+            data = _mm_unpacklo_epi16(data, data);
+            data = format == VertexAttributeFormat::BYTE ? _mm_srai_epi32(data, 24)
+                                                         : _mm_srli_epi32(data, 24);
+        }
+        value = _mm_cvtepi32_ps(data);
+        if constexpr (elements < 4) {
+            // The missing components were converted from zeroes
+            value = _mm_add_ps(value, _mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f));
+        }
+    }
+    _mm_storeu_ps(reinterpret_cast<float*>(&attribute), value);
+#else
+    for (u32 comp = 0; comp < elements; ++comp) {
+        float value;
+        if constexpr (format == VertexAttributeFormat::FLOAT) {
+            std::memcpy(&value, source + comp * sizeof(float), sizeof(float));
+        } else if constexpr (format == VertexAttributeFormat::SHORT) {
+            s16 raw;
+            std::memcpy(&raw, source + comp * sizeof(s16), sizeof(s16));
+            value = raw;
+        } else if constexpr (format == VertexAttributeFormat::BYTE) {
+            value = static_cast<s8>(source[comp]);
+        } else {
+            value = source[comp];
+        }
+        attribute[comp] = float24::FromFloat32(value);
+    }
+    for (u32 comp = elements; comp < 4; ++comp) {
+        attribute[comp] = float24::FromFloat32(comp == 3 ? 1.0f : 0.0f);
+    }
+#endif
+}
+
+template <VertexAttributeFormat format, u32 elements>
+static void LoadAttributeBatch(const u8* source, u32 stride, std::size_t count,
+                               Shader::AttributeBuffer* inputs, std::size_t attribute) {
+    for (std::size_t vertex = 0; vertex < count; ++vertex, source += stride) {
+        LoadAttribute<format, elements>(source, inputs[vertex].attr[attribute]);
+    }
+}
+
+template <VertexAttributeFormat format, typename Function>
+static Function GetAttributeLoadFunction(u32 elements) {
+    switch (elements) {
+    case 1:
+        return &LoadAttributeBatch<format, 1>;
+    case 2:
+        return &LoadAttributeBatch<format, 2>;
+    case 3:
+        return &LoadAttributeBatch<format, 3>;
+    case 4:
+        return &LoadAttributeBatch<format, 4>;
+    }
+    UNREACHABLE();
+    return nullptr;
+}
+
+template <typename Function>
+static Function GetAttributeLoadFunction(VertexAttributeFormat format, u32 elements) {
+    switch (format) {
+    case VertexAttributeFormat::BYTE:
+        return GetAttributeLoadFunction<VertexAttributeFormat::BYTE, Function>(elements);
+    case VertexAttributeFormat::UBYTE:
+        return GetAttributeLoadFunction<VertexAttributeFormat::UBYTE, Function>(elements);
+    case VertexAttributeFormat::SHORT:
+        return GetAttributeLoadFunction<VertexAttributeFormat::SHORT, Function>(elements);
+    case VertexAttributeFormat::FLOAT:
+        return GetAttributeLoadFunction<VertexAttributeFormat::FLOAT, Function>(elements);
+    }
+    UNREACHABLE();
+    return nullptr;
+}
+
 void VertexLoader::Setup(const PipelineRegs& regs) {
     ASSERT_MSG(!is_setup, "VertexLoader is not intended to be setup more than once.");
 
     const auto& attribute_config = regs.vertex_attributes;
     num_total_attributes = attribute_config.GetNumTotalAttributes();
 
-    boost::fill(vertex_attribute_sources, 0xdeadbeef);
+    std::array<u32, 16> vertex_attribute_sources;
+    std::array<u32, 16> vertex_attribute_strides{};
+    std::array<VertexAttributeFormat, 16> vertex_attribute_formats;
+    std::array<u32, 16> vertex_attribute_elements{};
 
-    for (int i = 0; i < 16; i++) {
-        vertex_attribute_is_default[i] = attribute_config.IsDefaultAttribute(i);
-    }
+    boost::fill(vertex_attribute_sources, 0xdeadbeef);
 
     // Setup attribute data from loaders
     for (int loader = 0; loader < 12; ++loader) {
@@ -68,96 +182,128 @@ void VertexLoader::Setup(const PipelineRegs& regs) {
         }
     }
 
+    // Pick the specialized routine of every attribute loaded from the vertex arrays
+    for (int i = 0; i < num_total_attributes; ++i) {
+        if (vertex_attribute_elements[i] != 0) {
+            const VertexAttributeFormat format = vertex_attribute_formats[i];
+            const u32 elements = vertex_attribute_elements[i];
+            const u32 element_size = (format == VertexAttributeFormat::FLOAT)
+                                         ? 4
+                                         : (format == VertexAttributeFormat::SHORT) ? 2 : 1;
+            attribute_loaders[num_attribute_loaders++] = {
+                static_cast<u32>(i), vertex_attribute_sources[i], vertex_attribute_strides[i],
+                elements * element_size,
+                GetAttributeLoadFunction<AttributeLoadFunction>(format, elements)};
+        } else if (attribute_config.IsDefaultAttribute(i)) {
+            default_attributes[num_default_attributes++] = static_cast<u32>(i);
+        } else {
+            // TODO(yuriks): In this case, no data gets loaded and the vertex
+            // remains with the last value it had. This isn't currently maintained
+            // as global state, however, and so won't work in Citra yet.
+        }
+    }
+
     is_setup = true;
 }
 
 void VertexLoader::LoadVertex(u32 base_address, int index, int vertex,
                               Shader::AttributeBuffer& input,
-                              DebugUtils::MemoryAccessTracker& memory_accesses) {
+                              DebugUtils::MemoryAccessTracker& memory_accesses) const {
+    LoadVertices(base_address, vertex, 1, &input, memory_accesses);
+
+    for (std::size_t i = 0; i < num_attribute_loaders; ++i) {
+        const AttributeLoader& loader = attribute_loaders[i];
+        const auto& attribute = input.attr[loader.attribute];
+        LOG_TRACE(HW_GPU,
+                  "Loaded attribute {:x} for vertex {:x} (index {:x}) from "
+                  "0x{:08x} + 0x{:08x} + 0x{:04x}: {} {} {} {}",
+                  loader.attribute, vertex, index, base_address, loader.source,
+                  loader.stride * vertex, attribute[0].ToFloat32(), attribute[1].ToFloat32(),
+                  attribute[2].ToFloat32(), attribute[3].ToFloat32());
+    }
+}
+
+void VertexLoader::LoadVertices(u32 base_address, u32 first_vertex, std::size_t count,
+                                Shader::AttributeBuffer* inputs,
+                                DebugUtils::MemoryAccessTracker& memory_accesses) const {
     ASSERT_MSG(is_setup, "A VertexLoader needs to be setup before loading vertices.");
 
-    for (int i = 0; i < num_total_attributes; ++i) {
-        if (vertex_attribute_elements[i] != 0) {
-            // Load per-vertex data from the loader arrays
-            u32 source_addr =
-                base_address + vertex_attribute_sources[i] + vertex_attribute_strides[i] * vertex;
-
-            if (g_debug_context && Pica::g_debug_context->recorder) {
-                memory_accesses.AddAccess(
-                    source_addr,
-                    vertex_attribute_elements[i] *
-                        ((vertex_attribute_formats[i] == PipelineRegs::VertexAttributeFormat::FLOAT)
-                             ? 4
-                             : (vertex_attribute_formats[i] ==
-                                PipelineRegs::VertexAttributeFormat::SHORT)
-                                   ? 2
-                                   : 1));
-            }
+    if (count == 0) {
+        return;
+    }
 
-            switch (vertex_attribute_formats[i]) {
-            case PipelineRegs::VertexAttributeFormat::BYTE: {
-                const s8* srcdata = reinterpret_cast<const s8*>(
-                    VideoCore::g_memory->GetPhysicalPointer(source_addr));
-                for (unsigned int comp = 0; comp < vertex_attribute_elements[i]; ++comp) {
-                    input.attr[i][comp] = float24::FromFloat32(srcdata[comp]);
-                }
-                break;
-            }
-            case PipelineRegs::VertexAttributeFormat::UBYTE: {
-                const u8* srcdata = reinterpret_cast<const u8*>(
-                    VideoCore::g_memory->GetPhysicalPointer(source_addr));
-                for (unsigned int comp = 0; comp < vertex_attribute_elements[i]; ++comp) {
-                    input.attr[i][comp] = float24::FromFloat32(srcdata[comp]);
-                }
-                break;
-            }
-            case PipelineRegs::VertexAttributeFormat::SHORT: {
-                const s16* srcdata = reinterpret_cast<const s16*>(
-                    VideoCore::g_memory->GetPhysicalPointer(source_addr));
-                for (unsigned int comp = 0; comp < vertex_attribute_elements[i]; ++comp) {
-                    input.attr[i][comp] = float24::FromFloat32(srcdata[comp]);
-                }
-                break;
-            }
-            case PipelineRegs::VertexAttributeFormat::FLOAT: {
-                const float* srcdata = reinterpret_cast<const float*>(
-                    VideoCore::g_memory->GetPhysicalPointer(source_addr));
-                for (unsigned int comp = 0; comp < vertex_attribute_elements[i]; ++comp) {
-                    input.attr[i][comp] = float24::FromFloat32(srcdata[comp]);
-                }
-                break;
-            }
-            }
+    for (std::size_t i = 0; i < num_attribute_loaders; ++i) {
+        const AttributeLoader& loader = attribute_loaders[i];
+        const PAddr source_addr = base_address + loader.source + loader.stride * first_vertex;
+        const u32 batch_size = loader.stride * static_cast<u32>(count - 1) + loader.size;
 
-            // Default attribute values set if array elements have < 4 components. This
-            // is *not* carried over from the default attribute settings even if they're
-            // enabled for this attribute.
-            for (unsigned int comp = vertex_attribute_elements[i]; comp < 4; ++comp) {
-                input.attr[i][comp] =
-                    comp == 3 ? float24::FromFloat32(1.0f) : float24::FromFloat32(0.0f);
-            }
+        if (g_debug_context && Pica::g_debug_context->recorder) {
+            memory_accesses.AddAccess(source_addr, batch_size);
+        }
 
-            LOG_TRACE(HW_GPU,
-                      "Loaded {} components of attribute {:x} for vertex {:x} (index {:x}) from "
-                      "0x{:08x} + 0x{:08x} + 0x{:04x}: {} {} {} {}",
-                      vertex_attribute_elements[i], i, vertex, index, base_address,
-                      vertex_attribute_sources[i], vertex_attribute_strides[i] * vertex,
-                      input.attr[i][0].ToFloat32(), input.attr[i][1].ToFloat32(),
-                      input.attr[i][2].ToFloat32(), input.attr[i][3].ToFloat32());
-        } else if (vertex_attribute_is_default[i]) {
-            // Load the default attribute if we're configured to do so
-            input.attr[i] = g_state.input_default_attributes.attr[i];
-            LOG_TRACE(
-                HW_GPU,
-                "Loaded default attribute {:x} for vertex {:x} (index {:x}): ({}, {}, {}, {})", i,
-                vertex, index, input.attr[i][0].ToFloat32(), input.attr[i][1].ToFloat32(),
-                input.attr[i][2].ToFloat32(), input.attr[i][3].ToFloat32());
-        } else {
-            // TODO(yuriks): In this case, no data gets loaded and the vertex
-            // remains with the last value it had. This isn't currently maintained
-            // as global state, however, and so won't work in Citra yet.
+        // The host pointer is looked up once for the whole batch, unless the batch crosses the
+        // end of an emulated memory region
+        const u8* source = VideoCore::g_memory->GetPhysicalPointer(source_addr);
+        const u8* last = VideoCore::g_memory->GetPhysicalPointer(source_addr + batch_size - 1);
+        if (source != nullptr && last == source + batch_size - 1) {
+            loader.load(source, loader.stride, count, inputs, loader.attribute);
+            continue;
+        }
+
+        for (std::size_t vertex = 0; vertex < count; ++vertex) {
+            source = VideoCore::g_memory->GetPhysicalPointer(
+                source_addr + loader.stride * static_cast<u32>(vertex));
+            loader.load(source, loader.stride, 1, inputs + vertex, loader.attribute);
+        }
+    }
+
+    // Load the default attributes if we're configured to do so
+    for (std::size_t i = 0; i < num_default_attributes; ++i) {
+        const u32 attribute = default_attributes[i];
+        for (std::size_t vertex = 0; vertex < count; ++vertex) {
+            inputs[vertex].attr[attribute] = g_state.input_default_attributes.attr[attribute];
         }
     }
 }
 
+/// Register words describing the attribute layout, i.e. the vertex_attributes block without the
+/// base address, which only moves the vertex arrays
+using AttributeLayout =
+    std::array<u32, sizeof(PipelineRegs::vertex_attributes) / sizeof(u32) - 1>;
+
+struct CachedVertexLoader {
+    AttributeLayout layout;
+    VertexLoader loader;
+};
+
+/// Games only use a handful of layouts, this is merely a bound for pathological cases
+constexpr std::size_t MAX_CACHED_VERTEX_LOADERS = 256;
+
+static std::unordered_map<u64, CachedVertexLoader> vertex_loader_cache;
+
+const VertexLoader& VertexLoader::GetCached(const PipelineRegs& regs) {
+    AttributeLayout layout;
+    std::memcpy(layout.data(), reinterpret_cast<const u32*>(&regs.vertex_attributes) + 1,
+                sizeof(layout));
+    const u64 hash = Common::ComputeHash64(layout.data(), sizeof(layout));
+
+    auto it = vertex_loader_cache.find(hash);
+    if (it != vertex_loader_cache.end()) {
+        if (it->second.layout == layout) {
+            return it->second.loader;
+        }
+        // Hash collision, replace the cached loader
+        vertex_loader_cache.erase(it);
+    }
+
+    if (vertex_loader_cache.size() >= MAX_CACHED_VERTEX_LOADERS) {
+        vertex_loader_cache.clear();
+    }
+
+    CachedVertexLoader& entry = vertex_loader_cache[hash];
+    entry.layout = layout;
+    entry.loader.Setup(regs);
+    return entry.loader;
+}
+
 } // namespace Pica
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <array>
+#include <cstddef>
 #include "common/common_types.h"
 #include "video_core/regs_pipeline.h"
 
@@ -23,18 +24,48 @@ public:
 
     void Setup(const PipelineRegs& regs);
     void LoadVertex(u32 base_address, int index, int vertex, Shader::AttributeBuffer& input,
-                    DebugUtils::MemoryAccessTracker& memory_accesses);
+                    DebugUtils::MemoryAccessTracker& memory_accesses) const;
+
+    /**
+     * Loads a batch of consecutive vertices. Each attribute is loaded for the whole batch at once
+     * by a routine specialized for its format and number of elements.
+     * @param first_vertex Index of the first vertex of the batch
+     * @param count Number of vertices to load
+     * @param inputs Array of at least count buffers receiving the vertices
+     */
+    void LoadVertices(u32 base_address, u32 first_vertex, std::size_t count,
+                      Shader::AttributeBuffer* inputs,
+                      DebugUtils::MemoryAccessTracker& memory_accesses) const;
 
     int GetNumTotalAttributes() const {
         return num_total_attributes;
     }
 
+    /**
+     * Returns the loader for the vertex attribute layout configured in the given registers,
+     * setting up a new one only the first time a layout is encountered. The returned reference
+     * stays valid until the next call.
+     */
+    static const VertexLoader& GetCached(const PipelineRegs& regs);
+
 private:
-    std::array<u32, 16> vertex_attribute_sources;
-    std::array<u32, 16> vertex_attribute_strides{};
-    std::array<PipelineRegs::VertexAttributeFormat, 16> vertex_attribute_formats;
-    std::array<u32, 16> vertex_attribute_elements{};
-    std::array<bool, 16> vertex_attribute_is_default;
+    /// Loads one attribute of count vertices, reading each one stride bytes after the previous one
+    using AttributeLoadFunction = void (*)(const u8* source, u32 stride, std::size_t count,
+                                           Shader::AttributeBuffer* inputs, std::size_t attribute);
+
+    struct AttributeLoader {
+        u32 attribute;
+        u32 source;
+        u32 stride;
+        u32 size;
+        AttributeLoadFunction load;
+    };
+
+    std::array<AttributeLoader, 16> attribute_loaders;
+    std::size_t num_attribute_loaders = 0;
+    /// Attributes taken from the default attribute values instead of the vertex arrays
+    std::array<u32, 16> default_attributes;
+    std::size_t num_default_attributes = 0;
     int num_total_attributes = 0;
     bool is_setup = false;
 };
@@ -5,8 +5,10 @@
 #include <memory>
 #include "common/logging/log.h"
 #include "core/settings.h"
+#include "video_core/gpu_thread.h"
 #include "video_core/pica.h"
 #include "video_core/renderer_base.h"
+#include "video_core/renderer_headless/renderer_headless.h"
 #include "video_core/renderer_opengl/gl_vars.h"
 #include "video_core/renderer_opengl/renderer_opengl.h"
 #include "video_core/video_core.h"
@@ -20,9 +22,14 @@ std::unique_ptr<RendererBase> g_renderer; ///< Renderer plugin
 
 std::atomic<bool> g_hw_renderer_enabled;
 std::atomic<bool> g_shader_jit_enabled;
+std::atomic<bool> g_disk_shader_cache_enabled;
 std::atomic<bool> g_hw_shader_enabled;
 std::atomic<bool> g_hw_shader_accurate_gs;
 std::atomic<bool> g_hw_shader_accurate_mul;
+std::atomic<u16> g_sw_rasterizer_threads;
+std::atomic<u16> g_vertex_shader_threads;
+std::atomic<u16> g_texture_decode_threads;
+std::atomic<u16> g_surface_cache_budget;
 std::atomic<bool> g_renderer_bg_color_update_requested;
 // Screenshot
 std::atomic<bool> g_renderer_screenshot_requested;
@@ -39,7 +46,11 @@ Core::System::ResultStatus Init(EmuWindow& emu_window, Memory::MemorySystem& mem
 
     OpenGL::GLES = Settings::values.use_gles;
 
-    g_renderer = std::make_unique<OpenGL::RendererOpenGL>(emu_window);
+    if (Settings::values.use_headless_renderer) {
+        g_renderer = std::make_unique<Headless::RendererHeadless>(emu_window);
+    } else {
+        g_renderer = std::make_unique<OpenGL::RendererOpenGL>(emu_window);
+    }
     Core::System::ResultStatus result = g_renderer->Init();
 
     if (result != Core::System::ResultStatus::Success) {
@@ -48,11 +59,18 @@ Core::System::ResultStatus Init(EmuWindow& emu_window, Memory::MemorySystem& mem
         LOG_DEBUG(Render, "initialized OK");
     }
 
+    if (Settings::values.use_asynchronous_gpu) {
+        g_gpu_thread = std::make_unique<GPUThread>();
+    }
+
     return result;
 }
 
 /// Shutdown the video core
 void Shutdown() {
+    // Finish the work of the GPU thread while the renderer is still around
+    g_gpu_thread.reset();
+
     Pica::Shutdown();
 
     g_renderer.reset();
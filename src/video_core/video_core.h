@@ -27,9 +27,15 @@ extern std::unique_ptr<RendererBase> g_renderer; ///< Renderer plugin
 // qt ui)
 extern std::atomic<bool> g_hw_renderer_enabled;
 extern std::atomic<bool> g_shader_jit_enabled;
+extern std::atomic<bool> g_disk_shader_cache_enabled;
 extern std::atomic<bool> g_hw_shader_enabled;
 extern std::atomic<bool> g_hw_shader_accurate_gs;
 extern std::atomic<bool> g_hw_shader_accurate_mul;
+extern std::atomic<u16> g_sw_rasterizer_threads;
+extern std::atomic<u16> g_vertex_shader_threads;
+extern std::atomic<u16> g_texture_decode_threads;
+/// Host GPU memory in MiB the surface cache may take, 0 if unlimited
+extern std::atomic<u16> g_surface_cache_budget;
 extern std::atomic<bool> g_renderer_bg_color_update_requested;
 // Screenshot
 extern std::atomic<bool> g_renderer_screenshot_requested;